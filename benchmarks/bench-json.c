@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <launchdarkly/api.h>
+
+#include "cJSON.h"
+
+#include "misc.h"
+
+/* Sweeps object sizes and reports the cost of building an object one key at
+a time and of looking up existing keys, through LDObjectLookup and through a
+plain cJSON member scan for comparison. Not part of the test suite, build
+with -DBENCHMARKS=ON and run manually. */
+
+/* each measurement repeats until it has run for at least this long */
+#define MINIMUM_MILLISECONDS 200
+#define LOOKUP_BATCH 1000
+
+static const unsigned int sizes[] = { 4, 16, 64, 256, 1024, 10000, 100000 };
+
+static char **
+makeKeys(const unsigned int count)
+{
+    char **keys;
+    unsigned int i;
+
+    LD_ASSERT(keys = LDAlloc(sizeof(char *) * count));
+
+    for (i = 0; i < count; i++) {
+        char key[32];
+
+        LD_ASSERT(snprintf(key, sizeof(key), "flag-key-%u", i) > 0);
+        LD_ASSERT(keys[i] = LDStrDup(key));
+    }
+
+    return keys;
+}
+
+static struct LDJSON *
+buildObject(char **const keys, const unsigned int count)
+{
+    struct LDJSON *object;
+    unsigned int i;
+
+    LD_ASSERT(object = LDNewObject());
+
+    for (i = 0; i < count; i++) {
+        LD_ASSERT(LDObjectSetKey(object, keys[i], LDNewNumber(i)));
+    }
+
+    return object;
+}
+
+/* returns nanoseconds per lookup */
+static double
+measureLookups(const struct LDJSON *const object, char **const keys,
+    const unsigned int count, const bool scan)
+{
+    unsigned long start, now, lookups;
+    unsigned int position, i;
+
+    lookups  = 0;
+    position = 1;
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&start));
+
+    do {
+        for (i = 0; i < LOOKUP_BATCH; i++) {
+            const struct LDJSON *found;
+
+            /* spread across the object instead of favoring the front */
+            position = position * 1103515245u + 12345u;
+
+            if (scan) {
+                found = (const struct LDJSON *)
+                    cJSON_GetObjectItemCaseSensitive((const cJSON *)object,
+                    keys[position % count]);
+            } else {
+                found = LDObjectLookup(object, keys[position % count]);
+            }
+
+            LD_ASSERT(found);
+        }
+
+        lookups += LOOKUP_BATCH;
+
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&now));
+    } while (now - start < MINIMUM_MILLISECONDS);
+
+    return (double)(now - start) * 1000000.0 / lookups;
+}
+
+int
+main()
+{
+    unsigned int s, i;
+
+    LDConfigureGlobalLogger(LD_LOG_WARNING, LDBasicLogger);
+    LDGlobalInit();
+
+    printf("%10s %14s %14s %14s\n", "keys", "build ms", "lookup ns",
+        "scan ns");
+
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        const unsigned int count = sizes[s];
+        struct LDJSON *object;
+        unsigned long start, end;
+        char **keys;
+
+        keys = makeKeys(count);
+
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&start));
+        object = buildObject(keys, count);
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&end));
+
+        printf("%10u %14lu %14.1f %14.1f\n", count, end - start,
+            measureLookups(object, keys, count, false),
+            measureLookups(object, keys, count, true));
+
+        LDJSONFree(object);
+
+        for (i = 0; i < count; i++) {
+            LDFree(keys[i]);
+        }
+
+        LDFree(keys);
+    }
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <launchdarkly/api.h>
+
+#include "cJSON.h"
+
+#include "misc.h"
+
+#include "util-payload.h"
+
+/* Parses a generated put payload of about 20MB, a few flags of it, a single
+flag, and an array of decimals as in event payloads. Each goes through
+cJSON_Parse and the structural indexing parser, then through
+LDJSONDeserialize and LDi_JSONDeserializeArena, which pick between them by
+length and index large objects. Not part of the test suite, build with
+-DBENCHMARKS=ON and run manually. */
+
+/* each measurement repeats until it has run for at least this long */
+#define MINIMUM_MILLISECONDS 1000
+#define FLAGS 36000
+#define NUMBERS 200000
+
+enum Method { CJSON, INDEXED, DESERIALIZE, ARENA };
+
+static const char *const methodNames[] = { "cJSON parse", "indexed parse",
+    "LDJSONDeserialize", "arena" };
+
+/* returns microseconds per parse */
+static double
+measure(const char *const text, const enum Method method)
+{
+    const size_t length = strlen(text);
+    unsigned long start, now, calls;
+
+    calls = 0;
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&start));
+
+    do {
+        switch (method) {
+            case CJSON:
+                cJSON_Delete(cJSON_Parse(text));
+                break;
+            case INDEXED:
+                cJSON_Delete((cJSON *)
+                    LDi_JSONParseIndexed(text, length, false));
+                break;
+            case DESERIALIZE:
+                LDJSONFree(LDJSONDeserialize(text));
+                break;
+            case ARENA:
+                LDJSONFree(LDi_JSONDeserializeArena(text));
+                break;
+        }
+
+        calls++;
+
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&now));
+    } while (now - start < MINIMUM_MILLISECONDS);
+
+    return (double)(now - start) * 1000.0 / calls;
+}
+
+static char *
+makeNumbers()
+{
+    struct LDJSON *numbers;
+    unsigned int i;
+    char *text;
+
+    LD_ASSERT(numbers = LDNewArray());
+
+    for (i = 0; i < NUMBERS; i++) {
+        LD_ASSERT(LDArrayPush(numbers,
+            LDNewNumber(i % 1000 + i % 997 / 1000.0)));
+    }
+
+    LD_ASSERT(text = LDJSONSerialize(numbers));
+    LDJSONFree(numbers);
+
+    return text;
+}
+
+static void
+report(const char *const name, const char *const text)
+{
+    const size_t length = strlen(text);
+    cJSON *expected, *actual;
+    unsigned int method;
+
+    /* the parsers agree before either is timed */
+    LD_ASSERT(expected = cJSON_Parse(text));
+    LD_ASSERT(actual = (cJSON *)LDi_JSONParseIndexed(text, length, false));
+    LD_ASSERT(cJSON_Compare(expected, actual, true));
+    cJSON_Delete(expected);
+    cJSON_Delete(actual);
+
+    for (method = CJSON; method <= ARENA; method++) {
+        const double micros = measure(text, (enum Method)method);
+
+        printf("%-10s %-18s %10lu %14.1f %10.1f\n", name, methodNames[method],
+            (unsigned long)length, micros, length / micros);
+    }
+}
+
+int
+main()
+{
+    struct LDJSON *flags, *flag;
+    char *payload, *few, *single, *numbers;
+
+    LDConfigureGlobalLogger(LD_LOG_WARNING, LDBasicLogger);
+    LDGlobalInit();
+
+    payload = makePayload(FLAGS);
+
+    LD_ASSERT(flags = makeFlags(8));
+    LD_ASSERT(few = LDJSONSerialize(flags));
+    LDJSONFree(flags);
+
+    LD_ASSERT(flag = makeFlag(0));
+    LD_ASSERT(single = LDJSONSerialize(flag));
+    LDJSONFree(flag);
+
+    numbers = makeNumbers();
+
+    printf("%-10s %-18s %10s %14s %10s\n", "input", "method", "bytes",
+        "us per parse", "MB/s");
+
+    report("payload", payload);
+    report("8 flags", few);
+    report("flag", single);
+    report("numbers", numbers);
+
+    LDFree(payload);
+    LDFree(few);
+    LDFree(single);
+    LDFree(numbers);
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include <launchdarkly/api.h>
+
+#include "misc.h"
+#include "store.h"
+
+#include "util-payload.h"
+
+/* Parses a large put payload and initializes a memory store with it, the
+way a stream connection does, once with the heap allocating every item and
+once with the payload parsed into an arena. Each mode runs in its own
+process so resident memory is comparable. Memory freed by the store is not
+necessarily returned to the system, so peak and retained resident memory
+are reported rather than what remains after it is destroyed. Not part of the test suite, build
+with -DBENCHMARKS=ON and run manually on Linux. */
+
+#define FLAGS 3000
+#define ROUNDS 20
+
+static unsigned long
+residentKilobytes()
+{
+    unsigned long size, resident;
+    FILE *file;
+
+    resident = 0;
+
+    if ((file = fopen("/proc/self/statm", "r"))) {
+        if (fscanf(file, "%lu %lu", &size, &resident) != 2) {
+            resident = 0;
+        }
+
+        fclose(file);
+    }
+
+    return resident * (unsigned long)sysconf(_SC_PAGESIZE) / 1024;
+}
+
+static void
+run(const char *const text, const bool arena)
+{
+    struct LDConfig *config;
+    struct LDStore *store;
+    unsigned long start, end, parse, init, destroy, before, retained;
+    struct rusage usage;
+    unsigned int round;
+
+    LD_ASSERT(config = LDConfigNew(""));
+    LD_ASSERT(store = LDStoreNew(config));
+    LDConfigFree(config);
+
+    parse  = 0;
+    init   = 0;
+    before = residentKilobytes();
+
+    for (round = 0; round < ROUNDS; round++) {
+        struct LDJSON *put, *data, *flags;
+
+        /* as onPut in streaming.c */
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&start));
+        LD_ASSERT(put = arena ? LDi_JSONDeserializeArena(text) :
+            LDJSONDeserialize(text));
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&end));
+        parse += end - start;
+
+        LD_ASSERT(data = LDObjectDetachKey(put, "data"));
+        LDJSONFree(put);
+        LD_ASSERT(flags = LDObjectDetachKey(data, "flags"));
+        LD_ASSERT(LDObjectSetKey(data, "features", flags));
+
+        /* includes freeing the payload the store replaces */
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&start));
+        LD_ASSERT(LDStoreInit(store, data));
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&end));
+        init += end - start;
+    }
+
+    retained = residentKilobytes() - before;
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&start));
+    LDStoreDestroy(store);
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&end));
+    destroy = end - start;
+
+    LD_ASSERT(getrusage(RUSAGE_SELF, &usage) == 0);
+
+    printf("%8s %12.1f %12.1f %12lu %14lu %14ld\n", arena ? "arena" : "heap",
+        (double)parse / ROUNDS, (double)init / ROUNDS, destroy, retained,
+        usage.ru_maxrss);
+}
+
+int
+main()
+{
+    char *text;
+    unsigned int mode;
+
+    LDConfigureGlobalLogger(LD_LOG_WARNING, LDBasicLogger);
+    LDGlobalInit();
+
+    text = makePayload(FLAGS);
+
+    printf("%u flags, %lu byte payload, %u rounds\n", FLAGS,
+        (unsigned long)strlen(text), ROUNDS);
+    printf("%8s %12s %12s %12s %14s %14s\n", "mode", "parse ms", "init ms",
+        "destroy ms", "retained KB", "peak KB");
+    fflush(stdout);
+
+    for (mode = 0; mode < 2; mode++) {
+        pid_t child;
+        int status;
+
+        LD_ASSERT((child = fork()) >= 0);
+
+        if (child == 0) {
+            run(text, mode == 1);
+
+            exit(0);
+        }
+
+        LD_ASSERT(waitpid(child, &status, 0) == child);
+    }
+
+    LDFree(text);
+
+    return 0;
+}
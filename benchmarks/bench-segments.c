@@ -0,0 +1,261 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <launchdarkly/api.h>
+
+#include "client.h"
+#include "evaluate.h"
+#include "misc.h"
+#include "store.h"
+
+#include "util-flags.h"
+
+/* Evaluates 500 flags whose rules share 20 segments for one user, each
+segment with long included and excluded lists and a bucketed rule. One pass
+evaluates every flag with LDi_evaluate, once without a memo so each rule
+checks its segments again, and once with a memo shared by the pass as
+LDAllFlags does. LDAllFlags itself is measured too. Not part of the test
+suite, build with -DBENCHMARKS=ON and run manually. */
+
+/* each measurement repeats until it has run for at least this long */
+#define MINIMUM_MILLISECONDS 1000
+#define FLAGS 500
+#define SEGMENTS 20
+#define RULES 4
+#define MEMBERS 1000
+
+enum Method { UNCACHED, MEMOIZED, ALL_FLAGS };
+
+static const char *const methodNames[] = { "no memo", "shared memo",
+    "LDAllFlags" };
+
+static struct LDJSON *
+makeKeys(const char *const prefix, const unsigned int count)
+{
+    struct LDJSON *keys;
+    unsigned int i;
+    char key[64];
+
+    LD_ASSERT(keys = LDNewArray());
+
+    for (i = 0; i < count; i++) {
+        LD_ASSERT(snprintf(key, sizeof(key), "%s-%u", prefix, i) > 0);
+        LD_ASSERT(LDArrayPush(keys, LDNewText(key)));
+    }
+
+    return keys;
+}
+
+static struct LDJSON *
+makeClause(const char *const attribute, const char *const op,
+    struct LDJSON *const values)
+{
+    struct LDJSON *clause;
+
+    LD_ASSERT(clause = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(clause, "attribute", LDNewText(attribute)));
+    LD_ASSERT(LDObjectSetKey(clause, "op", LDNewText(op)));
+    LD_ASSERT(LDObjectSetKey(clause, "values", values));
+
+    return clause;
+}
+
+/* the user is in neither list, so both are scanned and both rules run */
+static struct LDJSON *
+makeSegment(const unsigned int n)
+{
+    struct LDJSON *segment, *rules, *rule, *clauses, *values;
+    char key[64];
+
+    LD_ASSERT(snprintf(key, sizeof(key), "segment-%u", n) > 0);
+
+    LD_ASSERT(rules = LDNewArray());
+
+    LD_ASSERT(values = LDNewArray());
+    LD_ASSERT(LDArrayPush(values, LDNewText("@example.org")));
+    LD_ASSERT(clauses = LDNewArray());
+    LD_ASSERT(LDArrayPush(clauses, makeClause("email", "endsWith", values)));
+    LD_ASSERT(rule = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(rule, "clauses", clauses));
+    LD_ASSERT(LDArrayPush(rules, rule));
+
+    LD_ASSERT(values = LDNewArray());
+    LD_ASSERT(LDArrayPush(values, LDNewText("gold")));
+    LD_ASSERT(clauses = LDNewArray());
+    LD_ASSERT(LDArrayPush(clauses, makeClause("plan", "in", values)));
+    LD_ASSERT(rule = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(rule, "clauses", clauses));
+    LD_ASSERT(LDObjectSetKey(rule, "weight", LDNewNumber(n % 2 ? 0 : 1)));
+    LD_ASSERT(LDArrayPush(rules, rule));
+
+    LD_ASSERT(segment = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(segment, "key", LDNewText(key)));
+    LD_ASSERT(LDObjectSetKey(segment, "version", LDNewNumber(1)));
+    LD_ASSERT(LDObjectSetKey(segment, "salt", LDNewText("salt")));
+    LD_ASSERT(LDObjectSetKey(segment, "included",
+        makeKeys("member", MEMBERS)));
+    LD_ASSERT(LDObjectSetKey(segment, "excluded",
+        makeKeys("former", MEMBERS / 10)));
+    LD_ASSERT(LDObjectSetKey(segment, "rules", rules));
+
+    return segment;
+}
+
+/* every rule matches two segments, none of which contain the user */
+static struct LDJSON *
+makeSegmentFlag(const unsigned int n)
+{
+    struct LDJSON *flag, *rules, *rule, *clauses, *values;
+    unsigned int i;
+    char key[64];
+
+    LD_ASSERT(snprintf(key, sizeof(key), "flag-%u", n) > 0);
+    LD_ASSERT(flag = makeMinimalFlag(key, 1, true, false));
+
+    LD_ASSERT(rules = LDNewArray());
+
+    for (i = 0; i < RULES; i++) {
+        LD_ASSERT(values = LDNewArray());
+        LD_ASSERT(snprintf(key, sizeof(key), "segment-%u",
+            (n + i) % SEGMENTS) > 0);
+        LD_ASSERT(LDArrayPush(values, LDNewText(key)));
+        LD_ASSERT(snprintf(key, sizeof(key), "segment-%u",
+            (n + i + 7) % SEGMENTS) > 0);
+        LD_ASSERT(LDArrayPush(values, LDNewText(key)));
+
+        LD_ASSERT(clauses = LDNewArray());
+        LD_ASSERT(LDArrayPush(clauses, makeClause("", "segmentMatch",
+            values)));
+
+        LD_ASSERT(snprintf(key, sizeof(key), "rule-%u", i) > 0);
+        LD_ASSERT(rule = LDNewObject());
+        LD_ASSERT(LDObjectSetKey(rule, "id", LDNewText(key)));
+        LD_ASSERT(LDObjectSetKey(rule, "clauses", clauses));
+        LD_ASSERT(LDObjectSetKey(rule, "variation", LDNewNumber(1)));
+        LD_ASSERT(LDArrayPush(rules, rule));
+    }
+
+    LD_ASSERT(LDObjectSetKey(flag, "rules", rules));
+    setFallthrough(flag, 0);
+    addVariation(flag, LDNewBool(false));
+    addVariation(flag, LDNewBool(true));
+
+    return flag;
+}
+
+static void
+evaluateAll(struct LDStore *const store, struct LDJSON *const flags,
+    const struct LDUser *const user, struct LDEvalMemo *const memo)
+{
+    struct LDJSON *flag;
+
+    for (flag = LDGetIter(flags); flag; flag = LDIterNext(flag)) {
+        struct LDDetails details;
+        struct LDJSON *value, *events;
+
+        value  = NULL;
+        events = NULL;
+
+        LDDetailsInit(&details);
+
+        LD_ASSERT(LDi_evaluate(NULL, flag, user, store, &details, &events,
+            &value, false, memo) == EVAL_MATCH);
+        LD_ASSERT(LDGetBool(value) == false);
+
+        LDJSONFree(value);
+        LDJSONFree(events);
+        LDDetailsClear(&details);
+    }
+}
+
+/* returns microseconds per pass over every flag */
+static double
+measure(struct LDClient *const client, struct LDJSON *const flags,
+    struct LDUser *const user, const enum Method method)
+{
+    unsigned long start, now, calls;
+
+    calls = 0;
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&start));
+
+    do {
+        struct LDEvalMemo memo;
+
+        switch (method) {
+            case UNCACHED:
+                evaluateAll(client->store, flags, user, NULL);
+                break;
+            case MEMOIZED:
+                LDi_evalMemoInit(&memo);
+                evaluateAll(client->store, flags, user, &memo);
+                LDi_evalMemoClear(&memo);
+                break;
+            case ALL_FLAGS:
+                LDJSONFree(LDAllFlags(client, user));
+                break;
+        }
+
+        calls++;
+
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&now));
+    } while (now - start < MINIMUM_MILLISECONDS);
+
+    return (double)(now - start) * 1000.0 / calls;
+}
+
+int
+main()
+{
+    struct LDConfig *config;
+    struct LDClient *client;
+    struct LDUser *user;
+    struct LDJSON *flags, *custom;
+    unsigned int i, method;
+
+    /* LDAllFlags warns on every call that the client is not initialized */
+    LDConfigureGlobalLogger(LD_LOG_ERROR, LDBasicLogger);
+    LDGlobalInit();
+
+    LD_ASSERT(config = LDConfigNew("key"));
+    /* reads only the store, without a stream connection */
+    LDConfigSetUseLDD(config, true);
+    LD_ASSERT(client = LDClientInit(config, 0));
+
+    LD_ASSERT(custom = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(custom, "plan", LDNewText("gold")));
+
+    LD_ASSERT(user = LDUserNew("user-7"));
+    LD_ASSERT(LDUserSetEmail(user, "someone@example.com"));
+    LDUserSetCustom(user, custom);
+
+    LD_ASSERT(LDStoreInitEmpty(client->store));
+
+    for (i = 0; i < SEGMENTS; i++) {
+        LD_ASSERT(LDStoreUpsert(client->store, LD_SEGMENT, makeSegment(i)));
+    }
+
+    LD_ASSERT(flags = LDNewArray());
+
+    for (i = 0; i < FLAGS; i++) {
+        struct LDJSON *const flag = makeSegmentFlag(i);
+
+        LD_ASSERT(LDArrayPush(flags, LDJSONDuplicate(flag)));
+        LD_ASSERT(LDStoreUpsert(client->store, LD_FLAG, flag));
+    }
+
+    printf("%u flags, %u segments, %u rules per flag\n", FLAGS, SEGMENTS,
+        RULES);
+    printf("%-12s %14s\n", "method", "us per pass");
+
+    for (method = UNCACHED; method <= ALL_FLAGS; method++) {
+        printf("%-12s %14.1f\n", methodNames[method],
+            measure(client, flags, user, (enum Method)method));
+    }
+
+    LDJSONFree(flags);
+    LDUserFree(user);
+    LDClientClose(client);
+
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <launchdarkly/api.h>
+
+#include "cJSON.h"
+
+#include "misc.h"
+
+#include "util-payload.h"
+
+/* Serializes an event batch, a large flag collection, and summary counter
+keys through cJSON_PrintUnformatted, through LDJSONSerialize, and into a
+reused buffer. Not part of the test suite, build with -DBENCHMARKS=ON and
+run manually. */
+
+/* each measurement repeats until it has run for at least this long */
+#define MINIMUM_MILLISECONDS 300
+#define EVENTS 1000
+#define FLAGS 3000
+
+enum Method { PRINT, SERIALIZE, REUSE };
+
+static const char *const methodNames[] = { "cJSON print", "LDJSONSerialize",
+    "reused buffer" };
+
+static struct LDJSON *
+makeEvents()
+{
+    struct LDJSON *events, *event, *user, *custom;
+    char text[64];
+    unsigned int i;
+
+    LD_ASSERT(events = LDNewArray());
+
+    for (i = 0; i < EVENTS; i++) {
+        LD_ASSERT(custom = LDNewObject());
+        LD_ASSERT(LDObjectSetKey(custom, "plan", LDNewText("gold")));
+        LD_ASSERT(LDObjectSetKey(custom, "seats", LDNewNumber(i % 40)));
+
+        LD_ASSERT(snprintf(text, sizeof(text), "user-%u", i) > 0);
+        LD_ASSERT(user = LDNewObject());
+        LD_ASSERT(LDObjectSetKey(user, "key", LDNewText(text)));
+        LD_ASSERT(LDObjectSetKey(user, "email",
+            LDNewText("someone@example.com")));
+        LD_ASSERT(LDObjectSetKey(user, "custom", custom));
+
+        LD_ASSERT(snprintf(text, sizeof(text), "flag-%u", i % 50) > 0);
+        LD_ASSERT(event = LDNewObject());
+        LD_ASSERT(LDObjectSetKey(event, "kind", LDNewText("feature")));
+        LD_ASSERT(LDObjectSetKey(event, "creationDate",
+            LDNewNumber(1580000000000.0 + i)));
+        LD_ASSERT(LDObjectSetKey(event, "key", LDNewText(text)));
+        LD_ASSERT(LDObjectSetKey(event, "user", user));
+        LD_ASSERT(LDObjectSetKey(event, "value", LDNewBool(i % 2)));
+        LD_ASSERT(LDObjectSetKey(event, "default", LDNewBool(false)));
+        LD_ASSERT(LDObjectSetKey(event, "version", LDNewNumber(12)));
+        LD_ASSERT(LDObjectSetKey(event, "variation", LDNewNumber(i % 2)));
+
+        LD_ASSERT(LDArrayPush(events, event));
+    }
+
+    return events;
+}
+
+static struct LDJSON *
+makeSummaryKey()
+{
+    struct LDJSON *key;
+
+    LD_ASSERT(key = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(key, "variation", LDNewNumber(1)));
+    LD_ASSERT(LDObjectSetKey(key, "version", LDNewNumber(12)));
+
+    return key;
+}
+
+/* returns microseconds per serialization, and the text length */
+static double
+measure(const struct LDJSON *const json, const enum Method method,
+    size_t *const length)
+{
+    struct LDJSONBuffer buffer;
+    unsigned long start, now, calls;
+    char storage[128];
+
+    LDi_JSONBufferInit(&buffer, storage, sizeof(storage));
+
+    calls = 0;
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&start));
+
+    do {
+        char *text;
+
+        switch (method) {
+            case PRINT:
+                LD_ASSERT(text = cJSON_PrintUnformatted((const cJSON *)json));
+                *length = strlen(text);
+                LDFree(text);
+                break;
+            case SERIALIZE:
+                LD_ASSERT(text = LDJSONSerialize(json));
+                *length = strlen(text);
+                LDFree(text);
+                break;
+            case REUSE:
+                LD_ASSERT(LDi_JSONSerializeInto(json, &buffer));
+                *length = buffer.length;
+                break;
+        }
+
+        calls++;
+
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&now));
+    } while (now - start < MINIMUM_MILLISECONDS);
+
+    LDi_JSONBufferFree(&buffer);
+
+    return (double)(now - start) * 1000.0 / calls;
+}
+
+static void
+report(const char *const name, const struct LDJSON *const json)
+{
+    unsigned int method;
+
+    for (method = PRINT; method <= REUSE; method++) {
+        size_t length;
+        double micros;
+
+        micros = measure(json, (enum Method)method, &length);
+
+        printf("%-14s %-16s %10lu %14.2f %10.1f\n", name, methodNames[method],
+            (unsigned long)length, micros, length / micros);
+    }
+}
+
+int
+main()
+{
+    struct LDJSON *events, *flags, *key;
+
+    LDConfigureGlobalLogger(LD_LOG_WARNING, LDBasicLogger);
+    LDGlobalInit();
+
+    events = makeEvents();
+    flags  = makeFlags(FLAGS);
+    key    = makeSummaryKey();
+
+    printf("%-14s %-16s %10s %14s %10s\n", "input", "method", "bytes",
+        "us per call", "MB/s");
+
+    report("event batch", events);
+    report("flags", flags);
+    report("summary key", key);
+
+    LDJSONFree(events);
+    LDJSONFree(flags);
+    LDJSONFree(key);
+
+    return 0;
+}
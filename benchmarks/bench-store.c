@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <launchdarkly/api.h>
+
+#include "misc.h"
+#include "store.h"
+
+#include "util-flags.h"
+
+/* Measures a cold cache under a burst of concurrent readers of one flag,
+against a backend that takes a few milliseconds per read. Reports backend
+reads per burst and reader latency. Not part of the test suite, build with
+-DBENCHMARKS=ON and run manually. */
+
+#define READERS 64
+#define ROUNDS 50
+#define BACKEND_MILLISECONDS 5
+
+static ld_mutex_t backendLock;
+static unsigned int backendCalls;
+static char *backendValue;
+
+/* holds readers until all of them exist, so the burst is simultaneous */
+static ld_mutex_t gateLock;
+static ld_cond_t gateCondition;
+static unsigned int gateRound;
+
+static bool
+slowGet(void *const context, const char *const kind,
+    const char *const featureKey,
+    struct LDStoreCollectionItem *const result)
+{
+    (void)context;
+    (void)kind;
+    (void)featureKey;
+
+    LD_ASSERT(LDi_sleepMilliseconds(BACKEND_MILLISECONDS));
+
+    LD_ASSERT(LDi_mtxlock(&backendLock));
+    backendCalls++;
+    LD_ASSERT(LDi_mtxunlock(&backendLock));
+
+    LD_ASSERT(result->buffer = LDStrDup(backendValue));
+    result->bufferSize = strlen(backendValue);
+    result->version    = 1;
+
+    return true;
+}
+
+static bool
+slowInitialized(void *const context)
+{
+    (void)context;
+
+    return true;
+}
+
+static void
+slowDestructor(void *const context)
+{
+    (void)context;
+}
+
+struct Reader {
+    struct LDStore *store;
+    unsigned int round;
+    unsigned long latency;
+};
+
+static THREAD_RETURN
+readFlag(void *const rawReader)
+{
+    struct Reader *const reader = (struct Reader *)rawReader;
+    struct LDJSONRC *result;
+    unsigned long start, end;
+
+    LD_ASSERT(LDi_mtxlock(&gateLock));
+    while (gateRound != reader->round) {
+        LDi_condwait(&gateCondition, &gateLock, 1000);
+    }
+    LD_ASSERT(LDi_mtxunlock(&gateLock));
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&start));
+    LD_ASSERT(LDStoreGet(reader->store, LD_FLAG, "flag", &result));
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&end));
+
+    LD_ASSERT(result);
+    LDJSONRCDecrement(result);
+
+    reader->latency = end - start;
+
+    return THREAD_RETURN_DEFAULT;
+}
+
+static int
+compareLatency(const void *const a, const void *const b)
+{
+    const unsigned long left  = *(const unsigned long *)a;
+    const unsigned long right = *(const unsigned long *)b;
+
+    return (left > right) - (left < right);
+}
+
+int
+main()
+{
+    struct LDStoreInterface *backend;
+    struct LDConfig *config;
+    struct LDStore *store;
+    struct LDJSON *flag;
+    struct Reader readers[READERS];
+    ld_thread_t threads[READERS];
+    unsigned long *latencies;
+    unsigned int round, i;
+
+    LDConfigureGlobalLogger(LD_LOG_WARNING, LDBasicLogger);
+    LDGlobalInit();
+
+    LD_ASSERT(LDi_mtxinit(&backendLock));
+    LD_ASSERT(LDi_mtxinit(&gateLock));
+    LDi_condinit(&gateCondition);
+
+    LD_ASSERT(flag = makeMinimalFlag("flag", 1, true, false));
+    LD_ASSERT(backendValue = LDJSONSerialize(flag));
+    LDJSONFree(flag);
+
+    LD_ASSERT(backend = LDAlloc(sizeof(struct LDStoreInterface)));
+    memset(backend, 0, sizeof(struct LDStoreInterface));
+    backend->get         = slowGet;
+    backend->initialized = slowInitialized;
+    backend->destructor  = slowDestructor;
+
+    LD_ASSERT(config = LDConfigNew(""));
+    LDConfigSetFeatureStoreBackend(config, backend);
+    LD_ASSERT(store = LDStoreNew(config));
+    config->storeBackend = NULL;
+    LDConfigFree(config);
+
+    LD_ASSERT(latencies = LDAlloc(sizeof(unsigned long) * READERS * ROUNDS));
+
+    for (round = 0; round < ROUNDS; round++) {
+        /* every burst starts from a cold cache */
+        LDi_expireAll(store);
+
+        for (i = 0; i < READERS; i++) {
+            readers[i].store = store;
+            readers[i].round = round + 1;
+
+            LD_ASSERT(LDi_createthread(&threads[i], readFlag, &readers[i]));
+        }
+
+        LD_ASSERT(LDi_mtxlock(&gateLock));
+        gateRound = round + 1;
+        LD_ASSERT(LDi_mtxunlock(&gateLock));
+
+        LDi_condsignal(&gateCondition);
+
+        for (i = 0; i < READERS; i++) {
+            LD_ASSERT(LDi_jointhread(threads[i]));
+
+            latencies[round * READERS + i] = readers[i].latency;
+        }
+    }
+
+    qsort(latencies, READERS * ROUNDS, sizeof(unsigned long), compareLatency);
+
+    printf("store cold reads %u readers x %u rounds: %.1f backend reads "
+        "per round, p50 %lu ms, p99 %lu ms, max %lu ms\n", READERS, ROUNDS,
+        (double)backendCalls / ROUNDS, latencies[READERS * ROUNDS / 2],
+        latencies[READERS * ROUNDS * 99 / 100],
+        latencies[READERS * ROUNDS - 1]);
+
+    LDFree(latencies);
+    LDStoreDestroy(store);
+    LDFree(backendValue);
+    LD_ASSERT(LDi_mtxdestroy(&backendLock));
+    LD_ASSERT(LDi_mtxdestroy(&gateLock));
+    LDi_conddestroy(&gateCondition);
+
+    return 0;
+}
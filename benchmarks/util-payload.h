@@ -0,0 +1,105 @@
+#include <launchdarkly/api.h>
+
+/* Synthetic flags shaped like production ones, with targets and a rule, for
+the benchmarks. */
+
+/* the flag keyed flag-n */
+struct LDJSON *
+makeFlag(const unsigned int n)
+{
+    struct LDJSON *flag, *tmp, *values, *rule, *clause;
+    char text[64];
+    unsigned int i;
+
+    LD_ASSERT(snprintf(text, sizeof(text), "flag-%u", n) > 0);
+
+    LD_ASSERT(flag = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(flag, "key", LDNewText(text)));
+    LD_ASSERT(LDObjectSetKey(flag, "version", LDNewNumber(n % 50 + 1)));
+    LD_ASSERT(LDObjectSetKey(flag, "on", LDNewBool(n % 3 != 0)));
+    LD_ASSERT(LDObjectSetKey(flag, "salt", LDNewText("f7a6b3c2d1e0")));
+    LD_ASSERT(LDObjectSetKey(flag, "trackEvents", LDNewBool(false)));
+    LD_ASSERT(LDObjectSetKey(flag, "deleted", LDNewBool(false)));
+    LD_ASSERT(LDObjectSetKey(flag, "offVariation", LDNewNumber(1)));
+    LD_ASSERT(LDObjectSetKey(flag, "prerequisites", LDNewArray()));
+
+    LD_ASSERT(tmp = LDNewArray());
+    LD_ASSERT(LDArrayPush(tmp, LDNewBool(true)));
+    LD_ASSERT(LDArrayPush(tmp, LDNewBool(false)));
+    LD_ASSERT(LDObjectSetKey(flag, "variations", tmp));
+
+    LD_ASSERT(tmp = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(tmp, "variation", LDNewNumber(0)));
+    LD_ASSERT(LDObjectSetKey(flag, "fallthrough", tmp));
+
+    LD_ASSERT(values = LDNewArray());
+    for (i = 0; i < 10; i++) {
+        LD_ASSERT(snprintf(text, sizeof(text), "user-%u-%u", n, i) > 0);
+        LD_ASSERT(LDArrayPush(values, LDNewText(text)));
+    }
+    LD_ASSERT(tmp = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(tmp, "variation", LDNewNumber(0)));
+    LD_ASSERT(LDObjectSetKey(tmp, "values", values));
+    LD_ASSERT(values = LDNewArray());
+    LD_ASSERT(LDArrayPush(values, tmp));
+    LD_ASSERT(LDObjectSetKey(flag, "targets", values));
+
+    LD_ASSERT(values = LDNewArray());
+    LD_ASSERT(LDArrayPush(values, LDNewText("@example.com")));
+    LD_ASSERT(LDArrayPush(values, LDNewText("@test.com")));
+    LD_ASSERT(clause = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(clause, "attribute", LDNewText("email")));
+    LD_ASSERT(LDObjectSetKey(clause, "op", LDNewText("endsWith")));
+    LD_ASSERT(LDObjectSetKey(clause, "negate", LDNewBool(false)));
+    LD_ASSERT(LDObjectSetKey(clause, "values", values));
+    LD_ASSERT(tmp = LDNewArray());
+    LD_ASSERT(LDArrayPush(tmp, clause));
+    LD_ASSERT(rule = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(rule, "id", LDNewText("rule-0")));
+    LD_ASSERT(LDObjectSetKey(rule, "variation", LDNewNumber(1)));
+    LD_ASSERT(LDObjectSetKey(rule, "clauses", tmp));
+    LD_ASSERT(tmp = LDNewArray());
+    LD_ASSERT(LDArrayPush(tmp, rule));
+    LD_ASSERT(LDObjectSetKey(flag, "rules", tmp));
+
+    return flag;
+}
+
+/* an object of count flags by key */
+struct LDJSON *
+makeFlags(const unsigned int count)
+{
+    struct LDJSON *flags;
+    unsigned int i;
+
+    LD_ASSERT(flags = LDNewObject());
+
+    for (i = 0; i < count; i++) {
+        struct LDJSON *const flag = makeFlag(i);
+
+        LD_ASSERT(LDObjectSetKey(flags, LDGetText(LDObjectLookup(flag, "key")),
+            flag));
+    }
+
+    return flags;
+}
+
+/* the text of a stream put of count flags */
+char *
+makePayload(const unsigned int count)
+{
+    struct LDJSON *put, *data;
+    char *text;
+
+    LD_ASSERT(data = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(data, "flags", makeFlags(count)));
+    LD_ASSERT(LDObjectSetKey(data, "segments", LDNewObject()));
+    LD_ASSERT(put = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(put, "path", LDNewText("/")));
+    LD_ASSERT(LDObjectSetKey(put, "data", data));
+
+    LD_ASSERT(text = LDJSONSerialize(put));
+    LDJSONFree(put);
+
+    return text;
+}
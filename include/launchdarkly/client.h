@@ -13,6 +13,79 @@
 #include <launchdarkly/json.h>
 #include <launchdarkly/export.h>
 
+/** @brief Counters describing how the networking thread uses connections */
+struct LDNetworkStats {
+    /** @brief The number of HTTP requests that have completed */
+    unsigned long requests;
+    /** @brief The number of new connections that had to be established. When
+     * connections are reused this grows slower than `requests`. */
+    unsigned long connections;
+    /** @brief The number of TLS handshakes performed */
+    unsigned long handshakes;
+    /** @brief The number of requests that were completed over HTTP/2 */
+    unsigned long http2Requests;
+};
+
+/** @brief The outcome of `LDClientFlushWait` */
+enum LDFlushStatus {
+    /** @brief Every event queued before the call was delivered */
+    LD_FLUSH_SUCCESS,
+    /** @brief Delivery failed. The events remain queued and delivery will be
+     * retried in the background. */
+    LD_FLUSH_FAILED,
+    /** @brief The timeout was reached before delivery finished. Delivery
+     * continues in the background. */
+    LD_FLUSH_TIMEOUT,
+    /** @brief The client is offline and never delivers events */
+    LD_FLUSH_OFFLINE
+};
+
+/** @brief Where the client is currently receiving flag updates from */
+enum LDDataSourceState {
+    /** @brief No flag data has been received yet */
+    LD_DATA_SOURCE_INITIALIZING,
+    /** @brief The stream is connected and delivering updates */
+    LD_DATA_SOURCE_STREAMING,
+    /** @brief The stream dropped and is reconnecting. Flags may be stale. */
+    LD_DATA_SOURCE_INTERRUPTED,
+    /** @brief Streaming is disabled and flags are polled */
+    LD_DATA_SOURCE_POLLING,
+    /** @brief The stream has been down long enough that flags are polled
+     * until it delivers data again */
+    LD_DATA_SOURCE_FALLBACK,
+    /** @brief The number of states, not a valid state */
+    LD_DATA_SOURCE_STATE_COUNT
+};
+
+/** @brief A snapshot of the data source state machine */
+struct LDDataSourceStatus {
+    /** @brief The current state */
+    enum LDDataSourceState state;
+    /** @brief The number of state changes since the client started */
+    unsigned long transitions;
+    /** @brief Total time spent in each state, indexed by state */
+    unsigned long millisecondsInState[LD_DATA_SOURCE_STATE_COUNT];
+    /** @brief The interval currently used between polls. While falling back
+     * this adapts to how often flags actually change. */
+    unsigned int pollInterval;
+};
+
+/**
+ * @brief Creates a reactor. A reactor owns a networking thread and connection
+ * pool that can be shared by many clients with `LDConfigSetReactor`, so that
+ * each additional client only costs its store and event buffers.
+ * @return A new reactor, or `NULL` on failure.
+ */
+LD_EXPORT(struct LDReactor *) LDReactorNew();
+
+/**
+ * @brief Stops the networking thread of a reactor and frees it. Every client
+ * using the reactor must be closed first.
+ * @param[in] reactor The reactor to free. May be `NULL`.
+ * @return Void.
+ */
+LD_EXPORT(void) LDReactorFree(struct LDReactor *const reactor);
+
 /**
  * @brief Initialize a new client, and connect to LaunchDarkly.
  * @param[in] config The client configuration. Ownership of `config` is
@@ -42,6 +115,17 @@ LD_EXPORT(void) LDClientClose(struct LDClient *const client);
  */
 LD_EXPORT(bool) LDClientIsInitialized(struct LDClient *const client);
 
+/**
+ * @brief Block until the client has received its first full set of flags, or
+ * until the timeout is reached. The calling thread sleeps rather than polling
+ * so it is woken as soon as flags arrive.
+ * @param[in] client The client to use. May not be `NULL` (assert).
+ * @param[in] milliseconds The maximum amount of time to wait.
+ * @return true if the client has received flags.
+ */
+LD_EXPORT(bool) LDClientAwaitInitialized(struct LDClient *const client,
+    const unsigned int milliseconds);
+
 /**
  * @brief Reports that a user has performed an event. Custom data can be
  * attached to the event as JSON.
@@ -91,8 +175,40 @@ LD_EXPORT(bool) LDClientIdentify(struct LDClient *const client,
 LD_EXPORT(bool) LDClientIsOffline(struct LDClient *const client);
 
 /**
- * @brief Immediately flushes queued events.
+ * @brief Immediately flushes queued events. This wakes the networking thread
+ * but does not wait for delivery.
  * @param[in] client The client to use. May not be `NULL` (assert).
  * @return Void.
  */
 LD_EXPORT(void) LDClientFlush(struct LDClient *const client);
+
+/**
+ * @brief Immediately flushes queued events, and blocks until the events
+ * queued before this call have been acknowledged by LaunchDarkly, or the
+ * timeout is reached. Intended for graceful shutdown.
+ * @param[in] client The client to use. May not be `NULL` (assert).
+ * @param[in] milliseconds The maximum amount of time to wait. If zero the
+ * flush is only requested.
+ * @return The outcome of the flush.
+ */
+LD_EXPORT(enum LDFlushStatus) LDClientFlushWait(struct LDClient *const client,
+    const unsigned int milliseconds);
+
+/**
+ * @brief Reports connection reuse statistics for the networking thread.
+ * @param[in] client The client to use. May not be `NULL` (assert).
+ * @param[out] stats Where to write the statistics. May not be `NULL` (assert).
+ * @return Void.
+ */
+LD_EXPORT(void) LDClientGetNetworkStats(struct LDClient *const client,
+    struct LDNetworkStats *const stats);
+
+/**
+ * @brief Reports the state of the data source, and how long it has spent in
+ * each state.
+ * @param[in] client The client to use. May not be `NULL` (assert).
+ * @param[out] status Where to write the status. May not be `NULL` (assert).
+ * @return Void.
+ */
+LD_EXPORT(void) LDClientGetDataSourceStatus(struct LDClient *const client,
+    struct LDDataSourceStatus *const status);
@@ -12,7 +12,8 @@
 
 /* **** Forward Declarations **** */
 
-struct LDStoreInterface; struct LDConfig;
+struct LDStoreInterface; struct LDStoreInterfaceExtensions; struct LDConfig;
+struct LDClient; struct LDReactor;
 
 /**
  * @brief Creates a new default configuration. The configuration object is
@@ -208,14 +209,119 @@ LD_EXPORT(bool) LDConfigAddPrivateAttribute(struct LDConfig *const config,
 LD_EXPORT(void) LDConfigSetFeatureStoreBackend(struct LDConfig *const config,
     struct LDStoreInterface *const backend);
 
+/**
+ * @brief Sets the optional capabilities of the feature store backend.
+ * @param[in] config The configuration to modify. May not be `NULL` (assert).
+ * @param[in] extensions Copied, with `size` set by the implementation. May
+ * not be `NULL` (assert).
+ * @return Void
+ */
+LD_EXPORT(void) LDConfigSetFeatureStoreBackendExtensions(
+    struct LDConfig *const config,
+    const struct LDStoreInterfaceExtensions *const extensions);
+
 /**
  * @brief When a feature store backend is provided, configure how long items
  * will be cached in memory. Set the value to zero to always hit the external
  * store backend. If no backend exists this value is ignored. The default cache
- * time is 30 seconds.
+ * time is 30 seconds. Missing items are not cached longer than this unless
+ * `LDConfigSetFeatureStoreBackendNegativeCacheTTL` is set.
  * @param[in] config The configuration to modify. May not be `NULL` (assert).
  * @param[in] milliseconds How long the cache should live.
  * @return Void
  */
  LD_EXPORT(void) LDConfigSetFeatureStoreBackendCacheTTL(
      struct LDConfig *const config, const unsigned int milliseconds);
+
+/**
+ * @brief When a feature store backend is provided, allow cached items older
+ * than the cache TTL to be served for up to this long while a single
+ * background refresh fetches the current value. Only items older than this
+ * make callers wait on the backend. Values not greater than the cache TTL
+ * disable refresh-ahead, which is the default.
+ * @param[in] config The configuration to modify. May not be `NULL` (assert).
+ * @param[in] milliseconds Age after which a cached item is never served.
+ * @return Void
+ */
+LD_EXPORT(void) LDConfigSetFeatureStoreBackendCacheHardTTL(
+    struct LDConfig *const config, const unsigned int milliseconds);
+
+/**
+ * @brief When a feature store backend is provided, configure how long the
+ * absence of an item from the backend is cached. A value set here is used
+ * independently of the cache TTL, so that lookups of unknown flag keys cannot
+ * create backend load. Set the value to zero to disable negative caching.
+ * When not set it is the smaller of 30 seconds and the cache TTL, so a cache
+ * TTL of zero also disables negative caching.
+ * @param[in] config The configuration to modify. May not be `NULL` (assert).
+ * @param[in] milliseconds How long a missing item is remembered.
+ * @return Void
+ */
+LD_EXPORT(void) LDConfigSetFeatureStoreBackendNegativeCacheTTL(
+    struct LDConfig *const config, const unsigned int milliseconds);
+
+/**
+ * @brief When a feature store backend is provided, configure how many missing
+ * items are remembered at once. At capacity the oldest is forgotten first.
+ * Set the value to zero to disable negative caching. The default is 10000.
+ * @param[in] config The configuration to modify. May not be `NULL` (assert).
+ * @param[in] capacity The maximum number of missing items remembered.
+ * @return Void
+ */
+LD_EXPORT(void) LDConfigSetFeatureStoreBackendNegativeCacheCapacity(
+    struct LDConfig *const config, const unsigned int capacity);
+
+/**
+ * @brief When a feature store backend is provided, configure how long the
+ * backend is not asked again after reporting that it is not initialized. A
+ * positive answer is remembered for the life of the client. Set the value to
+ * zero to ask on every check. The default is 30 seconds.
+ * @param[in] config The configuration to modify. May not be `NULL` (assert).
+ * @param[in] milliseconds How long a negative answer is remembered.
+ * @return Void
+ */
+LD_EXPORT(void) LDConfigSetFeatureStoreBackendInitCheckTTL(
+    struct LDConfig *const config, const unsigned int milliseconds);
+
+/**
+ * @brief Registers a function to be called once the client has received its
+ * first full set of flags. This allows initialization to overlap with other
+ * work by passing a `maxwaitmilli` of zero to `LDClientInit`. The callback is
+ * executed on the networking thread so it should return quickly, and must not
+ * call `LDClientClose`.
+ * @param[in] config The configuration to modify. May not be `NULL` (assert).
+ * @param[in] callback The function to call. May be `NULL` to disable.
+ * @param[in] userData Passed through to `callback`. Ownership is not
+ * transferred.
+ * @return Void
+ */
+LD_EXPORT(void) LDConfigSetInitializedCallback(struct LDConfig *const config,
+    void (*const callback)(struct LDClient *const client,
+        void *const userData),
+    void *const userData);
+
+/**
+ * @brief Run the networking of this client on a shared reactor instead of
+ * spawning a dedicated thread. Every client on a reactor shares one thread and
+ * one connection pool.
+ * @param[in] config The configuration to modify. May not be `NULL` (assert).
+ * @param[in] reactor The reactor to use, created with `LDReactorNew`. May be
+ * `NULL` to use a private reactor. Ownership is not transferred, the reactor
+ * must outlive the client.
+ * @return Void
+ */
+LD_EXPORT(void) LDConfigSetReactor(struct LDConfig *const config,
+    struct LDReactor *const reactor);
+
+/**
+ * @brief Sets the number of threads `LDAllFlags` and `LDAllFlagsState`
+ * split evaluation across, including the calling thread. The client starts
+ * one fewer worker threads, shared by all callers. A call made while the
+ * workers are busy with another evaluates on the calling thread alone.
+ * @param[in] config The configuration to modify. May not be `NULL` (assert).
+ * @param[in] threads The number of threads, `0` is treated as `1`. The
+ * default is `1`, which starts no threads.
+ * @return Void
+ */
+LD_EXPORT(void) LDConfigSetEvaluationThreads(struct LDConfig *const config,
+    const unsigned int threads);
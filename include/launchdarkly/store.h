@@ -47,6 +47,50 @@ struct LDStoreCollectionState {
  * @{
  ******************************************************************************/
 
+/**
+ * @brief Drops cached items after they were changed in the store by another
+ * writer.
+ * @param[in] store The opaque value given to `subscribe`.
+ * @param[in] kind The namespace that changed, or NULL for every namespace.
+ * @param[in] key The item that changed, or NULL for every item in `kind`.
+ * @return Void.
+ */
+typedef void (*LDStoreInvalidate)(void *const store, const char *const kind,
+    const char *const key);
+
+/**
+ * @brief Receives the result of an asynchronous `get`.
+ * @param[in] completionData The value given with the request.
+ * @param[in] success False on failure.
+ * @param[in] result The item as returned by `get`, the receiver owns the
+ * buffer. Undefined on failure.
+ * @return Void.
+ */
+typedef void (*LDStoreGetCompletion)(void *const completionData,
+    const bool success, struct LDStoreCollectionItem *const result);
+
+/**
+ * @brief Receives the result of an asynchronous `all`.
+ * @param[in] completionData The value given with the request.
+ * @param[in] success False on failure.
+ * @param[in] result The items as returned by `all`, the receiver owns the
+ * array and every buffer. NULL on failure.
+ * @param[in] resultCount The number of items in the result array.
+ * @return Void.
+ */
+typedef void (*LDStoreAllCompletion)(void *const completionData,
+    const bool success, struct LDStoreCollectionItem *const result,
+    const unsigned int resultCount);
+
+/**
+ * @brief Receives the result of an asynchronous `init` or `upsert`.
+ * @param[in] completionData The value given with the request.
+ * @param[in] success False on failure.
+ * @return Void.
+ */
+typedef void (*LDStoreCompletion)(void *const completionData,
+    const bool success);
+
 /** @brief An Interface providing access to a store */
 struct LDStoreInterface {
     /**
@@ -121,4 +165,64 @@ struct LDStoreInterface {
     void (*destructor)(void *const context);
 };
 
+/**
+ * @brief Optional capabilities of a store, registered with
+ * `LDConfigSetFeatureStoreBackendExtensions` next to its `LDStoreInterface`.
+ *
+ * `LDStoreInterface` is allocated by implementations and never grows, so
+ * implementations built against earlier versions of this header keep
+ * working. Capabilities are added here instead, and `size` tells the SDK
+ * which of them an implementation knows about. Members past `size` and
+ * NULL members are not used. Each receives the `context` of the
+ * `LDStoreInterface`.
+ */
+struct LDStoreInterfaceExtensions {
+    /**
+     * @brief Must be `sizeof(struct LDStoreInterfaceExtensions)` as
+     * compiled by the implementation.
+     */
+    size_t size;
+    /**
+     * @brief Called once when the SDK starts using the store. From then
+     * until `destructor` returns the implementation may call `invalidate`
+     * from any thread when items change. This allows a long cache TTL
+     * without serving stale items.
+     * @param[in] context Implementation specific context.
+     * May not be NULL (assert).
+     * @param[in] invalidate Drops the cached copies of changed items.
+     * @param[in] store Must be passed back to `invalidate`.
+     * @return Void.
+     */
+    void (*subscribe)(void *const context, LDStoreInvalidate invalidate,
+        void *const store);
+    /**
+     * @brief Optional asynchronous variants of `get`, `all`, `upsert`, and
+     * `init`, each may be NULL. When present the SDK uses them instead of the
+     * blocking versions, which must still be provided.
+     *
+     * A request returns false if it could not be submitted, in which case
+     * the completion is never called. Otherwise the completion is called
+     * exactly once, from any thread, possibly before the request returns.
+     * Arguments other than `completionData` are only borrowed for the
+     * duration of the request. Completions of requests still outstanding
+     * when `destructor` is called must run before it returns.
+     */
+    bool (*getAsync)(void *const context, const char *const kind,
+        const char *const featureKey, LDStoreGetCompletion completion,
+        void *const completionData);
+    /** @brief See `getAsync` */
+    bool (*allAsync)(void *const context, const char *const kind,
+        LDStoreAllCompletion completion, void *const completionData);
+    /** @brief See `getAsync` */
+    bool (*upsertAsync)(void *const context, const char *const kind,
+        const struct LDStoreCollectionItem *const feature,
+        const char *const featureKey, LDStoreCompletion completion,
+        void *const completionData);
+    /** @brief See `getAsync` */
+    bool (*initAsync)(void *const context,
+        const struct LDStoreCollectionState *collections,
+        const unsigned int collectionCount, LDStoreCompletion completion,
+        void *const completionData);
+};
+
 /*@}*/
@@ -11,6 +11,8 @@
 #include <launchdarkly/json.h>
 #include <launchdarkly/export.h>
 
+struct LDUser; struct LDClient;
+
 /**
  * @brief Allocate a new empty user Object
  * @return `NULL` on failure.
@@ -121,3 +123,20 @@ LD_EXPORT(void) LDUserSetCustom(struct LDUser *const user,
  */
 LD_EXPORT(bool) LDUserAddPrivateAttribute(struct LDUser *const user,
     const char *const attribute);
+
+/**
+ * @brief Prepare a user for many evaluations by one client.
+ *
+ * Computes once what every evaluation and event would otherwise derive
+ * from the user again: its attribute values, the hash of its key, and its
+ * JSON with the client's private attributes redacted. All variation
+ * functions use these when called with the same client. Changing the user
+ * discards them, after which it may be prepared again. A user must not be
+ * prepared while it is being evaluated.
+ * @param[in] client The client to prepare for, may not be `NULL` (assert).
+ * @param[in] user The user to prepare, may not be `NULL` (assert).
+ * @return True on success, False on failure, which leaves the user
+ * unprepared.
+ */
+LD_EXPORT(bool) LDUserPrepare(struct LDClient *const client,
+    struct LDUser *const user);
@@ -200,6 +200,84 @@ LD_EXPORT(struct LDJSON *) LDJSONVariation(struct LDClient *const client,
     struct LDUser *const user, const char *const key,
     const struct LDJSON *const fallback, struct LDDetails *const details);
 
+/** @brief The type of value a flag of a batch evaluation returns */
+enum LDVariationType {
+    /** @brief As `LDBoolVariation` */
+    LD_VARIATION_BOOL,
+    /** @brief As `LDIntVariation` */
+    LD_VARIATION_INT,
+    /** @brief As `LDDoubleVariation` */
+    LD_VARIATION_DOUBLE,
+    /** @brief As `LDStringVariation` */
+    LD_VARIATION_STRING,
+    /** @brief As `LDJSONVariation` */
+    LD_VARIATION_JSON
+};
+
+/** @brief A flag to evaluate with `LDVariations` */
+struct LDVariationRequest {
+    /** @brief The key of the flag to evaluate */
+    const char *key;
+    /** @brief The type of value the flag is expected to return */
+    enum LDVariationType type;
+    /** @brief The value to return on error, the member matching `type`.
+     * Ownership is not transferred. */
+    union {
+        bool boolean;
+        int integer;
+        double number;
+        const char *text;
+        const struct LDJSON *json;
+    } fallback;
+};
+
+/** @brief The outcome of one flag of `LDVariations` */
+struct LDVariationResult {
+    /** @brief The type of `value`, copied from the request */
+    enum LDVariationType type;
+    /** @brief The value or the fallback, the member matching `type`. Text
+     * and JSON values are owned by the caller, see
+     * `LDVariationResultsClear`. */
+    union {
+        bool boolean;
+        int integer;
+        double number;
+        char *text;
+        struct LDJSON *json;
+    } value;
+    /** @brief The evaluation explanation */
+    struct LDDetails details;
+};
+
+/**
+ * @brief Evaluate several flags for one user.
+ *
+ * Equivalent to calling the typed variation functions for each request, but
+ * the flags are read from one version of the store, and the user is
+ * validated, indexed, and summarized once for the whole batch.
+ * @param[in] client The client to use. May not be `NULL` (assert).
+ * @param[in] user The user to evaluate the flags against.
+ * @param[in] requests The flags to evaluate. Ownership is not transferred.
+ * @param[out] results An array of `count` results, written in the order of
+ * `requests`. Must be released with `LDVariationResultsClear`.
+ * @param[in] count The number of requests.
+ * @param[in] details If true analytics events include evaluation reasons, as
+ * when passing `details` to the typed variation functions. The details of
+ * each result are filled in either way.
+ */
+LD_EXPORT(void) LDVariations(struct LDClient *const client,
+    struct LDUser *const user, const struct LDVariationRequest *const requests,
+    struct LDVariationResult *const results, const unsigned int count,
+    const bool details);
+
+/**
+ * @brief Free the values and details of results from `LDVariations`.
+ * @param[in] results The results to clear. May be `NULL` if `count` is zero.
+ * @param[in] count The number of results.
+ */
+LD_EXPORT(void) LDVariationResultsClear(
+    struct LDVariationResult *const results, const unsigned int count);
+
 /**
  * @brief Returns a map from feature flag keys to values for a given user.
  * This does not send analytics events back to LaunchDarkly.
@@ -210,3 +288,27 @@ LD_EXPORT(struct LDJSON *) LDJSONVariation(struct LDClient *const client,
  */
 LD_EXPORT(struct LDJSON *) LDAllFlags(struct LDClient *const client,
     struct LDUser *const user);
+
+/** @brief Options of `LDAllFlagsState`, may be combined with `|` */
+enum LDAllFlagsOption {
+    /** @brief Only include flags marked as available to client side SDKs */
+    LD_ALL_FLAGS_CLIENT_SIDE_ONLY = 1 << 0,
+    /** @brief Include the evaluation reason of each flag */
+    LD_ALL_FLAGS_WITH_REASONS = 1 << 1
+};
+
+/**
+ * @brief Returns the state of all flags for a given user, in the format
+ * client side SDKs are bootstrapped with. Besides the value of each flag
+ * keyed by flag key, the object holds `$flagsState`, mapping each flag key to
+ * its `version`, `variation`, and optionally `reason`, `trackEvents`, and
+ * `debugEventsUntilDate`, as well as `$valid`. Flags without a value are
+ * `null`. This does not send analytics events back to LaunchDarkly.
+ * @param[in] client The client to use. May not be `NULL` (assert).
+ * @param[in] user The user to evaluate flags for. Ownership is not transferred.
+ * May not be `NULL` (assert).
+ * @param[in] options A combination of `LDAllFlagsOption` values, or `0`.
+ * @return A JSON object, or `NULL` on `malloc` failure.
+ */
+LD_EXPORT(struct LDJSON *) LDAllFlagsState(struct LDClient *const client,
+    struct LDUser *const user, const unsigned int options);
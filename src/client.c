@@ -1,5 +1,7 @@
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
 
 #include <launchdarkly/api.h>
 
@@ -15,9 +17,13 @@ struct LDClient *
 LDClientInit(struct LDConfig *const config, const unsigned int maxwaitmilli)
 {
     struct LDClient *client;
+    /* locks and conditions are initialized and must be destroyed */
+    bool synchronized;
 
     LD_ASSERT(config);
 
+    synchronized = false;
+
     if (!(client = (struct LDClient *)LDAlloc(sizeof(struct LDClient)))) {
         return NULL;
     }
@@ -34,17 +40,43 @@ LDClientInit(struct LDConfig *const config, const unsigned int maxwaitmilli)
     config->storeBackend   = NULL;
 
     client->shouldFlush    = false;
-    client->shuttingdown   = false;
     client->config         = config;
     client->summaryStart   = 0;
     client->lastServerTime = 0;
+    client->flushRequested = 0;
+    client->flushCompleted = 0;
+    client->flushFailed    = 0;
 
     LD_ASSERT(LDi_getMonotonicMilliseconds(&client->lastUserKeyFlush));
 
+    client->dataSource.state        = LD_DATA_SOURCE_INITIALIZING;
+    client->dataSource.pollInterval = config->pollInterval;
+    client->dataSourceSince         = client->lastUserKeyFlush;
+    client->streamDown              = true;
+    client->streamDownSince         = client->lastUserKeyFlush;
+
     if (!LDi_rwlockinit(&client->lock)) {
         goto error;
     }
 
+    if (!LDi_mtxinit(&client->flushLock)) {
+        LD_ASSERT(LDi_rwlockdestroy(&client->lock));
+
+        goto error;
+    }
+
+    if (!LDi_mtxinit(&client->initLock)) {
+        LD_ASSERT(LDi_rwlockdestroy(&client->lock));
+        LD_ASSERT(LDi_mtxdestroy(&client->flushLock));
+
+        goto error;
+    }
+
+    LDi_condinit(&client->flushCond);
+    LDi_condinit(&client->initCond);
+
+    synchronized = true;
+
     if (!(client->events = LDNewArray())) {
         goto error;
     }
@@ -57,38 +89,60 @@ LDClientInit(struct LDConfig *const config, const unsigned int maxwaitmilli)
         goto error;
     }
 
-    if (!LDi_createthread(&client->thread, LDi_networkthread, client)) {
+    if (config->evaluationThreads > 1 &&
+        !(client->pool = LDi_poolNew(config->evaluationThreads - 1)))
+    {
         goto error;
     }
 
-    LD_LOG(LD_LOG_INFO, "waiting to initialize");
-    if (maxwaitmilli){
-        unsigned long start, diff, now;
+    if (config->reactor) {
+        client->reactor     = config->reactor;
+        client->ownsReactor = false;
+    } else {
+        if (!(client->reactor = LDReactorNew())) {
+            goto error;
+        }
+
+        client->ownsReactor = true;
+    }
 
-        LD_ASSERT(LDi_getMonotonicMilliseconds(&start));
-        do {
-            LD_ASSERT(LDi_rdlock(&client->lock));
-            if (client->initialized) {
-                LD_ASSERT(LDi_rdunlock(&client->lock));
-                break;
-            }
-            LD_ASSERT(LDi_rdunlock(&client->lock));
+    if (!(client->session = LDi_reactorAttach(client->reactor, client))) {
+        goto error;
+    }
 
-            LDi_sleepMilliseconds(5);
+    /* in daemon and offline mode nothing is downloaded so there is nothing to
+    wait for */
+    if (maxwaitmilli && !config->offline && !config->useLDD) {
+        LD_LOG(LD_LOG_INFO, "waiting to initialize");
 
-            LD_ASSERT(LDi_getMonotonicMilliseconds(&now));
-        } while ((diff = now - start) < maxwaitmilli);
+        if (LDClientAwaitInitialized(client, maxwaitmilli)) {
+            LD_LOG(LD_LOG_INFO, "initialized");
+        } else {
+            LD_LOG(LD_LOG_WARNING, "timeout reached before initialization");
+        }
     }
-    LD_LOG(LD_LOG_INFO, "initialized");
 
     return client;
 
   error:
+    if (client->ownsReactor) {
+        LDReactorFree(client->reactor);
+    }
+
     LDStoreDestroy(client->store);
 
     LDJSONFree(client->events);
     LDJSONFree(client->summaryCounters);
     LDLRUFree(client->userKeys);
+    LDi_poolFree(client->pool);
+
+    if (synchronized) {
+        LD_ASSERT(LDi_rwlockdestroy(&client->lock));
+        LD_ASSERT(LDi_mtxdestroy(&client->flushLock));
+        LD_ASSERT(LDi_mtxdestroy(&client->initLock));
+        LDi_conddestroy(&client->flushCond);
+        LDi_conddestroy(&client->initCond);
+    }
 
     LDFree(client);
 
@@ -99,19 +153,23 @@ void
 LDClientClose(struct LDClient *const client)
 {
     if (client) {
-        /* signal shutdown to background */
-        LD_ASSERT(LDi_wrlock(&client->lock));
-        client->shuttingdown = true;
-        LD_ASSERT(LDi_wrunlock(&client->lock));
+        /* wait until the reactor has released our interfaces */
+        LDi_reactorDetach(client->reactor, client->session);
 
-        /* wait until background exits */
-        LD_ASSERT(LDi_jointhread(client->thread));
+        if (client->ownsReactor) {
+            LDReactorFree(client->reactor);
+        }
 
         /* cleanup resources */
         LD_ASSERT(LDi_rwlockdestroy(&client->lock));
+        LD_ASSERT(LDi_mtxdestroy(&client->flushLock));
+        LD_ASSERT(LDi_mtxdestroy(&client->initLock));
+        LDi_conddestroy(&client->flushCond);
+        LDi_conddestroy(&client->initCond);
         LDJSONFree(client->events);
         LDJSONFree(client->summaryCounters);
         LDLRUFree(client->userKeys);
+        LDi_poolFree(client->pool);
 
         LDStoreDestroy(client->store);
 
@@ -131,6 +189,136 @@ LDClientIsInitialized(struct LDClient *const client)
     return LDStoreInitialized(client->store);
 }
 
+void
+LDi_setInitialized(struct LDClient *const client)
+{
+    bool alreadyInitialized;
+
+    LD_ASSERT(client);
+
+    LD_ASSERT(LDi_wrlock(&client->lock));
+    alreadyInitialized  = client->initialized;
+    client->initialized = true;
+    LD_ASSERT(LDi_wrunlock(&client->lock));
+
+    if (alreadyInitialized) {
+        return;
+    }
+
+    /* acquiring the lock orders this with a waiter checking the flag */
+    LD_ASSERT(LDi_mtxlock(&client->initLock));
+    LD_ASSERT(LDi_mtxunlock(&client->initLock));
+
+    LDi_condsignal(&client->initCond);
+
+    if (client->config->initializedCallback) {
+        client->config->initializedCallback(client,
+            client->config->initializedCallbackData);
+    }
+}
+
+static const char *
+dataSourceStateName(const enum LDDataSourceState state)
+{
+    switch (state) {
+        case LD_DATA_SOURCE_INITIALIZING: return "initializing";
+        case LD_DATA_SOURCE_STREAMING:    return "streaming";
+        case LD_DATA_SOURCE_INTERRUPTED:  return "interrupted";
+        case LD_DATA_SOURCE_POLLING:      return "polling";
+        case LD_DATA_SOURCE_FALLBACK:     return "fallback";
+        default:                          return "unknown";
+    }
+}
+
+void
+LDi_setDataSourceState(struct LDClient *const client,
+    const enum LDDataSourceState state)
+{
+    unsigned long now;
+
+    LD_ASSERT(client);
+    LD_ASSERT(state < LD_DATA_SOURCE_STATE_COUNT);
+
+    if (client->dataSource.state == state) {
+        return;
+    }
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&now));
+
+    {
+        char msg[128];
+
+        LD_ASSERT(snprintf(msg, sizeof(msg), "data source %s -> %s",
+            dataSourceStateName(client->dataSource.state),
+            dataSourceStateName(state)) >= 0);
+
+        LD_LOG(LD_LOG_INFO, msg);
+    }
+
+    client->dataSource.millisecondsInState[client->dataSource.state] +=
+        now - client->dataSourceSince;
+
+    client->dataSource.state = state;
+    client->dataSource.transitions++;
+    client->dataSourceSince = now;
+}
+
+void
+LDClientGetDataSourceStatus(struct LDClient *const client,
+    struct LDDataSourceStatus *const status)
+{
+    unsigned long now;
+
+    LD_ASSERT(client);
+    LD_ASSERT(status);
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&now));
+
+    LD_ASSERT(LDi_rdlock(&client->lock));
+    *status = client->dataSource;
+    /* include the time spent in the current state so far */
+    status->millisecondsInState[status->state] += now - client->dataSourceSince;
+    LD_ASSERT(LDi_rdunlock(&client->lock));
+}
+
+bool
+LDClientAwaitInitialized(struct LDClient *const client,
+    const unsigned int milliseconds)
+{
+    bool initialized;
+    unsigned long start, now, remaining;
+
+    LD_ASSERT(client);
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&start));
+
+    LD_ASSERT(LDi_mtxlock(&client->initLock));
+    while (true) {
+        LD_ASSERT(LDi_rdlock(&client->lock));
+        initialized = client->initialized;
+        LD_ASSERT(LDi_rdunlock(&client->lock));
+
+        if (initialized) {
+            break;
+        }
+
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&now));
+
+        if (now - start >= milliseconds) {
+            break;
+        }
+
+        /* LDi_condwait takes an int, the loop waits again for the rest */
+        remaining = milliseconds - (now - start);
+
+        LDi_condwait(&client->initCond, &client->initLock,
+            remaining > INT_MAX ? INT_MAX : (int)remaining);
+    }
+    LD_ASSERT(LDi_mtxunlock(&client->initLock));
+
+    return initialized;
+}
+
 bool
 LDClientTrack(struct LDClient *const client, const char *const key,
     const struct LDUser *const user, struct LDJSON *const data)
@@ -213,11 +401,88 @@ LDClientIsOffline(struct LDClient *const client)
     return client->config->offline;
 }
 
-void
-LDClientFlush(struct LDClient *const client)
+static unsigned long
+requestFlush(struct LDClient *const client)
 {
+    unsigned long generation;
+
     LD_ASSERT(client);
+
     LD_ASSERT(LDi_wrlock(&client->lock));
     client->shouldFlush = true;
+    generation = ++client->flushRequested;
     LD_ASSERT(LDi_wrunlock(&client->lock));
+
+    LDi_wakeNetworkThread(client);
+
+    return generation;
+}
+
+void
+LDClientFlush(struct LDClient *const client)
+{
+    LD_ASSERT(client);
+
+    requestFlush(client);
+}
+
+enum LDFlushStatus
+LDClientFlushWait(struct LDClient *const client,
+    const unsigned int milliseconds)
+{
+    enum LDFlushStatus status;
+    unsigned long generation, start, now, remaining;
+
+    LD_ASSERT(client);
+
+    if (client->config->offline) {
+        return LD_FLUSH_OFFLINE;
+    }
+
+    generation = requestFlush(client);
+    status     = LD_FLUSH_TIMEOUT;
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&start));
+
+    LD_ASSERT(LDi_mtxlock(&client->flushLock));
+    while (true) {
+        if (client->flushCompleted >= generation) {
+            status = LD_FLUSH_SUCCESS;
+
+            break;
+        }
+
+        if (client->flushFailed >= generation) {
+            status = LD_FLUSH_FAILED;
+
+            break;
+        }
+
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&now));
+
+        if (now - start >= milliseconds) {
+            break;
+        }
+
+        /* LDi_condwait takes an int, the loop waits again for the rest */
+        remaining = milliseconds - (now - start);
+
+        LDi_condwait(&client->flushCond, &client->flushLock,
+            remaining > INT_MAX ? INT_MAX : (int)remaining);
+    }
+    LD_ASSERT(LDi_mtxunlock(&client->flushLock));
+
+    return status;
+}
+
+void
+LDClientGetNetworkStats(struct LDClient *const client,
+    struct LDNetworkStats *const stats)
+{
+    LD_ASSERT(client);
+    LD_ASSERT(stats);
+
+    LD_ASSERT(LDi_rdlock(&client->lock));
+    *stats = client->networkStats;
+    LD_ASSERT(LDi_rdunlock(&client->lock));
 }
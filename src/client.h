@@ -4,19 +4,48 @@
 
 #include "misc.h"
 #include "lru.h"
+#include "pool.h"
 
 struct LDClient {
     bool initialized;
-    bool shuttingdown;
     struct LDConfig *config;
-    ld_thread_t thread;
+    /* networking is performed by the reactor, which may be shared */
+    struct LDReactor *reactor;
+    struct LDReactorSession *session;
+    bool ownsReactor;
     ld_rwlock_t lock;
     struct LDJSON *events; /* Array of Objects */
     struct LDJSON *summaryCounters; /* Object */
     unsigned long summaryStart;
     bool shouldFlush;
+    /* incremented for every flush request, guarded by lock */
+    unsigned long flushRequested;
+    /* latest flush generation delivered or failed, guarded by flushLock */
+    unsigned long flushCompleted;
+    unsigned long flushFailed;
+    ld_mutex_t flushLock;
+    ld_cond_t flushCond;
+    /* signalled when initialized becomes true */
+    ld_mutex_t initLock;
+    ld_cond_t initCond;
     unsigned long long lastServerTime;
     struct LDLRU *userKeys;
     unsigned long lastUserKeyFlush;
     struct LDStore *store;
+    /* workers for LDAllFlags, NULL when it runs on the caller alone */
+    struct LDPool *pool;
+    struct LDNetworkStats networkStats;
+    /* data source state machine, guarded by lock */
+    struct LDDataSourceStatus dataSource;
+    unsigned long dataSourceSince;
+    /* true until the stream delivers a put, and again after it drops */
+    bool streamDown;
+    unsigned long streamDownSince;
 };
+
+/* marks the client as having received flags and wakes any waiters */
+void LDi_setInitialized(struct LDClient *const client);
+
+/* transitions the data source state machine, expects write lock */
+void LDi_setDataSourceState(struct LDClient *const client,
+    const enum LDDataSourceState state);
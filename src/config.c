@@ -39,20 +39,30 @@ LDConfigNew(const char *const key)
         goto error;
     }
 
-    config->stream                 = true;
-    config->sendEvents             = true;
-    config->eventsCapacity         = 10000;
-    config->timeout                = 5000;
-    config->flushInterval          = 5000;
-    config->pollInterval           = 30000;
-    config->offline                = false;
-    config->useLDD                 = false;
-    config->allAttributesPrivate   = false;
-    config->inlineUsersInEvents    = false;
-    config->userKeysCapacity       = 1000;
-    config->userKeysFlushInterval  = 300000;
-    config->storeBackend           = NULL;
-    config->storeCacheMilliseconds = 30 * 1000;
+    config->stream                         = true;
+    config->sendEvents                     = true;
+    config->eventsCapacity                 = 10000;
+    config->timeout                        = 5000;
+    config->flushInterval                  = 5000;
+    config->pollInterval                   = 30000;
+    config->offline                        = false;
+    config->useLDD                         = false;
+    config->allAttributesPrivate           = false;
+    config->inlineUsersInEvents            = false;
+    config->userKeysCapacity               = 1000;
+    config->userKeysFlushInterval          = 300000;
+    config->storeBackend                   = NULL;
+    memset(&config->storeExtensions, 0, sizeof(config->storeExtensions));
+    config->storeCacheMilliseconds         = 30 * 1000;
+    config->storeHardCacheMilliseconds     = 0;
+    config->storeNegativeCacheMilliseconds = 30 * 1000;
+    config->storeNegativeCacheExplicit     = false;
+    config->storeNegativeCacheCapacity     = 10000;
+    config->storeInitCheckMilliseconds     = 30 * 1000;
+    config->initializedCallback            = NULL;
+    config->initializedCallbackData        = NULL;
+    config->reactor                        = NULL;
+    config->evaluationThreads              = 1;
 
     return config;
 
@@ -239,6 +249,25 @@ LDConfigSetFeatureStoreBackend(struct LDConfig *const config,
     config->storeBackend = backend;
 }
 
+void
+LDConfigSetFeatureStoreBackendExtensions(struct LDConfig *const config,
+    const struct LDStoreInterfaceExtensions *const extensions)
+{
+    size_t size;
+
+    LD_ASSERT(config);
+    LD_ASSERT(extensions);
+    LD_ASSERT(extensions->size >= sizeof(extensions->size));
+
+    /* an implementation built against an older header fills fewer members,
+    and one built against a newer header more than are known here */
+    size = extensions->size < sizeof(struct LDStoreInterfaceExtensions) ?
+        extensions->size : sizeof(struct LDStoreInterfaceExtensions);
+
+    memset(&config->storeExtensions, 0, sizeof(config->storeExtensions));
+    memcpy(&config->storeExtensions, extensions, size);
+}
+
 void LDConfigSetFeatureStoreBackendCacheTTL(struct LDConfig *const config,
     const unsigned int milliseconds)
 {
@@ -246,3 +275,70 @@ void LDConfigSetFeatureStoreBackendCacheTTL(struct LDConfig *const config,
 
     config->storeCacheMilliseconds = milliseconds;
 }
+
+void
+LDConfigSetFeatureStoreBackendCacheHardTTL(struct LDConfig *const config,
+    const unsigned int milliseconds)
+{
+    LD_ASSERT(config);
+
+    config->storeHardCacheMilliseconds = milliseconds;
+}
+
+void
+LDConfigSetFeatureStoreBackendNegativeCacheTTL(struct LDConfig *const config,
+    const unsigned int milliseconds)
+{
+    LD_ASSERT(config);
+
+    config->storeNegativeCacheMilliseconds = milliseconds;
+    config->storeNegativeCacheExplicit     = true;
+}
+
+void
+LDConfigSetFeatureStoreBackendNegativeCacheCapacity(
+    struct LDConfig *const config, const unsigned int capacity)
+{
+    LD_ASSERT(config);
+
+    config->storeNegativeCacheCapacity = capacity;
+}
+
+void
+LDConfigSetFeatureStoreBackendInitCheckTTL(struct LDConfig *const config,
+    const unsigned int milliseconds)
+{
+    LD_ASSERT(config);
+
+    config->storeInitCheckMilliseconds = milliseconds;
+}
+
+void
+LDConfigSetInitializedCallback(struct LDConfig *const config,
+    void (*const callback)(struct LDClient *const client,
+        void *const userData),
+    void *const userData)
+{
+    LD_ASSERT(config);
+
+    config->initializedCallback     = callback;
+    config->initializedCallbackData = userData;
+}
+
+void
+LDConfigSetReactor(struct LDConfig *const config,
+    struct LDReactor *const reactor)
+{
+    LD_ASSERT(config);
+
+    config->reactor = reactor;
+}
+
+void
+LDConfigSetEvaluationThreads(struct LDConfig *const config,
+    const unsigned int threads)
+{
+    LD_ASSERT(config);
+
+    config->evaluationThreads = threads > 0 ? threads : 1;
+}
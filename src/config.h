@@ -21,5 +21,20 @@ struct LDConfig {
     unsigned int userKeysCapacity;
     unsigned int userKeysFlushInterval;
     struct LDStoreInterface *storeBackend;
+    /* members the backend does not know about are NULL */
+    struct LDStoreInterfaceExtensions storeExtensions;
     unsigned int storeCacheMilliseconds;
+    unsigned int storeHardCacheMilliseconds;
+    unsigned int storeNegativeCacheMilliseconds;
+    /* otherwise the negative TTL is capped at the cache TTL */
+    bool storeNegativeCacheExplicit;
+    unsigned int storeNegativeCacheCapacity;
+    unsigned int storeInitCheckMilliseconds;
+    void (*initializedCallback)(struct LDClient *const client,
+        void *const userData);
+    void *initializedCallbackData;
+    /* not owned, NULL for a private networking thread */
+    struct LDReactor *reactor;
+    /* threads evaluating all flags, including the caller */
+    unsigned int evaluationThreads;
 };
@@ -1,5 +1,6 @@
 #include "sha1.h"
 #include "hexify.h"
+#include "uthash.h"
 
 #include <launchdarkly/api.h>
 
@@ -18,6 +19,141 @@ LDi_isEvalError(const EvalStatus status)
     return status == EVAL_MEM || status == EVAL_SCHEMA || status == EVAL_STORE;
 }
 
+/* the flags whose prerequisites are being checked, innermost first */
+struct EvalPath {
+    const char *key;
+    const struct EvalPath *parent;
+};
+
+struct LDEvalMemoEntry {
+    /* holds the key */
+    struct LDJSONRC *flag;
+    unsigned int version;
+    EvalStatus status;
+    struct LDDetails details;
+    struct LDJSON *value;
+    struct LDJSON *events;
+    UT_hash_handle hh;
+};
+
+struct LDEvalSegmentEntry {
+    /* holds the key */
+    struct LDJSONRC *segment;
+    unsigned int version;
+    EvalStatus status;
+    UT_hash_handle hh;
+};
+
+static EvalStatus evaluate(struct LDClient *const client,
+    const struct LDJSON *const flag, const struct LDUser *const user,
+    struct LDStore *const store, struct LDDetails *const details,
+    struct LDJSON **const o_events, struct LDJSON **const o_value,
+    const bool recordReason, struct LDEvalMemo *const memo,
+    const struct EvalPath *const parent);
+
+static EvalStatus checkPrerequisites(struct LDClient *const client,
+    const struct LDJSON *const flag, const struct LDUser *const user,
+    struct LDStore *const store, const char **const failedKey,
+    struct LDJSON **const events, const bool recordReason,
+    struct LDEvalMemo *const memo, const struct EvalPath *const path);
+
+void
+LDi_evalMemoInit(struct LDEvalMemo *const memo)
+{
+    LD_ASSERT(memo);
+
+    memo->entries  = NULL;
+    memo->segments = NULL;
+}
+
+void
+LDi_evalMemoClear(struct LDEvalMemo *const memo)
+{
+    struct LDEvalMemoEntry *entry, *tmp;
+    struct LDEvalSegmentEntry *segment, *segmentTmp;
+
+    LD_ASSERT(memo);
+
+    HASH_ITER(hh, memo->entries, entry, tmp) {
+        HASH_DEL(memo->entries, entry);
+
+        LDDetailsClear(&entry->details);
+        LDJSONFree(entry->value);
+        LDJSONFree(entry->events);
+        LDJSONRCDecrement(entry->flag);
+        LDFree(entry);
+    }
+
+    HASH_ITER(hh, memo->segments, segment, segmentTmp) {
+        HASH_DEL(memo->segments, segment);
+
+        LDJSONRCDecrement(segment->segment);
+        LDFree(segment);
+    }
+}
+
+/* Takes ownership of the details, value, and events of an evaluation, leaving
+them empty. Nothing is taken when the entry cannot be allocated. */
+static struct LDEvalMemoEntry *
+memoize(struct LDEvalMemo *const memo, struct LDJSONRC *const flagrc,
+    const EvalStatus status, struct LDDetails *const details,
+    struct LDJSON **const value, struct LDJSON **const events)
+{
+    struct LDEvalMemoEntry *entry, *existing;
+    const struct LDJSON *flag;
+    const char *key;
+
+    LD_ASSERT(memo);
+    LD_ASSERT(flagrc);
+    LD_ASSERT(details);
+    LD_ASSERT(value);
+    LD_ASSERT(events);
+
+    LD_ASSERT(flag = LDJSONRCGet(flagrc));
+
+    if (!(key = LDGetText(LDObjectLookup(flag, "key")))) {
+        return NULL;
+    }
+
+    if (!(entry = (struct LDEvalMemoEntry *)
+        LDAlloc(sizeof(struct LDEvalMemoEntry))))
+    {
+        return NULL;
+    }
+
+    memset(entry, 0, sizeof(struct LDEvalMemoEntry));
+
+    LDJSONRCIncrement(flagrc);
+
+    entry->flag    = flagrc;
+    entry->version = LDi_getFeatureVersionTrusted(flag);
+    entry->status  = status;
+    entry->details = *details;
+    entry->value   = *value;
+    entry->events  = *events;
+
+    LDDetailsInit(details);
+    *value  = NULL;
+    *events = NULL;
+
+    /* an older version evaluated earlier in the same call */
+    HASH_FIND_STR(memo->entries, key, existing);
+
+    if (existing) {
+        HASH_DEL(memo->entries, existing);
+
+        LDDetailsClear(&existing->details);
+        LDJSONFree(existing->value);
+        LDJSONFree(existing->events);
+        LDJSONRCDecrement(existing->flag);
+        LDFree(existing);
+    }
+
+    HASH_ADD_KEYPTR(hh, memo->entries, key, strlen(key), entry);
+
+    return entry;
+}
+
 static EvalStatus
 maybeNegate(const struct LDJSON *const clause, const EvalStatus status)
 {
@@ -164,12 +300,25 @@ EvalStatus
 LDi_evaluate(struct LDClient *const client, const struct LDJSON *const flag,
     const struct LDUser *const user, struct LDStore *const store,
     struct LDDetails *const details, struct LDJSON **const o_events,
-    struct LDJSON **const o_value, const bool recordReason)
+    struct LDJSON **const o_value, const bool recordReason,
+    struct LDEvalMemo *const memo)
+{
+    return evaluate(client, flag, user, store, details, o_events, o_value,
+        recordReason, memo, NULL);
+}
+
+static EvalStatus
+evaluate(struct LDClient *const client, const struct LDJSON *const flag,
+    const struct LDUser *const user, struct LDStore *const store,
+    struct LDDetails *const details, struct LDJSON **const o_events,
+    struct LDJSON **const o_value, const bool recordReason,
+    struct LDEvalMemo *const memo, const struct EvalPath *const parent)
 {
     EvalStatus substatus;
     const struct LDJSON *iter, *rules, *targets, *on;
     const struct LDJSON *index;
     const char *failedKey;
+    struct EvalPath path;
 
     LD_ASSERT(flag);
     LD_ASSERT(LDUserValidate(user));
@@ -221,9 +370,12 @@ LDi_evaluate(struct LDClient *const client, const struct LDJSON *const flag,
     }
 
     /* prerequisites */
+    path.key    = LDGetText(LDObjectLookup(flag, "key"));
+    path.parent = parent;
+
     if (LDi_isEvalError(substatus =
-        LDi_checkPrerequisites(client, flag, user, store, &failedKey,
-            o_events, recordReason)))
+        checkPrerequisites(client, flag, user, store, &failedKey,
+            o_events, recordReason, memo, &path)))
     {
         LD_LOG(LD_LOG_ERROR, "checkPrequisites failed");
 
@@ -326,7 +478,7 @@ LDi_evaluate(struct LDClient *const client, const struct LDJSON *const flag,
             }
 
             if (LDi_isEvalError(substatus = LDi_ruleMatchesUser(
-                iter, user, store)))
+                iter, user, store, memo)))
             {
                 LD_LOG(LD_LOG_ERROR, "sub error");
 
@@ -403,234 +555,264 @@ LDi_evaluate(struct LDClient *const client, const struct LDJSON *const flag,
     return EVAL_MATCH;
 }
 
-EvalStatus
-LDi_checkPrerequisites(struct LDClient *const client,
-    const struct LDJSON *const flag,
+/* Checks one prerequisite of a flag, appending its events. A prerequisite
+already evaluated by the memo for its current version is not evaluated
+again. */
+static EvalStatus
+checkPrerequisite(struct LDClient *const client,
+    const struct LDJSON *const flag, const struct LDJSON *const prerequisite,
     const struct LDUser *const user, struct LDStore *const store,
     const char **const failedKey, struct LDJSON **const events,
-    const bool recordReason)
+    const bool recordReason, struct LDEvalMemo *const memo,
+    const struct EvalPath *const path)
 {
-    struct LDJSON *prerequisites, *iter;
-
-    LD_ASSERT(flag);
-    LD_ASSERT(user);
-    LD_ASSERT(store);
-    LD_ASSERT(failedKey);
-    LD_ASSERT(events);
-    LD_ASSERT(LDJSONGetType(flag) == LDObject);
+    struct LDJSON *value, *subevents, *event, *on;
+    const struct LDJSON *key, *variation, *preflag, *resultValue;
+    const struct LDJSON *resultEvents;
+    const struct LDDetails *resultDetails;
+    const struct LDEvalMemoEntry *memoized;
+    const struct EvalPath *node;
+    const unsigned int *variationNumRef;
+    const char *keyText;
+    struct LDDetails details;
+    struct LDJSONRC *preflagrc;
+    EvalStatus status;
+
+    value     = NULL;
+    subevents = NULL;
+    event     = NULL;
+    preflag   = NULL;
+    memoized  = NULL;
+    preflagrc = NULL;
+
+    LDDetailsInit(&details);
+
+    if (LDJSONGetType(prerequisite) != LDObject) {
+        LD_LOG(LD_LOG_ERROR, "schema error");
 
-    prerequisites = NULL;
-    iter          = NULL;
+        return EVAL_SCHEMA;
+    }
 
-    prerequisites = LDObjectLookup(flag, "prerequisites");
+    if (!(key = LDObjectLookup(prerequisite, "key"))) {
+        LD_LOG(LD_LOG_ERROR, "schema error");
 
-    if (!prerequisites) {
-        return EVAL_MATCH;
+        return EVAL_SCHEMA;
     }
 
-    if (LDJSONGetType(prerequisites) != LDArray) {
+    if (LDJSONGetType(key) != LDText) {
         LD_LOG(LD_LOG_ERROR, "schema error");
 
         return EVAL_SCHEMA;
     }
 
-    for (iter = LDGetIter(prerequisites); iter; iter = LDIterNext(iter)) {
-        struct LDJSON *value, *preflag, *event, *subevents;
-        const struct LDJSON *key, *variation;
-        unsigned int *variationNumRef;
-        EvalStatus status;
-        const char *keyText;
-        struct LDDetails details, *detailsRef;
-        struct LDJSONRC *preflagrc;
-
-        value            = NULL;
-        preflag          = NULL;
-        key              = NULL;
-        variation        = NULL;
-        variationNumRef  = NULL;
-        event            = NULL;
-        subevents        = NULL;
-        keyText          = NULL;
-        detailsRef       = NULL;
-        preflagrc        = NULL;
-
-        LDDetailsInit(&details);
+    keyText = LDGetText(key);
 
-        if (LDJSONGetType(iter) != LDObject) {
-            LD_LOG(LD_LOG_ERROR, "schema error");
+    *failedKey = keyText;
 
-            return EVAL_SCHEMA;
-        }
+    if (!(variation = LDObjectLookup(prerequisite, "variation"))) {
+        LD_LOG(LD_LOG_ERROR, "schema error");
 
-        if (!(key = LDObjectLookup(iter, "key"))) {
-            LD_LOG(LD_LOG_ERROR, "schema error");
+        return EVAL_SCHEMA;
+    }
 
-            return EVAL_SCHEMA;
-        }
+    if (LDJSONGetType(variation) != LDNumber) {
+        LD_LOG(LD_LOG_ERROR, "schema error");
 
-        if (LDJSONGetType(key) != LDText) {
-            LD_LOG(LD_LOG_ERROR, "schema error");
+        return EVAL_SCHEMA;
+    }
+
+    for (node = path; node; node = node->parent) {
+        if (node->key && strcmp(node->key, keyText) == 0) {
+            LD_LOG(LD_LOG_ERROR, "prerequisite cycle");
 
             return EVAL_SCHEMA;
         }
+    }
 
-        keyText = LDGetText(key);
+    if (!LDStoreGet(store, LD_FLAG, keyText, &preflagrc)) {
+        LD_LOG(LD_LOG_ERROR, "store lookup error");
 
-        *failedKey = keyText;
+        return EVAL_STORE;
+    }
 
-        if (!(variation = LDObjectLookup(iter, "variation"))) {
-            LD_LOG(LD_LOG_ERROR, "schema error");
+    if (preflagrc) {
+        preflag = LDJSONRCGet(preflagrc);
+    }
 
-            return EVAL_SCHEMA;
-        }
+    if (!preflag) {
+        LD_LOG(LD_LOG_ERROR, "cannot find flag in store");
 
-        if (LDJSONGetType(variation) != LDNumber) {
-            LD_LOG(LD_LOG_ERROR, "schema error");
+        return EVAL_MISS;
+    }
 
-            return EVAL_SCHEMA;
-        }
+    if (memo) {
+        struct LDEvalMemoEntry *entry;
 
-        if (!LDStoreGet(store, LD_FLAG, keyText, &preflagrc)) {
-            LD_LOG(LD_LOG_ERROR, "store lookup error");
+        HASH_FIND_STR(memo->entries, keyText, entry);
 
-            return EVAL_STORE;
+        if (entry && entry->version == LDi_getFeatureVersionTrusted(preflag)) {
+            memoized = entry;
         }
+    }
 
-        if (preflagrc) {
-            preflag = LDJSONRCGet(preflagrc);
+    if (memoized) {
+        status        = memoized->status;
+        resultDetails = &memoized->details;
+        resultValue   = memoized->value;
+        resultEvents  = memoized->events;
+    } else {
+        if (LDi_isEvalError(status = evaluate(client, preflag, user, store,
+            &details, &subevents, &value, recordReason, memo, path)))
+        {
+            goto cleanup;
         }
 
-        if (!preflag) {
-            LD_LOG(LD_LOG_ERROR, "cannot find flag in store");
+        if (memo) {
+            memoized = memoize(memo, preflagrc, status, &details, &value,
+                &subevents);
+        }
 
-            return EVAL_MISS;
+        if (memoized) {
+            resultDetails = &memoized->details;
+            resultValue   = memoized->value;
+            resultEvents  = memoized->events;
+        } else {
+            resultDetails = &details;
+            resultValue   = value;
+            resultEvents  = subevents;
         }
+    }
 
-        if (LDi_isEvalError(status = LDi_evaluate(client, preflag, user, store,
-            &details, &subevents, &value, recordReason)))
-        {
-            LDJSONRCDecrement(preflagrc);
-            LDJSONFree(value);
-            LDDetailsClear(&details);
-            LDJSONFree(subevents);
+    if (!resultValue) {
+        LD_LOG(LD_LOG_ERROR, "sub error with result");
+    }
 
-            return status;
-        }
+    variationNumRef = NULL;
 
-        if (!value) {
-            LD_LOG(LD_LOG_ERROR, "sub error with result");
-        }
+    if (resultDetails->hasVariation) {
+        variationNumRef = &resultDetails->variationIndex;
+    }
 
-        if (details.hasVariation) {
-            variationNumRef = &details.variationIndex;
-        }
+    event = LDi_newFeatureRequestEvent(client,
+        keyText, user, variationNumRef, resultValue, NULL,
+        LDGetText(LDObjectLookup(flag, "key")), preflag,
+        recordReason ? resultDetails : NULL);
 
-        if (recordReason) {
-            detailsRef = &details;
-        }
+    if (!event) {
+        LD_LOG(LD_LOG_ERROR, "alloc error");
 
-        event = LDi_newFeatureRequestEvent(client,
-            keyText, user, variationNumRef, value, NULL,
-            LDGetText(LDObjectLookup(flag, "key")), preflag, detailsRef);
+        status = EVAL_MEM;
 
-        if (!event) {
-            LDJSONRCDecrement(preflagrc);
-            LDJSONFree(value);
-            LDDetailsClear(&details);
-            LDJSONFree(subevents);
+        goto cleanup;
+    }
 
+    if (!(*events)) {
+        if (!(*events = LDNewArray())) {
             LD_LOG(LD_LOG_ERROR, "alloc error");
 
-            return EVAL_MEM;
+            status = EVAL_MEM;
+
+            goto cleanup;
         }
+    }
 
-        if (!(*events)) {
-            if (!(*events = LDNewArray())) {
-                LDJSONRCDecrement(preflagrc);
-                LDJSONFree(value);
-                LDDetailsClear(&details);
-                LDJSONFree(subevents);
+    if (resultEvents) {
+        if (!LDArrayAppend(*events, resultEvents)) {
+            LD_LOG(LD_LOG_ERROR, "alloc error");
 
-                LD_LOG(LD_LOG_ERROR, "alloc error");
+            status = EVAL_MEM;
 
-                return EVAL_MEM;
-            }
+            goto cleanup;
         }
+    }
 
-        if (subevents) {
-            if (!LDArrayAppend(*events, subevents)) {
-                LDJSONRCDecrement(preflagrc);
-                LDJSONFree(value);
-                LDDetailsClear(&details);
-                LDJSONFree(subevents);
+    if (!LDArrayPush(*events, event)) {
+        LD_LOG(LD_LOG_ERROR, "alloc error");
 
-                LD_LOG(LD_LOG_ERROR, "alloc error");
+        status = EVAL_MEM;
 
-                return EVAL_MEM;
-            }
+        goto cleanup;
+    }
 
-            LDJSONFree(subevents);
-        }
+    event = NULL;
 
-        if (!LDArrayPush(*events, event)) {
-            LDJSONRCDecrement(preflagrc);
-            LDJSONFree(value);
-            LDDetailsClear(&details);
+    if (status == EVAL_MISS) {
+        goto cleanup;
+    }
 
-            LD_LOG(LD_LOG_ERROR, "alloc error");
+    if (!(on = LDObjectLookup(preflag, "on"))) {
+        LD_LOG(LD_LOG_ERROR, "schema error");
 
-            return EVAL_MEM;
-        }
+        status = EVAL_SCHEMA;
 
-        if (status == EVAL_MISS) {
-            LDJSONRCDecrement(preflagrc);
-            LDJSONFree(value);
-            LDDetailsClear(&details);
+        goto cleanup;
+    }
 
-            return EVAL_MISS;
-        }
+    if (LDJSONGetType(on) != LDBool) {
+        LD_LOG(LD_LOG_ERROR, "schema error");
 
-        {
-            struct LDJSON *on;
-            bool variationMatch = false;
+        status = EVAL_SCHEMA;
 
-            if (!(on = LDObjectLookup(preflag, "on"))) {
-                LDJSONRCDecrement(preflagrc);
-                LDJSONFree(value);
-                LDDetailsClear(&details);
+        goto cleanup;
+    }
 
-                LD_LOG(LD_LOG_ERROR, "schema error");
+    if (!LDGetBool(on) || !resultDetails->hasVariation ||
+        resultDetails->variationIndex != LDGetNumber(variation))
+    {
+        status = EVAL_MISS;
+    } else {
+        status = EVAL_MATCH;
+    }
 
-                return EVAL_SCHEMA;
-            }
+  cleanup:
+    LDJSONFree(event);
+    LDJSONFree(value);
+    LDJSONFree(subevents);
+    LDDetailsClear(&details);
+    LDJSONRCDecrement(preflagrc);
 
-            if (LDJSONGetType(on) != LDBool) {
-                LDJSONRCDecrement(preflagrc);
-                LDJSONFree(value);
-                LDDetailsClear(&details);
+    return status;
+}
 
-                LD_LOG(LD_LOG_ERROR, "schema error");
+static EvalStatus
+checkPrerequisites(struct LDClient *const client,
+    const struct LDJSON *const flag,
+    const struct LDUser *const user, struct LDStore *const store,
+    const char **const failedKey, struct LDJSON **const events,
+    const bool recordReason, struct LDEvalMemo *const memo,
+    const struct EvalPath *const path)
+{
+    struct LDJSON *prerequisites, *iter;
 
-                return EVAL_SCHEMA;
-            }
+    LD_ASSERT(flag);
+    LD_ASSERT(user);
+    LD_ASSERT(store);
+    LD_ASSERT(failedKey);
+    LD_ASSERT(events);
+    LD_ASSERT(LDJSONGetType(flag) == LDObject);
 
-            if (details.hasVariation) {
-                variationMatch = details.variationIndex ==
-                    LDGetNumber(variation);
-            }
+    prerequisites = NULL;
+    iter          = NULL;
 
-            if (!LDGetBool(on) || !variationMatch) {
-                LDJSONRCDecrement(preflagrc);
-                LDJSONFree(value);
-                LDDetailsClear(&details);
+    prerequisites = LDObjectLookup(flag, "prerequisites");
 
-                return EVAL_MISS;
-            }
-        }
+    if (!prerequisites) {
+        return EVAL_MATCH;
+    }
 
-        LDJSONRCDecrement(preflagrc);
-        LDJSONFree(value);
-        LDDetailsClear(&details);
+    if (LDJSONGetType(prerequisites) != LDArray) {
+        LD_LOG(LD_LOG_ERROR, "schema error");
+
+        return EVAL_SCHEMA;
+    }
+
+    for (iter = LDGetIter(prerequisites); iter; iter = LDIterNext(iter)) {
+        const EvalStatus status = checkPrerequisite(client, flag, iter, user,
+            store, failedKey, events, recordReason, memo, path);
+
+        if (status != EVAL_MATCH) {
+            return status;
+        }
     }
 
     return EVAL_MATCH;
@@ -638,7 +820,8 @@ LDi_checkPrerequisites(struct LDClient *const client,
 
 EvalStatus
 LDi_ruleMatchesUser(const struct LDJSON *const rule,
-    const struct LDUser *const user, struct LDStore *const store)
+    const struct LDUser *const user, struct LDStore *const store,
+    struct LDEvalMemo *const memo)
 {
     const struct LDJSON *clauses = NULL;
     const struct LDJSON *iter = NULL;
@@ -668,7 +851,7 @@ LDi_ruleMatchesUser(const struct LDJSON *const rule,
         }
 
         if (LDi_isEvalError(substatus = LDi_clauseMatchesUser(
-            iter, user, store)))
+            iter, user, store, memo)))
         {
             LD_LOG(LD_LOG_ERROR, "schema error");
 
@@ -683,9 +866,72 @@ LDi_ruleMatchesUser(const struct LDJSON *const rule,
     return EVAL_MATCH;
 }
 
+/* Segment membership of a segment read from the store, answered from the
+memo when the same version was checked earlier in the call. Errors are not
+remembered. */
+static EvalStatus
+segmentMatchesUser(struct LDJSONRC *const segmentrc,
+    const struct LDUser *const user, struct LDEvalMemo *const memo)
+{
+    struct LDEvalSegmentEntry *entry;
+    const struct LDJSON *segment;
+    unsigned int version;
+    EvalStatus status;
+    const char *key;
+
+    LD_ASSERT(segmentrc);
+    LD_ASSERT(user);
+
+    LD_ASSERT(segment = LDJSONRCGet(segmentrc));
+
+    if (!memo || !(key = LDGetText(LDObjectLookup(segment, "key")))) {
+        return LDi_segmentMatchesUser(segment, user);
+    }
+
+    version = LDi_getFeatureVersionTrusted(segment);
+
+    HASH_FIND_STR(memo->segments, key, entry);
+
+    if (entry && entry->version == version) {
+        return entry->status;
+    }
+
+    status = LDi_segmentMatchesUser(segment, user);
+
+    if (LDi_isEvalError(status)) {
+        return status;
+    }
+
+    /* an older version checked earlier in the same call */
+    if (entry) {
+        HASH_DEL(memo->segments, entry);
+
+        LDJSONRCDecrement(entry->segment);
+        LDFree(entry);
+    }
+
+    /* remembering is only an optimization, so allocation failure is not */
+    if ((entry = (struct LDEvalSegmentEntry *)
+        LDAlloc(sizeof(struct LDEvalSegmentEntry))))
+    {
+        memset(entry, 0, sizeof(struct LDEvalSegmentEntry));
+
+        LDJSONRCIncrement(segmentrc);
+
+        entry->segment = segmentrc;
+        entry->version = version;
+        entry->status  = status;
+
+        HASH_ADD_KEYPTR(hh, memo->segments, key, strlen(key), entry);
+    }
+
+    return status;
+}
+
 EvalStatus
 LDi_clauseMatchesUser(const struct LDJSON *const clause,
-    const struct LDUser *const user, struct LDStore *const store)
+    const struct LDUser *const user, struct LDStore *const store,
+    struct LDEvalMemo *const memo)
 {
     const struct LDJSON *op;
 
@@ -758,7 +1004,7 @@ LDi_clauseMatchesUser(const struct LDJSON *const clause,
                 }
 
                 if (LDi_isEvalError(
-                    evalstatus = LDi_segmentMatchesUser(segment, user)))
+                    evalstatus = segmentMatchesUser(segmentrc, user, memo)))
                 {
                     LD_LOG(LD_LOG_ERROR, "sub error");
 
@@ -987,8 +1233,8 @@ LDi_clauseMatchesUserNoSegments(const struct LDJSON *const clause,
 {
     OpFn fn;
     const char *operatorText, *attributeText;
-    struct LDJSON *operatorJSON, *attributeValue, *attribute;
-    const struct LDJSON *values;
+    struct LDJSON *operatorJSON, *attribute, *temporary;
+    const struct LDJSON *values, *attributeValue;
     LDJSONType type;
 
     LD_ASSERT(clause);
@@ -999,6 +1245,7 @@ LDi_clauseMatchesUserNoSegments(const struct LDJSON *const clause,
     operatorJSON   = NULL;
     attributeText  = NULL;
     attributeValue = NULL;
+    temporary      = NULL;
     attribute      = NULL;
     values         = NULL;
 
@@ -1050,7 +1297,9 @@ LDi_clauseMatchesUserNoSegments(const struct LDJSON *const clause,
         return EVAL_MISS;
     }
 
-    if (!(attributeValue = LDi_valueOfAttribute(user, attributeText))) {
+    if (!(attributeValue =
+        LDi_lookupAttribute(user, attributeText, &temporary)))
+    {
         LD_LOG(LD_LOG_TRACE, "attribute does not exist");
 
         return EVAL_MISS;
@@ -1069,7 +1318,7 @@ LDi_clauseMatchesUserNoSegments(const struct LDJSON *const clause,
             if (type == LDObject || type == LDArray) {
                 LD_LOG(LD_LOG_ERROR, "schema error");
 
-                LDJSONFree(attributeValue);
+                LDJSONFree(temporary);
 
                 return EVAL_SCHEMA;
             }
@@ -1077,19 +1326,19 @@ LDi_clauseMatchesUserNoSegments(const struct LDJSON *const clause,
             if (LDi_isEvalError(substatus = matchAny(fn, iter, values))) {
                 LD_LOG(LD_LOG_ERROR, "sub error");
 
-                LDJSONFree(attributeValue);
+                LDJSONFree(temporary);
 
                 return substatus;
             }
 
             if (substatus == EVAL_MATCH) {
-                LDJSONFree(attributeValue);
+                LDJSONFree(temporary);
 
                 return maybeNegate(clause, EVAL_MATCH);
             }
         }
 
-        LDJSONFree(attributeValue);
+        LDJSONFree(temporary);
 
         return maybeNegate(clause, EVAL_MISS);
     } else {
@@ -1098,12 +1347,12 @@ LDi_clauseMatchesUserNoSegments(const struct LDJSON *const clause,
         if (LDi_isEvalError(substatus = matchAny(fn, attributeValue, values))) {
             LD_LOG(LD_LOG_ERROR, "sub error");
 
-            LDJSONFree(attributeValue);
+            LDJSONFree(temporary);
 
             return substatus;
         }
 
-        LDJSONFree(attributeValue);
+        LDJSONFree(temporary);
 
         return maybeNegate(clause, substatus);
     }
@@ -1113,7 +1362,8 @@ bool
 LDi_bucketUser(const struct LDUser *const user, const char *const segmentKey,
     const char *const attribute, const char *const salt, float *const bucket)
 {
-    struct LDJSON *attributeValue;
+    const struct LDJSON *attributeValue;
+    struct LDJSON *temporary;
 
     LD_ASSERT(user);
     LD_ASSERT(segmentKey);
@@ -1121,9 +1371,7 @@ LDi_bucketUser(const struct LDUser *const user, const char *const segmentKey,
     LD_ASSERT(salt);
     LD_ASSERT(bucket);
 
-    attributeValue = NULL;
-
-    if ((attributeValue = LDi_valueOfAttribute(user, attribute))) {
+    if ((attributeValue = LDi_lookupAttribute(user, attribute, &temporary))) {
         char raw[256], bucketableBuffer[256];
         const char *bucketable;
 
@@ -1140,7 +1388,7 @@ LDi_bucketUser(const struct LDUser *const user, const char *const segmentKey,
         }
 
         if (!bucketable) {
-            LDJSONFree(attributeValue);
+            LDJSONFree(temporary);
 
             return false;
         }
@@ -1161,12 +1409,12 @@ LDi_bucketUser(const struct LDUser *const user, const char *const segmentKey,
 
             *bucket = (float)strtoll(encoded, NULL, 16) / longScale;
 
-            LDJSONFree(attributeValue);
+            LDJSONFree(temporary);
 
             return true;
         }
 
-        LDJSONFree(attributeValue);
+        LDJSONFree(temporary);
     }
 
     return false;
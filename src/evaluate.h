@@ -24,22 +24,38 @@ typedef enum {
 
 bool LDi_isEvalError(const EvalStatus status);
 
+struct LDEvalMemoEntry;
+struct LDEvalSegmentEntry;
+
+/* Prerequisites already evaluated for one user by flag key and version, and
+segment membership by segment key and version, shared by the evaluations of
+one call so a common prerequisite or segment is evaluated once. Prepare with
+LDi_evalMemoInit, release with LDi_evalMemoClear. */
+struct LDEvalMemo {
+    struct LDEvalMemoEntry *entries;
+    struct LDEvalSegmentEntry *segments;
+};
+
+void LDi_evalMemoInit(struct LDEvalMemo *const memo);
+
+void LDi_evalMemoClear(struct LDEvalMemo *const memo);
+
+/* memo may be NULL. Prerequisite cycles are a schema error. */
 EvalStatus LDi_evaluate(struct LDClient *const client,
     const struct LDJSON *const flag, const struct LDUser *const user,
     struct LDStore *const store, struct LDDetails *const details,
     struct LDJSON **const o_events, struct LDJSON **const o_value,
-    const bool recordReason);
-
-EvalStatus LDi_checkPrerequisites(struct LDClient *const client,
-    const struct LDJSON *const flag, const struct LDUser *const user,
-    struct LDStore *const store, const char **const failedKey,
-    struct LDJSON **const events, const bool recordReason);
+    const bool recordReason, struct LDEvalMemo *const memo);
 
+/* memo may be NULL */
 EvalStatus LDi_ruleMatchesUser(const struct LDJSON *const rule,
-    const struct LDUser *const user, struct LDStore *const store);
+    const struct LDUser *const user, struct LDStore *const store,
+    struct LDEvalMemo *const memo);
 
+/* memo may be NULL */
 EvalStatus LDi_clauseMatchesUser(const struct LDJSON *const clause,
-    const struct LDUser *const user, struct LDStore *const store);
+    const struct LDUser *const user, struct LDStore *const store,
+    struct LDEvalMemo *const memo);
 
 EvalStatus LDi_segmentMatchesUser(const struct LDJSON *const segment,
     const struct LDUser *const user);
@@ -40,7 +40,12 @@ LDi_maybeMakeIndexEvent(struct LDClient *const client,
 
         client->lastUserKeyFlush = now;
     }
-    status = LDLRUInsert(client->userKeys, user->key);
+    if (user->prepared) {
+        status = LDLRUInsertHashed(client->userKeys, user->key,
+            user->prepared->keyHash);
+    } else {
+        status = LDLRUInsert(client->userKeys, user->key);
+    }
     LD_ASSERT(LDi_wrunlock(&client->lock));
 
     if (status == LDLRUSTATUS_ERROR) {
@@ -560,22 +565,22 @@ LDi_addEvent(struct LDClient *const client, struct LDJSON *const event)
     }
 }
 
-char *
-LDi_makeSummaryKey(const struct LDJSON *const event)
+bool
+LDi_makeSummaryKey(const struct LDJSON *const event,
+    struct LDJSONBuffer *const keytext)
 {
-    char *keytext;
     struct LDJSON *key, *tmp;
 
     LD_ASSERT(event);
+    LD_ASSERT(keytext);
 
-    tmp     = NULL;
-    keytext = NULL;
-    key     = NULL;
+    tmp = NULL;
+    key = NULL;
 
     if (!(key = LDNewObject())) {
         LD_LOG(LD_LOG_ERROR, "alloc error");
 
-        return NULL;
+        return false;
     }
 
     tmp = LDObjectLookup(event, "variation");
@@ -588,7 +593,7 @@ LDi_makeSummaryKey(const struct LDJSON *const event)
 
             LDJSONFree(key);
 
-            return NULL;
+            return false;
         }
 
         if (!LDObjectSetKey(key, "variation", tmp)) {
@@ -597,7 +602,7 @@ LDi_makeSummaryKey(const struct LDJSON *const event)
             LDJSONFree(key);
             LDJSONFree(tmp);
 
-            return NULL;
+            return false;
         }
     }
 
@@ -611,7 +616,7 @@ LDi_makeSummaryKey(const struct LDJSON *const event)
 
             LDJSONFree(key);
 
-            return NULL;
+            return false;
         }
 
         if (!LDObjectSetKey(key, "version", tmp)) {
@@ -620,55 +625,46 @@ LDi_makeSummaryKey(const struct LDJSON *const event)
             LDJSONFree(key);
             LDJSONFree(tmp);
 
-            return NULL;
+            return false;
         }
     }
 
-    if (!(keytext = LDJSONSerialize(key))) {
+    if (!LDi_JSONSerializeInto(key, keytext)) {
         LD_LOG(LD_LOG_ERROR, "alloc error");
 
         LDJSONFree(key);
 
-        return NULL;
+        return false;
     }
 
     LDJSONFree(key);
 
-    return keytext;
+    return true;
 }
 
-bool
-LDi_summarizeEvent(struct LDClient *const client,
-    const struct LDJSON *const event, const bool unknown)
+/* Expects write lock. Counts an event under the counter key in keytext. */
+static bool
+summarizeLocked(struct LDClient *const client,
+    const struct LDJSON *const event, const bool unknown,
+    const struct LDJSONBuffer *const keytext)
 {
-    char *keytext;
     const char *flagKey;
     struct LDJSON *tmp, *entry, *flagContext, *counters;
-    bool success;
 
     LD_ASSERT(client);
     LD_ASSERT(event);
+    LD_ASSERT(keytext);
 
-    keytext     = NULL;
     flagKey     = NULL;
     tmp         = NULL;
     entry       = NULL;
     flagContext = NULL;
     counters    = NULL;
-    success     = false;
 
     LD_ASSERT(tmp = LDObjectLookup(event, "key"));
     LD_ASSERT(LDJSONGetType(tmp) == LDText);
     LD_ASSERT(flagKey = LDGetText(tmp));
 
-    if (!(keytext = LDi_makeSummaryKey(event))) {
-        LD_LOG(LD_LOG_ERROR, "alloc error");
-
-        return false;
-    }
-
-    LD_ASSERT(LDi_wrlock(&client->lock));
-
     if (client->summaryStart == 0) {
         unsigned long now;
 
@@ -681,7 +677,7 @@ LDi_summarizeEvent(struct LDClient *const client,
         if (!(flagContext = LDNewObject())) {
             LD_LOG(LD_LOG_ERROR, "alloc error");
 
-            goto cleanup;
+            return false;
         }
 
         tmp = LDObjectLookup(event, "default");
@@ -692,7 +688,7 @@ LDi_summarizeEvent(struct LDClient *const client,
 
                 LDJSONFree(flagContext);
 
-                goto cleanup;
+                return false;
             }
 
             if (!LDObjectSetKey(flagContext, "default", tmp)) {
@@ -701,7 +697,7 @@ LDi_summarizeEvent(struct LDClient *const client,
                 LDJSONFree(tmp);
                 LDJSONFree(flagContext);
 
-                goto cleanup;
+                return false;
             }
         }
 
@@ -710,7 +706,7 @@ LDi_summarizeEvent(struct LDClient *const client,
 
             LDJSONFree(flagContext);
 
-            goto cleanup;
+            return false;
         }
 
         if (!LDObjectSetKey(flagContext, "counters", tmp)) {
@@ -719,7 +715,7 @@ LDi_summarizeEvent(struct LDClient *const client,
             LDJSONFree(tmp);
             LDJSONFree(flagContext);
 
-            goto cleanup;
+            return false;
         }
 
         if (!LDObjectSetKey(client->summaryCounters, flagKey, flagContext)) {
@@ -727,18 +723,18 @@ LDi_summarizeEvent(struct LDClient *const client,
 
             LDJSONFree(flagContext);
 
-            goto cleanup;
+            return false;
         }
     }
 
     LD_ASSERT(counters = LDObjectLookup(flagContext, "counters"));
     LD_ASSERT(LDJSONGetType(counters) == LDObject);
 
-    if (!(entry = LDObjectLookup(counters, keytext))) {
+    if (!(entry = LDObjectLookup(counters, keytext->text))) {
         if (!(entry = LDNewObject())) {
             LD_LOG(LD_LOG_ERROR, "alloc error");
 
-            goto cleanup;
+            return false;
         }
 
         if (!(tmp = LDNewNumber(1))) {
@@ -746,7 +742,7 @@ LDi_summarizeEvent(struct LDClient *const client,
 
             LDJSONFree(entry);
 
-            goto cleanup;
+            return false;
         }
 
         if (!LDObjectSetKey(entry, "count", tmp)) {
@@ -755,7 +751,7 @@ LDi_summarizeEvent(struct LDClient *const client,
             LDJSONFree(tmp);
             LDJSONFree(entry);
 
-            goto cleanup;
+            return false;
         }
 
         tmp = LDObjectLookup(event, "value");
@@ -766,7 +762,7 @@ LDi_summarizeEvent(struct LDClient *const client,
 
                 LDJSONFree(entry);
 
-                goto cleanup;
+                return false;
             }
 
             if (!LDObjectSetKey(entry, "value", tmp)) {
@@ -775,7 +771,7 @@ LDi_summarizeEvent(struct LDClient *const client,
                 LDJSONFree(tmp);
                 LDJSONFree(entry);
 
-                goto cleanup;
+                return false;
             }
         }
 
@@ -787,7 +783,7 @@ LDi_summarizeEvent(struct LDClient *const client,
 
                 LDJSONFree(entry);
 
-                goto cleanup;
+                return false;
             }
 
             if (!LDObjectSetKey(entry, "version", tmp)) {
@@ -796,7 +792,7 @@ LDi_summarizeEvent(struct LDClient *const client,
                 LDJSONFree(tmp);
                 LDJSONFree(entry);
 
-                goto cleanup;
+                return false;
             }
         }
 
@@ -808,7 +804,7 @@ LDi_summarizeEvent(struct LDClient *const client,
 
                 LDJSONFree(entry);
 
-                goto cleanup;
+                return false;
             }
 
             if (!LDObjectSetKey(entry, "variation", tmp)) {
@@ -817,7 +813,7 @@ LDi_summarizeEvent(struct LDClient *const client,
                 LDJSONFree(tmp);
                 LDJSONFree(entry);
 
-                goto cleanup;
+                return false;
             }
         }
 
@@ -827,7 +823,7 @@ LDi_summarizeEvent(struct LDClient *const client,
 
                 LDJSONFree(entry);
 
-                goto cleanup;
+                return false;
             }
 
             if (!LDObjectSetKey(entry, "unknown", tmp)) {
@@ -836,38 +832,131 @@ LDi_summarizeEvent(struct LDClient *const client,
                 LDJSONFree(tmp);
                 LDJSONFree(entry);
 
-                goto cleanup;
+                return false;
             }
         }
 
-        if (!LDObjectSetKey(counters, keytext, entry)) {
+        if (!LDObjectSetKey(counters, keytext->text, entry)) {
             LD_LOG(LD_LOG_ERROR, "alloc error");
 
             LDJSONFree(entry);
 
-            goto cleanup;
+            return false;
         }
     } else {
         LD_ASSERT(tmp = LDObjectLookup(entry, "count"));
         LD_ASSERT(LDSetNumber(tmp, LDGetNumber(tmp) + 1));
     }
 
+    return true;
+}
+
+bool
+LDi_summarizeEvent(struct LDClient *const client,
+    const struct LDJSON *const event, const bool unknown)
+{
+    struct LDJSONBuffer keytext;
+    /* summary keys are short enough to stay on the stack */
+    char keyStorage[128];
+    bool success;
+
+    LD_ASSERT(client);
+    LD_ASSERT(event);
+
+    LDi_JSONBufferInit(&keytext, keyStorage, sizeof(keyStorage));
+
+    if (!LDi_makeSummaryKey(event, &keytext)) {
+        LD_LOG(LD_LOG_ERROR, "alloc error");
+
+        LDi_JSONBufferFree(&keytext);
+
+        return false;
+    }
+
+    LD_ASSERT(LDi_wrlock(&client->lock));
+    success = summarizeLocked(client, event, unknown, &keytext);
+    LD_ASSERT(LDi_wrunlock(&client->lock));
+
+    LDi_JSONBufferFree(&keytext);
+
+    return success;
+}
+
+bool
+LDi_summarizeEvents(struct LDClient *const client,
+    const struct LDJSON *const events, const bool unknown)
+{
+    struct LDJSONBuffer keytext;
+    char keyStorage[128];
+    struct LDJSON *iter;
+    bool success;
+
+    LD_ASSERT(client);
+    LD_ASSERT(events);
+    LD_ASSERT(LDJSONGetType(events) == LDArray);
+
     success = true;
 
-  cleanup:
+    LDi_JSONBufferInit(&keytext, keyStorage, sizeof(keyStorage));
+
+    LD_ASSERT(LDi_wrlock(&client->lock));
+
+    for (iter = LDGetIter(events); iter; iter = LDIterNext(iter)) {
+        if (!LDi_makeSummaryKey(iter, &keytext)) {
+            LD_LOG(LD_LOG_ERROR, "alloc error");
+
+            success = false;
+
+            break;
+        }
+
+        if (!summarizeLocked(client, iter, unknown, &keytext)) {
+            success = false;
+
+            break;
+        }
+    }
+
     LD_ASSERT(LDi_wrunlock(&client->lock));
 
-    LDFree(keytext);
+    LDi_JSONBufferFree(&keytext);
 
     return success;
 }
 
+void
+LDi_reportFlush(struct LDClient *const client,
+    const unsigned long generation, const bool success)
+{
+    LD_ASSERT(client);
+
+    LD_ASSERT(LDi_mtxlock(&client->flushLock));
+    if (success) {
+        if (generation > client->flushCompleted) {
+            client->flushCompleted = generation;
+        }
+    } else {
+        if (generation > client->flushFailed) {
+            client->flushFailed = generation;
+        }
+    }
+    LD_ASSERT(LDi_mtxunlock(&client->flushLock));
+
+    LDi_condsignal(&client->flushCond);
+}
+
+/* a payload buffer larger than this is freed after delivery */
+#define LD_PAYLOAD_RETAIN_BYTES (1024 * 1024)
+
 struct AnalyticsContext {
     bool active;
+    /* flush generation covered by the current payload */
+    unsigned long generation;
     unsigned long lastFlush;
     struct curl_slist *headers;
     struct LDClient *client;
-    char *buffer;
+    /* the serialized events, reused across flushes */
+    struct LDJSONBuffer payload;
     bool lastFailed;
     char payloadId[LD_UUID_SIZE + 1];
 };
@@ -880,8 +969,10 @@ resetMemory(struct AnalyticsContext *const context)
     curl_slist_free_all(context->headers);
     context->headers = NULL;
 
-    LDFree(context->buffer);
-    context->buffer = NULL;
+    /* keeps the memory of ordinary payloads for the next flush */
+    if (context->payload.capacity > LD_PAYLOAD_RETAIN_BYTES) {
+        LDi_JSONBufferFree(&context->payload);
+    }
 }
 
 static void
@@ -901,13 +992,18 @@ done(struct LDClient *const client, void *const rawcontext, const bool success)
 
     if (success) {
         LD_ASSERT(LDi_wrlock(&client->lock));
-        client->shouldFlush = false;
+        /* another flush may have been requested while this one was active */
+        if (client->flushRequested == context->generation) {
+            client->shouldFlush = false;
+        }
         LD_ASSERT(LDi_wrunlock(&client->lock));
 
         LD_ASSERT(LDi_getMonotonicMilliseconds(&context->lastFlush));
 
         resetMemory(context);
     }
+
+    LDi_reportFlush(client, context->generation, success);
 }
 
 static void
@@ -922,6 +1018,7 @@ destroy(void *const rawcontext)
     LD_LOG(LD_LOG_INFO, "analytics destroyed");
 
     resetMemory(context);
+    LDi_JSONBufferFree(&context->payload);
 
     LDFree(context);
 }
@@ -1191,9 +1288,15 @@ poll(struct LDClient *const client, void *const rawcontext)
         if (LDCollectionGetSize(client->events) == 0 &&
             LDCollectionGetSize(client->summaryCounters) == 0)
         {
-            LD_ASSERT(LDi_wrunlock(&client->lock));
+            unsigned long generation;
 
             client->shouldFlush = false;
+            generation          = client->flushRequested;
+
+            LD_ASSERT(LDi_wrunlock(&client->lock));
+
+            /* nothing to deliver so any pending flush is complete */
+            LDi_reportFlush(client, generation, true);
 
             return NULL;
         }
@@ -1244,7 +1347,7 @@ poll(struct LDClient *const client, void *const rawcontext)
 
         LDArrayPush(client->events, summaryEvent);
 
-        if (!(context->buffer = LDJSONSerialize(client->events))) {
+        if (!LDi_JSONSerializeInto(client->events, &context->payload)) {
             LD_LOG(LD_LOG_ERROR, "alloc error");
 
             LD_ASSERT(LDi_wrunlock(&client->lock));
@@ -1258,6 +1361,7 @@ poll(struct LDClient *const client, void *const rawcontext)
         LDJSONFree(client->events);
         LDJSONFree(client->summaryCounters);
 
+        context->generation     = client->flushRequested;
         client->summaryStart    = 0;
         client->events          = nextEvents;
         client->summaryCounters = nextSummaryCounters;
@@ -1346,7 +1450,13 @@ poll(struct LDClient *const client, void *const rawcontext)
 
     /* add outgoing buffer */
 
-    if (curl_easy_setopt(curl, CURLOPT_POSTFIELDS, context->buffer)
+    if (curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE,
+        (long)context->payload.length) != CURLE_OK)
+    {
+        goto error;
+    }
+
+    if (curl_easy_setopt(curl, CURLOPT_POSTFIELDS, context->payload.text)
         != CURLE_OK)
     {
         goto error;
@@ -1388,11 +1498,13 @@ LDi_constructAnalytics(struct LDClient *const client)
     }
 
     context->active     = false;
+    context->generation = 0;
     context->headers    = NULL;
     context->client     = client;
-    context->buffer     = NULL;
     context->lastFailed = false;
 
+    LDi_JSONBufferInit(&context->payload, NULL, 0);
+
     LD_ASSERT(LDi_getMonotonicMilliseconds(&context->lastFlush));
 
     netInterface->done      = done;
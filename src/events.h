@@ -11,6 +11,8 @@
 
 #include <launchdarkly/variations.h>
 
+#include "misc.h"
+
 /* event construction */
 struct LDJSON *LDi_newBaseEvent(const char *const kind);
 
@@ -38,10 +40,20 @@ void LDi_addEvent(struct LDClient *const client,
 bool LDi_summarizeEvent(struct LDClient *const client,
     const struct LDJSON *const event, const bool unknown);
 
-char *LDi_makeSummaryKey(const struct LDJSON *const event);
+/* summarizes an array of events under a single acquisition of the lock */
+bool LDi_summarizeEvents(struct LDClient *const client,
+    const struct LDJSON *const events, const bool unknown);
+
+/* writes the key of the counter of an event into keytext */
+bool LDi_makeSummaryKey(const struct LDJSON *const event,
+    struct LDJSONBuffer *const keytext);
 
 struct LDJSON *LDi_prepareSummaryEvent(struct LDClient *const client);
 
+/* wakes any LDClientFlushWait callers waiting on generation */
+void LDi_reportFlush(struct LDClient *const client,
+    const unsigned long generation, const bool success);
+
 size_t LDi_onHeader(const char *const buffer, const size_t size,
     const size_t itemcount, void *const context);
 
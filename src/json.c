@@ -1,9 +1,629 @@
+#include <math.h>
+
 #include "cJSON.h"
 
 #include <launchdarkly/api.h>
 
 #include "misc.h"
 
+/* Objects reaching this many members carry a hash index over them, kept up
+to date by every function in this file that changes an object. Smaller
+objects are scanned. */
+#define LD_JSON_INDEX_THRESHOLD 16
+
+/* Texts at least this long are parsed by LDi_JSONParseIndexed, which pays
+off once there is enough text to index */
+#define LD_JSON_INDEXED_PARSE_THRESHOLD 16384
+
+struct IndexSlot {
+    unsigned int hash;
+    /* NULL when the slot is empty */
+    cJSON *member;
+};
+
+/* A single allocation owned by the cJSON object, which frees it unless it
+came from an arena */
+struct ObjectIndex {
+    /* the arena of the object, as the index takes its place in the item */
+    struct JSONArena *arena;
+    bool inArena;
+    cJSON *tail;
+    unsigned int members;
+    /* occupied slots, lower than members if a key is repeated */
+    unsigned int used;
+    /* a power of two, kept at least twice used */
+    unsigned int capacity;
+    /* the object was parsed with a repeated key, only the first member with
+    a key is indexed as that is the one lookups return */
+    bool duplicates;
+    struct IndexSlot slots[];
+};
+
+/* Trees parsed by LDi_JSONDeserializeArena are bump allocated from chunks
+owned by one arena. Their items are marked with cJSON_InArena and point to
+the arena, or to an index that does, instead of being freed one by one.
+Each detached subtree is a root holding a reference on the arena, which is
+freed with the last of them. Linking a root back into its own arena drops
+its reference again, and keys given to arena items are copied into their
+arena, so the usual reshaping of a payload keeps it entirely in the arena.
+Anything else linked into an arena item marks the arena as mixed, and
+releasing its items then walks them to free what came from the heap. */
+
+#define LD_ARENA_ALIGNMENT 8
+/* chunk bytes per byte of text parsed, flag payloads take between six and
+seven so a single flag fits the first chunk */
+#define LD_ARENA_TEXT_RATIO 8
+#define LD_ARENA_MINIMUM_CHUNK 1024
+/* larger payloads take several chunks, as huge blocks are kept or returned
+to the system by the allocator less predictably */
+#define LD_ARENA_MAXIMUM_CHUNK (256 * 1024)
+
+struct ArenaChunk {
+    struct ArenaChunk *next;
+    size_t size;
+    size_t used;
+};
+
+struct JSONArena {
+    ld_mutex_t lock;
+    /* roots referencing the arena, guarded by lock */
+    unsigned int references;
+    /* heap items were linked into arena items, guarded by lock */
+    bool mixed;
+    /* the current chunk first, guarded by lock once parsing is done */
+    struct ArenaChunk *chunks;
+    size_t chunkSize;
+};
+
+/* set while this thread parses into an arena, all cJSON allocations are
+taken from it and frees ignored */
+static LD_THREAD_LOCAL struct JSONArena *parseArena = NULL;
+/* the hooks honoring parseArena are installed */
+static bool arenaAvailable = false;
+
+#define LD_ARENA_ALIGN(bytes) \
+    (((bytes) + LD_ARENA_ALIGNMENT - 1) & ~(size_t)(LD_ARENA_ALIGNMENT - 1))
+
+static struct JSONArena *
+newArena(const size_t textLength)
+{
+    struct JSONArena *arena;
+
+    if (!(arena = (struct JSONArena *)LDAlloc(sizeof(struct JSONArena)))) {
+        return NULL;
+    }
+
+    LD_ASSERT(LDi_mtxinit(&arena->lock));
+
+    arena->references = 0;
+    arena->mixed      = false;
+    arena->chunks     = NULL;
+    arena->chunkSize  = textLength * LD_ARENA_TEXT_RATIO;
+
+    if (arena->chunkSize < LD_ARENA_MINIMUM_CHUNK) {
+        arena->chunkSize = LD_ARENA_MINIMUM_CHUNK;
+    } else if (arena->chunkSize > LD_ARENA_MAXIMUM_CHUNK) {
+        arena->chunkSize = LD_ARENA_MAXIMUM_CHUNK;
+    }
+
+    return arena;
+}
+
+static void
+freeArena(struct JSONArena *const arena)
+{
+    struct ArenaChunk *chunk, *next;
+
+    for (chunk = arena->chunks; chunk; chunk = next) {
+        next = chunk->next;
+
+        LDFree(chunk);
+    }
+
+    LD_ASSERT(LDi_mtxdestroy(&arena->lock));
+
+    LDFree(arena);
+}
+
+/* expects the arena lock once parsing is done */
+static void *
+arenaAllocate(struct JSONArena *const arena, const size_t bytes)
+{
+    const size_t header = LD_ARENA_ALIGN(sizeof(struct ArenaChunk));
+    const size_t aligned = LD_ARENA_ALIGN(bytes);
+    struct ArenaChunk *chunk;
+    void *result;
+
+    chunk = arena->chunks;
+
+    if (!chunk || chunk->size - chunk->used < aligned) {
+        size_t size;
+
+        size = arena->chunkSize;
+
+        if (size < aligned) {
+            size = aligned;
+        }
+
+        if (!(chunk = (struct ArenaChunk *)LDAlloc(header + size))) {
+            return NULL;
+        }
+
+        chunk->next   = arena->chunks;
+        chunk->size   = size;
+        chunk->used   = 0;
+        arena->chunks = chunk;
+    }
+
+    result = (char *)chunk + header + chunk->used;
+
+    chunk->used += aligned;
+
+    return result;
+}
+
+static void *
+jsonAllocate(size_t bytes)
+{
+    struct JSONArena *const arena = parseArena;
+
+    if (arena) {
+        return arenaAllocate(arena, bytes);
+    }
+
+    return LDAlloc(bytes);
+}
+
+static void
+jsonFree(void *const buffer)
+{
+    /* only a failed parse frees while parsing, and the arena goes with it */
+    if (!parseArena) {
+        LDFree(buffer);
+    }
+}
+
+static struct JSONArena *
+nodeArena(const cJSON *const node)
+{
+    if (!(node->type & cJSON_InArena)) {
+        return NULL;
+    }
+
+    if (node->type & cJSON_ArenaIndexed) {
+        return ((struct ObjectIndex *)node->index)->arena;
+    }
+
+    return (struct JSONArena *)node->index;
+}
+
+static struct ObjectIndex *
+objectIndex(const cJSON *const node)
+{
+    if ((node->type & cJSON_InArena) && !(node->type & cJSON_ArenaIndexed)) {
+        return NULL;
+    }
+
+    return (struct ObjectIndex *)node->index;
+}
+
+/* index may be NULL to leave the object unindexed */
+static void
+replaceIndex(cJSON *const object, struct ObjectIndex *const index)
+{
+    struct ObjectIndex *const previous = objectIndex(object);
+    struct JSONArena *const arena = nodeArena(object);
+
+    if (previous && !previous->inArena) {
+        cJSON_free(previous);
+    }
+
+    if (!arena) {
+        object->index = index;
+    } else if (index) {
+        index->arena  = arena;
+        object->index = index;
+        object->type  |= cJSON_ArenaIndexed;
+    } else {
+        object->index = arena;
+        object->type  &= ~cJSON_ArenaIndexed;
+    }
+}
+
+static void
+adoptTree(cJSON *const node, struct JSONArena *const arena)
+{
+    cJSON *child;
+
+    for (child = node->child; child; child = child->next) {
+        adoptTree(child, arena);
+    }
+
+    node->type  |= cJSON_InArena;
+    node->index = arena;
+
+    /* freed with the arena */
+    if (node->string) {
+        node->type |= cJSON_StringIsConst;
+    }
+}
+
+static void
+dropReference(struct JSONArena *const arena)
+{
+    bool last;
+
+    LD_ASSERT(LDi_mtxlock(&arena->lock));
+    LD_ASSERT(arena->references);
+    last = --arena->references == 0;
+    LD_ASSERT(LDi_mtxunlock(&arena->lock));
+
+    if (last) {
+        freeArena(arena);
+    }
+}
+
+/* an arena item leaving its container becomes a root */
+static void
+makeRoot(cJSON *const node)
+{
+    struct JSONArena *arena;
+
+    if (!(arena = nodeArena(node)) || (node->type & cJSON_ArenaRoot)) {
+        return;
+    }
+
+    LD_ASSERT(LDi_mtxlock(&arena->lock));
+    arena->references++;
+    LD_ASSERT(LDi_mtxunlock(&arena->lock));
+
+    node->type |= cJSON_ArenaRoot;
+}
+
+/* called before linking an item into a container */
+static void
+noteLink(cJSON *const container, cJSON *const item)
+{
+    struct JSONArena *arena;
+
+    if (!(arena = nodeArena(container))) {
+        return;
+    }
+
+    if (nodeArena(item) == arena) {
+        if (item->type & cJSON_ArenaRoot) {
+            item->type &= ~cJSON_ArenaRoot;
+
+            /* the container holds a reference as well */
+            dropReference(arena);
+        }
+
+        return;
+    }
+
+    LD_ASSERT(LDi_mtxlock(&arena->lock));
+    arena->mixed = true;
+    LD_ASSERT(LDi_mtxunlock(&arena->lock));
+}
+
+/* a copy of key owned by item, which keeps it constant in an arena */
+static char *
+copyKey(const cJSON *const item, const char *const key)
+{
+    struct JSONArena *const arena = nodeArena(item);
+    char *copy;
+
+    if (arena) {
+        LD_ASSERT(LDi_mtxlock(&arena->lock));
+        copy = (char *)arenaAllocate(arena, strlen(key) + 1);
+        LD_ASSERT(LDi_mtxunlock(&arena->lock));
+    } else {
+        copy = (char *)cJSON_malloc(strlen(key) + 1);
+    }
+
+    if (copy) {
+        strcpy(copy, key);
+    }
+
+    return copy;
+}
+
+static void releaseArenaItem(cJSON *const node);
+
+/* frees what an arena item gained from the heap after parsing */
+static void
+releaseHeapParts(cJSON *const node, const bool mixed)
+{
+    struct ObjectIndex *index;
+    cJSON *child, *next;
+
+    if (!(node->type & cJSON_StringIsConst)) {
+        cJSON_free(node->string);
+    }
+
+    if ((index = objectIndex(node)) && !index->inArena) {
+        cJSON_free(index);
+    }
+
+    if (!mixed) {
+        return;
+    }
+
+    for (child = node->child; child; child = next) {
+        next = child->next;
+
+        if (!(child->type & cJSON_InArena)) {
+            child->next = NULL;
+
+            cJSON_Delete(child);
+        } else if (child->type & cJSON_ArenaRoot) {
+            releaseArenaItem(child);
+        } else {
+            releaseHeapParts(child, mixed);
+        }
+    }
+}
+
+/* the cJSON_Delete hook */
+static void
+releaseArenaItem(cJSON *const node)
+{
+    struct JSONArena *const arena = nodeArena(node);
+    bool mixed;
+
+    LD_ASSERT(LDi_mtxlock(&arena->lock));
+    mixed = arena->mixed;
+    LD_ASSERT(LDi_mtxunlock(&arena->lock));
+
+    releaseHeapParts(node, mixed);
+
+    if (node->type & cJSON_ArenaRoot) {
+        dropReference(arena);
+    }
+}
+
+void
+LDi_initJSON()
+{
+    struct cJSON_Hooks hooks;
+
+    hooks.malloc_fn = jsonAllocate;
+    hooks.free_fn   = jsonFree;
+
+    cJSON_InitHooks(&hooks);
+    cJSON_InitArenaHook(releaseArenaItem);
+
+    arenaAvailable = true;
+}
+
+/* FNV-1a */
+static unsigned int
+hashKey(const char *key)
+{
+    unsigned int hash;
+
+    hash = 2166136261u;
+
+    for (; *key; key++) {
+        hash ^= (unsigned char)*key;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static struct ObjectIndex *
+allocateIndex(const unsigned int capacity)
+{
+    struct ObjectIndex *index;
+    size_t bytes;
+
+    bytes = sizeof(struct ObjectIndex) + sizeof(struct IndexSlot) * capacity;
+
+    if (!(index = (struct ObjectIndex *)cJSON_malloc(bytes))) {
+        return NULL;
+    }
+
+    memset(index, 0, bytes);
+
+    index->inArena  = parseArena != NULL;
+    index->capacity = capacity;
+
+    return index;
+}
+
+static struct IndexSlot *
+indexFind(struct ObjectIndex *const index, const char *const key,
+    const unsigned int hash)
+{
+    unsigned int position;
+
+    for (position = hash & (index->capacity - 1);
+        index->slots[position].member;
+        position = (position + 1) & (index->capacity - 1))
+    {
+        struct IndexSlot *const slot = &index->slots[position];
+
+        if (slot->hash == hash && strcmp(slot->member->string, key) == 0) {
+            return slot;
+        }
+    }
+
+    return NULL;
+}
+
+/* expects the key to be absent and a free slot */
+static void
+indexPlace(struct ObjectIndex *const index, cJSON *const member,
+    const unsigned int hash)
+{
+    unsigned int position;
+
+    position = hash & (index->capacity - 1);
+
+    while (index->slots[position].member) {
+        position = (position + 1) & (index->capacity - 1);
+    }
+
+    index->slots[position].hash   = hash;
+    index->slots[position].member = member;
+
+    index->used++;
+}
+
+/* Shifts later entries of the probe sequence back instead of leaving a
+tombstone, so lookups never scan removed entries. */
+static void
+indexRemoveSlot(struct ObjectIndex *const index, struct IndexSlot *const slot)
+{
+    unsigned int hole, next, home, mask;
+
+    mask = index->capacity - 1;
+    hole = slot - index->slots;
+    next = hole;
+
+    while (true) {
+        next = (next + 1) & mask;
+
+        if (!index->slots[next].member) {
+            break;
+        }
+
+        home = index->slots[next].hash & mask;
+
+        /* the entry may fill the hole unless its home is cyclically
+        between the hole and itself */
+        if (hole <= next ? (home <= hole || home > next) :
+            (home <= hole && home > next))
+        {
+            index->slots[hole] = index->slots[next];
+            hole               = next;
+        }
+    }
+
+    index->slots[hole].member = NULL;
+
+    index->used--;
+}
+
+/* Indexes the members of an object from scratch. On allocation failure
+the object is left without an index and is scanned instead. */
+static void
+buildIndex(cJSON *const object, const unsigned int members)
+{
+    struct ObjectIndex *index;
+    unsigned int capacity;
+    cJSON *member;
+
+    capacity = 32;
+
+    while (capacity < members * 2) {
+        capacity *= 2;
+    }
+
+    if (!(index = allocateIndex(capacity))) {
+        replaceIndex(object, NULL);
+
+        return;
+    }
+
+    for (member = object->child; member; member = member->next) {
+        const unsigned int hash = hashKey(member->string);
+
+        if (indexFind(index, member->string, hash)) {
+            index->duplicates = true;
+        } else {
+            indexPlace(index, member, hash);
+        }
+
+        index->tail = member;
+        index->members++;
+    }
+
+    replaceIndex(object, index);
+}
+
+static void
+indexIfLarge(cJSON *const object)
+{
+    unsigned int members;
+    cJSON *member;
+
+    if (objectIndex(object)) {
+        return;
+    }
+
+    members = 0;
+
+    for (member = object->child; member; member = member->next) {
+        members++;
+    }
+
+    if (members >= LD_JSON_INDEX_THRESHOLD) {
+        buildIndex(object, members);
+    }
+}
+
+/* for trees built by cJSON directly */
+static void
+indexTree(cJSON *const node)
+{
+    cJSON *child;
+
+    if (!cJSON_IsObject(node) && !cJSON_IsArray(node)) {
+        return;
+    }
+
+    for (child = node->child; child; child = child->next) {
+        indexTree(child);
+    }
+
+    if (cJSON_IsObject(node)) {
+        indexIfLarge(node);
+    }
+}
+
+/* unlinks a member of an object, keeping the index current */
+static cJSON *
+detachMember(cJSON *const object, cJSON *const member)
+{
+    struct ObjectIndex *index;
+
+    if ((index = objectIndex(object))) {
+        const unsigned int hash = hashKey(member->string);
+        struct IndexSlot *slot;
+
+        if ((slot = indexFind(index, member->string, hash)) &&
+            slot->member == member)
+        {
+            indexRemoveSlot(index, slot);
+
+            /* a later member with the same key becomes visible */
+            if (index->duplicates) {
+                cJSON *other;
+
+                for (other = member->next; other; other = other->next) {
+                    if (strcmp(other->string, member->string) == 0) {
+                        indexPlace(index, other, hash);
+
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (index->tail == member) {
+            index->tail = member->prev;
+        }
+
+        index->members--;
+    }
+
+    makeRoot(member);
+
+    return cJSON_DetachItemViaPointer(object, member);
+}
+
 struct LDJSON *
 LDNewNull()
 {
@@ -64,9 +684,15 @@ LDJSONFree(struct LDJSON *const json)
 struct LDJSON *
 LDJSONDuplicate(const struct LDJSON *const input)
 {
+    cJSON *duplicate;
+
     LD_ASSERT(input);
 
-    return (struct LDJSON *)cJSON_Duplicate((cJSON *)input, true);
+    if ((duplicate = cJSON_Duplicate((cJSON *)input, true))) {
+        indexTree(duplicate);
+    }
+
+    return (struct LDJSON *)duplicate;
 }
 
 LDJSONType
@@ -170,10 +796,15 @@ unsigned int
 LDCollectionGetSize(const struct LDJSON *const rawcollection)
 {
     cJSON *const collection = (cJSON *)rawcollection;
+    struct ObjectIndex *index;
 
     LD_ASSERT(collection);
     LD_ASSERT(cJSON_IsArray(collection) || cJSON_IsObject(collection));
 
+    if ((index = objectIndex(collection))) {
+        return index->members;
+    }
+
     /* works for objects */
     return cJSON_GetArraySize(collection);
 }
@@ -189,7 +820,7 @@ LDCollectionDetachIter(struct LDJSON *const rawcollection,
     LD_ASSERT(cJSON_IsArray(collection) || cJSON_IsObject(collection));
     LD_ASSERT(iter);
 
-    return (struct LDJSON *)cJSON_DetachItemViaPointer(collection, iter);
+    return (struct LDJSON *)detachMember(collection, iter);
 }
 
 struct LDJSON *
@@ -212,6 +843,8 @@ LDArrayPush(struct LDJSON *const rawarray, struct LDJSON *const item)
     LD_ASSERT(cJSON_IsArray(array));
     LD_ASSERT(item);
 
+    noteLink(array, (cJSON *)item);
+
     cJSON_AddItemToArray(array, (cJSON *)item);
 
     return true;
@@ -237,12 +870,33 @@ LDArrayAppend(struct LDJSON *const rawprefix,
             return false;
         }
 
+        indexTree(dupe);
+
+        noteLink(prefix, dupe);
+
         cJSON_AddItemToArray(prefix, dupe);
     }
 
     return true;
 }
 
+static cJSON *
+findMember(const cJSON *const object, const char *const key)
+{
+    struct ObjectIndex *index;
+    struct IndexSlot *slot;
+
+    if (!(index = objectIndex(object))) {
+        return cJSON_GetObjectItemCaseSensitive(object, key);
+    }
+
+    if ((slot = indexFind(index, key, hashKey(key)))) {
+        return slot->member;
+    }
+
+    return NULL;
+}
+
 struct LDJSON *
 LDObjectLookup(const struct LDJSON *const rawobject, const char *const key)
 {
@@ -252,23 +906,95 @@ LDObjectLookup(const struct LDJSON *const rawobject, const char *const key)
     LD_ASSERT(cJSON_IsObject(object));
     LD_ASSERT(key);
 
-    return (struct LDJSON *)cJSON_GetObjectItemCaseSensitive(object, key);
+    return (struct LDJSON *)findMember(object, key);
 }
 
 bool
 LDObjectSetKey(struct LDJSON *const rawobject,
-    const char *const key, struct LDJSON *const item)
+    const char *const key, struct LDJSON *const rawitem)
 {
     cJSON *const object = (cJSON *)rawobject;
+    cJSON *const item = (cJSON *)rawitem;
+    struct ObjectIndex *index;
+    cJSON *existing;
+    char *keyCopy;
+    unsigned int hash;
 
     LD_ASSERT(object);
     LD_ASSERT(cJSON_IsObject(object));
     LD_ASSERT(key);
     LD_ASSERT(item);
 
-    cJSON_DeleteItemFromObjectCaseSensitive(object, key);
+    if (!(index = objectIndex(object)) && !nodeArena(item)) {
+        cJSON_DeleteItemFromObjectCaseSensitive(object, key);
+
+        noteLink(object, item);
+
+        cJSON_AddItemToObject(object, key, item);
+
+        indexIfLarge(object);
+
+        return true;
+    }
+
+    /* Copied first as the key may belong to the member being replaced. On
+    failure the item still belongs to the caller, as callers free it. */
+    if (!(keyCopy = copyKey(item, key))) {
+        return false;
+    }
+
+    if ((existing = findMember(object, keyCopy))) {
+        cJSON_Delete(detachMember(object, existing));
+    }
+
+    noteLink(object, item);
+
+    if (!(item->type & cJSON_StringIsConst)) {
+        cJSON_free(item->string);
+    }
+
+    item->string = keyCopy;
+
+    if (nodeArena(item)) {
+        item->type |= cJSON_StringIsConst;
+    } else {
+        item->type &= ~cJSON_StringIsConst;
+    }
+
+    if (!index) {
+        cJSON_AddItemToArray(object, item);
+
+        indexIfLarge(object);
+
+        return true;
+    }
+
+    /* appended through the index tail instead of walking the members */
+    if (index->tail) {
+        index->tail->next = item;
+        item->prev        = index->tail;
+    } else {
+        object->child = item;
+        item->prev    = NULL;
+    }
+
+    item->next  = NULL;
+    index->tail = item;
+    index->members++;
+
+    if ((index->used + 1) * 2 > index->capacity) {
+        /* rebuilding also refreshes the object index pointer */
+        buildIndex(object, index->members);
+
+        return true;
+    }
 
-    cJSON_AddItemToObject(object, key, (cJSON *)item);
+    hash = hashKey(keyCopy);
+
+    /* an earlier member with a repeated key still shadows the new one */
+    if (!index->duplicates || !indexFind(index, keyCopy, hash)) {
+        indexPlace(index, item, hash);
+    }
 
     return true;
 }
@@ -277,25 +1003,32 @@ void
 LDObjectDeleteKey(struct LDJSON *const rawobject, const char *const key)
 {
     cJSON *const object = (cJSON *)rawobject;
+    cJSON *member;
 
     LD_ASSERT(object);
     LD_ASSERT(cJSON_IsObject(object));
     LD_ASSERT(key);
 
-    cJSON_DeleteItemFromObjectCaseSensitive(object, key);
+    if ((member = findMember(object, key))) {
+        cJSON_Delete(detachMember(object, member));
+    }
 }
 
 struct LDJSON *
 LDObjectDetachKey(struct LDJSON *const rawobject, const char *const key)
 {
     cJSON *const object = (cJSON *)rawobject;
+    cJSON *member;
 
     LD_ASSERT(object);
     LD_ASSERT(cJSON_IsObject(object));
     LD_ASSERT(key);
 
-    return (struct LDJSON *)
-        cJSON_DetachItemFromObjectCaseSensitive(object, key);
+    if ((member = findMember(object, key))) {
+        return (struct LDJSON *)detachMember(object, member);
+    }
+
+    return NULL;
 }
 
 bool
@@ -321,18 +1054,474 @@ LDObjectMerge(struct LDJSON *const to, const struct LDJSON *const from)
     return true;
 }
 
+/* The serializer below writes the same text as cJSON_PrintUnformatted, into
+a buffer grown geometrically instead of sized by guessing, and formats
+common numbers without the sprintf and sscanf round trip of cJSON. */
+
+#define LD_JSON_BUFFER_MINIMUM 256
+
+void
+LDi_JSONBufferInit(struct LDJSONBuffer *const buffer, char *const storage,
+    const size_t storageSize)
+{
+    LD_ASSERT(buffer);
+    LD_ASSERT(storage || storageSize == 0);
+
+    buffer->text     = storage;
+    buffer->length   = 0;
+    buffer->capacity = storageSize;
+    buffer->owned    = false;
+}
+
+void
+LDi_JSONBufferFree(struct LDJSONBuffer *const buffer)
+{
+    LD_ASSERT(buffer);
+
+    if (buffer->owned) {
+        LDFree(buffer->text);
+    }
+
+    LDi_JSONBufferInit(buffer, NULL, 0);
+}
+
+/* room for bytes more and a terminator */
+static bool
+bufferReserve(struct LDJSONBuffer *const buffer, const size_t bytes)
+{
+    size_t capacity;
+    char *text;
+
+    if (buffer->capacity - buffer->length > bytes) {
+        return true;
+    }
+
+    capacity = buffer->capacity;
+
+    if (capacity < LD_JSON_BUFFER_MINIMUM) {
+        capacity = LD_JSON_BUFFER_MINIMUM;
+    }
+
+    while (capacity - buffer->length <= bytes) {
+        capacity *= 2;
+    }
+
+    if (buffer->owned) {
+        if (!(text = (char *)LDRealloc(buffer->text, capacity))) {
+            return false;
+        }
+    } else {
+        if (!(text = (char *)LDAlloc(capacity))) {
+            return false;
+        }
+
+        if (buffer->length) {
+            memcpy(text, buffer->text, buffer->length);
+        }
+    }
+
+    buffer->text     = text;
+    buffer->capacity = capacity;
+    buffer->owned    = true;
+
+    return true;
+}
+
+static bool
+bufferAppend(struct LDJSONBuffer *const buffer, const char *const text,
+    const size_t length)
+{
+    if (!bufferReserve(buffer, length)) {
+        return false;
+    }
+
+    memcpy(buffer->text + buffer->length, text, length);
+
+    buffer->length += length;
+
+    return true;
+}
+
+#define LD_SWAR_ONES UINT64_C(0x0101010101010101)
+#define LD_SWAR_HIGH UINT64_C(0x8080808080808080)
+
+/* Whether any of eight bytes is below 0x20, a quote, or a backslash, the
+bytes escaped by cJSON. May report bytes above an escaped one as well, which
+only ends a plain run early. */
+static bool
+wordNeedsEscape(const uint64_t word)
+{
+    const uint64_t quote = word ^ (LD_SWAR_ONES * '"');
+    const uint64_t slash = word ^ (LD_SWAR_ONES * '\\');
+
+    return (((word - LD_SWAR_ONES * 0x20) & ~word) |
+        ((quote - LD_SWAR_ONES) & ~quote) |
+        ((slash - LD_SWAR_ONES) & ~slash)) & LD_SWAR_HIGH;
+}
+
+static bool
+appendString(struct LDJSONBuffer *const buffer, const char *const text)
+{
+    const unsigned char *input;
+    size_t length, start, i;
+
+    if (!text) {
+        return bufferAppend(buffer, "\"\"", 2);
+    }
+
+    input  = (const unsigned char *)text;
+    length = strlen(text);
+
+    if (!bufferReserve(buffer, length + 2)) {
+        return false;
+    }
+
+    buffer->text[buffer->length++] = '"';
+
+    for (start = 0, i = 0; i < length; i++) {
+        char escape[8];
+        size_t escapeLength;
+
+        /* skips plain text eight bytes at a time */
+        while (length - i >= 8) {
+            uint64_t word;
+
+            memcpy(&word, input + i, sizeof(word));
+
+            if (wordNeedsEscape(word)) {
+                break;
+            }
+
+            i += 8;
+        }
+
+        if (i == length) {
+            break;
+        }
+
+        if (input[i] >= 0x20 && input[i] != '"' && input[i] != '\\') {
+            continue;
+        }
+
+        escape[0]    = '\\';
+        escapeLength = 2;
+
+        switch (input[i]) {
+            case '"':  escape[1] = '"';  break;
+            case '\\': escape[1] = '\\'; break;
+            case '\b': escape[1] = 'b';  break;
+            case '\f': escape[1] = 'f';  break;
+            case '\n': escape[1] = 'n';  break;
+            case '\r': escape[1] = 'r';  break;
+            case '\t': escape[1] = 't';  break;
+            default:
+                LD_ASSERT(snprintf(escape + 1, sizeof(escape) - 1, "u%04x",
+                    input[i]) == 5);
+
+                escapeLength = 6;
+        }
+
+        if (!bufferAppend(buffer, text + start, i - start) ||
+            !bufferAppend(buffer, escape, escapeLength))
+        {
+            return false;
+        }
+
+        start = i + 1;
+    }
+
+    return bufferAppend(buffer, text + start, length - start) &&
+        bufferAppend(buffer, "\"", 1);
+}
+
+static const double decimalPowers[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8
+};
+
+/* Formats numbers that cJSON prints without an exponent and with at most
+fifteen significant digits, which is all of them that read back from at
+most eight decimals. The digits read back exactly when dividing them by
+the power of ten does, both being exact doubles. Returns the length, or
+zero to fall back to sprintf. */
+static size_t
+formatDecimal(const double number, char *const output)
+{
+    char digits[24];
+    double magnitude, scaled;
+    uint64_t integer;
+    size_t decimals, count, skip, length, i;
+
+    if (number == 0) {
+        /* keeps the sign of negative zero */
+        if (signbit(number)) {
+            memcpy(output, "-0", 2);
+
+            return 2;
+        }
+
+        output[0] = '0';
+
+        return 1;
+    }
+
+    magnitude = number < 0 ? -number : number;
+
+    if (magnitude < 1e-4 || magnitude >= 1e15) {
+        return 0;
+    }
+
+    for (decimals = 0;; decimals++) {
+        if (decimals == sizeof(decimalPowers) / sizeof(decimalPowers[0])) {
+            return 0;
+        }
+
+        scaled = magnitude * decimalPowers[decimals];
+
+        if (scaled >= 1e15) {
+            return 0;
+        }
+
+        integer = (uint64_t)scaled;
+
+        if ((double)integer == scaled &&
+            (double)integer / decimalPowers[decimals] == magnitude)
+        {
+            break;
+        }
+    }
+
+    count = 0;
+
+    do {
+        digits[count++] = '0' + (char)(integer % 10);
+        integer /= 10;
+    } while (integer);
+
+    /* a digit before the point */
+    while (count <= decimals) {
+        digits[count++] = '0';
+    }
+
+    for (skip = 0; decimals && digits[skip] == '0'; skip++) {
+        decimals--;
+    }
+
+    length = 0;
+
+    if (number < 0) {
+        output[length++] = '-';
+    }
+
+    for (i = count; i > skip + decimals; i--) {
+        output[length++] = digits[i - 1];
+    }
+
+    if (decimals) {
+        output[length++] = '.';
+
+        for (; i > skip; i--) {
+            output[length++] = digits[i - 1];
+        }
+    }
+
+    return length;
+}
+
+static bool
+appendNumber(struct LDJSONBuffer *const buffer, const double number)
+{
+    char text[32], *point;
+    size_t length;
+    int printed;
+
+    /* NaN and infinities, as cJSON */
+    if (number * 0 != 0) {
+        return bufferAppend(buffer, "null", 4);
+    }
+
+    if ((length = formatDecimal(number, text))) {
+        return bufferAppend(buffer, text, length);
+    }
+
+    /* as cJSON, fifteen digits unless that does not read back */
+    if ((printed = snprintf(text, sizeof(text), "%1.15g", number)) > 0) {
+        double check;
+
+        if (sscanf(text, "%lg", &check) != 1 || check != number) {
+            printed = snprintf(text, sizeof(text), "%1.17g", number);
+        }
+    }
+
+    if (printed <= 0 || (size_t)printed >= sizeof(text)) {
+        return false;
+    }
+
+    /* as cJSON, printf follows the locale but JSON always uses '.' */
+    if ((point = memchr(text, LDi_decimalPoint(), (size_t)printed))) {
+        *point = '.';
+    }
+
+    return bufferAppend(buffer, text, (size_t)printed);
+}
+
+static bool
+serializeNode(struct LDJSONBuffer *const buffer, const cJSON *const node)
+{
+    const cJSON *child;
+
+    switch (node->type & 0xFF) {
+        case cJSON_NULL:
+            return bufferAppend(buffer, "null", 4);
+        case cJSON_False:
+            return bufferAppend(buffer, "false", 5);
+        case cJSON_True:
+            return bufferAppend(buffer, "true", 4);
+        case cJSON_Number:
+            return appendNumber(buffer, node->valuedouble);
+        case cJSON_String:
+            return appendString(buffer, node->valuestring);
+        case cJSON_Raw:
+            return node->valuestring && bufferAppend(buffer,
+                node->valuestring, strlen(node->valuestring));
+        case cJSON_Array:
+            if (!bufferAppend(buffer, "[", 1)) {
+                return false;
+            }
+
+            for (child = node->child; child; child = child->next) {
+                if ((child != node->child && !bufferAppend(buffer, ",", 1)) ||
+                    !serializeNode(buffer, child))
+                {
+                    return false;
+                }
+            }
+
+            return bufferAppend(buffer, "]", 1);
+        case cJSON_Object:
+            if (!bufferAppend(buffer, "{", 1)) {
+                return false;
+            }
+
+            for (child = node->child; child; child = child->next) {
+                if ((child != node->child && !bufferAppend(buffer, ",", 1)) ||
+                    !appendString(buffer, child->string) ||
+                    !bufferAppend(buffer, ":", 1) ||
+                    !serializeNode(buffer, child))
+                {
+                    return false;
+                }
+            }
+
+            return bufferAppend(buffer, "}", 1);
+        default:
+            return false;
+    }
+}
+
+bool
+LDi_JSONSerializeInto(const struct LDJSON *const json,
+    struct LDJSONBuffer *const buffer)
+{
+    LD_ASSERT(json);
+    LD_ASSERT(buffer);
+
+    buffer->length = 0;
+
+    if (!serializeNode(buffer, (const cJSON *)json) ||
+        !bufferReserve(buffer, 0))
+    {
+        return false;
+    }
+
+    buffer->text[buffer->length] = 0;
+
+    return true;
+}
+
 char *
 LDJSONSerialize(const struct LDJSON *const json)
 {
+    struct LDJSONBuffer buffer;
+
     LD_ASSERT(json);
 
-    return cJSON_PrintUnformatted((cJSON *)json);
+    LDi_JSONBufferInit(&buffer, NULL, 0);
+
+    if (!LDi_JSONSerializeInto(json, &buffer)) {
+        LDi_JSONBufferFree(&buffer);
+
+        return NULL;
+    }
+
+    return buffer.text;
+}
+
+/* anything the strict parser rejects is left to cJSON, which is lenient in
+ways callers may rely on, and arena trees share their repeated strings */
+static cJSON *
+parseText(const char *const text)
+{
+    const size_t length = strlen(text);
+    cJSON *result;
+
+    if (length >= LD_JSON_INDEXED_PARSE_THRESHOLD &&
+        (result = (cJSON *)LDi_JSONParseIndexed(text, length,
+        parseArena != NULL)))
+    {
+        return result;
+    }
+
+    return cJSON_Parse(text);
 }
 
 struct LDJSON *
 LDJSONDeserialize(const char *const text)
 {
+    cJSON *result;
+
     LD_ASSERT(text);
 
-    return (struct LDJSON *)cJSON_Parse(text);
+    if ((result = parseText(text))) {
+        indexTree(result);
+    }
+
+    return (struct LDJSON *)result;
+}
+
+struct LDJSON *
+LDi_JSONDeserializeArena(const char *const text)
+{
+    struct JSONArena *arena;
+    cJSON *result;
+
+    LD_ASSERT(text);
+
+    if (!arenaAvailable) {
+        return LDJSONDeserialize(text);
+    }
+
+    if (!(arena = newArena(strlen(text)))) {
+        return NULL;
+    }
+
+    parseArena = arena;
+
+    if ((result = parseText(text))) {
+        /* adopted first so indexes record the arena */
+        adoptTree(result, arena);
+        indexTree(result);
+    }
+
+    parseArena = NULL;
+
+    if (!result) {
+        freeArena(arena);
+
+        return NULL;
+    }
+
+    result->type      |= cJSON_ArenaRoot;
+    arena->references = 1;
+
+    return (struct LDJSON *)result;
 }
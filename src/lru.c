@@ -46,10 +46,37 @@ LDLRUFree(struct LDLRU *const lru)
     }
 }
 
+unsigned int
+LDLRUHash(const char *const key)
+{
+    unsigned int hash;
+
+    LD_ASSERT(key);
+
+    HASH_VALUE(key, strlen(key), hash);
+
+    return hash;
+}
+
 enum LDLRUStatus
 LDLRUInsert(struct LDLRU *const lru, const char *const key)
+{
+    LD_ASSERT(lru);
+    LD_ASSERT(key);
+
+    if (lru->capacity == 0) {
+        return LDLRUSTATUS_NEW;
+    }
+
+    return LDLRUInsertHashed(lru, key, LDLRUHash(key));
+}
+
+enum LDLRUStatus
+LDLRUInsertHashed(struct LDLRU *const lru, const char *const key,
+    const unsigned int hash)
 {
     struct LDLRUNode *existing = NULL;
+    size_t length;
 
     LD_ASSERT(lru);
     LD_ASSERT(key);
@@ -58,7 +85,9 @@ LDLRUInsert(struct LDLRU *const lru, const char *const key)
         return LDLRUSTATUS_NEW;
     }
 
-    HASH_FIND_STR(lru->hash, key, existing);
+    length = strlen(key);
+
+    HASH_FIND_BYHASHVALUE(hh, lru->hash, key, length, hash, existing);
 
     if (existing == NULL) {
         struct LDLRUNode *node;
@@ -91,7 +120,8 @@ LDLRUInsert(struct LDLRU *const lru, const char *const key)
 
         CDL_PREPEND(lru->list, node);
 
-        HASH_ADD_KEYPTR(hh, lru->hash, node->key, strlen(node->key), node);
+        HASH_ADD_KEYPTR_BYHASHVALUE(hh, lru->hash, node->key, length, hash,
+            node);
 
         return LDLRUSTATUS_NEW;
     } else {
@@ -14,4 +14,11 @@ void LDLRUFree(struct LDLRU *const lru);
 
 enum LDLRUStatus LDLRUInsert(struct LDLRU *const lru, const char *const key);
 
+/* the hash LDLRUInsert computes for a key, for keys inserted repeatedly */
+unsigned int LDLRUHash(const char *const key);
+
+/* as LDLRUInsert, with hash from LDLRUHash for the same key */
+enum LDLRUStatus LDLRUInsertHashed(struct LDLRU *const lru,
+    const char *const key, const unsigned int hash);
+
 void LDLRUClear(struct LDLRU *const lru);
@@ -1,8 +1,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "cJSON.h"
-
 #include <launchdarkly/api.h>
 
 #include "misc.h"
@@ -23,6 +21,12 @@ LDFree(void *const buffer)
     customFree(buffer);
 }
 
+bool
+LDi_usingSystemFree()
+{
+    return customFree == free;
+}
+
 static char *(*customStrDup)(const char *const string) = strdup;
 
 char *
@@ -98,16 +102,11 @@ LDGlobalInit()
     static bool first = true;
 
     if (first) {
-        struct cJSON_Hooks hooks;
-
         first = false;
 
         LD_ASSERT(!curl_global_init_mem(CURL_GLOBAL_DEFAULT, LDAlloc, LDFree,
             LDRealloc, LDStrDup, LDCalloc));
 
-        hooks.malloc_fn = LDAlloc;
-        hooks.free_fn   = LDFree;
-
-        cJSON_InitHooks(&hooks);
+        LDi_initJSON();
     }
 }
@@ -36,6 +36,8 @@
     #define LD_COND_INIT CONDITION_VARIABLE_INIT
     #define LDi_condinit(cond) InitializeConditionVariable(cond)
     #define LDi_conddestroy(cond)
+
+    #define LD_THREAD_LOCAL __declspec(thread)
 #else
     #define THREAD_RETURN void *
     #define THREAD_RETURN_DEFAULT NULL
@@ -48,6 +50,8 @@
     #define LD_COND_INIT PTHREAD_COND_INITIALIZER
     #define LDi_condinit(cond) pthread_cond_init(cond, NULL)
     #define LDi_conddestroy(cond) pthread_cond_destroy(cond)
+
+    #define LD_THREAD_LOCAL __thread
 #endif
 
 bool LDi_condwait(ld_cond_t *cond, ld_mutex_t *mtx, int ms);
@@ -69,6 +73,95 @@ bool LDi_mtxdestroy(ld_mutex_t *const mutex);
 bool LDi_mtxlock(ld_mutex_t *const mutex);
 bool LDi_mtxunlock(ld_mutex_t *const mutex);
 
+/* **** LDMemory **** */
+
+/* true unless LDSetMemoryRoutines replaced free, in which case buffers from
+other libraries must be copied before LDFree may release them */
+bool LDi_usingSystemFree();
+
+/* **** LDJSON **** */
+
+/* installs the allocation hooks of cJSON, called once by LDGlobalInit */
+void LDi_initJSON();
+
+/* Parses into a single arena freed once every subtree of the result has been
+freed, for large payloads that are split into items kept around together.
+Behaves as LDJSONDeserialize otherwise. */
+struct LDJSON *LDi_JSONDeserializeArena(const char *const text);
+
+/* Parses the same tree as cJSON_Parse with structural indexing, for large
+texts. Returns NULL for anything that is not strict RFC 8259 JSON, which
+cJSON may still accept, as well as on allocation failure. When interning,
+strings repeated in the text are allocated once and shared, and those equal
+to one of LDi_names point to it, for arena trees which never free strings
+one at a time. */
+struct LDJSON *LDi_JSONParseIndexed(const char *const text,
+    const size_t length, const bool interning);
+
+/* Text written by LDi_JSONSerializeInto, kept between serializations so its
+memory is reused. It may start out in storage owned by the caller, such as
+an array on the stack, and moves to the heap once that is too small. */
+struct LDJSONBuffer {
+    char *text;
+    size_t length;
+    size_t capacity;
+    /* text is heap allocated */
+    bool owned;
+};
+
+/* storage may be NULL to start on the heap */
+void LDi_JSONBufferInit(struct LDJSONBuffer *const buffer,
+    char *const storage, const size_t storageSize);
+
+/* frees heap memory, leaving the buffer empty and without storage */
+void LDi_JSONBufferFree(struct LDJSONBuffer *const buffer);
+
+/* replaces the text of the buffer, which is unspecified on failure */
+bool LDi_JSONSerializeInto(const struct LDJSON *const json,
+    struct LDJSONBuffer *const buffer);
+
+/* **** LDNames **** */
+
+/* Operator and built in user attribute names. Trees parsed from large texts
+into an arena point to these rather than to copies of their own, so their
+strings are one of these names when the pointers are equal. */
+enum LDName {
+    LD_NAME_IN = 0,
+    LD_NAME_ENDS_WITH,
+    LD_NAME_STARTS_WITH,
+    LD_NAME_MATCHES,
+    LD_NAME_CONTAINS,
+    LD_NAME_LESS_THAN,
+    LD_NAME_LESS_THAN_OR_EQUAL,
+    LD_NAME_GREATER_THAN,
+    LD_NAME_GREATER_THAN_OR_EQUAL,
+    LD_NAME_BEFORE,
+    LD_NAME_AFTER,
+    LD_NAME_SEMVER_EQUAL,
+    LD_NAME_SEMVER_LESS_THAN,
+    LD_NAME_SEMVER_GREATER_THAN,
+    LD_NAME_SEGMENT_MATCH,
+    LD_NAME_KEY,
+    LD_NAME_IP,
+    LD_NAME_EMAIL,
+    LD_NAME_FIRST_NAME,
+    LD_NAME_LAST_NAME,
+    LD_NAME_AVATAR,
+    LD_NAME_COUNTRY,
+    LD_NAME_NAME,
+    LD_NAME_ANONYMOUS,
+    /* also returned by LDi_nameIn for any other text */
+    LD_NAME_COUNT
+};
+
+extern const char *const LDi_names[LD_NAME_COUNT];
+
+/* The name between first and last that text is. Compares pointers first,
+and text only when none match, so a copy costs the strcmp calls of a chain
+over the same names. */
+enum LDName LDi_nameIn(const char *const text, const enum LDName first,
+    const enum LDName last);
+
 /* **** LDUtility **** */
 
 #define LD_UUID_SIZE 36
@@ -98,6 +191,9 @@ bool LDi_isDeleted(const struct LDJSON *const feature);
 bool LDi_textInArray(const struct LDJSON *const array, const char *const text);
 int LDi_strncasecmp(const char *const s1, const char *const s2, const size_t n);
 
+/* the character printf and strtod use for '.' under the current locale */
+char LDi_decimalPoint();
+
 /* windows does not have strptime */
 #ifdef _WIN32
     const char *strptime (const char *buf, const char *fmt, struct tm *tm);
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 #include <curl/curl.h>
 
@@ -68,6 +69,29 @@ LDi_prepareShared(const struct LDConfig *const config, const char *const url,
         goto error;
     }
 
+    /* keep idle connections warm between polls and flushes */
+    if (curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L) != CURLE_OK) {
+        LD_LOG(LD_LOG_CRITICAL,
+            "curl_easy_setopt CURLOPT_TCP_KEEPALIVE failed");
+
+        goto error;
+    }
+
+    #if LIBCURL_VERSION_NUM >= 0x072f00
+        /* negotiate HTTP/2 over TLS, silently falls back to HTTP/1.1 */
+        if (curl_easy_setopt(curl, CURLOPT_HTTP_VERSION,
+            (long)CURL_HTTP_VERSION_2TLS) != CURLE_OK)
+        {
+            LD_LOG(LD_LOG_WARNING,
+                "curl_easy_setopt CURLOPT_HTTP_VERSION failed");
+        }
+
+        /* prefer multiplexing on an existing connection over opening more */
+        if (curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L) != CURLE_OK) {
+            LD_LOG(LD_LOG_WARNING, "curl_easy_setopt CURLOPT_PIPEWAIT failed");
+        }
+    #endif
+
     *o_curl    = curl;
     *o_headers = headers;
 
@@ -81,210 +105,547 @@ LDi_prepareShared(const struct LDConfig *const config, const char *const url,
     return false;
 }
 
-THREAD_RETURN
-LDi_networkthread(void* const clientref)
+/* The share handle is only ever touched from the networking thread so it does
+not require lock callbacks. */
+static CURLSH *
+constructShareHandle()
 {
-    struct LDClient *const client = (struct LDClient *)clientref;
+    CURLSH *share;
 
-    /* allocated to max size */
-    struct NetworkInterface *interfaces[3];
-    /* record how many threads are actually running */
-    size_t interfacecount = 0;
+    if (!(share = curl_share_init())) {
+        LD_LOG(LD_LOG_ERROR, "curl_share_init returned NULL");
 
-    CURLM *multihandle;
+        return NULL;
+    }
+
+    if (curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS)
+        != CURLSHE_OK)
+    {
+        LD_LOG(LD_LOG_WARNING, "failed to share DNS cache");
+    }
+
+    if (curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION)
+        != CURLSHE_OK)
+    {
+        LD_LOG(LD_LOG_WARNING, "failed to share TLS sessions");
+    }
+
+    #if LIBCURL_VERSION_NUM >= 0x073900
+        if (curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT)
+            != CURLSHE_OK)
+        {
+            LD_LOG(LD_LOG_WARNING, "failed to share connection cache");
+        }
+    #endif
+
+    return share;
+}
+
+static void
+recordNetworkStats(struct LDClient *const client, CURL *const easy)
+{
+    long connects, httpVersion;
+    double appConnectTime;
 
     LD_ASSERT(client);
+    LD_ASSERT(easy);
 
-    if (!(multihandle = curl_multi_init())) {
-        LD_LOG(LD_LOG_ERROR, "failed to construct multihandle");
+    connects       = 0;
+    httpVersion    = 0;
+    appConnectTime = 0;
+
+    if (curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &connects)
+        != CURLE_OK)
+    {
+        LD_LOG(LD_LOG_WARNING, "failed to get connection count");
+    }
+
+    if (curl_easy_getinfo(easy, CURLINFO_APPCONNECT_TIME, &appConnectTime)
+        != CURLE_OK)
+    {
+        LD_LOG(LD_LOG_WARNING, "failed to get TLS connect time");
+    }
+
+    #if LIBCURL_VERSION_NUM >= 0x073200
+        if (curl_easy_getinfo(easy, CURLINFO_HTTP_VERSION, &httpVersion)
+            != CURLE_OK)
+        {
+            LD_LOG(LD_LOG_WARNING, "failed to get HTTP version");
+        }
+    #endif
+
+    LD_ASSERT(LDi_wrlock(&client->lock));
+    client->networkStats.requests++;
+
+    if (connects > 0) {
+        client->networkStats.connections += connects;
 
-        return THREAD_RETURN_DEFAULT;
+        /* a reused connection does not perform another handshake */
+        if (appConnectTime > 0) {
+            client->networkStats.handshakes++;
+        }
     }
 
+    #if LIBCURL_VERSION_NUM >= 0x073200
+        if (httpVersion == CURL_HTTP_VERSION_2_0) {
+            client->networkStats.http2Requests++;
+        }
+    #endif
+    LD_ASSERT(LDi_wrunlock(&client->lock));
+}
+
+static void
+wakeReactor(struct LDReactor *const reactor)
+{
+    LD_ASSERT(reactor);
+
+    LD_ASSERT(LDi_mtxlock(&reactor->wakeLock));
+    reactor->wakePending = true;
+    LD_ASSERT(LDi_mtxunlock(&reactor->wakeLock));
+
+    LDi_condsignal(&reactor->wakeCond);
+}
+
+void
+LDi_wakeNetworkThread(struct LDClient *const client)
+{
+    LD_ASSERT(client);
+
+    wakeReactor(client->reactor);
+}
+
+/* sleeps for up to milliseconds, returns early if woken */
+static void
+idleWait(struct LDReactor *const reactor, const int milliseconds)
+{
+    LD_ASSERT(reactor);
+
+    LD_ASSERT(LDi_mtxlock(&reactor->wakeLock));
+    if (!reactor->wakePending) {
+        LDi_condwait(&reactor->wakeCond, &reactor->wakeLock, milliseconds);
+    }
+    reactor->wakePending = false;
+    LD_ASSERT(LDi_mtxunlock(&reactor->wakeLock));
+}
+
+static bool
+constructSession(struct LDReactorSession *const session)
+{
+    struct LDClient *client;
+    unsigned int i;
+
+    LD_ASSERT(session);
+
+    client = session->client;
+
+    session->constructed = true;
+
     if (!client->config->useLDD) {
-        if (!(interfaces[interfacecount++] = LDi_constructPolling(client))) {
+        if (!(session->interfaces[session->interfacecount] =
+            LDi_constructPolling(client)))
+        {
             LD_LOG(LD_LOG_ERROR, "failed to construct polling");
 
-            return THREAD_RETURN_DEFAULT;
+            return false;
         }
+        session->interfacecount++;
 
-        if (!(interfaces[interfacecount++] = LDi_constructStreaming(client))) {
+        if (!(session->interfaces[session->interfacecount] =
+            LDi_constructStreaming(client)))
+        {
             LD_LOG(LD_LOG_ERROR, "failed to construct streaming");
 
-            return THREAD_RETURN_DEFAULT;
+            return false;
         }
+        session->interfacecount++;
     }
 
-    if (!(interfaces[interfacecount++] = LDi_constructAnalytics(client))) {
+    if (!(session->interfaces[session->interfacecount] =
+        LDi_constructAnalytics(client)))
+    {
         LD_LOG(LD_LOG_ERROR, "failed to construct analytics");
 
-        return THREAD_RETURN_DEFAULT;
+        return false;
     }
+    session->interfacecount++;
 
-    while (true) {
-        struct CURLMsg *info;
-        int running_handles, active_events;
-        unsigned int i;
-        bool offline;
+    for (i = 0; i < session->interfacecount; i++) {
+        session->interfaces[i]->session = session;
+    }
 
-        info            = NULL;
-        running_handles = 0;
-        active_events   = 0;
+    return true;
+}
 
-        LD_ASSERT(LDi_rdlock(&client->lock));
-        if (client->shuttingdown) {
-            LD_ASSERT(LDi_rdunlock(&client->lock));
+/* releases every interface and in flight request of a session */
+static void
+teardownSession(CURLM *const multihandle,
+    struct LDReactorSession *const session)
+{
+    unsigned int i;
 
-            break;
+    LD_ASSERT(multihandle);
+    LD_ASSERT(session);
+
+    for (i = 0; i < session->interfacecount; i++) {
+        struct NetworkInterface *const netInterface = session->interfaces[i];
+
+        if (netInterface->current) {
+            LD_ASSERT(curl_multi_remove_handle(
+                multihandle, netInterface->current) == CURLM_OK);
+
+            curl_easy_cleanup(netInterface->current);
         }
-        offline = client->config->offline;
-        LD_ASSERT(LDi_rdunlock(&client->lock));
 
-        curl_multi_perform(multihandle, &running_handles);
+        netInterface->destroy(netInterface->context);
+        LDFree(netInterface);
+    }
 
-        if (!offline) {
-            for (i = 0; i < interfacecount; i++) {
-                CURL *handle;
-                /* skip if waiting on backoff */
-                if (interfaces[i]->attempts) {
-                    unsigned long now;
-
-                    if (!LDi_getMonotonicMilliseconds(&now)) {
-                        LD_LOG(LD_LOG_ERROR, "failed to get time for backoff");
-
-                        goto cleanup;
-                    }
-
-                    if (interfaces[i]->waitUntil) {
-                        if (now >= interfaces[i]->waitUntil) {
-                            interfaces[i]->waitUntil = 0;
-                            /* fallthrough to polling */
-                        } else {
-                            /* still waiting on this interface */
-                            continue;
-                        }
-                    } else {
-                        double backoff;
-                        unsigned int rng;
-
-                        /* random value for jitter */
-                        if (!LDi_random(&rng)) {
-                            LD_LOG(LD_LOG_ERROR,
-                                "failed to get rng for jitter calculation");
-
-                            goto cleanup;
-                        }
-
-                        /* calculate time to wait */
-                        backoff = 1000 * pow(2, interfaces[i]->attempts) / 2;
-
-                        /* cap (min not built in) */
-                        if (backoff > 3600 * 1000) {
-                            backoff = 3600 * 1000;
-                        }
-
-                        /* jitter */
-                        backoff /= 2;
-
-                        backoff = backoff +
-                            LDi_normalize(rng, 0, LD_RAND_MAX, 0, backoff);
-
-                        interfaces[i]->waitUntil = now + backoff;
-                        /* skip because we are waiting */
-                        continue;
-                    }
-                }
+    session->interfacecount = 0;
+}
 
-                /* not waiting on backoff */
-                handle = interfaces[i]->poll(client, interfaces[i]->context);
+/* Unlinks every session with a pending detach (or every session when
+shutting down) and returns them as a list. */
+static struct LDReactorSession *
+takeDetaching(struct LDReactor *const reactor, const bool all)
+{
+    struct LDReactorSession **iter, *taken;
 
-                if (handle) {
-                    interfaces[i]->current = handle;
+    LD_ASSERT(reactor);
 
-                    if (curl_easy_setopt(
-                        handle, CURLOPT_PRIVATE, interfaces[i]) != CURLE_OK)
-                    {
-                        LD_LOG(LD_LOG_ERROR, "failed to associate context");
+    taken = NULL;
+    iter  = &reactor->sessions;
 
-                        goto cleanup;
-                    }
+    while (*iter) {
+        struct LDReactorSession *const session = *iter;
 
-                    if (curl_multi_add_handle(
-                        multihandle, handle) != CURLM_OK)
-                    {
-                        LD_LOG(LD_LOG_ERROR, "failed to add handle");
+        if (all || session->detaching) {
+            *iter         = session->next;
+            session->next = taken;
+            taken         = session;
+        } else {
+            iter = &session->next;
+        }
+    }
+
+    return taken;
+}
 
-                        goto cleanup;
-                    }
+static void
+finishDetaching(struct LDReactor *const reactor, CURLM *const multihandle,
+    struct LDReactorSession *taken)
+{
+    struct LDReactorSession *session;
+
+    LD_ASSERT(reactor);
+
+    if (!taken) {
+        return;
+    }
+
+    for (session = taken; session; session = session->next) {
+        teardownSession(multihandle, session);
+    }
+
+    LD_ASSERT(LDi_mtxlock(&reactor->lock));
+    while (taken) {
+        session = taken;
+        taken   = taken->next;
+
+        session->next     = NULL;
+        session->detached = true;
+    }
+    LD_ASSERT(LDi_mtxunlock(&reactor->lock));
+
+    LDi_condsignal(&reactor->detachCond);
+}
+
+/* stops a single client after an unexpected error, the reactor keeps
+servicing every other session */
+static void
+failSession(CURLM *const multihandle,
+    struct LDReactorSession *const session)
+{
+    LD_ASSERT(multihandle);
+    LD_ASSERT(session);
+
+    LD_LOG(LD_LOG_ERROR, "network failure, disabling client");
+
+    teardownSession(multihandle, session);
+
+    session->disabled = true;
+}
+
+static bool
+pollSession(CURLM *const multihandle, CURLSH *const sharehandle,
+    struct LDReactorSession *const session)
+{
+    struct LDClient *client;
+    unsigned int i;
+    bool offline;
+
+    LD_ASSERT(multihandle);
+    LD_ASSERT(sharehandle);
+    LD_ASSERT(session);
+
+    client = session->client;
+
+    if (!session->constructed && !constructSession(session)) {
+        session->disabled = true;
+    }
+
+    if (session->disabled) {
+        return true;
+    }
+
+    LD_ASSERT(LDi_rdlock(&client->lock));
+    offline = client->config->offline;
+    LD_ASSERT(LDi_rdunlock(&client->lock));
+
+    if (offline) {
+        return true;
+    }
+
+    for (i = 0; i < session->interfacecount; i++) {
+        struct NetworkInterface *const netInterface = session->interfaces[i];
+        CURL *handle;
+
+        /* skip if waiting on backoff */
+        if (netInterface->attempts) {
+            unsigned long now;
+
+            if (!LDi_getMonotonicMilliseconds(&now)) {
+                LD_LOG(LD_LOG_ERROR, "failed to get time for backoff");
+
+                return false;
+            }
+
+            if (netInterface->waitUntil) {
+                if (now >= netInterface->waitUntil) {
+                    netInterface->waitUntil = 0;
+                    /* fallthrough to polling */
+                } else {
+                    /* still waiting on this interface */
+                    continue;
                 }
+            } else {
+                double backoff;
+                unsigned int rng;
+
+                /* random value for jitter */
+                if (!LDi_random(&rng)) {
+                    LD_LOG(LD_LOG_ERROR,
+                        "failed to get rng for jitter calculation");
+
+                    return false;
+                }
+
+                /* calculate time to wait */
+                backoff = 1000 * pow(2, netInterface->attempts) / 2;
+
+                /* cap (min not built in) */
+                if (backoff > 3600 * 1000) {
+                    backoff = 3600 * 1000;
+                }
+
+                /* jitter */
+                backoff /= 2;
+
+                backoff = backoff +
+                    LDi_normalize(rng, 0, LD_RAND_MAX, 0, backoff);
+
+                netInterface->waitUntil = now + backoff;
+                /* skip because we are waiting */
+                continue;
             }
         }
 
-        do {
-            int inqueue = 0;
+        /* not waiting on backoff */
+        handle = netInterface->poll(client, netInterface->context);
 
-            info = curl_multi_info_read(multihandle, &inqueue);
+        if (handle) {
+            netInterface->current = handle;
 
-            if (info && (info->msg == CURLMSG_DONE)) {
-                long responsecode;
-                CURL *easy = info->easy_handle;
-                struct NetworkInterface *netInterface = NULL;
-                bool requestSuccess;
+            if (curl_easy_setopt(
+                handle, CURLOPT_PRIVATE, netInterface) != CURLE_OK)
+            {
+                LD_LOG(LD_LOG_ERROR, "failed to associate context");
+
+                return false;
+            }
 
-                if (curl_easy_getinfo(
-                    easy, CURLINFO_RESPONSE_CODE, &responsecode) != CURLE_OK)
-                {
-                    LD_LOG(LD_LOG_ERROR, "failed to get response code");
+            /* reuse DNS, TLS sessions, and connections across requests and
+            clients instead of handshaking on every poll / flush */
+            if (curl_easy_setopt(
+                handle, CURLOPT_SHARE, sharehandle) != CURLE_OK)
+            {
+                LD_LOG(LD_LOG_ERROR, "failed to associate share");
 
-                    goto cleanup;
-                }
+                return false;
+            }
 
-                if (responsecode == 401 || responsecode == 403) {
-                    LD_LOG(LD_LOG_ERROR, "LaunchDarkly API Access Denied");
+            if (curl_multi_add_handle(multihandle, handle) != CURLM_OK) {
+                LD_LOG(LD_LOG_ERROR, "failed to add handle");
 
-                    goto cleanup;
-                }
+                return false;
+            }
+        }
+    }
 
-                {
-                    char msg[256];
+    return true;
+}
 
-                    LD_ASSERT(snprintf(msg, sizeof(msg),
-                        "message done code %s %ld",
-                        curl_easy_strerror(info->data.result),
-                        responsecode) >= 0);
+static void
+completeRequest(CURLM *const multihandle, struct CURLMsg *const info)
+{
+    long responsecode;
+    CURL *easy;
+    struct NetworkInterface *netInterface;
+    struct LDReactorSession *session;
+    bool requestSuccess;
 
-                    LD_LOG(LD_LOG_TRACE, msg);
-                }
+    LD_ASSERT(multihandle);
+    LD_ASSERT(info);
 
-                if (curl_easy_getinfo(
-                    easy, CURLINFO_PRIVATE, &netInterface) != CURLE_OK)
-                {
-                    LD_LOG(LD_LOG_ERROR, "failed to get context");
+    easy         = info->easy_handle;
+    netInterface = NULL;
 
-                    goto cleanup;
-                }
+    if (curl_easy_getinfo(
+        easy, CURLINFO_PRIVATE, &netInterface) != CURLE_OK)
+    {
+        LD_LOG(LD_LOG_ERROR, "failed to get context");
 
-                LD_ASSERT(netInterface);
-                LD_ASSERT(netInterface->done);
-                LD_ASSERT(netInterface->context);
+        /* the owning interface still releases the handle on teardown */
+        LD_ASSERT(curl_multi_remove_handle(multihandle, easy) == CURLM_OK);
 
-                requestSuccess = info->data.result == CURLE_OK &&
-                    (responsecode == 200 || responsecode == 202);
+        return;
+    }
 
-                if (requestSuccess) {
-                    netInterface->attempts = 0;
-                } else {
-                    netInterface->attempts++;
-                }
+    /* without a response code the request is handled as failed */
+    if (curl_easy_getinfo(
+        easy, CURLINFO_RESPONSE_CODE, &responsecode) != CURLE_OK)
+    {
+        LD_LOG(LD_LOG_ERROR, "failed to get response code");
+
+        responsecode = 0;
+    }
+
+    LD_ASSERT(netInterface);
+    LD_ASSERT(netInterface->done);
+    LD_ASSERT(netInterface->context);
+    LD_ASSERT(netInterface->session);
+
+    session = netInterface->session;
+
+    {
+        char msg[256];
+
+        LD_ASSERT(snprintf(msg, sizeof(msg),
+            "message done code %s %ld",
+            curl_easy_strerror(info->data.result),
+            responsecode) >= 0);
+
+        LD_LOG(LD_LOG_TRACE, msg);
+    }
+
+    recordNetworkStats(session->client, easy);
+
+    /* 304 answers a conditional poll whose payload has not changed */
+    requestSuccess = info->data.result == CURLE_OK &&
+        (responsecode == 200 || responsecode == 202 || responsecode == 304);
+
+    if (responsecode == 401 || responsecode == 403) {
+        LD_LOG(LD_LOG_ERROR, "LaunchDarkly API Access Denied");
+
+        /* only this client stops, others on the reactor are unaffected */
+        session->disabled = true;
+    }
+
+    if (requestSuccess) {
+        netInterface->attempts = 0;
+    } else {
+        netInterface->attempts++;
+    }
+
+    netInterface->done(session->client, netInterface->context, requestSuccess);
+
+    netInterface->current = NULL;
+
+    LD_ASSERT(curl_multi_remove_handle(multihandle, easy) == CURLM_OK);
+
+    curl_easy_cleanup(easy);
+}
+
+THREAD_RETURN
+LDi_networkthread(void* const reactorref)
+{
+    struct LDReactor *const reactor = (struct LDReactor *)reactorref;
+
+    CURLM *multihandle;
+    CURLSH *sharehandle;
+
+    LD_ASSERT(reactor);
+
+    multihandle = NULL;
+    sharehandle = NULL;
+
+    if (!(multihandle = curl_multi_init())) {
+        LD_LOG(LD_LOG_ERROR, "failed to construct multihandle");
 
-                netInterface->done(client, netInterface->context, requestSuccess);
+        goto cleanup;
+    }
 
-                netInterface->current = NULL;
+    #if LIBCURL_VERSION_NUM >= 0x072b00
+        if (curl_multi_setopt(multihandle, CURLMOPT_PIPELINING,
+            CURLPIPE_MULTIPLEX) != CURLM_OK)
+        {
+            LD_LOG(LD_LOG_WARNING, "failed to enable HTTP/2 multiplexing");
+        }
+    #endif
 
-                LD_ASSERT(curl_multi_remove_handle(
-                    multihandle, easy) == CURLM_OK);
+    if (!(sharehandle = constructShareHandle())) {
+        LD_LOG(LD_LOG_ERROR, "failed to construct sharehandle");
 
-                curl_easy_cleanup(easy);
+        goto cleanup;
+    }
+
+    while (true) {
+        struct LDReactorSession *sessions, *detaching, *session;
+        struct CURLMsg *info;
+        int running_handles, active_events;
+
+        info            = NULL;
+        running_handles = 0;
+        active_events   = 0;
+
+        LD_ASSERT(LDi_mtxlock(&reactor->lock));
+        if (reactor->shuttingdown) {
+            LD_ASSERT(LDi_mtxunlock(&reactor->lock));
+
+            break;
+        }
+        detaching = takeDetaching(reactor, false);
+        /* sessions are only unlinked by this thread so the list may be walked
+        without the lock */
+        sessions  = reactor->sessions;
+        LD_ASSERT(LDi_mtxunlock(&reactor->lock));
+
+        finishDetaching(reactor, multihandle, detaching);
+
+        curl_multi_perform(multihandle, &running_handles);
+
+        for (session = sessions; session; session = session->next) {
+            if (!pollSession(multihandle, sharehandle, session)) {
+                failSession(multihandle, session);
+            }
+        }
+
+        do {
+            int inqueue = 0;
+
+            info = curl_multi_info_read(multihandle, &inqueue);
+
+            if (info && (info->msg == CURLMSG_DONE)) {
+                completeRequest(multihandle, info);
             }
         } while (info);
 
@@ -298,7 +659,7 @@ LDi_networkthread(void* const clientref)
 
         if (!active_events) {
             /* if curl is not doing anything wait so we don't burn CPU */
-            LD_ASSERT(LDi_sleepMilliseconds(10));
+            idleWait(reactor, 10);
         }
     }
 
@@ -306,24 +667,153 @@ LDi_networkthread(void* const clientref)
     LD_LOG(LD_LOG_INFO, "cleanup up networking thread");
 
     {
-        unsigned int i;
+        struct LDReactorSession *detaching;
 
-        for (i = 0; i < interfacecount; i++) {
-            struct NetworkInterface *const netInterface = interfaces[i];
+        LD_ASSERT(LDi_mtxlock(&reactor->lock));
+        reactor->running = false;
+        detaching = takeDetaching(reactor, true);
+        LD_ASSERT(LDi_mtxunlock(&reactor->lock));
 
-            if (netInterface->current) {
-                LD_ASSERT(curl_multi_remove_handle(
-                    multihandle, netInterface->current) == CURLM_OK);
-
-                curl_easy_cleanup(netInterface->current);
-            }
-
-            netInterface->destroy(netInterface->context);
-            LDFree(netInterface);
+        if (multihandle) {
+            finishDetaching(reactor, multihandle, detaching);
         }
     }
 
-    LD_ASSERT(curl_multi_cleanup(multihandle) == CURLM_OK);
+    if (multihandle) {
+        LD_ASSERT(curl_multi_cleanup(multihandle) == CURLM_OK);
+    }
+
+    /* must outlive every easy handle that referenced it */
+    if (sharehandle) {
+        LD_ASSERT(curl_share_cleanup(sharehandle) == CURLSHE_OK);
+    }
 
     return THREAD_RETURN_DEFAULT;
 }
+
+struct LDReactorSession *
+LDi_reactorAttach(struct LDReactor *const reactor,
+    struct LDClient *const client)
+{
+    struct LDReactorSession *session;
+
+    LD_ASSERT(reactor);
+    LD_ASSERT(client);
+
+    if (!(session = (struct LDReactorSession *)
+        LDAlloc(sizeof(struct LDReactorSession))))
+    {
+        LD_LOG(LD_LOG_ERROR, "failed to allocate reactor session");
+
+        return NULL;
+    }
+
+    memset(session, 0, sizeof(struct LDReactorSession));
+
+    session->client = client;
+
+    LD_ASSERT(LDi_mtxlock(&reactor->lock));
+    if (!reactor->running) {
+        LD_ASSERT(LDi_mtxunlock(&reactor->lock));
+
+        LD_LOG(LD_LOG_ERROR, "cannot attach to a stopped reactor");
+
+        LDFree(session);
+
+        return NULL;
+    }
+
+    session->next     = reactor->sessions;
+    reactor->sessions = session;
+    LD_ASSERT(LDi_mtxunlock(&reactor->lock));
+
+    wakeReactor(reactor);
+
+    return session;
+}
+
+void
+LDi_reactorDetach(struct LDReactor *const reactor,
+    struct LDReactorSession *const session)
+{
+    LD_ASSERT(reactor);
+    LD_ASSERT(session);
+
+    LD_ASSERT(LDi_mtxlock(&reactor->lock));
+    session->detaching = true;
+    LD_ASSERT(LDi_mtxunlock(&reactor->lock));
+
+    wakeReactor(reactor);
+
+    LD_ASSERT(LDi_mtxlock(&reactor->lock));
+    while (!session->detached) {
+        LDi_condwait(&reactor->detachCond, &reactor->lock, 1000);
+    }
+    LD_ASSERT(LDi_mtxunlock(&reactor->lock));
+
+    LDFree(session);
+}
+
+struct LDReactor *
+LDReactorNew()
+{
+    struct LDReactor *reactor;
+
+    if (!(reactor = (struct LDReactor *)LDAlloc(sizeof(struct LDReactor)))) {
+        return NULL;
+    }
+
+    memset(reactor, 0, sizeof(struct LDReactor));
+
+    if (!LDi_mtxinit(&reactor->lock)) {
+        goto error;
+    }
+
+    if (!LDi_mtxinit(&reactor->wakeLock)) {
+        LD_ASSERT(LDi_mtxdestroy(&reactor->lock));
+
+        goto error;
+    }
+
+    LDi_condinit(&reactor->detachCond);
+    LDi_condinit(&reactor->wakeCond);
+
+    reactor->running = true;
+
+    if (!LDi_createthread(&reactor->thread, LDi_networkthread, reactor)) {
+        LD_ASSERT(LDi_mtxdestroy(&reactor->lock));
+        LD_ASSERT(LDi_mtxdestroy(&reactor->wakeLock));
+        LDi_conddestroy(&reactor->detachCond);
+        LDi_conddestroy(&reactor->wakeCond);
+
+        goto error;
+    }
+
+    return reactor;
+
+  error:
+    LDFree(reactor);
+
+    return NULL;
+}
+
+void
+LDReactorFree(struct LDReactor *const reactor)
+{
+    if (reactor) {
+        LD_ASSERT(LDi_mtxlock(&reactor->lock));
+        reactor->shuttingdown = true;
+        LD_ASSERT(LDi_mtxunlock(&reactor->lock));
+
+        wakeReactor(reactor);
+
+        LD_ASSERT(LDi_jointhread(reactor->thread));
+
+        LD_ASSERT(LDi_mtxdestroy(&reactor->lock));
+        LD_ASSERT(LDi_mtxdestroy(&reactor->wakeLock));
+        LDi_conddestroy(&reactor->detachCond);
+        LDi_conddestroy(&reactor->wakeCond);
+
+        LDFree(reactor);
+    }
+}
@@ -9,6 +9,8 @@
 
 #include "misc.h"
 
+struct LDReactorSession;
+
 struct NetworkInterface {
     /* get next handle */
     CURL *(*poll)(struct LDClient *const client, void *context);
@@ -24,6 +26,40 @@ struct NetworkInterface {
     unsigned int attempts;
     /* point in future to backoff until */
     unsigned long waitUntil;
+    /* the client registration this interface belongs to */
+    struct LDReactorSession *session;
+};
+
+/* the interfaces of a single client multiplexed onto a reactor */
+struct LDReactorSession {
+    struct LDClient *client;
+    /* allocated to max size */
+    struct NetworkInterface *interfaces[3];
+    /* record how many interfaces are actually running */
+    size_t interfacecount;
+    /* interfaces are constructed lazily on the reactor thread */
+    bool constructed;
+    /* set after a fatal error, the session stops making requests */
+    bool disabled;
+    /* following fields guarded by reactor lock */
+    bool detaching;
+    bool detached;
+    struct LDReactorSession *next;
+};
+
+struct LDReactor {
+    ld_thread_t thread;
+    ld_mutex_t lock;
+    /* signalled when a detaching session has been torn down */
+    ld_cond_t detachCond;
+    /* following fields guarded by lock */
+    struct LDReactorSession *sessions;
+    bool running;
+    bool shuttingdown;
+    /* allows the reactor to be woken early from its idle wait */
+    bool wakePending;
+    ld_mutex_t wakeLock;
+    ld_cond_t wakeCond;
 };
 
 bool LDi_prepareShared(const struct LDConfig *const config,
@@ -34,6 +70,18 @@ struct NetworkInterface *LDi_constructPolling(struct LDClient *const client);
 struct NetworkInterface *LDi_constructStreaming(struct LDClient *const client);
 struct NetworkInterface *LDi_constructAnalytics(struct LDClient *const client);
 
-THREAD_RETURN LDi_networkthread(void *const clientref);
+THREAD_RETURN LDi_networkthread(void *const reactorref);
+
+/* registers a client with the reactor, the reactor thread constructs the
+interfaces */
+struct LDReactorSession *LDi_reactorAttach(struct LDReactor *const reactor,
+    struct LDClient *const client);
+
+/* blocks until the reactor has released every resource of the session */
+void LDi_reactorDetach(struct LDReactor *const reactor,
+    struct LDReactorSession *const session);
+
+/* interrupts the idle wait of the networking thread */
+void LDi_wakeNetworkThread(struct LDClient *const client);
 
 bool validatePutBody(const struct LDJSON *const put);
@@ -294,35 +294,21 @@ LDi_lookupOperation(const char *const operation)
 {
     LD_ASSERT(operation);
 
-    if (strcmp(operation, "in") == 0) {
-        return operatorInFn;
-    } else if (strcmp(operation, "endsWith") == 0) {
-        return operatorEndsWithFn;
-    } else if (strcmp(operation, "startsWith") == 0) {
-        return operatorStartsWithFn;
-    } else if (strcmp(operation, "matches") == 0) {
-        return operatorMatchesFn;
-    } else if (strcmp(operation, "contains") == 0) {
-        return operatorContainsFn;
-    } else if (strcmp(operation, "lessThan") == 0) {
-        return operatorLessThanFn;
-    } else if (strcmp(operation, "lessThanOrEqual") == 0) {
-        return operatorLessThanOrEqualFn;
-    } else if (strcmp(operation, "greaterThan") == 0) {
-        return operatorGreaterThanFn;
-    } else if (strcmp(operation, "greaterThanOrEqual") == 0) {
-        return operatorGreaterThanOrEqualFn;
-    } else if (strcmp(operation, "before") == 0) {
-        return operatorBefore;
-    } else if (strcmp(operation, "after") == 0) {
-        return operatorAfter;
-    } else if (strcmp(operation, "semVerEqual") == 0) {
-        return operatorSemVerEqual;
-    } else if (strcmp(operation, "semVerLessThan") == 0) {
-        return operatorSemVerLessThan;
-    } else if (strcmp(operation, "semVerGreaterThan") == 0) {
-        return operatorSemVerGreaterThan;
+    switch (LDi_nameIn(operation, LD_NAME_IN, LD_NAME_SEMVER_GREATER_THAN)) {
+        case LD_NAME_IN:                    return operatorInFn;
+        case LD_NAME_ENDS_WITH:             return operatorEndsWithFn;
+        case LD_NAME_STARTS_WITH:           return operatorStartsWithFn;
+        case LD_NAME_MATCHES:               return operatorMatchesFn;
+        case LD_NAME_CONTAINS:              return operatorContainsFn;
+        case LD_NAME_LESS_THAN:             return operatorLessThanFn;
+        case LD_NAME_LESS_THAN_OR_EQUAL:    return operatorLessThanOrEqualFn;
+        case LD_NAME_GREATER_THAN:          return operatorGreaterThanFn;
+        case LD_NAME_GREATER_THAN_OR_EQUAL: return operatorGreaterThanOrEqualFn;
+        case LD_NAME_BEFORE:                return operatorBefore;
+        case LD_NAME_AFTER:                 return operatorAfter;
+        case LD_NAME_SEMVER_EQUAL:          return operatorSemVerEqual;
+        case LD_NAME_SEMVER_LESS_THAN:      return operatorSemVerLessThan;
+        case LD_NAME_SEMVER_GREATER_THAN:   return operatorSemVerGreaterThan;
+        default:                            return NULL;
     }
-
-    return NULL;
 }
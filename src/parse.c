@@ -0,0 +1,988 @@
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define LD_PARSE_SSE2
+    #include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && defined(_M_X64)
+    #include <intrin.h>
+#endif
+
+#include "cJSON.h"
+
+#include <launchdarkly/api.h>
+
+#include "misc.h"
+
+/* A strict parser for large texts in two stages, after the approach of
+simdjson. The first classifies 64 byte blocks into bitmasks, with SSE2 where
+the compiler targets it and a byte at a time otherwise, and from those finds
+the structural characters, the quotes around strings, and where scalars
+start, skipping everything inside strings without looking at it again. The
+second walks these positions and builds the tree cJSON_Parse would, through
+the allocation hooks of cJSON so arenas work unchanged. Into an arena, it
+interns the strings of the text as it goes, so each is stored once however
+often it is repeated, and the names of LDi_names are not stored at all.
+
+Anything outside RFC 8259 is rejected rather than reproducing the leniency
+of cJSON, such as control characters in strings, leading zeros, or text
+after the value, so callers fall back to cJSON_Parse on failure. */
+
+/* blocks indexed at once, the positions of which the tree builder consumes
+before the next are indexed */
+#define LD_PARSE_BATCH_BLOCKS 16
+/* longer numbers are left to cJSON */
+#define LD_PARSE_NUMBER_LENGTH 63
+/* 2^53, below which every integer is exactly a double */
+#define LD_PARSE_EXACT_MANTISSA (UINT64_C(1) << 53)
+/* longer strings are rarely repeated and not worth hashing */
+#define LD_PARSE_SHARED_LENGTH 256
+#define LD_PARSE_SHARED_CAPACITY 256
+
+struct BlockMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t structural;
+    uint64_t whitespace;
+    uint64_t control;
+};
+
+struct SharedString {
+    const char *text;
+    unsigned int hash;
+    unsigned int length;
+};
+
+struct Parser {
+    const char *text;
+    size_t length;
+    /* offset of the next block to index */
+    size_t block;
+    /* carried over from the previous block: all ones if it ended inside a
+    string, 1 if it ended in an odd run of backslashes, and 1 if it ended
+    inside a scalar */
+    uint64_t inString;
+    uint64_t oddBackslash;
+    uint64_t scalar;
+    /* a control character was found inside a string */
+    bool invalid;
+    unsigned int count;
+    unsigned int next;
+    /* open addressing over the strings parsed so far when interning, NULL
+    otherwise or once growing it failed */
+    struct SharedString *shared;
+    /* a power of two, kept above a third empty */
+    unsigned int sharedCapacity;
+    unsigned int sharedCount;
+    size_t positions[LD_PARSE_BATCH_BLOCKS * 64 + 8];
+};
+
+static const double powersOfTen[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static unsigned int
+lowestBit(const uint64_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned int)__builtin_ctzll(bits);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+
+    _BitScanForward64(&index, bits);
+
+    return (unsigned int)index;
+#else
+    unsigned int index;
+
+    for (index = 0; !(bits & ((uint64_t)1 << index)); index++) { }
+
+    return index;
+#endif
+}
+
+static unsigned int
+countBits(uint64_t bits)
+{
+#if defined(__POPCNT__)
+    return (unsigned int)__builtin_popcountll(bits);
+#else
+    /* without the instruction, compilers call out to a slower routine */
+    bits = bits - ((bits >> 1) & UINT64_C(0x5555555555555555));
+    bits = (bits & UINT64_C(0x3333333333333333)) +
+        ((bits >> 2) & UINT64_C(0x3333333333333333));
+    bits = (bits + (bits >> 4)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+
+    return (unsigned int)((bits * UINT64_C(0x0101010101010101)) >> 56);
+#endif
+}
+
+static void
+classifyBlock(const unsigned char *const block, struct BlockMasks *const masks)
+{
+#ifdef LD_PARSE_SSE2
+    const __m128i quote     = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    /* '[' and ']' are '{' and '}' without 0x20 */
+    const __m128i caseBit   = _mm_set1_epi8(0x20);
+    const __m128i open      = _mm_set1_epi8('{');
+    const __m128i close     = _mm_set1_epi8('}');
+    const __m128i colon     = _mm_set1_epi8(':');
+    const __m128i comma     = _mm_set1_epi8(',');
+    const __m128i space     = _mm_set1_epi8(' ');
+    const __m128i tab       = _mm_set1_epi8('\t');
+    const __m128i newline   = _mm_set1_epi8('\n');
+    const __m128i feed      = _mm_set1_epi8('\r');
+    const __m128i lastControl = _mm_set1_epi8(0x1F);
+    unsigned int i;
+
+    memset(masks, 0, sizeof(struct BlockMasks));
+
+    for (i = 0; i < 64; i += 16) {
+        const __m128i bytes = _mm_loadu_si128((const __m128i *)(block + i));
+        const __m128i folded = _mm_or_si128(bytes, caseBit);
+        __m128i matches;
+
+        #define LD_PARSE_MASK(vector) \
+            ((uint64_t)(unsigned int)_mm_movemask_epi8(vector) << i)
+
+        masks->quote |= LD_PARSE_MASK(_mm_cmpeq_epi8(bytes, quote));
+        masks->backslash |= LD_PARSE_MASK(_mm_cmpeq_epi8(bytes, backslash));
+
+        matches = _mm_or_si128(_mm_cmpeq_epi8(folded, open),
+            _mm_cmpeq_epi8(folded, close));
+        matches = _mm_or_si128(matches, _mm_cmpeq_epi8(bytes, colon));
+        matches = _mm_or_si128(matches, _mm_cmpeq_epi8(bytes, comma));
+        masks->structural |= LD_PARSE_MASK(matches);
+
+        matches = _mm_or_si128(_mm_cmpeq_epi8(bytes, space),
+            _mm_cmpeq_epi8(bytes, tab));
+        matches = _mm_or_si128(matches, _mm_cmpeq_epi8(bytes, newline));
+        matches = _mm_or_si128(matches, _mm_cmpeq_epi8(bytes, feed));
+        masks->whitespace |= LD_PARSE_MASK(matches);
+
+        /* unsigned comparison, bytes up to 0x1F are their own minimum */
+        masks->control |= LD_PARSE_MASK(_mm_cmpeq_epi8(
+            _mm_min_epu8(bytes, lastControl), bytes));
+
+        #undef LD_PARSE_MASK
+    }
+#else
+    unsigned int i;
+
+    memset(masks, 0, sizeof(struct BlockMasks));
+
+    for (i = 0; i < 64; i++) {
+        const uint64_t bit = (uint64_t)1 << i;
+
+        switch (block[i]) {
+            case '"':
+                masks->quote |= bit;
+                break;
+            case '\\':
+                masks->backslash |= bit;
+                break;
+            case '{': case '}': case '[': case ']': case ':': case ',':
+                masks->structural |= bit;
+                break;
+            case ' ':
+                masks->whitespace |= bit;
+                break;
+            case '\t': case '\n': case '\r':
+                masks->whitespace |= bit;
+                masks->control    |= bit;
+                break;
+            default:
+                if (block[i] < 0x20) {
+                    masks->control |= bit;
+                }
+        }
+    }
+#endif
+}
+
+/* Characters following an odd run of backslashes. Runs starting on even
+and odd bits are added to separately, so the carry lands just past the end
+of each run, and those ending on a bit of the other parity are odd. */
+static uint64_t
+escapedCharacters(const uint64_t backslash, uint64_t *const oddCarry)
+{
+    const uint64_t evenBits   = UINT64_C(0x5555555555555555);
+    const uint64_t oddBits    = ~evenBits;
+    const uint64_t starts     = backslash & ~(backslash << 1);
+    /* a run continuing an odd one starts as if on an odd bit */
+    const uint64_t evenStarts = starts & (evenBits ^ *oddCarry);
+    const uint64_t oddStarts  = starts & ~(evenBits ^ *oddCarry);
+    const uint64_t evenEnds   = (backslash + evenStarts) & ~backslash;
+    uint64_t oddCarries;
+
+    oddCarries = backslash + oddStarts;
+    /* the first character is escaped by the previous block */
+    oddCarries |= *oddCarry;
+    *oddCarry  = backslash + oddStarts < backslash ? 1 : 0;
+
+    return (evenEnds & oddBits) | (oddCarries & ~backslash & evenBits);
+}
+
+/* each bit is the parity of the bits up to and including it */
+static uint64_t
+prefixXor(uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+
+    return bits;
+}
+
+/* returns the positions in the block the tree builder visits */
+static uint64_t
+indexBlock(struct Parser *const parser, const unsigned char *const block)
+{
+    struct BlockMasks masks;
+    uint64_t quotes, inString, scalar, starts;
+
+    classifyBlock(block, &masks);
+
+    quotes = masks.quote & ~escapedCharacters(masks.backslash,
+        &parser->oddBackslash);
+
+    /* set from an opening quote up to but excluding its closing quote */
+    inString         = prefixXor(quotes) ^ parser->inString;
+    parser->inString = (uint64_t)0 - (inString >> 63);
+
+    if (masks.control & inString) {
+        parser->invalid = true;
+    }
+
+    scalar = ~(masks.structural | masks.whitespace | masks.quote | inString);
+    starts = scalar & ~((scalar << 1) | parser->scalar);
+    parser->scalar = scalar >> 63;
+
+    return (masks.structural & ~inString) | quotes | starts;
+}
+
+static void
+indexBatch(struct Parser *const parser)
+{
+    unsigned int blocks;
+
+    parser->count = 0;
+    parser->next  = 0;
+
+    for (blocks = 0; blocks < LD_PARSE_BATCH_BLOCKS &&
+        parser->block < parser->length; blocks++)
+    {
+        const size_t remaining = parser->length - parser->block;
+        const unsigned char *block;
+        unsigned char padded[64];
+        unsigned int found, written;
+        uint64_t positions;
+
+        if (remaining >= 64) {
+            block = (const unsigned char *)parser->text + parser->block;
+        } else {
+            /* whitespace past the end is never indexed */
+            memset(padded, ' ', sizeof(padded));
+            memcpy(padded, parser->text + parser->block, remaining);
+            block = padded;
+        }
+
+        positions = indexBlock(parser, block);
+        found     = countBits(positions);
+
+        /* eight at a time rather than branching on each, writing past the
+        end into slack the next block overwrites */
+        for (written = 0; written < found; written += 8) {
+            size_t *const out = parser->positions + parser->count + written;
+            unsigned int i;
+
+            for (i = 0; i < 8; i++) {
+                /* the top bit keeps lowestBit defined once positions run out */
+                out[i] = parser->block +
+                    lowestBit(positions | ((uint64_t)1 << 63));
+
+                positions &= positions - 1;
+            }
+        }
+
+        parser->count += found;
+
+        parser->block += 64;
+    }
+}
+
+/* returns false once the text is indexed to the end, kept apart from
+nextPosition so that inlines */
+static bool
+refillPositions(struct Parser *const parser)
+{
+    while (parser->next == parser->count) {
+        if (parser->invalid || parser->block >= parser->length) {
+            return false;
+        }
+
+        indexBatch(parser);
+    }
+
+    return true;
+}
+
+static bool
+nextPosition(struct Parser *const parser, size_t *const position)
+{
+    if (parser->next == parser->count && !refillPositions(parser)) {
+        return false;
+    }
+
+    *position = parser->positions[parser->next++];
+
+    return true;
+}
+
+/* whether a literal or number may end before offset */
+static bool
+endsScalar(const struct Parser *const parser, const size_t offset)
+{
+    if (offset == parser->length) {
+        return true;
+    }
+
+    switch (parser->text[offset]) {
+        case ' ': case '\t': case '\n': case '\r':
+        case '{': case '}': case '[': case ']': case ':': case ',': case '"':
+            return true;
+        default:
+            return false;
+    }
+}
+
+static cJSON *
+newItem(const int type)
+{
+    cJSON *const item = cJSON_malloc(sizeof(cJSON));
+
+    if (item) {
+        memset(item, 0, sizeof(cJSON));
+
+        item->type = type;
+    }
+
+    return item;
+}
+
+static bool
+parseHex(const char *const text, unsigned int *const result)
+{
+    unsigned int i;
+
+    *result = 0;
+
+    for (i = 0; i < 4; i++) {
+        const char c = text[i];
+
+        *result <<= 4;
+
+        if (c >= '0' && c <= '9') {
+            *result |= (unsigned int)(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            *result |= (unsigned int)(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            *result |= (unsigned int)(c - 'A' + 10);
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* decodes a \u escape, or a surrogate pair of them, as cJSON does */
+static bool
+decodeUnicode(const char **const input, const char *const limit,
+    char **const output)
+{
+    unsigned int first, second, codepoint;
+    const char *const in = *input;
+    unsigned char *out;
+
+    if (limit - in < 6 || !parseHex(in + 2, &first)) {
+        return false;
+    }
+
+    if (first >= 0xDC00 && first <= 0xDFFF) {
+        return false;
+    }
+
+    if (first >= 0xD800 && first <= 0xDBFF) {
+        if (limit - in < 12 || in[6] != '\\' || in[7] != 'u' ||
+            !parseHex(in + 8, &second) || second < 0xDC00 || second > 0xDFFF)
+        {
+            return false;
+        }
+
+        codepoint = 0x10000 + (((first & 0x3FF) << 10) | (second & 0x3FF));
+        *input    = in + 12;
+    } else {
+        codepoint = first;
+        *input    = in + 6;
+    }
+
+    out = (unsigned char *)*output;
+
+    if (codepoint < 0x80) {
+        *out++ = (unsigned char)codepoint;
+    } else if (codepoint < 0x800) {
+        *out++ = (unsigned char)(0xC0 | (codepoint >> 6));
+        *out++ = (unsigned char)(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+        *out++ = (unsigned char)(0xE0 | (codepoint >> 12));
+        *out++ = (unsigned char)(0x80 | ((codepoint >> 6) & 0x3F));
+        *out++ = (unsigned char)(0x80 | (codepoint & 0x3F));
+    } else {
+        *out++ = (unsigned char)(0xF0 | (codepoint >> 18));
+        *out++ = (unsigned char)(0x80 | ((codepoint >> 12) & 0x3F));
+        *out++ = (unsigned char)(0x80 | ((codepoint >> 6) & 0x3F));
+        *out++ = (unsigned char)(0x80 | (codepoint & 0x3F));
+    }
+
+    *output = (char *)out;
+
+    return true;
+}
+
+/* FNV-1a */
+static unsigned int
+hashBytes(const char *const text, const size_t length)
+{
+    unsigned int hash;
+    size_t i;
+
+    hash = 2166136261u;
+
+    for (i = 0; i < length; i++) {
+        hash ^= (unsigned char)text[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static char *
+findShared(const struct Parser *const parser, const char *const text,
+    const size_t length, const unsigned int hash)
+{
+    const unsigned int mask = parser->sharedCapacity - 1;
+    unsigned int slot;
+
+    for (slot = hash & mask; parser->shared[slot].text;
+        slot = (slot + 1) & mask)
+    {
+        const struct SharedString *const shared = &parser->shared[slot];
+
+        if (shared->hash == hash && shared->length == length &&
+            memcmp(shared->text, text, length) == 0)
+        {
+            /* only ever read, as arena strings are never freed or changed */
+            return (char *)shared->text;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+insertShared(struct SharedString *const table, const unsigned int capacity,
+    const struct SharedString *const shared)
+{
+    unsigned int slot;
+
+    for (slot = shared->hash & (capacity - 1); table[slot].text;
+        slot = (slot + 1) & (capacity - 1))
+    { }
+
+    table[slot] = *shared;
+}
+
+/* text must not be parsed already, interning stops if growing fails */
+static void
+addShared(struct Parser *const parser, const char *const text,
+    const size_t length, const unsigned int hash)
+{
+    struct SharedString shared;
+
+    if ((parser->sharedCount + 1) * 3 > parser->sharedCapacity * 2) {
+        const unsigned int capacity = parser->sharedCapacity * 2;
+        struct SharedString *table;
+        unsigned int i;
+
+        if (!(table = LDAlloc(sizeof(struct SharedString) * capacity))) {
+            LDFree(parser->shared);
+
+            parser->shared = NULL;
+
+            return;
+        }
+
+        memset(table, 0, sizeof(struct SharedString) * capacity);
+
+        for (i = 0; i < parser->sharedCapacity; i++) {
+            if (parser->shared[i].text) {
+                insertShared(table, capacity, &parser->shared[i]);
+            }
+        }
+
+        LDFree(parser->shared);
+
+        parser->shared         = table;
+        parser->sharedCapacity = capacity;
+    }
+
+    shared.text   = text;
+    shared.hash   = hash;
+    shared.length = (unsigned int)length;
+
+    insertShared(parser->shared, parser->sharedCapacity, &shared);
+
+    parser->sharedCount++;
+}
+
+/* start is the opening quote, the closing quote is the next position */
+static char *
+parseString(struct Parser *const parser, const size_t start)
+{
+    const char *in, *limit;
+    size_t end, length;
+    char *result, *out;
+    unsigned int hash;
+    bool escaped, sharing;
+
+    if (!nextPosition(parser, &end) || parser->text[end] != '"') {
+        return NULL;
+    }
+
+    in      = parser->text + start + 1;
+    length  = end - start - 1;
+    limit   = in + length;
+    escaped = memchr(in, '\\', length) != NULL;
+    sharing = parser->shared && !escaped &&
+        length <= LD_PARSE_SHARED_LENGTH;
+    hash    = 0;
+
+    if (sharing) {
+        hash = hashBytes(in, length);
+
+        if ((result = findShared(parser, in, length, hash))) {
+            return result;
+        }
+    }
+
+    /* escapes never decode to more than they take up */
+    if (!(result = cJSON_malloc(length + 1))) {
+        return NULL;
+    }
+
+    if (!escaped) {
+        memcpy(result, in, length);
+        result[length] = 0;
+
+        if (sharing) {
+            addShared(parser, result, length, hash);
+        }
+
+        return result;
+    }
+
+    out = result;
+
+    while (in < limit) {
+        if (*in != '\\') {
+            *out++ = *in++;
+
+            continue;
+        }
+
+        /* a backslash always has a character after it before the quote */
+        switch (in[1]) {
+            case '"':  *out++ = '"';  break;
+            case '\\': *out++ = '\\'; break;
+            case '/':  *out++ = '/';  break;
+            case 'b':  *out++ = '\b'; break;
+            case 'f':  *out++ = '\f'; break;
+            case 'n':  *out++ = '\n'; break;
+            case 'r':  *out++ = '\r'; break;
+            case 't':  *out++ = '\t'; break;
+            case 'u':
+                if (!decodeUnicode(&in, limit, &out)) {
+                    goto error;
+                }
+
+                continue;
+            default:
+                goto error;
+        }
+
+        in += 2;
+    }
+
+    *out = 0;
+
+    return result;
+
+  error:
+    cJSON_free(result);
+
+    return NULL;
+}
+
+static bool
+isDigit(const char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static bool
+parseNumber(const struct Parser *const parser, const size_t start,
+    cJSON *const item)
+{
+    const char *const text = parser->text;
+    uint64_t mantissa;
+    long exponent, written;
+    bool exact, negative;
+    double number;
+    size_t i;
+
+    mantissa = 0;
+    exponent = 0;
+    exact    = true;
+    i        = start;
+
+    /* significant digits beyond what a double holds exactly go to strtod */
+    #define LD_PARSE_DIGIT(c) \
+        if (mantissa < LD_PARSE_EXACT_MANTISSA / 10) { \
+            mantissa = mantissa * 10 + (uint64_t)((c) - '0'); \
+        } else { \
+            exact = false; \
+        }
+
+    if ((negative = text[i] == '-')) {
+        i++;
+    }
+
+    if (text[i] == '0') {
+        i++;
+    } else if (isDigit(text[i])) {
+        for (; isDigit(text[i]); i++) {
+            LD_PARSE_DIGIT(text[i]);
+        }
+    } else {
+        return false;
+    }
+
+    if (text[i] == '.') {
+        if (!isDigit(text[++i])) {
+            return false;
+        }
+
+        for (; isDigit(text[i]); i++) {
+            LD_PARSE_DIGIT(text[i]);
+            exponent--;
+        }
+    }
+
+    #undef LD_PARSE_DIGIT
+
+    if (text[i] == 'e' || text[i] == 'E') {
+        bool negativeExponent;
+
+        written = 0;
+
+        if ((negativeExponent = text[++i] == '-') || text[i] == '+') {
+            i++;
+        }
+
+        if (!isDigit(text[i])) {
+            return false;
+        }
+
+        for (; isDigit(text[i]); i++) {
+            if (written < 100000) {
+                written = written * 10 + (text[i] - '0');
+            }
+        }
+
+        exponent += negativeExponent ? -written : written;
+    }
+
+    if (i - start > LD_PARSE_NUMBER_LENGTH || !endsScalar(parser, i)) {
+        return false;
+    }
+
+    if (exact && exponent >= -22 && exponent <= 22) {
+        /* both exact, so one correctly rounded operation as strtod gives */
+        if (exponent < 0) {
+            number = (double)mantissa / powersOfTen[-exponent];
+        } else {
+            number = (double)mantissa * powersOfTen[exponent];
+        }
+
+        if (negative) {
+            number = -number;
+        }
+    } else {
+        char buffer[LD_PARSE_NUMBER_LENGTH + 1], *point;
+
+        memcpy(buffer, text + start, i - start);
+        buffer[i - start] = 0;
+
+        /* as cJSON, strtod expects the decimal point of the locale */
+        if ((point = strchr(buffer, '.'))) {
+            *point = LDi_decimalPoint();
+        }
+
+        number = strtod(buffer, NULL);
+    }
+
+    item->type        = cJSON_Number;
+    item->valuedouble = number;
+
+    if (number >= INT_MAX) {
+        item->valueint = INT_MAX;
+    } else if (number <= (double)INT_MIN) {
+        item->valueint = INT_MIN;
+    } else {
+        item->valueint = (int)number;
+    }
+
+    return true;
+}
+
+static bool
+parseLiteral(const struct Parser *const parser, const size_t start,
+    const char *const literal, const int type, cJSON *const item)
+{
+    const size_t length = strlen(literal);
+
+    if (strncmp(parser->text + start, literal, length) != 0 ||
+        !endsScalar(parser, start + length))
+    {
+        return false;
+    }
+
+    item->type = type;
+
+    if (type == cJSON_True) {
+        item->valueint = 1;
+    }
+
+    return true;
+}
+
+static bool parseValue(struct Parser *const parser, const size_t position,
+    const unsigned int depth, cJSON *const item);
+
+/* children are linked before they are parsed, so deleting the root frees
+everything allocated when parsing fails part of the way */
+static cJSON *
+appendChild(cJSON *const container, cJSON **const tail)
+{
+    cJSON *const child = newItem(cJSON_Invalid);
+
+    if (!child) {
+        return NULL;
+    }
+
+    if (*tail) {
+        (*tail)->next = child;
+        child->prev   = *tail;
+    } else {
+        container->child = child;
+    }
+
+    *tail = child;
+
+    return child;
+}
+
+static bool
+parseArray(struct Parser *const parser, const unsigned int depth,
+    cJSON *const array)
+{
+    cJSON *tail, *element;
+    size_t position;
+
+    if (depth >= CJSON_NESTING_LIMIT) {
+        return false;
+    }
+
+    array->type = cJSON_Array;
+    tail        = NULL;
+
+    if (!nextPosition(parser, &position)) {
+        return false;
+    }
+
+    if (parser->text[position] == ']') {
+        return true;
+    }
+
+    for (;;) {
+        if (!(element = appendChild(array, &tail)) ||
+            !parseValue(parser, position, depth + 1, element) ||
+            !nextPosition(parser, &position))
+        {
+            return false;
+        }
+
+        if (parser->text[position] == ']') {
+            return true;
+        }
+
+        if (parser->text[position] != ',' ||
+            !nextPosition(parser, &position))
+        {
+            return false;
+        }
+    }
+}
+
+static bool
+parseObject(struct Parser *const parser, const unsigned int depth,
+    cJSON *const object)
+{
+    cJSON *tail, *member;
+    size_t position;
+
+    if (depth >= CJSON_NESTING_LIMIT) {
+        return false;
+    }
+
+    object->type = cJSON_Object;
+    tail         = NULL;
+
+    if (!nextPosition(parser, &position)) {
+        return false;
+    }
+
+    if (parser->text[position] == '}') {
+        return true;
+    }
+
+    for (;;) {
+        if (parser->text[position] != '"' ||
+            !(member = appendChild(object, &tail)) ||
+            !(member->string = parseString(parser, position)) ||
+            !nextPosition(parser, &position) ||
+            parser->text[position] != ':' ||
+            !nextPosition(parser, &position) ||
+            !parseValue(parser, position, depth + 1, member) ||
+            !nextPosition(parser, &position))
+        {
+            return false;
+        }
+
+        if (parser->text[position] == '}') {
+            return true;
+        }
+
+        if (parser->text[position] != ',' ||
+            !nextPosition(parser, &position))
+        {
+            return false;
+        }
+    }
+}
+
+static bool
+parseValue(struct Parser *const parser, const size_t position,
+    const unsigned int depth, cJSON *const item)
+{
+    switch (parser->text[position]) {
+        case '{':
+            return parseObject(parser, depth, item);
+        case '[':
+            return parseArray(parser, depth, item);
+        case '"':
+            item->type = cJSON_String;
+
+            return (item->valuestring = parseString(parser, position)) != NULL;
+        case 't':
+            return parseLiteral(parser, position, "true", cJSON_True, item);
+        case 'f':
+            return parseLiteral(parser, position, "false", cJSON_False, item);
+        case 'n':
+            return parseLiteral(parser, position, "null", cJSON_NULL, item);
+        default:
+            return parseNumber(parser, position, item);
+    }
+}
+
+struct LDJSON *
+LDi_JSONParseIndexed(const char *const text, const size_t length,
+    const bool interning)
+{
+    struct Parser *parser;
+    size_t position;
+    cJSON *result;
+
+    LD_ASSERT(text);
+
+    if (!(parser = LDAlloc(sizeof(struct Parser)))) {
+        return NULL;
+    }
+
+    parser->text         = text;
+    parser->length       = length;
+    parser->block        = 0;
+    parser->inString     = 0;
+    parser->oddBackslash = 0;
+    parser->scalar       = 0;
+    parser->invalid      = false;
+    parser->count        = 0;
+    parser->next         = 0;
+    parser->shared       = NULL;
+
+    if (interning && (parser->shared = LDAlloc(sizeof(struct SharedString) *
+        LD_PARSE_SHARED_CAPACITY)))
+    {
+        unsigned int name;
+
+        memset(parser->shared, 0,
+            sizeof(struct SharedString) * LD_PARSE_SHARED_CAPACITY);
+
+        parser->sharedCapacity = LD_PARSE_SHARED_CAPACITY;
+        parser->sharedCount    = 0;
+
+        for (name = 0; name < LD_NAME_COUNT && parser->shared; name++) {
+            const size_t length = strlen(LDi_names[name]);
+
+            addShared(parser, LDi_names[name], length,
+                hashBytes(LDi_names[name], length));
+        }
+    }
+
+    /* only whitespace may follow the value */
+    if ((result = newItem(cJSON_Invalid)) &&
+        (!nextPosition(parser, &position) ||
+        !parseValue(parser, position, 0, result) ||
+        nextPosition(parser, &position) || parser->invalid))
+    {
+        cJSON_Delete(result);
+
+        result = NULL;
+    }
+
+    LDFree(parser->shared);
+    LDFree(parser);
+
+    return (struct LDJSON *)result;
+}
@@ -1,5 +1,6 @@
 #include <string.h>
 #include <stdio.h>
+#include <ctype.h>
 
 #include <launchdarkly/api.h>
 
@@ -20,7 +21,7 @@ updateStore(struct LDStore *const store, const char *const rawupdate)
 
     update = NULL;
 
-    if (!(update = LDJSONDeserialize(rawupdate))) {
+    if (!(update = LDi_JSONDeserializeArena(rawupdate))) {
         LD_LOG(LD_LOG_ERROR, "failed to deserialize put");
 
         return false;
@@ -51,14 +52,87 @@ updateStore(struct LDStore *const store, const char *const rawupdate)
     return false;
 }
 
+/* how long the stream may be down before polling takes over */
+#define LD_FALLBACK_GRACE_MILLISECONDS (5 * 1000)
+/* fallback polling relaxes up to this multiple of the poll interval */
+#define LD_FALLBACK_MAX_MULTIPLIER 8
+
 struct PollContext {
     char *memory;
     size_t size;
     struct curl_slist *headers;
     bool active;
     unsigned long lastpoll;
+    CURL *curl;
+    /* validator of the last applied payload, sent as If-None-Match */
+    char etag[256];
+    char pendingEtag[256];
+    /* detects unchanged payloads when the server does not send an ETag */
+    unsigned long bodyHash;
+    /* current interval, adapts to the change rate while falling back */
+    unsigned int interval;
 };
 
+static unsigned long
+hashBody(const char *text)
+{
+    unsigned long hash;
+
+    LD_ASSERT(text);
+
+    /* FNV-1a */
+    for (hash = 2166136261UL; *text; text++) {
+        hash ^= (unsigned char)*text;
+        hash *= 16777619UL;
+    }
+
+    return hash;
+}
+
+static size_t
+headerCallback(char *const buffer, const size_t size, const size_t nitems,
+    void *const rawcontext)
+{
+    size_t realsize, namelen;
+    struct PollContext *context;
+    const char *const name = "etag:";
+
+    LD_ASSERT(buffer);
+    LD_ASSERT(rawcontext);
+
+    realsize = size * nitems;
+    context  = (struct PollContext *)rawcontext;
+    namelen  = strlen(name);
+
+    if (realsize > namelen) {
+        size_t i, begin, end;
+
+        for (i = 0; i < namelen; i++) {
+            if (tolower((unsigned char)buffer[i]) != name[i]) {
+                return realsize;
+            }
+        }
+
+        begin = namelen;
+        end   = realsize;
+
+        while (begin < end && isspace((unsigned char)buffer[begin])) {
+            begin++;
+        }
+
+        while (end > begin && isspace((unsigned char)buffer[end - 1])) {
+            end--;
+        }
+
+        if (end - begin < sizeof(context->pendingEtag)) {
+            memcpy(context->pendingEtag, buffer + begin, end - begin);
+            context->pendingEtag[end - begin] = 0;
+        }
+    }
+
+    return realsize;
+}
+
 static size_t
 writeCallback(void *const contents, const size_t size,
     const size_t nmemb, void *const rawmem)
@@ -96,31 +170,111 @@ resetMemory(struct PollContext *const context)
     context->headers = NULL;
 
     context->size = 0;
+
+    context->curl           = NULL;
+    context->pendingEtag[0] = 0;
+}
+
+/* relaxes the interval while nothing changes, tightens it on change */
+static void
+adaptInterval(struct LDClient *const client,
+    struct PollContext *const context, const bool changed)
+{
+    unsigned int ceiling;
+
+    LD_ASSERT(client);
+    LD_ASSERT(context);
+
+    ceiling = client->config->pollInterval * LD_FALLBACK_MAX_MULTIPLIER;
+
+    if (changed) {
+        context->interval = client->config->pollInterval;
+    } else if (context->interval < ceiling / 2) {
+        context->interval *= 2;
+    } else {
+        context->interval = ceiling;
+    }
+
+    LD_ASSERT(LDi_wrlock(&client->lock));
+    client->dataSource.pollInterval = context->interval;
+    LD_ASSERT(LDi_wrunlock(&client->lock));
 }
 
 static void
 done(struct LDClient *const client, void *const rawcontext, const bool success)
 {
     struct PollContext *context;
+    long responsecode;
+    bool changed, streamDown;
 
     LD_ASSERT(client);
     LD_ASSERT(rawcontext);
 
     context = (struct PollContext *)rawcontext;
     context->active = false;
+    responsecode    = 0;
+    changed         = false;
 
-    if (success) {
-        if (updateStore(client->store, context->memory)) {
-            LD_ASSERT(LDi_wrlock(&client->lock));
-            client->initialized = true;
-            LD_ASSERT(LDi_wrunlock(&client->lock));
+    if (!success) {
+        goto cleanup;
+    }
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&context->lastpoll));
+
+    LD_ASSERT(LDi_rdlock(&client->lock));
+    streamDown = client->streamDown;
+    LD_ASSERT(LDi_rdunlock(&client->lock));
+
+    /* the stream delivered newer data while this request was in flight */
+    if (client->config->stream && !streamDown) {
+        goto cleanup;
+    }
+
+    LD_ASSERT(context->curl);
+
+    if (curl_easy_getinfo(context->curl, CURLINFO_RESPONSE_CODE,
+        &responsecode) != CURLE_OK)
+    {
+        LD_LOG(LD_LOG_ERROR, "failed to get polling response code");
+
+        goto cleanup;
+    }
+
+    if (responsecode == 304) {
+        LD_LOG(LD_LOG_TRACE, "polling payload not modified");
+    } else if (context->memory) {
+        const unsigned long hash = hashBody(context->memory);
+
+        if (hash == context->bodyHash && context->bodyHash != 0) {
+            LD_LOG(LD_LOG_TRACE, "polling payload unchanged");
+        } else if (updateStore(client->store, context->memory)) {
+            changed           = true;
+            context->bodyHash = hash;
+
+            memcpy(context->etag, context->pendingEtag,
+                sizeof(context->etag));
         } else {
             LD_LOG(LD_LOG_ERROR, "polling failed to update store");
+
+            goto cleanup;
         }
+    } else {
+        LD_LOG(LD_LOG_ERROR, "polling received an empty payload");
+
+        goto cleanup;
+    }
 
-        LD_ASSERT(LDi_getMonotonicMilliseconds(&context->lastpoll));
+    if (client->config->stream) {
+        adaptInterval(client, context, changed);
+    } else {
+        LD_ASSERT(LDi_wrlock(&client->lock));
+        LDi_setDataSourceState(client, LD_DATA_SOURCE_POLLING);
+        LD_ASSERT(LDi_wrunlock(&client->lock));
     }
 
+    LDi_setInitialized(client);
+
+  cleanup:
     resetMemory(context);
 }
 
@@ -150,19 +304,48 @@ poll(struct LDClient *const client, void *const rawcontext)
     curl    = NULL;
     context = (struct PollContext *)rawcontext;
 
-    if (context->active || client->config->stream) {
+    if (context->active) {
         return NULL;
     }
 
     {
-        unsigned long now;
+        unsigned long now, interval;
+        bool streamDown;
+        unsigned long streamDownSince;
 
         LD_ASSERT(LDi_getMonotonicMilliseconds(&now));
         LD_ASSERT(now >= context->lastpoll);
 
-        if (now - context->lastpoll < client->config->pollInterval) {
+        interval = client->config->pollInterval;
+
+        if (client->config->stream) {
+            LD_ASSERT(LDi_rdlock(&client->lock));
+            streamDown      = client->streamDown;
+            streamDownSince = client->streamDownSince;
+            LD_ASSERT(LDi_rdunlock(&client->lock));
+
+            /* only poll when the stream is unable to deliver updates */
+            if (!streamDown ||
+                now - streamDownSince < LD_FALLBACK_GRACE_MILLISECONDS)
+            {
+                context->interval = client->config->pollInterval;
+
+                return NULL;
+            }
+
+            interval = context->interval;
+        }
+
+        if (context->lastpoll && now - context->lastpoll < interval) {
             return NULL;
         }
+
+        if (client->config->stream) {
+            LD_ASSERT(LDi_wrlock(&client->lock));
+            LDi_setDataSourceState(client, LD_DATA_SOURCE_FALLBACK);
+            client->dataSource.pollInterval = context->interval;
+            LD_ASSERT(LDi_wrunlock(&client->lock));
+        }
     }
 
     if (snprintf(url, sizeof(url), "%s/sdk/latest-all",
@@ -201,12 +384,60 @@ poll(struct LDClient *const client, void *const rawcontext)
         goto error;
     }
 
+    if (curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerCallback)
+        != CURLE_OK)
+    {
+        LD_LOG(LD_LOG_CRITICAL,
+            "curl_easy_setopt CURLOPT_HEADERFUNCTION failed");
+
+        goto error;
+    }
+
+    if (curl_easy_setopt(curl, CURLOPT_HEADERDATA, context) != CURLE_OK) {
+        LD_LOG(LD_LOG_CRITICAL, "curl_easy_setopt CURLOPT_HEADERDATA failed");
+
+        goto error;
+    }
+
+    /* conditional request, an unchanged payload is answered with 304 */
+    if (context->etag[0]) {
+        char header[300];
+        struct curl_slist *headers;
+
+        if (snprintf(header, sizeof(header), "If-None-Match: %s",
+            context->etag) < 0)
+        {
+            LD_LOG(LD_LOG_CRITICAL, "snprintf If-None-Match failed");
+
+            goto error;
+        }
+
+        if (!(headers = curl_slist_append(context->headers, header))) {
+            LD_LOG(LD_LOG_CRITICAL, "curl_slist_append failed for etag");
+
+            goto error;
+        }
+
+        context->headers = headers;
+
+        if (curl_easy_setopt(curl, CURLOPT_HTTPHEADER, context->headers)
+            != CURLE_OK)
+        {
+            LD_LOG(LD_LOG_CRITICAL,
+                "curl_easy_setopt CURLOPT_HTTPHEADER failed");
+
+            goto error;
+        }
+    }
+
+    context->curl   = curl;
     context->active = true;
 
     return curl;
 
   error:
     curl_slist_free_all(context->headers);
+    context->headers = NULL;
 
     curl_easy_cleanup(curl);
 
@@ -241,6 +472,12 @@ LDi_constructPolling(struct LDClient *const client)
     context->headers  = NULL;
     context->active   = false;
     context->lastpoll = 0;
+    context->curl     = NULL;
+    context->etag[0]  = 0;
+    context->bodyHash = 0;
+    context->interval = client->config->pollInterval;
+
+    context->pendingEtag[0] = 0;
 
     netInterface->done      = done;
     netInterface->poll      = poll;
@@ -0,0 +1,187 @@
+#include <launchdarkly/api.h>
+
+#include "misc.h"
+#include "pool.h"
+
+struct LDPool {
+    ld_thread_t *threads;
+    unsigned int threadCount;
+    ld_mutex_t lock;
+    /* signalled when a job starts, a job finishes, or the pool stops */
+    ld_cond_t condition;
+    /* following fields guarded by lock */
+    bool stopping;
+    bool busy;
+    void (*work)(void *const context, const unsigned int part);
+    void *context;
+    unsigned int parts;
+    unsigned int nextPart;
+    unsigned int partsDone;
+};
+
+/* Expects lock. Runs parts of the current job until none are left to take,
+releasing the lock while each runs. */
+static void
+runParts(struct LDPool *const pool)
+{
+    LD_ASSERT(pool);
+
+    while (pool->busy && pool->nextPart < pool->parts) {
+        void (*const work)(void *const, const unsigned int) = pool->work;
+        void *const context      = pool->context;
+        const unsigned int part  = pool->nextPart++;
+
+        LD_ASSERT(LDi_mtxunlock(&pool->lock));
+        work(context, part);
+        LD_ASSERT(LDi_mtxlock(&pool->lock));
+
+        if (++pool->partsDone == pool->parts) {
+            LDi_condsignal(&pool->condition);
+        }
+    }
+}
+
+static THREAD_RETURN
+worker(void *const poolRaw)
+{
+    struct LDPool *pool;
+
+    LD_ASSERT(poolRaw);
+
+    pool = (struct LDPool *)poolRaw;
+
+    LD_ASSERT(LDi_mtxlock(&pool->lock));
+
+    while (!pool->stopping) {
+        if (pool->busy && pool->nextPart < pool->parts) {
+            runParts(pool);
+        } else {
+            LDi_condwait(&pool->condition, &pool->lock, 1000 * 60);
+        }
+    }
+
+    LD_ASSERT(LDi_mtxunlock(&pool->lock));
+
+    return THREAD_RETURN_DEFAULT;
+}
+
+static void
+stopWorkers(struct LDPool *const pool, const unsigned int started)
+{
+    unsigned int i;
+
+    LD_ASSERT(pool);
+
+    LD_ASSERT(LDi_mtxlock(&pool->lock));
+    pool->stopping = true;
+    LD_ASSERT(LDi_mtxunlock(&pool->lock));
+
+    LDi_condsignal(&pool->condition);
+
+    for (i = 0; i < started; i++) {
+        LD_ASSERT(LDi_jointhread(pool->threads[i]));
+    }
+}
+
+struct LDPool *
+LDi_poolNew(const unsigned int threads)
+{
+    struct LDPool *pool;
+    unsigned int started;
+
+    LD_ASSERT(threads > 0);
+
+    if (!(pool = (struct LDPool *)LDAlloc(sizeof(struct LDPool)))) {
+        return NULL;
+    }
+
+    memset(pool, 0, sizeof(struct LDPool));
+
+    if (!(pool->threads = (ld_thread_t *)
+        LDAlloc(sizeof(ld_thread_t) * threads)))
+    {
+        LDFree(pool);
+
+        return NULL;
+    }
+
+    LD_ASSERT(LDi_mtxinit(&pool->lock));
+    LDi_condinit(&pool->condition);
+
+    for (started = 0; started < threads; started++) {
+        if (!LDi_createthread(&pool->threads[started], worker, pool)) {
+            LD_LOG(LD_LOG_ERROR, "failed to start pool thread");
+
+            stopWorkers(pool, started);
+
+            LD_ASSERT(LDi_mtxdestroy(&pool->lock));
+            LDi_conddestroy(&pool->condition);
+            LDFree(pool->threads);
+            LDFree(pool);
+
+            return NULL;
+        }
+    }
+
+    pool->threadCount = threads;
+
+    return pool;
+}
+
+void
+LDi_poolFree(struct LDPool *const pool)
+{
+    if (pool) {
+        stopWorkers(pool, pool->threadCount);
+
+        LD_ASSERT(LDi_mtxdestroy(&pool->lock));
+        LDi_conddestroy(&pool->condition);
+        LDFree(pool->threads);
+        LDFree(pool);
+    }
+}
+
+void
+LDi_poolRun(struct LDPool *const pool,
+    void (*const work)(void *const context, const unsigned int part),
+    void *const context, const unsigned int parts)
+{
+    unsigned int part;
+
+    LD_ASSERT(work);
+
+    if (pool && parts > 1) {
+        LD_ASSERT(LDi_mtxlock(&pool->lock));
+
+        if (!pool->busy) {
+            pool->busy      = true;
+            pool->work      = work;
+            pool->context   = context;
+            pool->parts     = parts;
+            pool->nextPart  = 0;
+            pool->partsDone = 0;
+
+            LDi_condsignal(&pool->condition);
+
+            runParts(pool);
+
+            while (pool->partsDone < pool->parts) {
+                LDi_condwait(&pool->condition, &pool->lock, 1000 * 60);
+            }
+
+            pool->busy    = false;
+            pool->work    = NULL;
+            pool->context = NULL;
+
+            LD_ASSERT(LDi_mtxunlock(&pool->lock));
+
+            return;
+        }
+
+        LD_ASSERT(LDi_mtxunlock(&pool->lock));
+    }
+
+    for (part = 0; part < parts; part++) {
+        work(context, part);
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdbool.h>
+
+/* A fixed set of threads that split a job into parts with the caller. */
+struct LDPool;
+
+/* starts threads workers, returns NULL on failure */
+struct LDPool *LDi_poolNew(const unsigned int threads);
+
+void LDi_poolFree(struct LDPool *const pool);
+
+/* Calls work for every part in [0, parts) on the workers and the calling
+thread, returning once all of them are done. Parts may run in any order.
+Without a pool, or while the pool runs the job of another caller,
+everything runs on the calling thread. */
+void LDi_poolRun(struct LDPool *const pool,
+    void (*const work)(void *const context, const unsigned int part),
+    void *const context, const unsigned int parts);
@@ -1,4 +1,8 @@
+#include <stdlib.h>
+#include <string.h>
+
 #include "uthash.h"
+#include "utlist.h"
 
 #include <launchdarkly/api.h>
 
@@ -12,8 +16,6 @@ struct CacheItem;
 
 static const char *const LD_SS_FEATURES   = "features";
 static const char *const LD_SS_SEGMENTS   = "segments";
-static const char *const INIT_CHECKED_KEY = "$initChecked";
-
 static bool memoryInit(struct LDStore *const context,
     struct LDJSON *const sets);
 
@@ -94,6 +96,106 @@ LDi_getFeatureVersion(const struct LDJSON *const feature)
     return LDGetNumber(tmp);
 }
 
+static const char *
+skipWhitespace(const char *text)
+{
+    while (*text == ' ' || *text == '\t' || *text == '\n' || *text == '\r') {
+        text++;
+    }
+
+    return text;
+}
+
+bool
+LDi_scanFeatureVersion(const char *text, unsigned int *const version,
+    bool *const deleted)
+{
+    unsigned int depth;
+    bool expectKey;
+
+    LD_ASSERT(text);
+    LD_ASSERT(version);
+    LD_ASSERT(deleted);
+
+    *version  = 0;
+    *deleted  = false;
+    depth     = 0;
+    expectKey = false;
+
+    for (; *text; text++) {
+        switch (*text) {
+            case '{':
+                depth++;
+                expectKey = depth == 1;
+                break;
+            case '[':
+                depth++;
+                break;
+            case '}':
+            case ']':
+                if (depth == 0) {
+                    return false;
+                }
+                depth--;
+                break;
+            case ',':
+                expectKey = depth == 1;
+                break;
+            case '"':
+                {
+                    const char *const begin = text + 1;
+                    size_t length;
+
+                    for (text = begin; *text != '"'; text++) {
+                        if (*text == '\\') {
+                            text++;
+                        }
+
+                        if (*text == 0) {
+                            return false;
+                        }
+                    }
+
+                    if (depth != 1 || !expectKey) {
+                        break;
+                    }
+
+                    expectKey = false;
+                    length    = text - begin;
+
+                    {
+                        const char *value;
+
+                        value = skipWhitespace(text + 1);
+
+                        if (*value != ':') {
+                            return false;
+                        }
+
+                        value = skipWhitespace(value + 1);
+
+                        if (length == 7 && strncmp(begin, "version", 7) == 0)
+                        {
+                            char *end;
+                            const double number = strtod(value, &end);
+
+                            if (end != value && number >= 0) {
+                                *version = number;
+                            }
+                        } else if (length == 7 &&
+                            strncmp(begin, "deleted", 7) == 0)
+                        {
+                            *deleted = strncmp(value, "true", 4) == 0;
+                        }
+                    }
+                }
+                break;
+        }
+    }
+
+    return depth == 0;
+}
+
 static const char *
 LDi_getFeatureKeyTrusted(const struct LDJSON *const feature)
 {
@@ -196,10 +298,33 @@ LDi_makeDeleted(const char *const key, const unsigned int version)
 
 /* **** LDStore **** */
 
+struct RefreshRequest;
+struct Flight;
+
 struct LDStore {
     struct MemoryContext *cache;
     struct LDStoreInterface *backend;
+    struct LDStoreInterfaceExtensions extensions;
     unsigned int cacheMilliseconds;
+    unsigned int hardCacheMilliseconds;
+    unsigned int negativeCacheMilliseconds;
+    unsigned int negativeCacheCapacity;
+    unsigned int initCheckMilliseconds;
+    /* refresh-ahead worker, only started when the hard TTL is in use */
+    bool refreshStarted;
+    ld_thread_t refreshThread;
+    ld_mutex_t refreshLock;
+    ld_cond_t refreshCondition;
+    /* following fields guarded by refreshLock */
+    bool refreshStopping;
+    /* queued or running requests, ut hash table by cache key */
+    struct RefreshRequest *refreshPending;
+    /* queued requests, oldest first */
+    struct RefreshRequest *refreshQueue;
+    /* backend reads in progress, ut hash table by cache key */
+    ld_mutex_t flightLock;
+    ld_cond_t flightCondition;
+    struct Flight *flights;
 };
 
 /* ***** Reference counting **** */
@@ -288,6 +413,26 @@ struct CacheItem {
     UT_hash_handle hh;
     /* monotonic milliseconds */
     unsigned long updatedOn;
+    /* placeholder for an item missing from the backend */
+    bool negative;
+    struct CacheItem *negativePrev, *negativeNext;
+};
+
+struct MemoryContext {
+    bool initialized;
+    /* last negative answer from the backend, rate limits further checks */
+    bool initChecked;
+    unsigned long initCheckedOn;
+    /* a caller is currently asking the backend */
+    bool initChecking;
+    /* bumped by backend invalidations, reads overlapping one are not cached */
+    unsigned long invalidations;
+    /* ut hash table */
+    struct CacheItem *items;
+    /* items the backend does not have, oldest first */
+    struct CacheItem *negatives;
+    unsigned int negativeCount;
+    ld_rwlock_t lock;
 };
 
 static void
@@ -301,13 +446,19 @@ deleteCacheItem(struct CacheItem *const item)
 }
 
 static void
-deleteAndRemoveCacheItem(struct CacheItem **const collection,
+deleteAndRemoveCacheItem(struct MemoryContext *const context,
     struct CacheItem *const item)
 {
-    if (collection && item) {
+    if (context && item) {
+        if (item->negative) {
+            DL_DELETE2(context->negatives, item, negativePrev, negativeNext);
+
+            context->negativeCount--;
+        }
+
         LDFree(item->key);
         LDJSONRCDecrement(item->feature);
-        HASH_DEL(*collection, item);
+        HASH_DEL(context->items, item);
         LDFree(item);
     }
 }
@@ -362,13 +513,6 @@ makeCacheItem(const char *const key, struct LDJSON *value)
     return NULL;
 }
 
-struct MemoryContext {
-    bool initialized;
-    /* ut hash table */
-    struct CacheItem *items;
-    ld_rwlock_t lock;
-};
-
 static char *
 featureStoreCacheKey(const char *const kind, const char *const key)
 {
@@ -408,10 +552,12 @@ featureStoreAllCacheKey(const char *const kind)
     return result;
 }
 
-/* expects write lock */
+/* Expects write lock. Without a backend the filtered copy of all items is
+copied and updated as well, unless initializing, which caches it once all
+items are in. */
 static bool
-upsertMemory(struct LDStore *const store, const char *const kind,
-    struct LDJSON *replacement)
+upsertMemoryItem(struct LDStore *const store, const char *const kind,
+    struct LDJSON *replacement, const bool initializing)
 {
     bool success;
     struct LDJSON *weakReplacementRef;
@@ -467,7 +613,9 @@ upsertMemory(struct LDStore *const store, const char *const kind,
 
     HASH_FIND_STR(store->cache->items, allCacheKey, allItems);
 
-    if (!store->backend) {
+    if (initializing) {
+        /* filterAndCacheItems caches all items itself */
+    } else if (!store->backend) {
         struct LDJSON *itemDupe;
 
         itemDupe = NULL;
@@ -501,7 +649,7 @@ upsertMemory(struct LDStore *const store, const char *const kind,
                 goto cleanup;
             }
 
-            deleteAndRemoveCacheItem(&store->cache->items, allItems);
+            deleteAndRemoveCacheItem(store->cache, allItems);
 
             HASH_ADD_KEYPTR(hh, store->cache->items, allDupeItem->key,
                 strlen(allDupeItem->key), allDupeItem);
@@ -529,11 +677,11 @@ upsertMemory(struct LDStore *const store, const char *const kind,
                 strlen(singletonItem->key), singletonItem);
         }
     } else if (allItems) {
-        deleteAndRemoveCacheItem(&store->cache->items, allItems);
+        deleteAndRemoveCacheItem(store->cache, allItems);
     }
 
     if (currentItem) {
-        deleteAndRemoveCacheItem(&store->cache->items, currentItem);
+        deleteAndRemoveCacheItem(store->cache, currentItem);
     }
 
     HASH_ADD_KEYPTR(hh, store->cache->items, replacementItem->key,
@@ -552,6 +700,14 @@ upsertMemory(struct LDStore *const store, const char *const kind,
     return success;
 }
 
+/* expects write lock */
+static bool
+upsertMemory(struct LDStore *const store, const char *const kind,
+    struct LDJSON *replacement)
+{
+    return upsertMemoryItem(store, kind, replacement, false);
+}
+
 /* expects write lock */
 static bool
 filterAndCacheItems(struct LDStore *const store, const char *const kind,
@@ -591,20 +747,43 @@ filterAndCacheItems(struct LDStore *const store, const char *const kind,
             dupe = NULL;
         }
 
-        if (!upsertMemory(store, kind,
-            LDCollectionDetachIter(features, featuresIter)))
+        /* without a result the filtered items are cached below, instead of
+        copying them for every item */
+        if (!upsertMemoryItem(store, kind,
+            LDCollectionDetachIter(features, featuresIter), !result))
         {
             goto cleanup;
         }
     }
 
-    success = true;
-
     if (result) {
         *result       = filteredItems;
         filteredItems = NULL;
+    } else if (!store->backend && LDCollectionGetSize(filteredItems)) {
+        struct CacheItem *allItems;
+        char *allCacheKey;
+
+        if (!(allCacheKey = featureStoreAllCacheKey(kind))) {
+            goto cleanup;
+        }
+
+        allItems = makeCacheItem(allCacheKey, filteredItems);
+
+        LDFree(allCacheKey);
+
+        /* consumed either way */
+        filteredItems = NULL;
+
+        if (!allItems) {
+            goto cleanup;
+        }
+
+        HASH_ADD_KEYPTR(hh, store->cache->items, allItems->key,
+            strlen(allItems->key), allItems);
     }
 
+    success = true;
+
   cleanup:
     LDJSONFree(dupe);
     LDJSONFree(filteredItems);
@@ -621,12 +800,185 @@ memoryCacheFlush(struct MemoryContext *const context)
     LD_ASSERT(context);
 
     HASH_ITER(hh, context->items, item, itemTmp) {
-        deleteAndRemoveCacheItem(&context->items, item);
+        deleteAndRemoveCacheItem(context, item);
     }
 
     context->items = NULL;
 }
 
+/* Expects write lock. A NULL kind drops everything, a NULL key drops every
+item of the kind. */
+static void
+memoryInvalidate(struct MemoryContext *const context, const char *const kind,
+    const char *const key)
+{
+    struct CacheItem *item, *itemTmp;
+    char *allCacheKey, *cacheKey;
+    size_t kindLength;
+
+    LD_ASSERT(context);
+    LD_ASSERT(kind || !key);
+
+    context->invalidations++;
+
+    if (!kind) {
+        memoryCacheFlush(context);
+
+        return;
+    }
+
+    allCacheKey = featureStoreAllCacheKey(kind);
+    cacheKey    = key ? featureStoreCacheKey(kind, key) : NULL;
+
+    if (!allCacheKey || (key && !cacheKey)) {
+        /* dropping more than needed is always safe */
+        memoryCacheFlush(context);
+    } else if (key) {
+        HASH_FIND_STR(context->items, cacheKey, item);
+        deleteAndRemoveCacheItem(context, item);
+
+        HASH_FIND_STR(context->items, allCacheKey, item);
+        deleteAndRemoveCacheItem(context, item);
+    } else {
+        kindLength = strlen(kind);
+
+        HASH_ITER(hh, context->items, item, itemTmp) {
+            if (strcmp(item->key, allCacheKey) == 0 ||
+                (strncmp(item->key, kind, kindLength) == 0 &&
+                item->key[kindLength] == ':'))
+            {
+                deleteAndRemoveCacheItem(context, item);
+            }
+        }
+    }
+
+    LDFree(allCacheKey);
+    LDFree(cacheKey);
+}
+
+/* given to the backend as its LDStoreInvalidate */
+static void
+invalidateCache(void *const storeRaw, const char *const kind,
+    const char *const key)
+{
+    struct LDStore *store;
+
+    LD_ASSERT(storeRaw);
+
+    store = (struct LDStore *)storeRaw;
+
+    LD_ASSERT(LDi_wrlock(&store->cache->lock));
+    memoryInvalidate(store->cache, kind, key);
+    LD_ASSERT(LDi_wrunlock(&store->cache->lock));
+}
+
+static unsigned long
+cacheGeneration(struct LDStore *const store)
+{
+    unsigned long generation;
+
+    LD_ASSERT(store);
+
+    LD_ASSERT(LDi_rdlock(&store->cache->lock));
+    generation = store->cache->invalidations;
+    LD_ASSERT(LDi_rdunlock(&store->cache->lock));
+
+    return generation;
+}
+
+/* Caches an item read from the backend, unless an invalidation arrived while
+it was read, in which case it may already be outdated. Consumes item. */
+static bool
+cacheBackendItem(struct LDStore *const store, const char *const kind,
+    struct LDJSON *const item, const unsigned long generation)
+{
+    bool success;
+
+    LD_ASSERT(store);
+    LD_ASSERT(kind);
+    LD_ASSERT(item);
+
+    LD_ASSERT(LDi_wrlock(&store->cache->lock));
+    if (store->cache->invalidations == generation) {
+        success = upsertMemory(store, kind, item);
+    } else {
+        LDJSONFree(item);
+
+        success = true;
+    }
+    LD_ASSERT(LDi_wrunlock(&store->cache->lock));
+
+    return success;
+}
+
+/* Caches that the backend does not have an item, unless an invalidation
+arrived while it was read. The oldest such entry is evicted at capacity. */
+static bool
+cacheNegativeItem(struct LDStore *const store, const char *const kind,
+    const char *const key, const unsigned int version,
+    const unsigned long generation)
+{
+    struct LDJSON *placeholder;
+    struct CacheItem *item;
+    char *cacheKey;
+    bool success;
+
+    LD_ASSERT(store);
+    LD_ASSERT(kind);
+    LD_ASSERT(key);
+
+    if (store->negativeCacheCapacity == 0 ||
+        store->negativeCacheMilliseconds == 0)
+    {
+        return true;
+    }
+
+    if (!(placeholder = LDi_makeDeleted(key, version))) {
+        return false;
+    }
+
+    if (!(cacheKey = featureStoreCacheKey(kind, key))) {
+        LDJSONFree(placeholder);
+
+        return false;
+    }
+
+    LD_ASSERT(LDi_wrlock(&store->cache->lock));
+    if (store->cache->invalidations != generation) {
+        LDJSONFree(placeholder);
+
+        success = true;
+    } else {
+        struct LDJSON *const weakPlaceholderRef = placeholder;
+
+        success = upsertMemory(store, kind, placeholder);
+
+        HASH_FIND_STR(store->cache->items, cacheKey, item);
+
+        /* a newer item from a concurrent upsert may have been kept */
+        if (success && item && !item->negative &&
+            LDJSONRCGet(item->feature) == weakPlaceholderRef)
+        {
+            if (store->cache->negativeCount == store->negativeCacheCapacity) {
+                deleteAndRemoveCacheItem(store->cache,
+                    store->cache->negatives);
+            }
+
+            item->negative = true;
+
+            DL_APPEND2(store->cache->negatives, item, negativePrev,
+                negativeNext);
+
+            store->cache->negativeCount++;
+        }
+    }
+    LD_ASSERT(LDi_wrunlock(&store->cache->lock));
+
+    LDFree(cacheKey);
+
+    return success;
+}
+
 static bool
 memoryInit(struct LDStore *const store, struct LDJSON *const sets)
 {
@@ -657,9 +1009,10 @@ memoryInit(struct LDStore *const store, struct LDJSON *const sets)
         }
     }
 
-    if (!store->backend) {
-        store->cache->initialized = true;
-    }
+    /* any backend was initialized first, so it is no longer uninitialized
+    whatever an earlier check found */
+    store->cache->initialized = true;
+    store->cache->initChecked = false;
 
     LD_ASSERT(LDi_wrunlock(&store->cache->lock));
 
@@ -668,36 +1021,52 @@ memoryInit(struct LDStore *const store, struct LDJSON *const sets)
     return true;
 }
 
+/* cache keys of flags and segments this long are formatted on the stack */
+#define LD_STORE_CACHE_KEY_STORAGE 256
+
 static bool
 memoryGetCollectionItem(struct MemoryContext *const context,
     const char *const kind, const char *const key,
     struct CacheItem **result)
 {
-    char *cacheKey;
+    char *cacheKey, cacheKeyStorage[LD_STORE_CACHE_KEY_STORAGE];
     struct CacheItem *current;
+    size_t kindLength, keyLength;
 
     LD_ASSERT(context);
     LD_ASSERT(kind);
     LD_ASSERT(key);
     LD_ASSERT(result);
 
-    cacheKey = NULL;
-    *result  = NULL;
+    cacheKey   = NULL;
+    *result    = NULL;
+    kindLength = strlen(kind);
+    keyLength  = strlen(key);
 
-    if (!(cacheKey = featureStoreCacheKey(kind, key))) {
+    /* same format as featureStoreCacheKey */
+    if (kindLength + 1 + keyLength + 1 <= sizeof(cacheKeyStorage)) {
+        cacheKey = cacheKeyStorage;
+
+        memcpy(cacheKey, kind, kindLength);
+        cacheKey[kindLength] = ':';
+        memcpy(cacheKey + kindLength + 1, key, keyLength + 1);
+    } else if (!(cacheKey = featureStoreCacheKey(kind, key))) {
         return false;
     }
 
     HASH_FIND_STR(context->items, cacheKey, current);
 
-    LDFree(cacheKey);
+    if (cacheKey != cacheKeyStorage) {
+        LDFree(cacheKey);
+    }
 
     *result = current;
 
     return true;
 }
 
-/* -1 error, 0 not expired, 1 expired */
+/* -1 error, 0 not expired, 1 expired, 2 expired but may be served while it
+is refreshed in the background */
 static int
 isExpired(const struct LDStore *const store,
     const struct CacheItem *const item)
@@ -711,63 +1080,62 @@ isExpired(const struct LDStore *const store,
         return 0;
     }
 
+    if (item->negative) {
+        if (!LDi_getMonotonicMilliseconds(&now)) {
+            return -1;
+        }
+
+        return (now - item->updatedOn) > store->negativeCacheMilliseconds;
+    }
+
     if (store->cacheMilliseconds == 0) {
         return 1;
     }
 
     if (LDi_getMonotonicMilliseconds(&now)) {
-        if ((now - item->updatedOn) > store->cacheMilliseconds) {
-            return 1;
-        } else {
+        if ((now - item->updatedOn) <= store->cacheMilliseconds) {
             return 0;
+        } else if (store->refreshStarted &&
+            (now - item->updatedOn) <= store->hardCacheMilliseconds)
+        {
+            return 2;
+        } else {
+            return 1;
         }
     } else {
         return -1;
     }
 }
 
-/* if there is a backend use it to fetch all features */
+/* Caches the result of a backend `all`. Consumes the items. */
 static bool
-tryGetAllBackend(struct LDStore *const store, const char *const kind,
+cacheBackendAll(struct LDStore *const store, const char *const kind,
+    struct LDStoreCollectionItem *const rawFeatureItems,
+    const unsigned int rawFeaturesCount, const unsigned long generation,
     struct LDJSONRC **const result)
 {
     bool success;
-    struct LDStoreCollectionItem *rawFeatureItems;
-    unsigned int rawFeaturesCount, i;
+    unsigned int i;
     struct LDJSON *active, *rawFeatures, *activeDupe;
     struct LDJSONRC *activeRC;
     char *cacheKey;
-    struct CacheItem *cacheItem;
+    struct CacheItem *cacheItem, *previousItem;
 
     LD_ASSERT(store);
     LD_ASSERT(kind);
+    LD_ASSERT(rawFeatureItems || rawFeaturesCount == 0);
     LD_ASSERT(result);
 
-    success          = false;
-    *result          = NULL;
-    rawFeatureItems  = NULL;
-    rawFeaturesCount = 0;
-    i                = 0;
-    active           = NULL;
-    rawFeatures      = NULL;
-    activeRC         = NULL;
-    cacheKey         = NULL;
-    cacheItem        = NULL;
-    activeDupe       = NULL;
-
-    if (!store->backend) {
-        success = true;
-
-        goto cleanup;
-    }
-
-    LD_ASSERT(store->backend->all);
-
-    if (!store->backend->all(store->backend->context, kind, &rawFeatureItems,
-        &rawFeaturesCount))
-    {
-        goto cleanup;
-    }
+    success      = false;
+    *result      = NULL;
+    i            = 0;
+    active       = NULL;
+    rawFeatures  = NULL;
+    activeRC     = NULL;
+    cacheKey     = NULL;
+    cacheItem    = NULL;
+    previousItem = NULL;
+    activeDupe   = NULL;
 
     if (!(rawFeatures = LDNewObject())) {
         goto cleanup;
@@ -783,7 +1151,9 @@ tryGetAllBackend(struct LDStore *const store, const char *const kind,
             continue;
         }
 
-        if (!(deserialized = LDJSONDeserialize(rawFeatureItems[i].buffer))) {
+        if (!(deserialized = LDi_JSONDeserializeArena(
+            rawFeatureItems[i].buffer)))
+        {
             goto cleanup;
         }
 
@@ -816,22 +1186,26 @@ tryGetAllBackend(struct LDStore *const store, const char *const kind,
     }
     rawFeatures = NULL;
 
-    if (!(cacheKey = featureStoreAllCacheKey(kind))) {
-        goto cleanup;
-    }
-
-    if (!(activeDupe = LDJSONDuplicate(active))) {
-        goto cleanup;
-    }
+    if (store->cache->invalidations != generation) {
+        /* the items cached above may already be outdated */
+        memoryInvalidate(store->cache, kind, NULL);
+    } else if (!(cacheKey = featureStoreAllCacheKey(kind)) ||
+        !(activeDupe = LDJSONDuplicate(active)) ||
+        !(cacheItem = makeCacheItem(cacheKey, activeDupe)))
+    {
+        LD_ASSERT(LDi_wrunlock(&store->cache->lock));
 
-    if (!(cacheItem = makeCacheItem(cacheKey, activeDupe))) {
         goto cleanup;
-    }
-    activeDupe = NULL;
+    } else {
+        activeDupe = NULL;
 
-    HASH_ADD_KEYPTR(hh, store->cache->items, cacheItem->key,
-        strlen(cacheItem->key), cacheItem);
+        /* replaces the previous copy, an empty collection included */
+        HASH_FIND_STR(store->cache->items, cacheKey, previousItem);
+        deleteAndRemoveCacheItem(store->cache, previousItem);
 
+        HASH_ADD_KEYPTR(hh, store->cache->items, cacheItem->key,
+            strlen(cacheItem->key), cacheItem);
+    }
     LD_ASSERT(LDi_wrunlock(&store->cache->lock));
 
     if (!(activeRC = LDJSONRCNew(active))) {
@@ -843,10 +1217,9 @@ tryGetAllBackend(struct LDStore *const store, const char *const kind,
     success = true;
 
   cleanup:
-    LDFree(active);
-    LDFree(rawFeatures);
+    LDJSONFree(active);
+    LDJSONFree(rawFeatures);
     LDFree(cacheKey);
-    LDFree(activeDupe);
 
     for (i = 0; i < rawFeaturesCount; i++) {
         LDFree(rawFeatureItems[i].buffer);
@@ -857,47 +1230,70 @@ tryGetAllBackend(struct LDStore *const store, const char *const kind,
     return success;
 }
 
+/* if there is a backend use it to fetch all features */
 static bool
-tryGetBackend(struct LDStore *const store, const char *const kind,
-    const char *const key, struct LDJSONRC **const result)
+tryGetAllBackend(struct LDStore *const store, const char *const kind,
+    struct LDJSONRC **const result)
 {
-    struct LDStoreCollectionItem collectionItem;
+    struct LDStoreCollectionItem *rawFeatureItems;
+    unsigned int rawFeaturesCount;
+    unsigned long generation;
 
     LD_ASSERT(store);
     LD_ASSERT(kind);
-    LD_ASSERT(key);
     LD_ASSERT(result);
 
-    *result = NULL;
-    memset(&collectionItem, 0, sizeof(struct LDStoreCollectionItem));
+    *result          = NULL;
+    rawFeatureItems  = NULL;
+    rawFeaturesCount = 0;
 
     if (!store->backend) {
         return true;
     }
 
-    LD_ASSERT(store->backend->get);
+    LD_ASSERT(store->backend->all);
 
-    if (!store->backend->get(store->backend->context, kind, key,
-        &collectionItem))
+    generation = cacheGeneration(store);
+
+    if (!store->backend->all(store->backend->context, kind, &rawFeatureItems,
+        &rawFeaturesCount))
     {
         return false;
     }
 
-    if (collectionItem.buffer) {
-        struct LDJSON *deserialized, *dupe;
-        struct LDJSONRC *deserializedRef;
-
-        if (!(deserialized = LDJSONDeserialize(
-            (const char *)collectionItem.buffer)))
-        {
-            LD_LOG(LD_LOG_ERROR, "LDStoreGet failed to deserialize JSON");
-
-            LDFree(collectionItem.buffer);
+    return cacheBackendAll(store, kind, rawFeatureItems, rawFeaturesCount,
+        generation, result);
+}
+
+/* Caches the result of a backend `get`. Consumes the item buffer. */
+static bool
+cacheBackendGet(struct LDStore *const store, const char *const kind,
+    const char *const key, struct LDStoreCollectionItem *const collectionItem,
+    const unsigned long generation, struct LDJSONRC **const result)
+{
+    LD_ASSERT(store);
+    LD_ASSERT(kind);
+    LD_ASSERT(key);
+    LD_ASSERT(collectionItem);
+    LD_ASSERT(result);
+
+    *result = NULL;
+
+    if (collectionItem->buffer) {
+        struct LDJSON *deserialized, *dupe;
+        struct LDJSONRC *deserializedRef;
+
+        if (!(deserialized = LDi_JSONDeserializeArena(
+            (const char *)collectionItem->buffer)))
+        {
+            LD_LOG(LD_LOG_ERROR, "LDStoreGet failed to deserialize JSON");
+
+            LDFree(collectionItem->buffer);
 
             return false;
         }
 
-        LDFree(collectionItem.buffer);
+        LDFree(collectionItem->buffer);
 
         if (!LDi_validateFeature(deserialized)) {
             LD_LOG(LD_LOG_ERROR, "LDStoreGet invalid feature from backend");
@@ -908,7 +1304,7 @@ tryGetBackend(struct LDStore *const store, const char *const kind,
         }
 
         if (LDi_isFeatureDeleted(deserialized)) {
-            return upsertMemory(store, kind, deserialized);
+            return cacheBackendItem(store, kind, deserialized, generation);
         } else {
             if (!(deserializedRef = LDJSONRCNew(deserialized))) {
                 LDJSONFree(deserialized);
@@ -924,26 +1320,556 @@ tryGetBackend(struct LDStore *const store, const char *const kind,
 
             *result = deserializedRef;
 
-            return upsertMemory(store, kind, dupe);
+            return cacheBackendItem(store, kind, dupe, generation);
         }
     } else {
-        bool status;
-        struct LDJSON *placeholder;
-
         LD_ASSERT(store->cache);
 
-        if (!(placeholder = LDi_makeDeleted(key, collectionItem.version))) {
-            return false;
+        return cacheNegativeItem(store, kind, key, collectionItem->version,
+            generation);
+    }
+}
+
+static bool
+tryGetBackend(struct LDStore *const store, const char *const kind,
+    const char *const key, struct LDJSONRC **const result)
+{
+    struct LDStoreCollectionItem collectionItem;
+    unsigned long generation;
+
+    LD_ASSERT(store);
+    LD_ASSERT(kind);
+    LD_ASSERT(key);
+    LD_ASSERT(result);
+
+    *result = NULL;
+    memset(&collectionItem, 0, sizeof(struct LDStoreCollectionItem));
+
+    if (!store->backend) {
+        return true;
+    }
+
+    LD_ASSERT(store->backend->get);
+
+    generation = cacheGeneration(store);
+
+    if (!store->backend->get(store->backend->context, kind, key,
+        &collectionItem))
+    {
+        return false;
+    }
+
+    return cacheBackendGet(store, kind, key, &collectionItem, generation,
+        result);
+}
+
+/* **** Request coalescing **** */
+
+/* A backend read other callers for the same item can wait on */
+struct Flight {
+    /* see featureStoreCacheKey and featureStoreAllCacheKey */
+    char *cacheKey;
+    bool finished;
+    bool success;
+    struct LDJSONRC *result;
+    /* the leader and each waiter, the last one frees the flight */
+    unsigned int references;
+    UT_hash_handle hh;
+};
+
+/* expects flightLock */
+static void
+releaseFlight(struct Flight *const flight)
+{
+    LD_ASSERT(flight);
+    LD_ASSERT(flight->references > 0);
+
+    flight->references--;
+
+    if (flight->references == 0) {
+        LDJSONRCDecrement(flight->result);
+        LDFree(flight->cacheKey);
+        LDFree(flight);
+    }
+}
+
+/* Expects flightLock. Returns the read of the item already in progress with
+a reference taken, or registers a new one led by the caller. Consumes
+cacheKey. */
+static struct Flight *
+joinFlight(struct LDStore *const store, char *const cacheKey,
+    bool *const leader)
+{
+    struct Flight *flight;
+
+    LD_ASSERT(store);
+    LD_ASSERT(cacheKey);
+    LD_ASSERT(leader);
+
+    HASH_FIND_STR(store->flights, cacheKey, flight);
+
+    if (flight) {
+        LDFree(cacheKey);
+
+        flight->references++;
+
+        *leader = false;
+
+        return flight;
+    }
+
+    if (!(flight = (struct Flight *)LDAlloc(sizeof(struct Flight)))) {
+        LDFree(cacheKey);
+
+        return NULL;
+    }
+
+    memset(flight, 0, sizeof(struct Flight));
+
+    flight->cacheKey   = cacheKey;
+    flight->references = 1;
+
+    HASH_ADD_KEYPTR(hh, store->flights, flight->cacheKey,
+        strlen(flight->cacheKey), flight);
+
+    *leader = true;
+
+    return flight;
+}
+
+/* publishes the result of a read led by the caller to its waiters */
+static void
+finishFlight(struct LDStore *const store, struct Flight *const flight,
+    const bool success, struct LDJSONRC *const result)
+{
+    LD_ASSERT(store);
+    LD_ASSERT(flight);
+
+    LD_ASSERT(LDi_mtxlock(&store->flightLock));
+    HASH_DEL(store->flights, flight);
+
+    flight->finished = true;
+    flight->success  = success;
+
+    if (result) {
+        LDJSONRCIncrement(result);
+
+        flight->result = result;
+    }
+
+    releaseFlight(flight);
+    LD_ASSERT(LDi_mtxunlock(&store->flightLock));
+
+    LDi_condsignal(&store->flightCondition);
+}
+
+static char *
+flightKey(const char *const kind, const char *const key)
+{
+    LD_ASSERT(kind);
+
+    if (key) {
+        return featureStoreCacheKey(kind, key);
+    } else {
+        return featureStoreAllCacheKey(kind);
+    }
+}
+
+/* Reads from the backend, a NULL key reads the whole kind. Concurrent reads
+of the same item share one backend request, the first caller performs it and
+the others wait on its result. */
+static bool
+fetchBackend(struct LDStore *const store, const char *const kind,
+    const char *const key, struct LDJSONRC **const result)
+{
+    struct Flight *flight;
+    char *cacheKey;
+    bool success, leader;
+
+    LD_ASSERT(store);
+    LD_ASSERT(kind);
+    LD_ASSERT(result);
+
+    *result = NULL;
+
+    if (!(cacheKey = flightKey(kind, key))) {
+        return false;
+    }
+
+    LD_ASSERT(LDi_mtxlock(&store->flightLock));
+    if (!(flight = joinFlight(store, cacheKey, &leader))) {
+        LD_ASSERT(LDi_mtxunlock(&store->flightLock));
+
+        return false;
+    }
+
+    if (!leader) {
+        while (!flight->finished) {
+            LDi_condwait(&store->flightCondition, &store->flightLock, 1000);
         }
 
-        LD_ASSERT(LDi_wrlock(&store->cache->lock));
-        status = upsertMemory(store, kind, placeholder);
-        LD_ASSERT(LDi_wrunlock(&store->cache->lock));
+        success = flight->success;
+
+        if (flight->result) {
+            LDJSONRCIncrement(flight->result);
+
+            *result = flight->result;
+        }
+
+        releaseFlight(flight);
+        LD_ASSERT(LDi_mtxunlock(&store->flightLock));
 
-        return status;
+        return success;
     }
+    LD_ASSERT(LDi_mtxunlock(&store->flightLock));
 
-    return false;
+    if (key) {
+        success = tryGetBackend(store, kind, key, result);
+    } else {
+        success = tryGetAllBackend(store, kind, result);
+    }
+
+    finishFlight(store, flight, success, *result);
+
+    return success;
+}
+
+/* **** Refresh-ahead **** */
+
+struct RefreshRequest {
+    /* see featureStoreCacheKey and featureStoreAllCacheKey */
+    char *cacheKey;
+    char *kind;
+    /* NULL when refreshing the whole kind */
+    char *key;
+    UT_hash_handle hh;
+    struct RefreshRequest *next;
+};
+
+static void
+freeRefreshRequest(struct RefreshRequest *const request)
+{
+    if (request) {
+        LDFree(request->cacheKey);
+        LDFree(request->kind);
+        LDFree(request->key);
+        LDFree(request);
+    }
+}
+
+static struct RefreshRequest *
+makeRefreshRequest(const char *const kind, const char *const key)
+{
+    struct RefreshRequest *request;
+
+    LD_ASSERT(kind);
+
+    if (!(request = (struct RefreshRequest *)
+        LDAlloc(sizeof(struct RefreshRequest))))
+    {
+        return NULL;
+    }
+
+    memset(request, 0, sizeof(struct RefreshRequest));
+
+    if (key) {
+        request->cacheKey = featureStoreCacheKey(kind, key);
+    } else {
+        request->cacheKey = featureStoreAllCacheKey(kind);
+    }
+
+    if (!request->cacheKey || !(request->kind = LDStrDup(kind)) ||
+        (key && !(request->key = LDStrDup(key))))
+    {
+        freeRefreshRequest(request);
+
+        return NULL;
+    }
+
+    return request;
+}
+
+/* Asks the worker to refresh a stale item, a NULL key refreshes the whole
+kind. Requests for an item that is already queued or running are dropped. */
+static void
+queueRefresh(struct LDStore *const store, const char *const kind,
+    const char *const key)
+{
+    struct RefreshRequest *request, *existing;
+
+    LD_ASSERT(store);
+    LD_ASSERT(kind);
+
+    /* on failure the stale value is still served and a later read retries */
+    if (!(request = makeRefreshRequest(kind, key))) {
+        return;
+    }
+
+    LD_ASSERT(LDi_mtxlock(&store->refreshLock));
+    HASH_FIND_STR(store->refreshPending, request->cacheKey, existing);
+
+    if (existing || store->refreshStopping) {
+        LD_ASSERT(LDi_mtxunlock(&store->refreshLock));
+
+        freeRefreshRequest(request);
+
+        return;
+    }
+
+    HASH_ADD_KEYPTR(hh, store->refreshPending, request->cacheKey,
+        strlen(request->cacheKey), request);
+    LL_APPEND(store->refreshQueue, request);
+    LD_ASSERT(LDi_mtxunlock(&store->refreshLock));
+
+    LDi_condsignal(&store->refreshCondition);
+}
+
+/* readers may queue the item again from here on */
+static void
+completeRefresh(struct LDStore *const store,
+    struct RefreshRequest *const request)
+{
+    LD_ASSERT(store);
+    LD_ASSERT(request);
+
+    LD_ASSERT(LDi_mtxlock(&store->refreshLock));
+    HASH_DEL(store->refreshPending, request);
+    LD_ASSERT(LDi_mtxunlock(&store->refreshLock));
+
+    freeRefreshRequest(request);
+}
+
+/* a refresh submitted through the asynchronous backend interface */
+struct AsyncRefresh {
+    struct LDStore *store;
+    struct RefreshRequest *request;
+    struct Flight *flight;
+    unsigned long generation;
+};
+
+static void
+finishAsyncRefresh(struct AsyncRefresh *const refresh, const bool success,
+    struct LDJSONRC *const result)
+{
+    LD_ASSERT(refresh);
+
+    if (!success) {
+        LD_LOG(LD_LOG_WARNING, "background store refresh failed");
+    }
+
+    finishFlight(refresh->store, refresh->flight, success, result);
+
+    LDJSONRCDecrement(result);
+
+    completeRefresh(refresh->store, refresh->request);
+
+    LDFree(refresh);
+}
+
+static void
+onRefreshGet(void *const refreshRaw, const bool success,
+    struct LDStoreCollectionItem *const item)
+{
+    struct AsyncRefresh *refresh;
+    struct LDJSONRC *result;
+    bool cached;
+
+    LD_ASSERT(refreshRaw);
+
+    refresh = (struct AsyncRefresh *)refreshRaw;
+    result  = NULL;
+    cached  = false;
+
+    if (success) {
+        LD_ASSERT(item);
+
+        cached = cacheBackendGet(refresh->store, refresh->request->kind,
+            refresh->request->key, item, refresh->generation, &result);
+    }
+
+    finishAsyncRefresh(refresh, cached, result);
+}
+
+static void
+onRefreshAll(void *const refreshRaw, const bool success,
+    struct LDStoreCollectionItem *const items, const unsigned int itemCount)
+{
+    struct AsyncRefresh *refresh;
+    struct LDJSONRC *result;
+    bool cached;
+
+    LD_ASSERT(refreshRaw);
+
+    refresh = (struct AsyncRefresh *)refreshRaw;
+    result  = NULL;
+    cached  = false;
+
+    if (success) {
+        cached = cacheBackendAll(refresh->store, refresh->request->kind,
+            items, itemCount, refresh->generation, &result);
+    }
+
+    finishAsyncRefresh(refresh, cached, result);
+}
+
+/* Submits the refresh without waiting for the backend. Returns false if the
+backend has no asynchronous interface for the request. */
+static bool
+submitRefresh(struct LDStore *const store,
+    struct RefreshRequest *const request)
+{
+    struct AsyncRefresh *refresh;
+    struct Flight *flight;
+    char *cacheKey;
+    bool leader, submitted;
+
+    LD_ASSERT(store);
+    LD_ASSERT(request);
+
+    if (request->key ?
+        !store->extensions.getAsync : !store->extensions.allAsync)
+    {
+        return false;
+    }
+
+    refresh = NULL;
+    flight  = NULL;
+
+    if ((cacheKey = LDStrDup(request->cacheKey))) {
+        LD_ASSERT(LDi_mtxlock(&store->flightLock));
+        flight = joinFlight(store, cacheKey, &leader);
+
+        if (flight && !leader) {
+            /* a caller is already reading the item */
+            releaseFlight(flight);
+            LD_ASSERT(LDi_mtxunlock(&store->flightLock));
+
+            completeRefresh(store, request);
+
+            return true;
+        }
+        LD_ASSERT(LDi_mtxunlock(&store->flightLock));
+    }
+
+    if (!flight || !(refresh = (struct AsyncRefresh *)
+        LDAlloc(sizeof(struct AsyncRefresh))))
+    {
+        LD_LOG(LD_LOG_WARNING, "background store refresh failed");
+
+        if (flight) {
+            finishFlight(store, flight, false, NULL);
+        }
+
+        completeRefresh(store, request);
+
+        return true;
+    }
+
+    refresh->store      = store;
+    refresh->request    = request;
+    refresh->flight     = flight;
+    refresh->generation = cacheGeneration(store);
+
+    /* the completion may run before this returns */
+    if (request->key) {
+        submitted = store->extensions.getAsync(store->backend->context,
+            request->kind, request->key, onRefreshGet, refresh);
+    } else {
+        submitted = store->extensions.allAsync(store->backend->context,
+            request->kind, onRefreshAll, refresh);
+    }
+
+    if (!submitted) {
+        finishAsyncRefresh(refresh, false, NULL);
+    }
+
+    return true;
+}
+
+static THREAD_RETURN
+refreshThread(void *const storeRaw)
+{
+    struct LDStore *store;
+
+    LD_ASSERT(storeRaw);
+
+    store = (struct LDStore *)storeRaw;
+
+    while (true) {
+        struct RefreshRequest *request;
+        struct LDJSONRC *result;
+
+        LD_ASSERT(LDi_mtxlock(&store->refreshLock));
+        while (!store->refreshStopping && !store->refreshQueue) {
+            LDi_condwait(&store->refreshCondition, &store->refreshLock,
+                1000 * 60);
+        }
+
+        if (store->refreshStopping) {
+            LD_ASSERT(LDi_mtxunlock(&store->refreshLock));
+
+            break;
+        }
+
+        request = store->refreshQueue;
+        LL_DELETE(store->refreshQueue, request);
+        LD_ASSERT(LDi_mtxunlock(&store->refreshLock));
+
+        if (submitRefresh(store, request)) {
+            continue;
+        }
+
+        result = NULL;
+
+        /* joins a caller already blocked on the same item */
+        if (!fetchBackend(store, request->kind, request->key, &result)) {
+            LD_LOG(LD_LOG_WARNING, "background store refresh failed");
+        }
+
+        LDJSONRCDecrement(result);
+
+        completeRefresh(store, request);
+    }
+
+    return THREAD_RETURN_DEFAULT;
+}
+
+static void
+stopRefreshThread(struct LDStore *const store)
+{
+    LD_ASSERT(store);
+
+    if (!store->refreshStarted) {
+        return;
+    }
+
+    LD_ASSERT(LDi_mtxlock(&store->refreshLock));
+    store->refreshStopping = true;
+    LD_ASSERT(LDi_mtxunlock(&store->refreshLock));
+
+    LDi_condsignal(&store->refreshCondition);
+
+    LD_ASSERT(LDi_jointhread(store->refreshThread));
+
+    store->refreshStarted = false;
+}
+
+/* expects the worker stopped and no asynchronous refresh outstanding */
+static void
+freeRefreshRequests(struct LDStore *const store)
+{
+    struct RefreshRequest *request, *requestTmp;
+
+    LD_ASSERT(store);
+
+    /* every queued request is also in the pending table */
+    HASH_ITER(hh, store->refreshPending, request, requestTmp) {
+        HASH_DEL(store->refreshPending, request);
+
+        freeRefreshRequest(request);
+    }
+
+    store->refreshQueue = NULL;
 }
 
 static bool
@@ -984,6 +1910,8 @@ LDi_expireAll(struct LDStore *const store)
         item->updatedOn = 0;
     }
 
+    store->cache->initChecked = false;
+
     LD_ASSERT(LDi_wrunlock(&store->cache->lock));
 }
 
@@ -1025,12 +1953,60 @@ LDStoreNew(const struct LDConfig *const config)
     }
 
     cache->initialized       = false;
+    cache->initChecked       = false;
+    cache->initCheckedOn     = 0;
+    cache->initChecking      = false;
+    cache->invalidations     = 0;
     cache->items             = NULL;
+    cache->negatives         = NULL;
+    cache->negativeCount     = 0;
 
     store->cache             = cache;
     store->backend           = config->storeBackend;
+    store->extensions        = config->storeExtensions;
     store->cacheMilliseconds = config->storeCacheMilliseconds;
 
+    store->initCheckMilliseconds = config->storeInitCheckMilliseconds;
+    store->hardCacheMilliseconds = config->storeHardCacheMilliseconds;
+
+    store->negativeCacheMilliseconds = config->storeNegativeCacheMilliseconds;
+    store->negativeCacheCapacity     = config->storeNegativeCacheCapacity;
+
+    /* unless set, missing items are not remembered longer than present ones,
+    so a cache TTL of zero still always reads the backend */
+    if (!config->storeNegativeCacheExplicit &&
+        store->negativeCacheMilliseconds > store->cacheMilliseconds)
+    {
+        store->negativeCacheMilliseconds = store->cacheMilliseconds;
+    }
+
+    store->refreshStarted        = false;
+    store->refreshStopping       = false;
+    store->refreshPending        = NULL;
+    store->refreshQueue          = NULL;
+
+    store->flights               = NULL;
+
+    LD_ASSERT(LDi_mtxinit(&store->refreshLock));
+    LDi_condinit(&store->refreshCondition);
+    LD_ASSERT(LDi_mtxinit(&store->flightLock));
+    LDi_condinit(&store->flightCondition);
+
+    if (store->backend && store->cacheMilliseconds &&
+        store->hardCacheMilliseconds > store->cacheMilliseconds)
+    {
+        if (LDi_createthread(&store->refreshThread, refreshThread, store)) {
+            store->refreshStarted = true;
+        } else {
+            LD_LOG(LD_LOG_ERROR, "failed to start store refresh thread");
+        }
+    }
+
+    if (store->backend && store->extensions.subscribe) {
+        store->extensions.subscribe(store->backend->context, invalidateCache,
+            store);
+    }
+
     return store;
 
   error:
@@ -1042,6 +2018,159 @@ LDStoreNew(const struct LDConfig *const config)
 
 /* **** Store API Operations **** */
 
+/* an upsert submitted through the asynchronous backend interface */
+struct AsyncUpsert {
+    struct LDStore *store;
+    const char *kind;
+    struct LDJSON *feature;
+};
+
+static void
+onUpsert(void *const upsertRaw, const bool success)
+{
+    struct AsyncUpsert *upsert;
+
+    LD_ASSERT(upsertRaw);
+
+    upsert = (struct AsyncUpsert *)upsertRaw;
+
+    if (success) {
+        LD_ASSERT(LDi_wrlock(&upsert->store->cache->lock));
+        upsertMemory(upsert->store, upsert->kind, upsert->feature);
+        LD_ASSERT(LDi_wrunlock(&upsert->store->cache->lock));
+    } else {
+        LD_LOG(LD_LOG_ERROR, "asynchronous store upsert failed");
+
+        LDJSONFree(upsert->feature);
+    }
+
+    LDFree(upsert);
+}
+
+/* Writes the item to the backend then applies feature to the cache. With an
+asynchronous backend the cache is updated once the write completes and the
+return value only reports whether it was submitted. Consumes feature. */
+static bool
+upsertBackend(struct LDStore *const store, const char *const kind,
+    const struct LDStoreCollectionItem *const item, const char *const key,
+    struct LDJSON *const feature)
+{
+    struct AsyncUpsert *upsert;
+    bool status;
+
+    LD_ASSERT(store);
+    LD_ASSERT(kind);
+    LD_ASSERT(item);
+    LD_ASSERT(key);
+    LD_ASSERT(feature);
+
+    if (store->extensions.upsertAsync) {
+        if (!(upsert = (struct AsyncUpsert *)
+            LDAlloc(sizeof(struct AsyncUpsert))))
+        {
+            LDJSONFree(feature);
+
+            return false;
+        }
+
+        upsert->store   = store;
+        upsert->kind    = kind;
+        upsert->feature = feature;
+
+        if (!store->extensions.upsertAsync(store->backend->context, kind,
+            item, key, onUpsert, upsert))
+        {
+            LDJSONFree(feature);
+            LDFree(upsert);
+
+            return false;
+        }
+
+        return true;
+    }
+
+    LD_ASSERT(store->backend->upsert);
+
+    if (!store->backend->upsert(store->backend->context, kind, item, key)) {
+        LDJSONFree(feature);
+
+        return false;
+    }
+
+    LD_ASSERT(LDi_wrlock(&store->cache->lock));
+    status = upsertMemory(store, kind, feature);
+    LD_ASSERT(LDi_wrunlock(&store->cache->lock));
+
+    return status;
+}
+
+/* lets a caller block on an asynchronous request */
+struct AsyncWaiter {
+    ld_mutex_t lock;
+    ld_cond_t condition;
+    bool finished;
+    bool success;
+};
+
+static void
+onWaiterCompletion(void *const waiterRaw, const bool success)
+{
+    struct AsyncWaiter *waiter;
+
+    LD_ASSERT(waiterRaw);
+
+    waiter = (struct AsyncWaiter *)waiterRaw;
+
+    /* signaled under the lock as the waiter may return as soon as it is set */
+    LD_ASSERT(LDi_mtxlock(&waiter->lock));
+    waiter->finished = true;
+    waiter->success  = success;
+    LDi_condsignal(&waiter->condition);
+    LD_ASSERT(LDi_mtxunlock(&waiter->lock));
+}
+
+static bool
+initBackend(struct LDStore *const store,
+    const struct LDStoreCollectionState *const collections,
+    const unsigned int collectionCount)
+{
+    struct AsyncWaiter waiter;
+    bool success;
+
+    LD_ASSERT(store);
+
+    if (!store->extensions.initAsync) {
+        LD_ASSERT(store->backend->init);
+
+        return store->backend->init(store->backend->context, collections,
+            collectionCount);
+    }
+
+    LD_ASSERT(LDi_mtxinit(&waiter.lock));
+    LDi_condinit(&waiter.condition);
+
+    waiter.finished = false;
+    waiter.success  = false;
+
+    /* the completion may run before this returns */
+    if (store->extensions.initAsync(store->backend->context, collections,
+        collectionCount, onWaiterCompletion, &waiter))
+    {
+        LD_ASSERT(LDi_mtxlock(&waiter.lock));
+        while (!waiter.finished) {
+            LDi_condwait(&waiter.condition, &waiter.lock, 1000);
+        }
+        LD_ASSERT(LDi_mtxunlock(&waiter.lock));
+    }
+
+    success = waiter.success;
+
+    LD_ASSERT(LDi_mtxdestroy(&waiter.lock));
+    LDi_conddestroy(&waiter.condition);
+
+    return success;
+}
+
 bool
 LDStoreInit(struct LDStore *const store, struct LDJSON *const sets)
 {
@@ -1058,8 +2187,6 @@ LDStoreInit(struct LDStore *const store, struct LDJSON *const sets)
         struct LDStoreCollectionState *collections, *collectionsIter;
         unsigned int x;
 
-        LD_ASSERT(store->backend->init);
-
         success         = false;
         set             = NULL;
         setItem         = NULL;
@@ -1136,8 +2263,8 @@ LDStoreInit(struct LDStore *const store, struct LDJSON *const sets)
             collectionsIter++;
         }
 
-        success = store->backend->init(store->backend->context, collections,
-            LDCollectionGetSize(sets));
+        /* the buffers are freed below so an asynchronous init is awaited */
+        success = initBackend(store, collections, LDCollectionGetSize(sets));
 
       cleanup:
         if (collections) {
@@ -1206,30 +2333,30 @@ LDStoreGet(struct LDStore *const store, const enum FeatureKind kind,
             LD_ASSERT(LDi_rdunlock(&store->cache->lock));
 
             return false;
-        } else if (expired == 0) {
-            if (LDi_isFeatureDeleted(LDJSONRCGet(item->feature))) {
-                LD_ASSERT(LDi_rdunlock(&store->cache->lock));
-
-                return true;
-            } else {
+        } else if (expired == 0 || expired == 2) {
+            if (!LDi_isFeatureDeleted(LDJSONRCGet(item->feature))) {
                 LDJSONRCIncrement(item->feature);
 
                 *result = item->feature;
+            }
 
-                LD_ASSERT(LDi_rdunlock(&store->cache->lock));
+            LD_ASSERT(LDi_rdunlock(&store->cache->lock));
 
-                return true;
+            if (expired == 2) {
+                queueRefresh(store, featureKindToString(kind), key);
             }
+
+            return true;
         } else if (expired > 0) {
             LD_ASSERT(LDi_rdunlock(&store->cache->lock));
             /* When there is no backend a flag will never be expired */
-            return tryGetBackend(store, featureKindToString(kind), key, result);
+            return fetchBackend(store, featureKindToString(kind), key, result);
         }
     } else {
         LD_ASSERT(LDi_rdunlock(&store->cache->lock));
 
         if (store->backend) {
-            return tryGetBackend(store, featureKindToString(kind), key, result);
+            return fetchBackend(store, featureKindToString(kind), key, result);
         } else {
             return true;
         }
@@ -1238,6 +2365,72 @@ LDStoreGet(struct LDStore *const store, const enum FeatureKind kind,
     return false;
 }
 
+bool
+LDStoreGetMany(struct LDStore *const store, const enum FeatureKind kind,
+    const char *const *const keys, const unsigned int count,
+    struct LDJSONRC **const results)
+{
+    struct CacheItem *item;
+    unsigned int i;
+
+    LD_LOG(LD_LOG_TRACE, "LDStoreGetMany");
+
+    LD_ASSERT(store);
+    LD_ASSERT(store->cache);
+    LD_ASSERT(keys || count == 0);
+    LD_ASSERT(results || count == 0);
+
+    for (i = 0; i < count; i++) {
+        results[i] = NULL;
+    }
+
+    /* items may expire and are fetched one at a time */
+    if (store->backend) {
+        for (i = 0; i < count; i++) {
+            if (keys[i] && !LDStoreGet(store, kind, keys[i], &results[i])) {
+                goto error;
+            }
+        }
+
+        return true;
+    }
+
+    LD_ASSERT(LDi_rdlock(&store->cache->lock));
+
+    for (i = 0; i < count; i++) {
+        if (!keys[i]) {
+            continue;
+        }
+
+        if (!memoryGetCollectionItem(store->cache, featureKindToString(kind),
+            keys[i], &item))
+        {
+            LD_ASSERT(LDi_rdunlock(&store->cache->lock));
+
+            goto error;
+        }
+
+        if (item && !LDi_isFeatureDeleted(LDJSONRCGet(item->feature))) {
+            LDJSONRCIncrement(item->feature);
+
+            results[i] = item->feature;
+        }
+    }
+
+    LD_ASSERT(LDi_rdunlock(&store->cache->lock));
+
+    return true;
+
+  error:
+    for (i = 0; i < count; i++) {
+        LDJSONRCDecrement(results[i]);
+
+        results[i] = NULL;
+    }
+
+    return false;
+}
+
 bool
 LDStoreAll(struct LDStore *const store, const enum FeatureKind kind,
     struct LDJSONRC **const result)
@@ -1272,24 +2465,30 @@ LDStoreAll(struct LDStore *const store, const enum FeatureKind kind,
             LD_ASSERT(LDi_rdunlock(&store->cache->lock));
 
             return false;
-        } else if (expired == 0) {
+        } else if (expired == 0 || expired == 2) {
             LDJSONRCIncrement(item->feature);
 
             *result = item->feature;
 
             LD_ASSERT(LDi_rdunlock(&store->cache->lock));
 
+            if (expired == 2) {
+                queueRefresh(store, featureKindToString(kind), NULL);
+            }
+
             return true;
         } else if (expired > 0) {
             LD_ASSERT(LDi_rdunlock(&store->cache->lock));
             /* When there is no backend a flag will never be expired */
-            return tryGetAllBackend(store, featureKindToString(kind), result);
+            return fetchBackend(store, featureKindToString(kind), NULL, result);
         }
     } else {
         LD_ASSERT(LDi_rdunlock(&store->cache->lock));
 
-        return tryGetAllBackend(store, featureKindToString(kind), result);
+        return fetchBackend(store, featureKindToString(kind), NULL, result);
     }
+
+    return false;
 }
 
 bool
@@ -1307,24 +2506,19 @@ LDStoreRemove(struct LDStore *const store, const enum FeatureKind kind,
     status      = false;
     placeholder = NULL;
 
+    if (!(placeholder = LDi_makeDeleted(key, version))) {
+        return false;
+    }
+
     if (store->backend) {
         struct LDStoreCollectionItem item;
 
-        LD_ASSERT(store->backend->upsert);
-
         item.buffer     = NULL;
         item.bufferSize = 0;
         item.version    = version;
 
-        if (!store->backend->upsert(store->backend->context,
-            featureKindToString(kind), &item, key))
-        {
-            return false;
-        }
-    }
-
-    if (!(placeholder = LDi_makeDeleted(key, version))) {
-        return false;
+        return upsertBackend(store, featureKindToString(kind), &item, key,
+            placeholder);
     }
 
     LD_ASSERT(LDi_wrlock(&store->cache->lock));
@@ -1360,8 +2554,6 @@ LDStoreUpsert(struct LDStore *const store, const enum FeatureKind kind,
         success    = false;
         serialized = NULL;
 
-        LD_ASSERT(store->backend->upsert);
-
         if (!(serialized = LDJSONSerialize(feature))) {
             LDJSONFree(feature);
 
@@ -1372,17 +2564,12 @@ LDStoreUpsert(struct LDStore *const store, const enum FeatureKind kind,
         collectionItem.bufferSize = strlen(serialized);
         collectionItem.version    = LDi_getFeatureVersionTrusted(feature);
 
-        success = store->backend->upsert(store->backend->context,
-            featureKindToString(kind), &collectionItem,
-            LDi_getFeatureKeyTrusted(feature));
+        success = upsertBackend(store, featureKindToString(kind),
+            &collectionItem, LDi_getFeatureKeyTrusted(feature), feature);
 
         LDFree(serialized);
 
-        if (!success) {
-            LDJSONFree(feature);
-
-            return false;
-        }
+        return success;
     }
 
     LD_ASSERT(LDi_wrlock(&store->cache->lock));
@@ -1396,57 +2583,59 @@ bool
 LDStoreInitialized(struct LDStore *const store)
 {
     bool isInitialized;
-    struct CacheItem *item;
+    unsigned long now;
 
     LD_ASSERT(store);
 
     LD_LOG(LD_LOG_TRACE, "LDStoreInitialized");
 
+    /* Once initialized a store never becomes uninitialized, so after the
+    first positive answer the backend is never asked again, and readers only
+    share the lock. */
     LD_ASSERT(LDi_rdlock(&store->cache->lock));
     isInitialized = store->cache->initialized;
+    LD_ASSERT(LDi_rdunlock(&store->cache->lock));
 
     if (isInitialized || !store->backend) {
-        LD_ASSERT(LDi_rdunlock(&store->cache->lock));
-
         return isInitialized;
     }
 
-    HASH_FIND_STR(store->cache->items, INIT_CHECKED_KEY, item);
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&now));
 
-    if (item) {
-        int expired = isExpired(store, item);
+    /* Negative answers are remembered for initCheckMilliseconds, and only
+    one caller at a time asks the backend. */
+    LD_ASSERT(LDi_wrlock(&store->cache->lock));
+    isInitialized = store->cache->initialized;
 
-        if (expired < 0) {
-            LD_ASSERT(LDi_rdunlock(&store->cache->lock));
+    if (isInitialized || store->cache->initChecking) {
+        LD_ASSERT(LDi_wrunlock(&store->cache->lock));
 
-            return false;
-        } else if (expired == 0) {
-            LD_ASSERT(LDi_rdunlock(&store->cache->lock));
+        return isInitialized;
+    }
 
-            return false;
-        } else if (expired > 0) {
-            deleteAndRemoveCacheItem(&store->cache->items, item);
-        }
+    if (store->cache->initChecked &&
+        now - store->cache->initCheckedOn < store->initCheckMilliseconds)
+    {
+        LD_ASSERT(LDi_wrunlock(&store->cache->lock));
+
+        return false;
     }
 
-    LD_ASSERT(LDi_rdunlock(&store->cache->lock));
+    store->cache->initChecking = true;
+    LD_ASSERT(LDi_wrunlock(&store->cache->lock));
 
     isInitialized = store->backend->initialized(store->backend->context);
 
+    LD_ASSERT(LDi_wrlock(&store->cache->lock));
+    store->cache->initChecking = false;
+
     if (isInitialized) {
-        LD_ASSERT(LDi_wrlock(&store->cache->lock));
         store->cache->initialized = true;
-        LD_ASSERT(LDi_wrunlock(&store->cache->lock));
     } else {
-        if (!(item = makeCacheItem(INIT_CHECKED_KEY, NULL))) {
-            return false;
-        }
-
-        LD_ASSERT(LDi_wrlock(&store->cache->lock));
-        HASH_ADD_KEYPTR(hh, store->cache->items, item->key, strlen(item->key),
-            item);
-        LD_ASSERT(LDi_wrunlock(&store->cache->lock));
+        store->cache->initChecked   = true;
+        store->cache->initCheckedOn = now;
     }
+    LD_ASSERT(LDi_wrunlock(&store->cache->lock));
 
     return isInitialized;
 }
@@ -1457,8 +2646,10 @@ LDStoreDestroy(struct LDStore *const store)
     LD_LOG(LD_LOG_TRACE, "LDStoreDestroy");
 
     if (store) {
-        memoryDestructor(store->cache);
+        stopRefreshThread(store);
 
+        /* stops any invalidations and runs outstanding completions before
+        the cache goes away */
         if (store->backend) {
             if (store->backend->destructor) {
                 store->backend->destructor(store->backend->context);
@@ -1467,6 +2658,15 @@ LDStoreDestroy(struct LDStore *const store)
             LDFree(store->backend);
         }
 
+        freeRefreshRequests(store);
+
+        LD_ASSERT(LDi_mtxdestroy(&store->refreshLock));
+        LDi_conddestroy(&store->refreshCondition);
+        LD_ASSERT(LDi_mtxdestroy(&store->flightLock));
+        LDi_conddestroy(&store->flightCondition);
+
+        memoryDestructor(store->cache);
+
         LDFree(store);
     }
 }
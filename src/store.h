@@ -40,6 +40,12 @@ bool LDi_isFeatureDeleted(const struct LDJSON *const feature);
 /** @brief Get version of a non validated feature value */
 unsigned int LDi_getFeatureVersion(const struct LDJSON *const feature);
 
+/** @brief Read the top level version and deletion status of a serialized
+ * feature without constructing a tree. Returns false if the text is not
+ * structurally balanced. */
+bool LDi_scanFeatureVersion(const char *text, unsigned int *const version,
+    bool *const deleted);
+
 /** @brief Get version of a validated feature value */
 unsigned int LDi_getFeatureVersionTrusted(const struct LDJSON *const feature);
 
@@ -68,6 +74,16 @@ bool LDStoreGet(struct LDStore *const store,
     const enum FeatureKind kind, const char *const key,
     struct LDJSONRC **const result);
 
+/** @brief Get several features under a single read of the cache, so they
+ * come from one version of the store when there is no backend.
+ *
+ * Keys may be `NULL`, their results are `NULL` as are those of missing
+ * features. On failure no references are held.
+ */
+bool LDStoreGetMany(struct LDStore *const store,
+    const enum FeatureKind kind, const char *const *const keys,
+    const unsigned int count, struct LDJSONRC **const results);
+
 /** @brief A convenience wrapper around `store->all`. */
 bool LDStoreAll(struct LDStore *const store,
     const enum FeatureKind kind, struct LDJSONRC **const result);
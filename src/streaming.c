@@ -157,6 +157,14 @@ onPut(struct LDClient *const client, struct LDJSON *const put)
      }
      data = NULL;
 
+     LD_ASSERT(LDi_wrlock(&client->lock));
+     client->streamDown = false;
+     /* also ends fallback polling */
+     LDi_setDataSourceState(client, LD_DATA_SOURCE_STREAMING);
+     LD_ASSERT(LDi_wrunlock(&client->lock));
+
+     LDi_setInitialized(client);
+
      success = true;
 
   cleanup:
@@ -281,7 +289,10 @@ LDi_onSSE(struct StreamContext *const context, const char *line)
         } else if (context->dataBuffer == NULL) {
             LD_LOG(LD_LOG_WARNING,
                 "streamcallback got dispatch but data was never set");
-        } else if ((json = LDJSONDeserialize(context->dataBuffer))) {
+        } else if ((json = strcmp(context->eventName, "put") == 0 ?
+            LDi_JSONDeserializeArena(context->dataBuffer) :
+            LDJSONDeserialize(context->dataBuffer)))
+        {
             if (LDJSONGetType(json) != LDObject) {
                 LDJSONFree(json);
 
@@ -428,6 +439,18 @@ done(struct LDClient *const client, void *const rawcontext, const bool success)
 
     (void)success;
 
+    /* a stream ending for any reason means updates are no longer received */
+    LD_ASSERT(LDi_wrlock(&client->lock));
+    if (!client->streamDown) {
+        client->streamDown = true;
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&client->streamDownSince));
+    }
+
+    if (client->dataSource.state == LD_DATA_SOURCE_STREAMING) {
+        LDi_setDataSourceState(client, LD_DATA_SOURCE_INTERRUPTED);
+    }
+    LD_ASSERT(LDi_wrunlock(&client->lock));
+
     resetMemory(context);
 }
 
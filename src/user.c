@@ -7,6 +7,26 @@
 #include "user.h"
 #include "config.h"
 #include "misc.h"
+#include "lru.h"
+
+static void
+unprepare(struct LDUser *const user)
+{
+    LD_ASSERT(user);
+
+    if (user->prepared) {
+        unsigned int name;
+
+        for (name = 0; name < LD_NAME_COUNT; name++) {
+            LDJSONFree(user->prepared->attributes[name]);
+        }
+
+        LDJSONFree(user->prepared->redacted);
+        LDFree(user->prepared);
+
+        user->prepared = NULL;
+    }
+}
 
 struct LDUser *
 LDUserNew(const char *const key)
@@ -36,6 +56,7 @@ LDUserNew(const char *const key)
     user->avatar    = NULL;
     user->custom    = NULL;
     user->country   = NULL;
+    user->prepared  = NULL;
 
     return user;
 
@@ -49,6 +70,8 @@ void
 LDUserFree(struct LDUser *const user)
 {
     if (user) {
+        unprepare(user);
+
         LDFree(     user->key                   );
         LDFree(     user->secondary             );
         LDFree(     user->ip                    );
@@ -69,6 +92,8 @@ LDUserSetAnonymous(struct LDUser *const user, const bool anon)
 {
     LD_ASSERT(user);
 
+    unprepare(user);
+
     user->anonymous = anon;
 }
 
@@ -77,6 +102,8 @@ LDUserSetIP(struct LDUser *const user, const char *const ip)
 {
     LD_ASSERT(user);
 
+    unprepare(user);
+
     return LDSetString(&user->ip, ip);
 }
 
@@ -85,6 +112,8 @@ LDUserSetFirstName(struct LDUser *const user, const char *const firstName)
 {
     LD_ASSERT(user);
 
+    unprepare(user);
+
     return LDSetString(&user->firstName, firstName);
 }
 
@@ -93,6 +122,8 @@ LDUserSetLastName(struct LDUser *const user, const char *const lastName)
 {
     LD_ASSERT(user);
 
+    unprepare(user);
+
     return LDSetString(&user->lastName, lastName);
 }
 
@@ -101,6 +132,8 @@ LDUserSetEmail(struct LDUser *const user, const char *const email)
 {
     LD_ASSERT(user);
 
+    unprepare(user);
+
     return LDSetString(&user->email, email);
 }
 
@@ -109,6 +142,8 @@ LDUserSetName(struct LDUser *const user, const char *const name)
 {
     LD_ASSERT(user);
 
+    unprepare(user);
+
     return LDSetString(&user->name, name);
 }
 
@@ -117,6 +152,8 @@ LDUserSetAvatar(struct LDUser *const user, const char *const avatar)
 {
     LD_ASSERT(user);
 
+    unprepare(user);
+
     return LDSetString(&user->avatar, avatar);
 }
 
@@ -125,6 +162,8 @@ LDUserSetCountry(struct LDUser *const user, const char *const country)
 {
     LD_ASSERT(user);
 
+    unprepare(user);
+
     return LDSetString(&user->country, country);
 }
 
@@ -133,14 +172,19 @@ LDUserSetSecondary(struct LDUser *const user, const char *const secondary)
 {
     LD_ASSERT(user);
 
+    unprepare(user);
+
     return LDSetString(&user->secondary, secondary);
 }
 
 void
 LDUserSetCustom(struct LDUser *const user, struct LDJSON *const custom)
 {
+    LD_ASSERT(user);
     LD_ASSERT(custom);
 
+    unprepare(user);
+
     user->custom = custom;
 }
 
@@ -153,6 +197,8 @@ LDUserAddPrivateAttribute(struct LDUser *const user,
     LD_ASSERT(user);
     LD_ASSERT(attribute);
 
+    unprepare(user);
+
     if ((temp = LDNewText(attribute))) {
         return LDArrayPush(user->privateAttributeNames, temp);
     } else {
@@ -229,6 +275,10 @@ LDUserToJSON(struct LDClient *const client, const struct LDUser *const lduser,
     json   = NULL;
     temp   = NULL;
 
+    if (redact && lduser->prepared && lduser->prepared->client == client) {
+        return LDJSONDuplicate(lduser->prepared->redacted);
+    }
+
     if (!(json = LDNewObject())) {
         return NULL;
     }
@@ -348,60 +398,148 @@ LDUserToJSON(struct LDClient *const client, const struct LDUser *const lduser,
     #undef addstring
 }
 
+/* the value of a built in attribute, NULL when the user does not have it */
+static bool
+newAttribute(const struct LDUser *const user, const enum LDName name,
+    struct LDJSON **const value)
+{
+    const char *text;
+
+    LD_ASSERT(user);
+    LD_ASSERT(value);
+
+    switch (name) {
+        case LD_NAME_KEY:        text = user->key;       break;
+        case LD_NAME_IP:         text = user->ip;        break;
+        case LD_NAME_EMAIL:      text = user->email;     break;
+        case LD_NAME_FIRST_NAME: text = user->firstName; break;
+        case LD_NAME_LAST_NAME:  text = user->lastName;  break;
+        case LD_NAME_AVATAR:     text = user->avatar;    break;
+        case LD_NAME_COUNTRY:    text = user->country;   break;
+        case LD_NAME_NAME:       text = user->name;      break;
+        case LD_NAME_ANONYMOUS:
+            return (*value = LDNewBool(user->anonymous)) != NULL;
+        default:
+            LD_ASSERT(false);
+
+            return false;
+    }
+
+    if (text) {
+        return (*value = LDNewText(text)) != NULL;
+    }
+
+    *value = NULL;
+
+    return true;
+}
+
+const struct LDJSON *
+LDi_lookupAttribute(const struct LDUser *const user,
+    const char *const attribute, struct LDJSON **const temporary)
+{
+    enum LDName name;
+
+    LD_ASSERT(user);
+    LD_ASSERT(attribute);
+    LD_ASSERT(temporary);
+
+    *temporary = NULL;
+
+    if ((name = LDi_nameIn(attribute, LD_NAME_KEY, LD_NAME_ANONYMOUS))
+        == LD_NAME_COUNT)
+    {
+        if (user->custom) {
+            LD_ASSERT(LDJSONGetType(user->custom) == LDObject);
+
+            return LDObjectLookup(user->custom, attribute);
+        }
+
+        return NULL;
+    }
+
+    if (user->prepared) {
+        return user->prepared->attributes[name];
+    }
+
+    if (!newAttribute(user, name, temporary)) {
+        return NULL;
+    }
+
+    return *temporary;
+}
+
 struct LDJSON *
 LDi_valueOfAttribute(const struct LDUser *const user,
     const char *const attribute)
 {
+    const struct LDJSON *value;
+    struct LDJSON *temporary;
+
     LD_ASSERT(user);
     LD_ASSERT(attribute);
 
-    if (strcmp(attribute, "key") == 0) {
-        if (user->key) {
-            return LDNewText(user->key);
-        }
-    } else if (strcmp(attribute, "ip") == 0) {
-        if (user->ip) {
-            return LDNewText(user->ip);
-        }
-    } else if (strcmp(attribute, "email") == 0) {
-        if (user->email) {
-            return LDNewText(user->email);
-        }
-    } else if (strcmp(attribute, "firstName") == 0) {
-        if (user->firstName) {
-            return LDNewText(user->firstName);
-        }
-    } else if (strcmp(attribute, "lastName") == 0) {
-        if (user->lastName) {
-            return LDNewText(user->lastName);
-        }
-    } else if (strcmp(attribute, "avatar") == 0) {
-        if (user->avatar) {
-            return LDNewText(user->avatar);
-        }
-    } else if (strcmp(attribute, "country") == 0) {
-        if (user->country) {
-            return LDNewText(user->country);
-        }
-    } else if (strcmp(attribute, "name") == 0) {
-        if (user->name) {
-            return LDNewText(user->name);
-        }
-    } else if (strcmp(attribute, "anonymous") == 0) {
-        return LDNewBool(user->anonymous);
-    } else if (user->custom) {
-        const struct LDJSON *node = NULL;
+    if (!(value = LDi_lookupAttribute(user, attribute, &temporary))) {
+        return NULL;
+    }
+
+    if (temporary) {
+        return temporary;
+    }
 
-        LD_ASSERT(LDJSONGetType(user->custom) == LDObject);
+    return LDJSONDuplicate(value);
+}
 
-        if ((node = LDObjectLookup(user->custom, attribute))) {
-            return LDJSONDuplicate(node);
+bool
+LDUserPrepare(struct LDClient *const client, struct LDUser *const user)
+{
+    struct LDUserPrepared *prepared;
+    unsigned int name;
+
+    LD_ASSERT(client);
+    LD_ASSERT(user);
+
+    unprepare(user);
+
+    if (!(prepared = (struct LDUserPrepared *)
+        LDAlloc(sizeof(struct LDUserPrepared))))
+    {
+        return false;
+    }
+
+    memset(prepared, 0, sizeof(struct LDUserPrepared));
+
+    for (name = LD_NAME_KEY; name <= LD_NAME_ANONYMOUS; name++) {
+        if (!newAttribute(user, (enum LDName)name,
+            &prepared->attributes[name]))
+        {
+            goto error;
         }
+    }
 
-        return NULL;
+    if (!(prepared->redacted = LDUserToJSON(client, user, true))) {
+        goto error;
     }
 
-    return NULL;
+    prepared->client = client;
+
+    if (user->key) {
+        prepared->keyHash = LDLRUHash(user->key);
+    }
+
+    user->prepared = prepared;
+
+    return true;
+
+  error:
+    for (name = 0; name < LD_NAME_COUNT; name++) {
+        LDJSONFree(prepared->attributes[name]);
+    }
+
+    LDJSONFree(prepared->redacted);
+    LDFree(prepared);
+
+    return false;
 }
 
 bool
@@ -2,6 +2,20 @@
 
 #include <launchdarkly/api.h>
 
+#include "misc.h"
+
+/* What evaluations and events derive from a user, computed once by
+LDUserPrepare and discarded by any change to the user. */
+struct LDUserPrepared {
+    /* built in attributes by name, NULL when the user does not have one */
+    struct LDJSON *attributes[LD_NAME_COUNT];
+    /* the client the user JSON was redacted for */
+    const struct LDClient *client;
+    struct LDJSON *redacted;
+    /* of the key, for the user keys LRU */
+    unsigned int keyHash;
+};
+
 struct LDUser {
     char *key;
     bool anonymous;
@@ -15,11 +29,18 @@ struct LDUser {
     char *country;
     struct LDJSON *privateAttributeNames; /* Array of Text */
     struct LDJSON *custom; /* Object, may be NULL */
+    struct LDUserPrepared *prepared; /* may be NULL */
 };
 
 struct LDJSON *LDi_valueOfAttribute(const struct LDUser *const user,
     const char *const attribute);
 
+/* As LDi_valueOfAttribute without copying, the value belongs to the user
+when it is custom or the user is prepared. Otherwise it is allocated into
+temporary, which the caller frees. */
+const struct LDJSON *LDi_lookupAttribute(const struct LDUser *const user,
+    const char *const attribute, struct LDJSON **const temporary);
+
 struct LDJSON *LDUserToJSON(struct LDClient *const client,
     const struct LDUser *const lduser, const bool redact);
 
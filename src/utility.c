@@ -1,10 +1,63 @@
 #include <string.h>
 #include <stdlib.h>
+#include <locale.h>
 
 #include <launchdarkly/api.h>
 
 #include "misc.h"
 
+const char *const LDi_names[LD_NAME_COUNT] = {
+    "in",
+    "endsWith",
+    "startsWith",
+    "matches",
+    "contains",
+    "lessThan",
+    "lessThanOrEqual",
+    "greaterThan",
+    "greaterThanOrEqual",
+    "before",
+    "after",
+    "semVerEqual",
+    "semVerLessThan",
+    "semVerGreaterThan",
+    "segmentMatch",
+    "key",
+    "ip",
+    "email",
+    "firstName",
+    "lastName",
+    "avatar",
+    "country",
+    "name",
+    "anonymous"
+};
+
+enum LDName
+LDi_nameIn(const char *const text, const enum LDName first,
+    const enum LDName last)
+{
+    unsigned int name;
+
+    LD_ASSERT(text);
+    LD_ASSERT(first <= last);
+    LD_ASSERT(last < LD_NAME_COUNT);
+
+    for (name = first; name <= last; name++) {
+        if (text == LDi_names[name]) {
+            return (enum LDName)name;
+        }
+    }
+
+    for (name = first; name <= last; name++) {
+        if (strcmp(text, LDi_names[name]) == 0) {
+            return (enum LDName)name;
+        }
+    }
+
+    return LD_NAME_COUNT;
+}
+
 bool
 LDSetString(char **const target, const char *const value)
 {
@@ -68,3 +121,11 @@ LDi_UUIDv4(char *const buffer)
 
     return true;
 }
+
+char
+LDi_decimalPoint()
+{
+    const struct lconv *const conventions = localeconv();
+
+    return conventions->decimal_point[0] ? conventions->decimal_point[0] : '.';
+}
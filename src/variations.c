@@ -239,209 +239,352 @@ possiblyQueueEvent(struct LDClient *const client,
     LDJSONFree(event);
 }
 
-static struct LDJSON *
-variation(struct LDClient *const client, const struct LDUser *const user,
-    const char *const key, struct LDJSON *const fallback,
-    bool (*const checkType)(const LDJSONType type),
-    struct LDDetails *const o_details)
-{
-    struct LDStore *store;
-    struct LDJSON *flag, *value, *event, *indexEvent;
-    struct LDDetails details, *detailsref;
-    struct LDJSONRC *flagrc;
-    bool validUser;
-
-    LD_ASSERT(client);
-    LD_ASSERT(checkType);
-
-    flag       = NULL;
-    flagrc     = NULL;
-    value      = NULL;
-    store      = NULL;
-    event      = NULL;
-    indexEvent = NULL;
-    validUser  = LDUserValidate(user);
+/* batches of up to this many flags keep their lookups on the stack */
+#define LD_VARIATIONS_STACK 16
+
+/* one flag of a batch */
+struct Evaluation {
+    const char *key;
+    /* consumed, may be NULL */
+    struct LDJSON *fallback;
+    bool (*checkType)(const LDJSONType type);
+    /* never NULL */
+    struct LDDetails *details;
+    /* the flag value during evaluation, afterwards the value or fallback */
+    struct LDJSON *value;
+};
 
-    LDDetailsInit(&details);
-
-    if (o_details) {
-        detailsref = o_details;
-        LDDetailsInit(detailsref);
-    } else {
-        detailsref = &details;
-    }
+static void
+setError(struct LDDetails *const details, const enum LDEvalErrorKind kind)
+{
+    LD_ASSERT(details);
 
-    if (!LDClientIsInitialized(client)) {
-        detailsref->reason = LD_ERROR;
-        detailsref->extra.errorKind = LD_CLIENT_NOT_READY;
+    LDDetailsClear(details);
 
-        goto error;
-    }
+    details->reason          = LD_ERROR;
+    details->extra.errorKind = kind;
+}
 
-    if (!key) {
-        detailsref->reason = LD_ERROR;
-        detailsref->extra.errorKind = LD_NULL_KEY;
+static bool
+pushEvent(struct LDJSON **const events, struct LDJSON *const event)
+{
+    LD_ASSERT(events);
+    LD_ASSERT(event);
 
-        goto error;
+    if (!*events && !(*events = LDNewArray())) {
+        return false;
     }
 
-    LD_ASSERT(store = client->store);
+    return LDArrayPush(*events, event);
+}
 
-    if (!LDStoreGet(store, LD_FLAG, key, &flagrc)) {
-        detailsref->reason = LD_ERROR;
-        detailsref->extra.errorKind = LD_STORE_ERROR;
+/* Evaluates one flag of a batch. Feature events are appended to known, or to
+unknown when the flag does not exist, to be summarized and queued once the
+whole batch is done. */
+static void
+evaluateOne(struct LDClient *const client, const struct LDUser *const user,
+    const bool validUser, struct Evaluation *const evaluation,
+    const struct LDJSON *const flag, const bool withReasons,
+    struct LDEvalMemo *const memo, struct LDJSON **const known,
+    struct LDJSON **const unknown)
+{
+    struct LDJSON *value, *event, *events;
+    struct LDDetails *details;
 
-        goto error;
-    }
+    LD_ASSERT(client);
+    LD_ASSERT(evaluation);
+    LD_ASSERT(evaluation->key);
+    LD_ASSERT(known);
+    LD_ASSERT(unknown);
 
-    if (flagrc) {
-        flag = LDJSONRCGet(flagrc);
-    }
+    value   = NULL;
+    event   = NULL;
+    events  = NULL;
+    details = evaluation->details;
 
     if (!flag) {
-        detailsref->reason = LD_ERROR;
-        detailsref->extra.errorKind = LD_FLAG_NOT_FOUND;
+        setError(details, LD_FLAG_NOT_FOUND);
     } else if (validUser == false) {
-        detailsref->reason = LD_ERROR;
-        detailsref->extra.errorKind = LD_USER_NOT_SPECIFIED;
+        setError(details, LD_USER_NOT_SPECIFIED);
     } else {
-        struct LDJSON *events;
-
-        events = NULL;
+        struct LDJSON *iter;
 
-        const EvalStatus status = LDi_evaluate(client, flag, user, store,
-            detailsref, &events, &value, o_details != NULL);
+        const EvalStatus status = LDi_evaluate(client, flag, user,
+            client->store, details, &events, &value, withReasons, memo);
 
         if (status == EVAL_MEM) {
-            detailsref->reason = LD_ERROR;
-            detailsref->extra.errorKind = LD_OOM;
-
-            LDJSONFree(events);
+            setError(details, LD_OOM);
 
             goto error;
         } else if (status == EVAL_SCHEMA) {
-            detailsref->reason = LD_ERROR;
-            detailsref->extra.errorKind = LD_MALFORMED_FLAG;
-
-            LDJSONFree(events);
+            setError(details, LD_MALFORMED_FLAG);
 
             goto error;
         }
 
         if (events) {
-            struct LDJSON *iter;
             /* local only sanity */
             LD_ASSERT(LDJSONGetType(events) == LDArray);
-            /* different loop to make cleanup easier */
-            for (iter = LDGetIter(events); iter; iter = LDIterNext(iter)) {
-                if (!LDi_summarizeEvent(client, iter, false)) {
-                    LD_LOG(LD_LOG_ERROR, "summary failed");
 
-                    LDJSONFree(events);
+            for (iter = LDGetIter(events); iter;) {
+                struct LDJSON *const next = LDIterNext(iter);
+
+                if (!pushEvent(known, LDCollectionDetachIter(events, iter))) {
+                    LDJSONFree(iter);
+
+                    setError(details, LD_OOM);
 
                     goto error;
                 }
+
+                iter = next;
             }
+        }
+    }
 
-            for (iter = LDGetIter(events); iter;) {
-                struct LDJSON *const next = LDIterNext(iter);
+    {
+        const struct LDJSON *evalue;
+        const unsigned int *variationNumRef;
 
-                possiblyQueueEvent(client, LDCollectionDetachIter(events, iter));
+        if (!LDi_notNull(evalue = value)) {
+            evalue = evaluation->fallback;
+        }
 
-                iter = next;
-            }
+        variationNumRef = NULL;
 
-            LDJSONFree(events);
+        if (details->hasVariation) {
+            variationNumRef = &details->variationIndex;
+        }
+
+        event = LDi_newFeatureRequestEvent(client, evaluation->key, user,
+            variationNumRef, evalue, evaluation->fallback, NULL, flag,
+            withReasons ? details : NULL);
+
+        if (!event) {
+            LD_LOG(LD_LOG_ERROR, "failed to build feature request event");
+
+            setError(details, LD_OOM);
+
+            goto error;
         }
     }
 
-    if (validUser && !LDi_maybeMakeIndexEvent(client, user, &indexEvent)) {
-        detailsref->reason = LD_ERROR;
-        detailsref->extra.errorKind = LD_OOM;
+    if (!pushEvent(flag ? known : unknown, event)) {
+        setError(details, LD_OOM);
 
         goto error;
     }
 
-    {
-        struct LDDetails *optionalDetails;
-        struct LDJSON *evalue;
-        unsigned int *variationNumRef;
+    event = NULL;
 
-        optionalDetails = NULL;
-        evalue = NULL;
-        variationNumRef = NULL;
+    if (LDi_notNull(value) && !evaluation->checkType(LDJSONGetType(value))) {
+        setError(details, LD_WRONG_TYPE);
 
-        if (!LDi_notNull(evalue = value)) {
-            evalue = fallback;
+        goto error;
+    }
+
+    LDJSONFree(events);
+
+    evaluation->value = value;
+
+    return;
+
+  error:
+    LDJSONFree(event);
+    LDJSONFree(events);
+    LDJSONFree(value);
+}
+
+/* Evaluates a batch of flags for one user. Flags are read from the store
+together, and the index event, summary counters, and event queue are each
+visited once for the whole batch. Every evaluation ends with its value, or
+its fallback which is otherwise freed. */
+static void
+evaluateMany(struct LDClient *const client, const struct LDUser *const user,
+    struct Evaluation *const evaluations, const unsigned int count,
+    const bool withReasons)
+{
+    struct LDJSONRC *flagStorage[LD_VARIATIONS_STACK], **flags;
+    const char *keyStorage[LD_VARIATIONS_STACK], **keys;
+    struct LDJSON *known, *unknown, *indexEvent, *iter;
+    struct LDEvalMemo memo;
+    unsigned int i;
+    bool validUser, fetched;
+
+    LD_ASSERT(client);
+    LD_ASSERT(evaluations || count == 0);
+
+    flags      = flagStorage;
+    keys       = keyStorage;
+    known      = NULL;
+    unknown    = NULL;
+    indexEvent = NULL;
+    fetched    = false;
+    validUser  = LDUserValidate(user);
+
+    LDi_evalMemoInit(&memo);
+
+    for (i = 0; i < count; i++) {
+        LD_ASSERT(evaluations[i].details);
+        LD_ASSERT(evaluations[i].checkType);
+
+        LDDetailsInit(evaluations[i].details);
+
+        evaluations[i].value = NULL;
+    }
+
+    if (!LDClientIsInitialized(client)) {
+        for (i = 0; i < count; i++) {
+            setError(evaluations[i].details, LD_CLIENT_NOT_READY);
         }
 
-        if (detailsref->hasVariation) {
-            variationNumRef = &detailsref->variationIndex;
+        goto cleanup;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (!evaluations[i].key) {
+            setError(evaluations[i].details, LD_NULL_KEY);
         }
+    }
+
+    if (count > LD_VARIATIONS_STACK) {
+        flags = (struct LDJSONRC **)LDAlloc(sizeof(*flags) * count);
+        keys  = (const char **)LDAlloc(sizeof(*keys) * count);
+
+        if (!flags || !keys) {
+            for (i = 0; i < count; i++) {
+                if (evaluations[i].key) {
+                    setError(evaluations[i].details, LD_OOM);
+                }
+            }
 
-        if (o_details) {
-            optionalDetails = detailsref;
+            goto cleanup;
         }
+    }
 
-        event = LDi_newFeatureRequestEvent(client, key, user,
-            variationNumRef, evalue, fallback, NULL, flag, optionalDetails);
+    for (i = 0; i < count; i++) {
+        keys[i] = evaluations[i].key;
+    }
 
-        if (!event) {
-            LD_LOG(LD_LOG_ERROR, "failed to build feature request event");
+    if (!LDStoreGetMany(client->store, LD_FLAG, keys, count, flags)) {
+        for (i = 0; i < count; i++) {
+            if (evaluations[i].key) {
+                setError(evaluations[i].details, LD_STORE_ERROR);
+            }
+        }
 
-            detailsref->reason = LD_ERROR;
-            detailsref->extra.errorKind = LD_OOM;
+        goto cleanup;
+    }
 
-            goto error;
+    fetched = true;
+
+    for (i = 0; i < count; i++) {
+        if (evaluations[i].key) {
+            evaluateOne(client, user, validUser, &evaluations[i],
+                flags[i] ? LDJSONRCGet(flags[i]) : NULL, withReasons,
+                &memo, &known, &unknown);
         }
     }
 
+    LDi_evalMemoClear(&memo);
+
+    if (!known && !unknown) {
+        goto cleanup;
+    }
+
+    if (validUser && !LDi_maybeMakeIndexEvent(client, user, &indexEvent)) {
+        goto failed;
+    }
+
     if (indexEvent) {
         LDi_addEvent(client, indexEvent);
         indexEvent = NULL;
     }
 
-    if (!LDi_summarizeEvent(client, event, !flag)) {
+    if ((known && !LDi_summarizeEvents(client, known, false)) ||
+        (unknown && !LDi_summarizeEvents(client, unknown, true)))
+    {
         LD_LOG(LD_LOG_ERROR, "summary failed");
 
-        detailsref->reason = LD_ERROR;
-        detailsref->extra.errorKind = LD_OOM;
+        goto failed;
+    }
 
-        goto error;
+    if (known) {
+        for (iter = LDGetIter(known); iter;) {
+            struct LDJSON *const next = LDIterNext(iter);
+
+            possiblyQueueEvent(client, LDCollectionDetachIter(known, iter));
+
+            iter = next;
+        }
     }
 
-    if (flag) {
-        possiblyQueueEvent(client, event);
-        event = NULL;
+    goto cleanup;
+
+  failed:
+    for (i = 0; i < count; i++) {
+        if (evaluations[i].details->reason != LD_ERROR) {
+            LDJSONFree(evaluations[i].value);
+            evaluations[i].value = NULL;
+
+            setError(evaluations[i].details, LD_OOM);
+        }
     }
 
-    if (!LDi_notNull(value)) {
-        goto error;
+  cleanup:
+    for (i = 0; i < count; i++) {
+        if (LDi_notNull(evaluations[i].value)) {
+            LDJSONFree(evaluations[i].fallback);
+        } else {
+            LDJSONFree(evaluations[i].value);
+
+            evaluations[i].value = evaluations[i].fallback;
+        }
+
+        evaluations[i].fallback = NULL;
+
+        if (fetched) {
+            LDJSONRCDecrement(flags[i]);
+        }
     }
 
-    if (!checkType(LDJSONGetType(value))) {
-        detailsref->reason = LD_ERROR;
-        detailsref->extra.errorKind = LD_WRONG_TYPE;
+    if (flags != flagStorage) {
+        LDFree(flags);
+    }
 
-        goto error;
+    if (keys != keyStorage) {
+        LDFree(keys);
     }
 
-    LDJSONFree(event);
+    LDJSONFree(known);
+    LDJSONFree(unknown);
     LDJSONFree(indexEvent);
-    LDJSONFree(fallback);
-    LDDetailsClear(&details);
-    LDJSONRCDecrement(flagrc);
+}
 
-    return value;
+static struct LDJSON *
+variation(struct LDClient *const client, const struct LDUser *const user,
+    const char *const key, struct LDJSON *const fallback,
+    bool (*const checkType)(const LDJSONType type),
+    struct LDDetails *const o_details)
+{
+    struct Evaluation evaluation;
+    struct LDDetails details;
+
+    LD_ASSERT(client);
+    LD_ASSERT(checkType);
+
+    LDDetailsInit(&details);
+
+    evaluation.key       = key;
+    evaluation.fallback  = fallback;
+    evaluation.checkType = checkType;
+    evaluation.details   = o_details ? o_details : &details;
+
+    evaluateMany(client, user, &evaluation, 1, o_details != NULL);
 
-  error:
-    LDJSONFree(event);
-    LDJSONFree(indexEvent);
-    LDJSONFree(value);
     LDDetailsClear(&details);
-    LDJSONRCDecrement(flagrc);
 
-    return fallback;
+    return evaluation.value;
 }
 
 static bool
@@ -641,18 +784,412 @@ LDJSONVariation(struct LDClient *const client, struct LDUser *const user,
     return result;
 }
 
-struct LDJSON *
-LDAllFlags(struct LDClient *const client, struct LDUser *const user)
+static struct LDJSON *
+newFallback(const struct LDVariationRequest *const request, bool *const failed)
 {
-    struct LDJSON *evaluatedFlags, *rawFlags, *rawFlagsIter;
+    struct LDJSON *fallback;
+
+    LD_ASSERT(request);
+    LD_ASSERT(failed);
+
+    fallback = NULL;
+
+    switch (request->type) {
+        case LD_VARIATION_BOOL:
+            fallback = LDNewBool(request->fallback.boolean);
+            break;
+        case LD_VARIATION_INT:
+            fallback = LDNewNumber(request->fallback.integer);
+            break;
+        case LD_VARIATION_DOUBLE:
+            fallback = LDNewNumber(request->fallback.number);
+            break;
+        case LD_VARIATION_STRING:
+            if (!request->fallback.text) {
+                return NULL;
+            }
+
+            fallback = LDNewText(request->fallback.text);
+            break;
+        case LD_VARIATION_JSON:
+            if (!request->fallback.json) {
+                return NULL;
+            }
+
+            fallback = LDJSONDuplicate(request->fallback.json);
+            break;
+        default:
+            LD_ASSERT(false);
+    }
+
+    if (!fallback) {
+        *failed = true;
+    }
+
+    return fallback;
+}
+
+static bool (*
+checkerOf(const enum LDVariationType type))(const LDJSONType type)
+{
+    switch (type) {
+        case LD_VARIATION_BOOL:   return isBool;
+        case LD_VARIATION_INT:    return isNumber;
+        case LD_VARIATION_DOUBLE: return isNumber;
+        case LD_VARIATION_STRING: return isText;
+        default: return isArrayOrObject;
+    }
+}
+
+/* converts what an evaluation ended with as the typed variation functions
+do, consuming it */
+static void
+setResult(const struct LDVariationRequest *const request,
+    struct LDVariationResult *const result, struct LDJSON *const value)
+{
+    LD_ASSERT(request);
+    LD_ASSERT(result);
+
+    switch (request->type) {
+        case LD_VARIATION_BOOL:
+            result->value.boolean = value ? LDGetBool(value) :
+                request->fallback.boolean;
+            break;
+        case LD_VARIATION_INT:
+            result->value.integer = value ? (int)LDGetNumber(value) :
+                request->fallback.integer;
+            break;
+        case LD_VARIATION_DOUBLE:
+            result->value.number = value ? LDGetNumber(value) :
+                request->fallback.number;
+            break;
+        case LD_VARIATION_STRING:
+            if (value) {
+                result->value.text = LDStrDup(LDGetText(value));
+            } else if (request->fallback.text) {
+                result->value.text = LDStrDup(request->fallback.text);
+            } else {
+                result->value.text = NULL;
+            }
+            break;
+        case LD_VARIATION_JSON:
+            if (value) {
+                result->value.json = value;
+
+                return;
+            } else if (request->fallback.json) {
+                result->value.json = LDJSONDuplicate(request->fallback.json);
+            } else {
+                result->value.json = NULL;
+            }
+            break;
+        default:
+            LD_ASSERT(false);
+    }
+
+    LDJSONFree(value);
+}
+
+void
+LDVariations(struct LDClient *const client, struct LDUser *const user,
+    const struct LDVariationRequest *const requests,
+    struct LDVariationResult *const results, const unsigned int count,
+    const bool details)
+{
+    struct Evaluation evaluationStorage[LD_VARIATIONS_STACK], *evaluations;
+    unsigned int i;
+    bool failed;
+
+    LD_ASSERT(client);
+    LD_ASSERT(requests || count == 0);
+    LD_ASSERT(results || count == 0);
+
+    evaluations = evaluationStorage;
+    failed      = false;
+
+    for (i = 0; i < count; i++) {
+        results[i].type = requests[i].type;
+
+        LDDetailsInit(&results[i].details);
+    }
+
+    if (count > LD_VARIATIONS_STACK) {
+        if (!(evaluations = (struct Evaluation *)
+            LDAlloc(sizeof(*evaluations) * count)))
+        {
+            LD_LOG(LD_LOG_ERROR, "allocation error");
+
+            goto failed;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        evaluations[i].key       = requests[i].key;
+        evaluations[i].fallback  = newFallback(&requests[i], &failed);
+        evaluations[i].checkType = checkerOf(requests[i].type);
+        evaluations[i].details   = &results[i].details;
+        evaluations[i].value     = NULL;
+    }
+
+    if (failed) {
+        LD_LOG(LD_LOG_ERROR, "allocation error");
+
+        for (i = 0; i < count; i++) {
+            LDJSONFree(evaluations[i].fallback);
+        }
+
+        goto failed;
+    }
+
+    evaluateMany(client, user, evaluations, count, details);
+
+    for (i = 0; i < count; i++) {
+        setResult(&requests[i], &results[i], evaluations[i].value);
+    }
+
+    if (evaluations != evaluationStorage) {
+        LDFree(evaluations);
+    }
+
+    return;
+
+  failed:
+    for (i = 0; i < count; i++) {
+        results[i].details.reason          = LD_ERROR;
+        results[i].details.extra.errorKind = LD_OOM;
+
+        setResult(&requests[i], &results[i], NULL);
+    }
+
+    if (evaluations != evaluationStorage) {
+        LDFree(evaluations);
+    }
+}
+
+void
+LDVariationResultsClear(struct LDVariationResult *const results,
+    const unsigned int count)
+{
+    unsigned int i;
+
+    LD_ASSERT(results || count == 0);
+
+    for (i = 0; i < count; i++) {
+        if (results[i].type == LD_VARIATION_STRING) {
+            LDFree(results[i].value.text);
+
+            results[i].value.text = NULL;
+        } else if (results[i].type == LD_VARIATION_JSON) {
+            LDJSONFree(results[i].value.json);
+
+            results[i].value.json = NULL;
+        }
+
+        LDDetailsClear(&results[i].details);
+    }
+}
+
+/* flags evaluated by each part of an all flags job */
+#define LD_ALL_FLAGS_PART 64
+
+struct FlagResult {
+    const struct LDJSON *flag;
+    struct LDJSON *value;
+    /* entry of $flagsState when requested */
+    struct LDJSON *state;
+    bool skipped;
+    bool failed;
+};
+
+struct AllFlagsJob {
+    struct LDClient *client;
+    const struct LDUser *user;
+    struct FlagResult *results;
+    unsigned int count;
+    unsigned int options;
+    bool withState;
+};
+
+static bool
+isClientSide(const struct LDJSON *const flag)
+{
+    const struct LDJSON *clientSide;
+
+    clientSide = LDObjectLookup(flag, "clientSide");
+
+    return clientSide && LDJSONGetType(clientSide) == LDBool &&
+        LDGetBool(clientSide);
+}
+
+/* the metadata of a flag the client side SDKs expect in $flagsState */
+static struct LDJSON *
+newFlagState(const struct LDJSON *const flag,
+    const struct LDDetails *const details, const bool withReasons)
+{
+    struct LDJSON *state, *tmp;
+
+    LD_ASSERT(flag);
+    LD_ASSERT(details);
+
+    if (!(state = LDNewObject())) {
+        return NULL;
+    }
+
+    if (!(tmp = LDNewNumber(LDi_getFeatureVersionTrusted(flag))) ||
+        !LDObjectSetKey(state, "version", tmp))
+    {
+        goto error;
+    }
+
+    if (details->hasVariation) {
+        if (!(tmp = LDNewNumber(details->variationIndex)) ||
+            !LDObjectSetKey(state, "variation", tmp))
+        {
+            goto error;
+        }
+    }
+
+    if (withReasons) {
+        if (!(tmp = LDReasonToJSON(details)) ||
+            !LDObjectSetKey(state, "reason", tmp))
+        {
+            goto error;
+        }
+    }
+
+    tmp = LDObjectLookup(flag, "trackEvents");
+
+    if (tmp && LDJSONGetType(tmp) == LDBool && LDGetBool(tmp)) {
+        if (!(tmp = LDNewBool(true)) ||
+            !LDObjectSetKey(state, "trackEvents", tmp))
+        {
+            goto error;
+        }
+    }
+
+    tmp = LDObjectLookup(flag, "debugEventsUntilDate");
+
+    if (tmp && LDJSONGetType(tmp) == LDNumber) {
+        if (!(tmp = LDJSONDuplicate(tmp)) ||
+            !LDObjectSetKey(state, "debugEventsUntilDate", tmp))
+        {
+            goto error;
+        }
+    }
+
+    return state;
+
+  error:
+    LDJSONFree(tmp);
+    LDJSONFree(state);
+
+    return NULL;
+}
+
+static void
+evaluateForAll(const struct AllFlagsJob *const job,
+    struct FlagResult *const result, struct LDEvalMemo *const memo)
+{
+    struct LDJSON *value, *events;
+    struct LDDetails details;
+    EvalStatus status;
+    bool withReasons;
+
+    LD_ASSERT(job);
+    LD_ASSERT(result);
+
+    value       = NULL;
+    events      = NULL;
+    withReasons = job->options & LD_ALL_FLAGS_WITH_REASONS;
+
+    if ((job->options & LD_ALL_FLAGS_CLIENT_SIDE_ONLY) &&
+        !isClientSide(result->flag))
+    {
+        result->skipped = true;
+
+        return;
+    }
+
+    LDDetailsInit(&details);
+
+    status = LDi_evaluate(job->client, result->flag, job->user,
+        job->client->store, &details, &events, &value, withReasons, memo);
+
+    LDJSONFree(events);
+
+    if (LDi_isEvalError(status)) {
+        result->failed = true;
+
+        LDJSONFree(value);
+        LDDetailsClear(&details);
+
+        return;
+    }
+
+    if (job->withState &&
+        !(result->state = newFlagState(result->flag, &details, withReasons)))
+    {
+        LD_LOG(LD_LOG_ERROR, "alloc error");
+
+        result->failed = true;
+
+        LDJSONFree(value);
+        LDDetailsClear(&details);
+
+        return;
+    }
+
+    result->value = value;
+
+    LDDetailsClear(&details);
+}
+
+/* a memo per part, so prerequisites and segments shared by its flags are
+evaluated once without the workers sharing state */
+static void
+evaluatePart(void *const jobRaw, const unsigned int part)
+{
+    struct AllFlagsJob *job;
+    struct LDEvalMemo memo;
+    unsigned int i, end;
+
+    LD_ASSERT(jobRaw);
+
+    job = (struct AllFlagsJob *)jobRaw;
+    end = (part + 1) * LD_ALL_FLAGS_PART;
+
+    if (end > job->count) {
+        end = job->count;
+    }
+
+    LDi_evalMemoInit(&memo);
+
+    for (i = part * LD_ALL_FLAGS_PART; i < end; i++) {
+        evaluateForAll(job, &job->results[i], &memo);
+    }
+
+    LDi_evalMemoClear(&memo);
+}
+
+/* Evaluates every flag, split into parts across the pool of the client, then
+merges the results in the order of the store so the output does not depend
+on scheduling. */
+static struct LDJSON *
+allFlags(struct LDClient *const client, const struct LDUser *const user,
+    const unsigned int options, const bool withState)
+{
+    struct LDJSON *evaluatedFlags, *flagsState, *rawFlags, *iter, *tmp;
     struct LDJSONRC *rawFlagsRC;
+    struct AllFlagsJob job;
+    unsigned int i;
 
     LD_ASSERT(client);
 
-    rawFlags       = NULL;
-    rawFlagsIter   = NULL;
-    rawFlagsRC     = NULL;
     evaluatedFlags = NULL;
+    flagsState     = NULL;
+    rawFlagsRC     = NULL;
+    job.results    = NULL;
+    job.count      = 0;
 
     if (client->config->offline) {
         LD_LOG(LD_LOG_WARNING, "LDAllFlags called when offline returning NULL");
@@ -682,66 +1219,128 @@ LDAllFlags(struct LDClient *const client, struct LDUser *const user)
         return NULL;
     }
 
+    if (withState && !(flagsState = LDNewObject())) {
+        LD_LOG(LD_LOG_ERROR, "alloc error");
+
+        goto error;
+    }
+
     if (!LDStoreAll(client->store, LD_FLAG, &rawFlagsRC)) {
         LD_LOG(LD_LOG_ERROR, "LDAllFlags failed to fetch flags");
 
-        LDJSONFree(evaluatedFlags);
-
-        return NULL;
+        goto error;
     }
 
     LD_ASSERT(rawFlags = LDJSONRCGet(rawFlagsRC));
 
-    for (rawFlagsIter = LDGetIter(rawFlags); rawFlagsIter;
-        rawFlagsIter = LDIterNext(rawFlagsIter))
-    {
-        struct LDJSON *value, *events;
-        EvalStatus status;
-        struct LDDetails details;
-        struct LDJSON *flag;
-        const char *key;
+    job.client    = client;
+    job.user      = user;
+    job.options   = options;
+    job.withState = withState;
 
-        value   = NULL;
-        events  = NULL;
-        key     = NULL;
+    if ((job.count = LDCollectionGetSize(rawFlags)) > 0) {
+        if (!(job.results = (struct FlagResult *)
+            LDAlloc(sizeof(struct FlagResult) * job.count)))
+        {
+            LD_LOG(LD_LOG_ERROR, "alloc error");
+
+            job.count = 0;
+
+            goto error;
+        }
 
-        LD_ASSERT(flag = rawFlagsIter);
+        memset(job.results, 0, sizeof(struct FlagResult) * job.count);
+    }
 
-        LDDetailsInit(&details);
+    for (i = 0, iter = LDGetIter(rawFlags); iter; i++, iter = LDIterNext(iter))
+    {
+        job.results[i].flag = iter;
+    }
 
-        status = LDi_evaluate(client, flag, user, client->store,
-            &details, &events, &value, false);
+    LDi_poolRun(client->pool, evaluatePart, &job,
+        (job.count + LD_ALL_FLAGS_PART - 1) / LD_ALL_FLAGS_PART);
 
-        if (LDi_isEvalError(status)) {
-            LDJSONFree(events);
-            LDDetailsClear(&details);
+    for (i = 0; i < job.count; i++) {
+        struct FlagResult *const result = &job.results[i];
+        const char *key;
 
+        if (result->failed) {
             goto error;
         }
 
-        LD_ASSERT(key = LDGetText(LDObjectLookup(flag, "key")));
+        if (result->skipped) {
+            continue;
+        }
 
-        if (value) {
-            if (!LDObjectSetKey(evaluatedFlags, key, value)) {
-                LDJSONFree(events);
-                LDJSONFree(value);
-                LDDetailsClear(&details);
+        LD_ASSERT(key = LDGetText(LDObjectLookup(result->flag, "key")));
 
+        if (withState) {
+            if (!result->value && !(result->value = LDNewNull())) {
                 goto error;
             }
+
+            if (!LDObjectSetKey(flagsState, key, result->state)) {
+                goto error;
+            }
+
+            result->state = NULL;
         }
 
-        LDJSONFree(events);
-        LDDetailsClear(&details);
+        if (result->value) {
+            if (!LDObjectSetKey(evaluatedFlags, key, result->value)) {
+                goto error;
+            }
+
+            result->value = NULL;
+        }
     }
 
+    if (withState) {
+        if (!LDObjectSetKey(evaluatedFlags, "$flagsState", flagsState)) {
+            goto error;
+        }
+
+        flagsState = NULL;
+
+        if (!(tmp = LDNewBool(true))) {
+            goto error;
+        }
+
+        if (!LDObjectSetKey(evaluatedFlags, "$valid", tmp)) {
+            LDJSONFree(tmp);
+
+            goto error;
+        }
+    }
+
+    LDFree(job.results);
     LDJSONRCDecrement(rawFlagsRC);
 
     return evaluatedFlags;
 
   error:
+    for (i = 0; i < job.count; i++) {
+        LDJSONFree(job.results[i].value);
+        LDJSONFree(job.results[i].state);
+    }
+
+    LDFree(job.results);
     LDJSONRCDecrement(rawFlagsRC);
+    LDJSONFree(flagsState);
     LDJSONFree(evaluatedFlags);
 
     return NULL;
 }
+
+struct LDJSON *
+LDAllFlags(struct LDClient *const client, struct LDUser *const user)
+{
+    return allFlags(client, user, 0, false);
+}
+
+struct LDJSON *
+LDAllFlagsState(struct LDClient *const client, struct LDUser *const user,
+    const unsigned int options)
+{
+    return allFlags(client, user, options, true);
+}
@@ -0,0 +1,194 @@
+#include <stdio.h>
+
+#include <launchdarkly/api.h>
+#include <launchdarkly/store/redis.h>
+
+#include "misc.h"
+#include "src/redis.h"
+
+#include "util-flags.h"
+
+/* Measures backend initialization and contended upserts against a local
+redis-server. Not part of the test suite, build with -DBENCHMARKS=ON and run
+manually. */
+
+#define ITERATIONS 5
+#define WRITERS 8
+#define WRITES_PER_WRITER 2000
+
+struct Writer {
+    struct LDStoreInterface *interface;
+    unsigned int index;
+    char *serialized;
+};
+
+/* every writer patches the same flag with interleaved versions */
+static THREAD_RETURN
+writeContended(void *const rawWriter)
+{
+    struct Writer *const writer = (struct Writer *)rawWriter;
+    unsigned int i;
+
+    LD_ASSERT(writer);
+
+    for (i = 0; i < WRITES_PER_WRITER; i++) {
+        struct LDStoreCollectionItem item;
+
+        item.buffer     = writer->serialized;
+        item.bufferSize = strlen(writer->serialized);
+        item.version    = i * WRITERS + writer->index + 1;
+
+        LD_ASSERT(writer->interface->upsert(writer->interface->context,
+            "features", &item, "contended"));
+    }
+
+    return THREAD_RETURN_DEFAULT;
+}
+
+static void
+benchContendedUpsert(struct LDStoreInterface *const interface)
+{
+    struct Writer writers[WRITERS];
+    ld_thread_t threads[WRITERS];
+    struct LDJSON *flag;
+    char *serialized;
+    unsigned long start, end;
+    unsigned int i;
+
+    LD_ASSERT(interface);
+
+    LD_ASSERT(flag = makeMinimalFlag("contended", 1, true, false));
+    LD_ASSERT(serialized = LDJSONSerialize(flag));
+    LDJSONFree(flag);
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&start));
+
+    for (i = 0; i < WRITERS; i++) {
+        writers[i].interface  = interface;
+        writers[i].index      = i;
+        writers[i].serialized = serialized;
+
+        LD_ASSERT(LDi_createthread(&threads[i], writeContended, &writers[i]));
+    }
+
+    for (i = 0; i < WRITERS; i++) {
+        LD_ASSERT(LDi_jointhread(threads[i]));
+    }
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&end));
+
+    if (end == start) {
+        end++;
+    }
+
+    printf("redis upsert %u writers x %u: %6lu ms (%.0f writes/s)\n",
+        WRITERS, WRITES_PER_WRITER, end - start,
+        (WRITERS * WRITES_PER_WRITER * 1000.0) / (end - start));
+
+    LDFree(serialized);
+}
+
+static void
+printPoolStats(struct LDStoreInterface *const interface)
+{
+    struct LDRedisPoolStats stats;
+
+    LD_ASSERT(interface);
+
+    LDRedisGetPoolStats(interface, &stats);
+
+    printf("redis pool: %lu checkouts, %lu waits (%lu ms), %lu timeouts, "
+        "%lu connects\n", stats.checkouts, stats.waits,
+        stats.waitMilliseconds, stats.timeouts, stats.connects);
+}
+
+static void
+benchInit(struct LDStoreInterface *const interface,
+    const unsigned int itemCount)
+{
+    struct LDStoreCollectionState collections[2];
+    struct LDStoreCollectionStateItem *items;
+    char **keys;
+    unsigned int i, iteration;
+    unsigned long best;
+
+    LD_ASSERT(interface);
+
+    LD_ASSERT(items = (struct LDStoreCollectionStateItem *)
+        LDAlloc(sizeof(struct LDStoreCollectionStateItem) * itemCount));
+    LD_ASSERT(keys = (char **)LDAlloc(sizeof(char *) * itemCount));
+
+    for (i = 0; i < itemCount; i++) {
+        struct LDJSON *flag;
+        char key[64];
+
+        LD_ASSERT(snprintf(key, sizeof(key), "flag-%u", i) >= 0);
+        LD_ASSERT(keys[i] = LDStrDup(key));
+        LD_ASSERT(flag = makeMinimalFlag(key, 1, true, false));
+
+        items[i].key             = keys[i];
+        LD_ASSERT(items[i].item.buffer = LDJSONSerialize(flag));
+        items[i].item.bufferSize = strlen(items[i].item.buffer);
+        items[i].item.version    = 1;
+
+        LDJSONFree(flag);
+    }
+
+    collections[0].kind      = "features";
+    collections[0].items     = items;
+    collections[0].itemCount = itemCount;
+
+    collections[1].kind      = "segments";
+    collections[1].items     = NULL;
+    collections[1].itemCount = 0;
+
+    best = 0;
+
+    for (iteration = 0; iteration < ITERATIONS; iteration++) {
+        unsigned long start, end;
+
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&start));
+        LD_ASSERT(interface->init(interface->context, collections, 2));
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&end));
+
+        if (iteration == 0 || end - start < best) {
+            best = end - start;
+        }
+    }
+
+    printf("redis init %6u items: %6lu ms (best of %d)\n", itemCount, best,
+        ITERATIONS);
+
+    for (i = 0; i < itemCount; i++) {
+        LDFree(items[i].item.buffer);
+        LDFree(keys[i]);
+    }
+
+    LDFree(items);
+    LDFree(keys);
+}
+
+int
+main()
+{
+    struct LDRedisConfig *redisConfig;
+    struct LDStoreInterface *interface;
+
+    LDConfigureGlobalLogger(LD_LOG_WARNING, LDBasicLogger);
+    LDGlobalInit();
+
+    LD_ASSERT(redisConfig = LDRedisConfigNew());
+    LD_ASSERT(LDRedisConfigSetPrefix(redisConfig, "bench"));
+    LD_ASSERT(interface = LDStoreInterfaceRedisNew(redisConfig));
+
+    benchInit(interface, 100);
+    benchInit(interface, 5000);
+    benchInit(interface, 50000);
+    benchContendedUpsert(interface);
+    printPoolStats(interface);
+
+    interface->destructor(interface->context);
+    LDFree(interface);
+
+    return 0;
+}
@@ -10,6 +10,39 @@ extern "C" {
 
 struct LDRedisConfig;
 
+/* How cached items learn about changes made by other writers */
+enum LDRedisInvalidation {
+    /* cached items are only refreshed when the cache TTL expires */
+    LD_REDIS_INVALIDATION_NONE,
+    /* Writers publish "kind:key", "kind", or "*" on the channel
+    "<prefix>:$invalidate". Stores using this mode publish their own
+    writes. */
+    LD_REDIS_INVALIDATION_CHANNEL,
+    /* Redis keyspace notifications, requires notify-keyspace-events to
+    include "Khg" on the server. Each change drops the cache of a whole
+    kind. */
+    LD_REDIS_INVALIDATION_KEYSPACE
+};
+
+/* Counters describing the connection pool */
+struct LDRedisPoolStats {
+    /* connections handed out */
+    unsigned long checkouts;
+    /* checkouts that had to wait for a free connection */
+    unsigned long waits;
+    /* total time spent waiting, including waits that timed out */
+    unsigned long waitMilliseconds;
+    /* checkouts that gave up after the pool wait timeout */
+    unsigned long timeouts;
+    /* connections opened */
+    unsigned long connects;
+    unsigned long failedConnects;
+    /* connections closed after an error */
+    unsigned long discarded;
+    /* idle connections that did not answer PING */
+    unsigned long healthCheckFailures;
+};
+
 LD_EXPORT(struct LDRedisConfig *) LDRedisConfigNew();
 
 LD_EXPORT(bool) LDRedisConfigSetHost(struct LDRedisConfig *const config,
@@ -24,11 +57,55 @@ LD_EXPORT(bool) LDRedisConfigSetPrefix(struct LDRedisConfig *const config,
 LD_EXPORT(bool) LDRedisConfigSetPoolSize(struct LDRedisConfig *const config,
     const unsigned int poolSize);
 
+/* Time allowed to establish a connection. Default 1000ms, 0 blocks. */
+LD_EXPORT(bool) LDRedisConfigSetConnectTimeout(
+    struct LDRedisConfig *const config, const unsigned int milliseconds);
+
+/* Time allowed for a single command. Default 3000ms, 0 blocks. */
+LD_EXPORT(bool) LDRedisConfigSetCommandTimeout(
+    struct LDRedisConfig *const config, const unsigned int milliseconds);
+
+/* How long to wait for a free connection when the pool is exhausted.
+Default 1000ms. */
+LD_EXPORT(bool) LDRedisConfigSetPoolWaitTimeout(
+    struct LDRedisConfig *const config, const unsigned int milliseconds);
+
+/* Connections idle for longer than this are checked with PING before use.
+Default 10000ms, 0 disables. */
+LD_EXPORT(bool) LDRedisConfigSetHealthCheckInterval(
+    struct LDRedisConfig *const config, const unsigned int milliseconds);
+
+/* Keeps the SDK cache in sync without waiting for the cache TTL, which can
+then be very long. Requires LDStoreInterfaceRedisExtensions. Default
+LD_REDIS_INVALIDATION_NONE. */
+LD_EXPORT(bool) LDRedisConfigSetInvalidation(
+    struct LDRedisConfig *const config,
+    const enum LDRedisInvalidation invalidation);
+
+/* Background refreshes, writes, and initialization are sent on a single
+non-blocking connection driven by a dedicated thread, instead of holding a
+pooled connection for each round trip. Reads that miss the cache still use
+the pool. Requires LDStoreInterfaceRedisExtensions. Not available on Windows.
+Default false. */
+LD_EXPORT(bool) LDRedisConfigSetAsync(struct LDRedisConfig *const config,
+    const bool async);
+
 LD_EXPORT(void) LDRedisConfigFree(struct LDRedisConfig *const config);
 
 LD_EXPORT(struct LDStoreInterface *) LDStoreInterfaceRedisNew(
     struct LDRedisConfig *const config);
 
+/* Fills the optional capabilities of a store created by
+LDStoreInterfaceRedisNew, to pass to LDConfigSetFeatureStoreBackendExtensions.
+Invalidation and LDRedisConfigSetAsync require them. */
+LD_EXPORT(void) LDStoreInterfaceRedisExtensions(
+    struct LDStoreInterface *const store,
+    struct LDStoreInterfaceExtensions *const extensions);
+
+/* The store must have been created by LDStoreInterfaceRedisNew */
+LD_EXPORT(void) LDRedisGetPoolStats(struct LDStoreInterface *const store,
+    struct LDRedisPoolStats *const stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,7 +1,24 @@
+#include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #define LD_SHUT_RDWR SD_BOTH
+#else
+    #include <sys/socket.h>
+    #include <poll.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #define LD_SHUT_RDWR SHUT_RDWR
+#endif
+
+#include <hiredis/async.h>
 
 #include <launchdarkly/store/redis.h>
 
+#include "sha1.h"
 #include "utlist.h"
 #include "misc.h"
 #include "redis.h"
@@ -10,12 +27,39 @@
 static const char *const defaultHost   = "127.0.0.1";
 static const char *const defaultPrefix = "launchdarkly";
 static const char *const initedKey     = "$inited";
+/* suffix of the pub/sub channel used by LD_REDIS_INVALIDATION_CHANNEL */
+static const char *const invalidateKey = "$invalidate";
+
+/* Compare and set in a single round trip. The version is decoded from the
+stored item, as other SDKs may write the hash without any other bookkeeping.
+Only the collection hash is touched, so the script also runs where every key
+of a script must be in the same Redis Cluster slot. Writes are published on
+the channel ARGV[4] when it is not empty. Returns 1 if written and 0 if the
+stored version is the same or newer. */
+static const char *const upsertScript =
+    "local raw = redis.call('HGET', KEYS[1], ARGV[1])\n"
+    "if raw then\n"
+    "  local ok, item = pcall(cjson.decode, raw)\n"
+    "  if ok and type(item) == 'table' and tonumber(item.version) and\n"
+    "    tonumber(item.version) >= tonumber(ARGV[2]) then\n"
+    "    return 0\n"
+    "  end\n"
+    "end\n"
+    "redis.call('HSET', KEYS[1], ARGV[1], ARGV[3])\n"
+    "if ARGV[4] ~= '' then redis.call('PUBLISH', ARGV[4], ARGV[5]) end\n"
+    "return 1\n";
 
 struct LDRedisConfig {
     char *host;
     uint16_t port;
     unsigned int poolSize;
     char *prefix;
+    unsigned int connectTimeout;
+    unsigned int commandTimeout;
+    unsigned int poolWaitTimeout;
+    unsigned int healthCheckInterval;
+    enum LDRedisInvalidation invalidation;
+    bool async;
 };
 
 static const char *
@@ -53,10 +97,16 @@ LDRedisConfigNew()
         return NULL;
     }
 
-    config->host     = NULL;
-    config->port     = 6379;
-    config->poolSize = 10;
-    config->prefix   = NULL;
+    config->host                = NULL;
+    config->port                = 6379;
+    config->poolSize            = 10;
+    config->prefix              = NULL;
+    config->connectTimeout      = 1000;
+    config->commandTimeout      = 3000;
+    config->poolWaitTimeout     = 1000;
+    config->healthCheckInterval = 10 * 1000;
+    config->invalidation        = LD_REDIS_INVALIDATION_NONE;
+    config->async               = false;
 
     return config;
 }
@@ -121,6 +171,80 @@ LDRedisConfigSetPoolSize(struct LDRedisConfig *const config,
     return true;
 }
 
+bool
+LDRedisConfigSetConnectTimeout(struct LDRedisConfig *const config,
+    const unsigned int milliseconds)
+{
+    LD_ASSERT(config);
+
+    config->connectTimeout = milliseconds;
+
+    return true;
+}
+
+bool
+LDRedisConfigSetCommandTimeout(struct LDRedisConfig *const config,
+    const unsigned int milliseconds)
+{
+    LD_ASSERT(config);
+
+    config->commandTimeout = milliseconds;
+
+    return true;
+}
+
+bool
+LDRedisConfigSetPoolWaitTimeout(struct LDRedisConfig *const config,
+    const unsigned int milliseconds)
+{
+    LD_ASSERT(config);
+
+    config->poolWaitTimeout = milliseconds;
+
+    return true;
+}
+
+bool
+LDRedisConfigSetHealthCheckInterval(struct LDRedisConfig *const config,
+    const unsigned int milliseconds)
+{
+    LD_ASSERT(config);
+
+    config->healthCheckInterval = milliseconds;
+
+    return true;
+}
+
+bool
+LDRedisConfigSetInvalidation(struct LDRedisConfig *const config,
+    const enum LDRedisInvalidation invalidation)
+{
+    LD_ASSERT(config);
+
+    config->invalidation = invalidation;
+
+    return true;
+}
+
+bool
+LDRedisConfigSetAsync(struct LDRedisConfig *const config, const bool async)
+{
+    LD_ASSERT(config);
+
+    #ifdef _WIN32
+        if (async) {
+            LD_LOG(LD_LOG_ERROR,
+                "redis async mode is not supported on Windows");
+
+            return false;
+        }
+    #endif
+
+    config->async = async;
+
+    return true;
+}
+
 void
 LDRedisConfigFree(struct LDRedisConfig *const config)
 {
@@ -132,125 +256,462 @@ LDRedisConfigFree(struct LDRedisConfig *const config)
     }
 }
 
-struct Context {
+enum ScriptState {
+    LD_SCRIPT_UNKNOWN,
+    LD_SCRIPT_LOADED,
+    /* scripting is disabled on the server, use WATCH / MULTI instead */
+    LD_SCRIPT_UNSUPPORTED
+};
+
+/* upper bound on pool shards, each with its own lock and free list */
+#define LD_REDIS_POOL_SHARDS 8
+/* how long a waiting borrower sleeps before rescanning every shard */
+#define LD_REDIS_POOL_RESCAN 50
+
+struct Connection {
+    redisContext *connection;
+    struct Connection *next;
+    /* the shard this connection counts against */
+    unsigned int shard;
+    unsigned long lastUsed;
+};
+
+struct PoolShard {
+    ld_mutex_t lock;
+    ld_cond_t condition;
+    /* idle connections */
     struct Connection *connections;
+    /* open connections, idle or borrowed */
     unsigned int count;
+    unsigned int capacity;
+    /* new connections are not attempted until then after a failure */
+    unsigned long failedUntil;
+    struct LDRedisPoolStats stats;
+};
+
+/* delay before resubscribing after the subscription is lost, doubles up to
+the maximum */
+#define LD_REDIS_SUBSCRIBE_MIN_BACKOFF 1000
+#define LD_REDIS_SUBSCRIBE_MAX_BACKOFF (30 * 1000)
+
+struct Subscriber {
+    ld_thread_t thread;
+    bool started;
+    /* set before the thread starts */
+    LDStoreInvalidate invalidate;
+    void *store;
     ld_mutex_t lock;
-    struct LDRedisConfig *config;
     ld_cond_t condition;
+    /* following fields guarded by lock */
+    bool stopping;
+    redisContext *connection;
 };
 
-struct Connection {
-    redisContext *connection;
-    struct Connection *next;
+/* a request submitted on the asynchronous connection */
+struct AsyncRequest {
+    /* exactly one completion is set */
+    LDStoreGetCompletion getCompletion;
+    LDStoreAllCompletion allCompletion;
+    LDStoreCompletion completion;
+    void *completionData;
+    /* reply type a write expects */
+    int expectedReply;
+    bool success;
+    struct LDStoreCollectionItem item;
+    struct LDStoreCollectionItem *items;
+    unsigned int itemCount;
+    /* EVAL sent if EVALSHA is answered with NOSCRIPT, from hiredis */
+    char *fallback;
+    size_t fallbackLength;
+    /* copy of an upsert, completed with WATCH / MULTI by runCompletions if
+    the server rejects scripting */
+    struct Context *context;
+    bool watched;
+    char *kind;
+    char *featureKey;
+    struct LDStoreCollectionItem feature;
+    struct AsyncRequest *next;
+};
+
+struct AsyncClient {
+    ld_thread_t thread;
+    bool started;
+    /* the event loop polls the read end, written when there is output */
+    int wake[2];
+    ld_mutex_t lock;
+    /* following fields guarded by lock, hiredis calls are made under it */
+    bool stopping;
+    redisAsyncContext *connection;
+    bool reading;
+    bool writing;
+    unsigned int outstanding;
+    /* last submission to an idle connection or reply received */
+    unsigned long lastProgress;
+    /* replied requests, completed outside of the lock */
+    struct AsyncRequest *finished;
+};
+
+struct Context {
+    struct PoolShard *shards;
+    unsigned int shardCount;
+    struct Subscriber subscriber;
+    struct AsyncClient async;
+    ld_mutex_t lock;
+    struct LDRedisConfig *config;
+    /* SHA1 of upsertScript in hex, set on creation */
+    char upsertScriptDigest[41];
+    /* following fields guarded by lock */
+    enum ScriptState upsertScriptState;
+    char upsertScriptSHA[41];
 };
 
+static struct timeval
+millisecondsToTimeval(const unsigned int milliseconds)
+{
+    struct timeval result;
+
+    result.tv_sec  = milliseconds / 1000;
+    result.tv_usec = (milliseconds % 1000) * 1000;
+
+    return result;
+}
+
+static redisContext *
+openConnection(const struct LDRedisConfig *const config,
+    const unsigned int commandTimeout)
+{
+    redisContext *connection;
+
+    LD_ASSERT(config);
+
+    if (config->connectTimeout) {
+        connection = redisConnectWithTimeout(LDRedisConfigGetHost(config),
+            config->port, millisecondsToTimeval(config->connectTimeout));
+    } else {
+        connection = redisConnect(LDRedisConfigGetHost(config), config->port);
+    }
+
+    if (!connection) {
+        LD_LOG(LD_LOG_ERROR, "failed to create redis connection");
+
+        return NULL;
+    }
+
+    if (connection->err) {
+        char msg[256];
+
+        LD_ASSERT(snprintf(msg, sizeof(msg),
+            "redis connection had error: %s", connection->errstr) >= 0);
+
+        LD_LOG(LD_LOG_ERROR, msg);
+
+        redisFree(connection);
+
+        return NULL;
+    }
+
+    /* a stalled server fails the command instead of blocking the caller */
+    if (commandTimeout && redisSetTimeout(connection,
+        millisecondsToTimeval(commandTimeout)) != REDIS_OK)
+    {
+        LD_LOG(LD_LOG_WARNING, "failed to set redis command timeout");
+    }
+
+    if (redisEnableKeepAlive(connection) != REDIS_OK) {
+        LD_LOG(LD_LOG_WARNING, "failed to enable redis keepalive");
+    }
+
+    return connection;
+}
+
+/* detects connections the server or network dropped while idle */
+static bool
+pingConnection(struct Connection *const connection)
+{
+    redisReply *reply;
+    bool healthy;
+
+    LD_ASSERT(connection);
+
+    reply   = redisCommand(connection->connection, "PING");
+    healthy = reply && reply->type == REDIS_REPLY_STATUS &&
+        strcmp(reply->str, "PONG") == 0;
+
+    freeReplyObject(reply);
+
+    return healthy;
+}
+
+/* Takes an idle connection from the shard or reserves capacity to open a
+new one. Returns false when the shard has neither. */
+static bool
+checkoutShard(struct Context *const context, const unsigned int shardIndex,
+    const unsigned long now, struct Connection **const idle)
+{
+    struct PoolShard *shard;
+    bool available;
+
+    LD_ASSERT(context);
+    LD_ASSERT(idle);
+
+    shard     = &context->shards[shardIndex];
+    *idle     = NULL;
+    available = true;
+
+    LD_ASSERT(LDi_mtxlock(&shard->lock));
+    if (shard->connections) {
+        *idle = shard->connections;
+
+        LL_DELETE(shard->connections, shard->connections);
+    } else if (shard->count < shard->capacity && now >= shard->failedUntil) {
+        shard->count++; /* pre increment before attempt */
+    } else {
+        available = false;
+    }
+    LD_ASSERT(LDi_mtxunlock(&shard->lock));
+
+    return available;
+}
+
+/* prepares a checked out slot for use, returns NULL and releases the slot
+if no healthy connection could be made */
 static struct Connection *
-borrowConnection(struct Context *const context)
+prepareConnection(struct Context *const context,
+    const unsigned int shardIndex, struct Connection *connection,
+    const unsigned long now)
 {
-    struct Connection *connection;
+    struct PoolShard *shard;
+    bool healthCheckFailed, connected;
 
     LD_ASSERT(context);
 
-    connection = NULL;
+    shard             = &context->shards[shardIndex];
+    healthCheckFailed = false;
+    connected         = false;
 
-    LD_ASSERT(LDi_mtxlock(&context->lock));
-    while (!connection) {
-        if (context->connections) {
-            LD_LOG(LD_LOG_TRACE, "using existing redis connection");
+    if (connection && context->config->healthCheckInterval &&
+        now - connection->lastUsed >= context->config->healthCheckInterval)
+    {
+        if (!pingConnection(connection)) {
+            LD_LOG(LD_LOG_WARNING, "idle redis connection failed health check");
+
+            redisFree(connection->connection);
+            connection->connection = NULL;
 
-            connection = context->connections;
+            healthCheckFailed = true;
+        }
+    }
 
-            LL_DELETE(context->connections, context->connections);
+    if (!connection) {
+        LD_LOG(LD_LOG_TRACE, "opening new redis connection");
 
-            LD_ASSERT(LDi_mtxunlock(&context->lock));
+        if (!(connection = LDAlloc(sizeof(struct Connection)))) {
+            LD_LOG(LD_LOG_ERROR, "failed to allocate connection pool item");
         } else {
-            if (context->count < context->config->poolSize) {
-                LD_LOG(LD_LOG_TRACE, "opening new redis connection");
+            connection->next       = NULL;
+            connection->connection = NULL;
+            connection->shard      = shardIndex;
+            connection->lastUsed   = now;
+        }
+    }
 
-                context->count++; /* pre increment before attempt */
+    if (connection && !connection->connection) {
+        if ((connection->connection = openConnection(context->config,
+            context->config->commandTimeout)))
+        {
+            connected = true;
+        }
+    }
 
-                LD_ASSERT(LDi_mtxunlock(&context->lock));
+    LD_ASSERT(LDi_mtxlock(&shard->lock));
+    shard->stats.checkouts++;
 
-                if (!(connection = LDAlloc(sizeof(struct Connection)))) {
-                    LD_LOG(LD_LOG_ERROR,
-                        "failed to allocate connection pool item");
+    if (healthCheckFailed) {
+        shard->stats.healthCheckFailures++;
+    }
 
-                    goto error;
-                }
+    if (connected) {
+        shard->stats.connects++;
+    }
 
-                connection->next       = NULL;
-                connection->connection = NULL;
+    if (!connection || !connection->connection) {
+        shard->stats.failedConnects++;
+        shard->count--;
+        /* let the other borrowers fail fast while the server is down */
+        shard->failedUntil = now + context->config->connectTimeout;
 
-                if (!(connection->connection =
-                    redisConnect(LDRedisConfigGetHost(context->config),
-                    context->config->port)))
-                {
-                    LD_LOG(LD_LOG_ERROR, "failed to create redis connection");
+        LD_ASSERT(LDi_mtxunlock(&shard->lock));
 
-                    goto error;
-                }
+        LDFree(connection);
 
-                if (connection->connection->err) {
-                    LD_LOG(LD_LOG_ERROR, "redis connection had error");
+        /* a freed slot may be usable by a waiter elsewhere */
+        LDi_condsignal(&shard->condition);
 
-                    goto error;
-                }
-            } else {
-                LD_LOG(LD_LOG_TRACE, "waiting on free connection");
+        return NULL;
+    }
+    LD_ASSERT(LDi_mtxunlock(&shard->lock));
+
+    return connection;
+}
 
-                LDi_condwait(&context->condition, &context->lock, 1000 * 10);
+static struct Connection *
+borrowConnection(struct Context *const context)
+{
+    unsigned long start, now;
+    unsigned int first, i;
+    bool waited;
+    int stackMarker;
+
+    LD_ASSERT(context);
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&start));
+
+    /* Threads have distinct stacks, so the address of a local spreads them
+    across shards without any shared state. */
+    first  = ((size_t)&stackMarker >> 12) % context->shardCount;
+    waited = false;
+    now    = start;
+
+    while (true) {
+        for (i = 0; i < context->shardCount; i++) {
+            const unsigned int shardIndex = (first + i) % context->shardCount;
+            struct Connection *connection;
+
+            if (!checkoutShard(context, shardIndex, now, &connection)) {
+                continue;
+            }
+
+            if (!(connection =
+                prepareConnection(context, shardIndex, connection, now)))
+            {
+                continue;
+            }
+
+            if (waited) {
+                struct PoolShard *const shard = &context->shards[shardIndex];
+
+                LD_ASSERT(LDi_mtxlock(&shard->lock));
+                shard->stats.waits++;
+                shard->stats.waitMilliseconds += now - start;
+                LD_ASSERT(LDi_mtxunlock(&shard->lock));
             }
+
+            return connection;
         }
-    }
 
-    return connection;
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&now));
 
-  error:
-    LD_ASSERT(LDi_mtxlock(&context->lock));
-    context->count--;
-    LD_ASSERT(LDi_mtxunlock(&context->lock));
+        if (now - start >= context->config->poolWaitTimeout) {
+            struct PoolShard *const shard = &context->shards[first];
 
-    if (connection) {
-        if (connection->connection) {
-            redisFree(connection->connection);
+            LD_LOG(LD_LOG_ERROR, "timed out waiting on redis connection");
+
+            LD_ASSERT(LDi_mtxlock(&shard->lock));
+            shard->stats.timeouts++;
+            shard->stats.waitMilliseconds += now - start;
+            LD_ASSERT(LDi_mtxunlock(&shard->lock));
+
+            return NULL;
         }
 
-        LDFree(connection);
-    }
+        LD_LOG(LD_LOG_TRACE, "waiting on free connection");
 
-    return NULL;
+        waited = true;
+
+        {
+            struct PoolShard *const shard = &context->shards[first];
+            unsigned long remaining;
+
+            remaining = context->config->poolWaitTimeout - (now - start);
+
+            if (remaining > LD_REDIS_POOL_RESCAN) {
+                remaining = LD_REDIS_POOL_RESCAN;
+            }
+
+            LD_ASSERT(LDi_mtxlock(&shard->lock));
+            if (!shard->connections) {
+                LDi_condwait(&shard->condition, &shard->lock, remaining);
+            }
+            LD_ASSERT(LDi_mtxunlock(&shard->lock));
+        }
+
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&now));
+    }
 }
 
+/* a connection in error, or whose context was freed and set to NULL, is
+closed instead of being pooled */
 static void
 returnConnection(struct Context *const context,
     struct Connection *const connection)
 {
+    struct PoolShard *shard;
+
     LD_ASSERT(context);
 
     if (!connection) {
         return;
     }
 
-    LD_ASSERT(LDi_mtxlock(&context->lock));
+    LD_ASSERT(connection->shard < context->shardCount);
+
+    shard = &context->shards[connection->shard];
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&connection->lastUsed));
+
+    LD_ASSERT(LDi_mtxlock(&shard->lock));
 
-    if (connection->connection->err == 0) {
+    if (connection->connection && connection->connection->err == 0) {
         LD_LOG(LD_LOG_TRACE, "returning redis connection");
 
-        LL_PREPEND(context->connections, connection);
+        LL_PREPEND(shard->connections, connection);
     } else {
         LD_LOG(LD_LOG_TRACE, "deleting failed redis context");
 
-        redisFree(connection->connection);
+        if (connection->connection) {
+            redisFree(connection->connection);
+        }
 
-        context->count--;
+        shard->count--;
+        shard->stats.discarded++;
 
         LDFree(connection);
     }
 
-    LD_ASSERT(LDi_mtxunlock(&context->lock));
+    LD_ASSERT(LDi_mtxunlock(&shard->lock));
+
+    LDi_condsignal(&shard->condition);
+}
+
+void
+LDRedisGetPoolStats(struct LDStoreInterface *const store,
+    struct LDRedisPoolStats *const stats)
+{
+    struct Context *context;
+    unsigned int i;
 
-    LDi_condsignal(&context->condition);
+    LD_ASSERT(store);
+    LD_ASSERT(store->context);
+    LD_ASSERT(stats);
+
+    context = (struct Context *)store->context;
+
+    memset(stats, 0, sizeof(struct LDRedisPoolStats));
+
+    for (i = 0; i < context->shardCount; i++) {
+        struct PoolShard *const shard = &context->shards[i];
+
+        LD_ASSERT(LDi_mtxlock(&shard->lock));
+        stats->checkouts           += shard->stats.checkouts;
+        stats->waits               += shard->stats.waits;
+        stats->waitMilliseconds    += shard->stats.waitMilliseconds;
+        stats->timeouts            += shard->stats.timeouts;
+        stats->connects            += shard->stats.connects;
+        stats->failedConnects      += shard->stats.failedConnects;
+        stats->discarded           += shard->stats.discarded;
+        stats->healthCheckFailures += shard->stats.healthCheckFailures;
+        LD_ASSERT(LDi_mtxunlock(&shard->lock));
+    }
 }
 
 static bool
@@ -295,103 +756,474 @@ resetReply(redisReply **const reply)
     *reply = NULL;
 }
 
+/* Writes the channel writes are published on, or an empty string when
+LD_REDIS_INVALIDATION_CHANNEL is not in use */
 static bool
-storeInit(void *const contextRaw,
-    const struct LDStoreCollectionState *collections,
-    const unsigned int collectionCount)
+invalidationChannel(const struct Context *const context, char *const buffer,
+    const size_t bufferSize)
 {
-    struct Context *context;
-    redisReply *reply;
-    struct Connection *connection;
-    bool success;
-    unsigned int x;
+    LD_ASSERT(context);
+    LD_ASSERT(buffer);
+    LD_ASSERT(bufferSize);
 
-    LD_LOG(LD_LOG_TRACE, "redis storeInit");
+    if (context->config->invalidation != LD_REDIS_INVALIDATION_CHANNEL) {
+        buffer[0] = 0;
 
-    LD_ASSERT(contextRaw);
-    LD_ASSERT(collections || collectionCount == 0);
+        return true;
+    }
 
-    connection = NULL;
-    context    = (struct Context *)contextRaw;
-    reply      = NULL;
-    success    = false;
+    if (snprintf(buffer, bufferSize, "%s:%s",
+        LDRedisConfigGetPrefix(context->config), invalidateKey) < 0)
+    {
+        LD_LOG(LD_LOG_ERROR, "snprintf invalidation channel failed");
 
-    if (!(connection = borrowConnection(context))) {
-        goto cleanup;
+        return false;
     }
 
-    reply = redisCommand(connection->connection, "MULTI");
+    return true;
+}
 
-    if (!redisCheckStatus(reply, "OK")) {
-        goto cleanup;
-    }
+/* upper bound on field / value pairs sent in a single HMSET */
+#define LD_REDIS_INIT_BATCH 1000
 
-    resetReply(&reply);
+/* Commands written without waiting for their replies, either to a pooled
+connection or to the asynchronous connection. Replies to asynchronous
+pipeline commands are discarded, the caller only checks the last one. */
+struct Pipeline {
+    redisContext *connection;
+    redisAsyncContext *asyncConnection;
+    /* replies owed on a pooled connection */
+    unsigned int pending;
+};
 
-    for (x = 0; x < collectionCount; x++) {
-        const struct LDStoreCollectionState *collection;
-        unsigned int y;
+static bool
+appendArgv(struct Pipeline *const pipeline, const int argc,
+    const char **const argv, const size_t *const argvlen)
+{
+    int status;
 
-        collection = &(collections[x]);
+    LD_ASSERT(pipeline);
+    LD_ASSERT(argv);
+    LD_ASSERT(argvlen);
 
-        reply = redisCommand(connection->connection, "DEL %s:%s",
-            LDRedisConfigGetPrefix(context->config), collection->kind);
+    if (pipeline->asyncConnection) {
+        status = redisAsyncCommandArgv(pipeline->asyncConnection, NULL, NULL,
+            argc, argv, argvlen);
+    } else {
+        status = redisAppendCommandArgv(pipeline->connection, argc, argv,
+            argvlen);
+    }
 
-        if (!redisCheckStatus(reply, "QUEUED")) {
-            goto cleanup;
-        }
+    if (status != REDIS_OK) {
+        LD_LOG(LD_LOG_ERROR, "redisAppendCommandArgv failed");
 
-        resetReply(&reply);
+        return false;
+    }
+
+    pipeline->pending++;
+
+    return true;
+}
+
+static bool
+appendCommand(struct Pipeline *const pipeline, const char *const format, ...)
+{
+    va_list args;
+    int status;
 
-        for (y = 0; y < collection->itemCount; y++) {
-            struct LDStoreCollectionStateItem *item;
+    LD_ASSERT(pipeline);
+    LD_ASSERT(format);
 
-            item = &(collection->items[y]);
+    va_start(args, format);
 
-            reply = redisCommand(connection->connection, "HSET %s:%s %s %s",
-                LDRedisConfigGetPrefix(context->config), collection->kind,
-                item->key, item->item.buffer);
+    if (pipeline->asyncConnection) {
+        status = redisvAsyncCommand(pipeline->asyncConnection, NULL, NULL,
+            format, args);
+    } else {
+        status = redisvAppendCommand(pipeline->connection, format, args);
+    }
 
-            if (!redisCheckStatus(reply, "QUEUED")) {
+    va_end(args);
+
+    if (status != REDIS_OK) {
+        LD_LOG(LD_LOG_ERROR, "redisAppendCommand failed");
+
+        return false;
+    }
+
+    pipeline->pending++;
+
+    return true;
+}
+
+/* appends HMSET commands for a collection in bounded batches */
+static bool
+appendCollection(struct Pipeline *const pipeline,
+    const char *const collectionKey,
+    const struct LDStoreCollectionState *const collection)
+{
+    const char **argv;
+    size_t *argvlen;
+    unsigned int y, argc, capacity;
+    bool success;
+
+    LD_ASSERT(pipeline);
+    LD_ASSERT(collectionKey);
+    LD_ASSERT(collection);
+
+    argv     = NULL;
+    argvlen  = NULL;
+    success  = false;
+    capacity = 2 + 2 * LD_REDIS_INIT_BATCH;
+
+    if (!(argv = (const char **)LDAlloc(sizeof(char *) * capacity))) {
+        goto cleanup;
+    }
+
+    if (!(argvlen = (size_t *)LDAlloc(sizeof(size_t) * capacity))) {
+        goto cleanup;
+    }
+
+    argv[0]    = "HMSET";
+    argvlen[0] = 5;
+    argv[1]    = collectionKey;
+    argvlen[1] = strlen(collectionKey);
+    argc       = 2;
+
+    for (y = 0; y < collection->itemCount; y++) {
+        const struct LDStoreCollectionStateItem *const item =
+            &(collection->items[y]);
+
+        /* LDStoreInit leaves the slots of invalid features empty */
+        if (item->key && item->item.buffer) {
+            argv[argc]    = item->key;
+            argvlen[argc] = strlen(item->key);
+            argc++;
+
+            argv[argc]    = item->item.buffer;
+            argvlen[argc] = item->item.bufferSize;
+            argc++;
+        }
+
+        /* HMSET requires at least one field */
+        if (argc > 2 && (argc == capacity || y + 1 == collection->itemCount)) {
+            if (!appendArgv(pipeline, argc, argv, argvlen)) {
                 goto cleanup;
             }
 
-            resetReply(&reply);
+            argc = 2;
+        }
+    }
+
+    success = true;
+
+  cleanup:
+    LDFree(argv);
+    LDFree(argvlen);
+
+    return success;
+}
+
+/* Appends the transaction replacing every collection, up to but not
+including EXEC. */
+static bool
+appendInit(struct Context *const context, struct Pipeline *const pipeline,
+    const struct LDStoreCollectionState *collections,
+    const unsigned int collectionCount)
+{
+    unsigned int x;
+    char channel[256];
+
+    LD_ASSERT(context);
+    LD_ASSERT(pipeline);
+    LD_ASSERT(collections || collectionCount == 0);
+
+    if (!invalidationChannel(context, channel, sizeof(channel))) {
+        return false;
+    }
+
+    if (!appendCommand(pipeline, "MULTI")) {
+        return false;
+    }
+
+    for (x = 0; x < collectionCount; x++) {
+        const struct LDStoreCollectionState *collection;
+        char collectionKey[256];
+
+        collection = &(collections[x]);
+
+        if (snprintf(collectionKey, sizeof(collectionKey), "%s:%s",
+            LDRedisConfigGetPrefix(context->config), collection->kind) < 0)
+        {
+            LD_LOG(LD_LOG_ERROR, "snprintf collection key failed");
+
+            return false;
+        }
+
+        if (!appendCommand(pipeline, "DEL %s", collectionKey)) {
+            return false;
+        }
+
+        if (!appendCollection(pipeline, collectionKey, collection)) {
+            return false;
+        }
+
+    }
+
+    if (!appendCommand(pipeline, "SET %s:%s %s",
+        LDRedisConfigGetPrefix(context->config), initedKey, ""))
+    {
+        return false;
+    }
+
+    /* every item may have changed */
+    if (channel[0]) {
+        if (!appendCommand(pipeline, "PUBLISH %s %s", channel, "*")) {
+            return false;
         }
     }
 
-    reply = redisCommand(connection->connection, "SET %s:%s %s",
-        LDRedisConfigGetPrefix(context->config), initedKey, "");
+    return true;
+}
+
+static bool
+storeInit(void *const contextRaw,
+    const struct LDStoreCollectionState *collections,
+    const unsigned int collectionCount)
+{
+    struct Context *context;
+    redisReply *reply;
+    struct Connection *connection;
+    struct Pipeline pipeline;
+    bool success;
+    unsigned int x;
+
+    LD_LOG(LD_LOG_TRACE, "redis storeInit");
+
+    LD_ASSERT(contextRaw);
+    LD_ASSERT(collections || collectionCount == 0);
+
+    connection = NULL;
+    context    = (struct Context *)contextRaw;
+    reply      = NULL;
+    success    = false;
+
+    memset(&pipeline, 0, sizeof(struct Pipeline));
 
-    if (!redisCheckStatus(reply, "QUEUED")) {
+    if (!(connection = borrowConnection(context))) {
         goto cleanup;
     }
 
-    resetReply(&reply);
+    pipeline.connection = connection->connection;
 
-    reply = redisCommand(connection->connection, "EXEC");
+    /* The whole transaction is written in one pipeline and the replies are
+    drained afterwards, so the cost is a single round trip regardless of the
+    number of items. */
+    if (!appendInit(context, &pipeline, collections, collectionCount)) {
+        goto cleanup;
+    }
 
-    if (!redisCheckReply(reply, REDIS_REPLY_ARRAY)) {
+    if (!appendCommand(&pipeline, "EXEC")) {
         goto cleanup;
     }
 
+    /* MULTI, every queued command, then EXEC */
     success = true;
 
+    for (x = 0; x < pipeline.pending; x++) {
+        if (redisGetReply(connection->connection, (void **)&reply)
+            != REDIS_OK)
+        {
+            LD_LOG(LD_LOG_ERROR, "redisGetReply failed");
+
+            success = false;
+
+            /* the connection is marked as failed and will be discarded */
+            break;
+        }
+
+        if (x == 0) {
+            success = success && redisCheckStatus(reply, "OK");
+        } else if (x + 1 < pipeline.pending) {
+            success = success && redisCheckStatus(reply, "QUEUED");
+        } else {
+            success = success && redisCheckReply(reply, REDIS_REPLY_ARRAY);
+        }
+
+        resetReply(&reply);
+    }
+
+    pipeline.pending = 0;
+
   cleanup:
     resetReply(&reply);
 
+    /* replies still buffered would desynchronize the pooled connection */
+    if (connection && pipeline.pending) {
+        redisFree(connection->connection);
+        connection->connection = NULL;
+    }
+
     returnConnection(context, connection);
 
     return success;
 }
 
+/* Hands the reply string over to the store, which releases it with LDFree.
+When both libraries free with the system allocator the buffer is taken from
+the reply instead of being copied. */
+static char *
+takeReplyString(redisReply *const reply)
+{
+    bool systemFree;
+    char *result;
+
+    LD_ASSERT(reply);
+    LD_ASSERT(reply->str);
+
+    systemFree = LDi_usingSystemFree();
+
+    #if defined(HIREDIS_MAJOR) && HIREDIS_MAJOR >= 1
+        systemFree = systemFree && hiredisAllocFns.freeFn == free;
+    #endif
+
+    if (systemFree) {
+        result     = reply->str;
+        reply->str = NULL;
+        reply->len = 0;
+
+        return result;
+    }
+
+    return LDStrNDup(reply->str, reply->len);
+}
+
+/* reads the reply to HGET, a missing item has a NULL buffer */
+static bool
+readItem(redisReply *const reply, struct LDStoreCollectionItem *const result)
+{
+    bool deleted;
+
+    LD_ASSERT(result);
+
+    if (reply && reply->type == REDIS_REPLY_NIL) {
+        result->buffer     = NULL;
+        result->bufferSize = 0;
+        result->version    = 0;
+
+        return true;
+    } else if (!redisCheckReply(reply, REDIS_REPLY_STRING)) {
+        return false;
+    }
+
+    /* the store parses and validates the item, only the version is needed */
+    if (!LDi_scanFeatureVersion(reply->str, &result->version, &deleted)) {
+        LD_LOG(LD_LOG_ERROR, "redis item is not valid JSON");
+
+        return false;
+    }
+
+    result->bufferSize = reply->len;
+
+    return (result->buffer = takeReplyString(reply)) != NULL;
+}
+
+/* reads the reply to HGETALL */
+static bool
+readCollection(redisReply *const reply,
+    struct LDStoreCollectionItem **const result,
+    unsigned int *const resultCount)
+{
+    bool success;
+    unsigned int i, count;
+    struct LDStoreCollectionItem *collection, *collectionIter;
+    size_t resultBytes;
+
+    LD_ASSERT(result);
+    LD_ASSERT(resultCount);
+
+    success      = false;
+    *result      = NULL;
+    *resultCount = 0;
+    collection   = NULL;
+    count        = 0;
+
+    if (reply && reply->type == REDIS_REPLY_NIL) {
+        return true;
+    }
+
+    if (!redisCheckReply(reply, REDIS_REPLY_ARRAY)) {
+        return false;
+    }
+
+    count       = reply->elements / 2;
+    resultBytes = sizeof(struct LDStoreCollectionItem) * count;
+
+    if (!(collection = (struct LDStoreCollectionItem *)LDAlloc(resultBytes))) {
+        LD_LOG(LD_LOG_ERROR, "LDAlloc failed");
+
+        goto cleanup;
+    }
+
+    memset(collection, 0, resultBytes);
+
+    collectionIter = collection;
+
+    for (i = 0; i < reply->elements; i++) {
+        redisReply *element;
+        bool deleted;
+        /* skip name field */
+        i++;
+
+        element = reply->element[i];
+
+        if (!redisCheckReply(element, REDIS_REPLY_STRING)) {
+            LD_LOG(LD_LOG_ERROR, "not a string");
+
+            goto cleanup;
+        }
+
+        LD_ASSERT(element->str);
+
+        /* parsed once by the store, only the version is read here */
+        if (!LDi_scanFeatureVersion(element->str, &collectionIter->version,
+            &deleted))
+        {
+            LD_LOG(LD_LOG_ERROR, "redis item is not valid JSON");
+
+            goto cleanup;
+        }
+
+        collectionIter->bufferSize = element->len;
+
+        if (!(collectionIter->buffer = takeReplyString(element))) {
+            goto cleanup;
+        }
+
+        collectionIter++;
+    }
+
+    *result      = collection;
+    *resultCount = count;
+    success      = true;
+
+  cleanup:
+    if (!success && collection) {
+        for (i = 0; i < count; i++) {
+            LDFree(collection[i].buffer);
+        }
+        LDFree(collection);
+    }
+
+    return success;
+}
+
 static bool
 storeGet(void *const contextRaw, const char *const kind,
     const char *const key, struct LDStoreCollectionItem *const result)
 {
     struct Context *context;
     struct Connection *connection;
-    struct LDJSON *feature;
     redisReply *reply;
     bool success;
 
@@ -404,7 +1236,6 @@ storeGet(void *const contextRaw, const char *const kind,
 
     context    = (struct Context *)contextRaw;
     connection = NULL;
-    feature    = NULL;
     reply      = NULL;
     success    = false;
 
@@ -415,35 +1246,9 @@ storeGet(void *const contextRaw, const char *const kind,
     reply = redisCommand(connection->connection, "HGET %s:%s %s",
         LDRedisConfigGetPrefix(context->config), kind, key);
 
-    if (!reply) {
-        goto cleanup;
-    } else if (reply->type == REDIS_REPLY_NIL) {
-        result->buffer = NULL;
-
-        success = true;
-
-        goto cleanup;
-    } else if (!redisCheckReply(reply, REDIS_REPLY_STRING)) {
-        goto cleanup;
-    } else if (!(feature = LDJSONDeserialize(reply->str))) {
-        goto cleanup;
-    } else if (!(result->buffer = LDStrDup(reply->str))) {
-        goto cleanup;
-    }
-
-    if (result->buffer) {
-        result->bufferSize = strlen(reply->str);
-        result->version    = LDi_getFeatureVersion(feature);
-    } else {
-        result->bufferSize = 0;
-        result->version    = 0;
-    }
-
-    success = true;
+    success = readItem(reply, result);
 
   cleanup:
-    LDJSONFree(feature);
-
     resetReply(&reply);
 
     returnConnection(context, connection);
@@ -460,25 +1265,19 @@ storeAll(void *const contextRaw, const char *const kind,
     redisReply *reply;
     struct Connection *connection;
     bool success;
-    unsigned int i;
-    struct LDStoreCollectionItem *collection, *collectionIter;
-    size_t resultBytes;
-    struct LDJSON *feature;
 
     LD_LOG(LD_LOG_TRACE, "redis storeAll");
 
     LD_ASSERT(contextRaw);
     LD_ASSERT(kind);
     LD_ASSERT(result);
+    LD_ASSERT(resultCount);
 
     context      = (struct Context *)contextRaw;
     reply        = NULL;
     success      = false;
     *result      = NULL;
     *resultCount = 0;
-    collection   = NULL;
-    resultBytes  = 0;
-    feature      = NULL;
 
     if (!(connection = borrowConnection(context))) {
         goto cleanup;
@@ -487,280 +1286,1606 @@ storeAll(void *const contextRaw, const char *const kind,
     reply = redisCommand(connection->connection, "HGETALL %s:%s",
         LDRedisConfigGetPrefix(context->config), kind);
 
-    if (reply->type == REDIS_REPLY_NIL) {
-        success = true;
+    success = readCollection(reply, result, resultCount);
 
-        goto cleanup;
-    }
-
-    if (!redisCheckReply(reply, REDIS_REPLY_ARRAY)) {
-        goto cleanup;
-    }
+  cleanup:
+    resetReply(&reply);
+    returnConnection(context, connection);
 
-    *resultCount = reply->elements / 2;
-    resultBytes = sizeof(struct LDStoreCollectionItem) * (*resultCount);
+    return success;
+}
 
-    if (!(collection = (struct LDStoreCollectionItem *)LDAlloc(resultBytes))) {
+/* serialized placeholder written in place of a deleted item */
+static char *
+serializeDeleted(const struct LDStoreCollectionItem *const feature,
+    const char *const featureKey)
+{
+    struct LDJSON *placeholder;
+    char *serialized;
+
+    LD_ASSERT(feature);
+    LD_ASSERT(featureKey);
+
+    if (!(placeholder = LDi_makeDeleted(featureKey, feature->version))) {
+        return NULL;
+    }
+
+    serialized = LDJSONSerialize(placeholder);
+
+    LDJSONFree(placeholder);
+
+    return serialized;
+}
+
+enum ScriptResult {
+    LD_SCRIPT_RESULT_OK,
+    LD_SCRIPT_RESULT_ERROR,
+    /* the caller should use the WATCH / MULTI path */
+    LD_SCRIPT_RESULT_FALLBACK
+};
+
+/* True for errors meaning the server will never run the script, such as
+SCRIPT being renamed away, scripting being disabled by a hosting provider, or
+an ACL denying it. Others, for example LOADING, BUSY, NOAUTH, or READONLY, may
+pass. */
+static bool
+scriptingRejected(const redisReply *const reply)
+{
+    LD_ASSERT(reply);
+
+    return reply->type == REDIS_REPLY_ERROR && reply->str && (
+        strncmp(reply->str, "ERR unknown command", 19) == 0 ||
+        strncmp(reply->str, "ERR unknown subcommand", 22) == 0 ||
+        strncmp(reply->str, "NOSCRIPT", 8) == 0 ||
+        strncmp(reply->str, "NOPERM", 6) == 0);
+}
+
+static void
+markScriptingUnsupported(struct Context *const context)
+{
+    LD_ASSERT(context);
+
+    LD_LOG(LD_LOG_WARNING,
+        "redis scripting unavailable, using optimistic transactions");
+
+    LD_ASSERT(LDi_mtxlock(&context->lock));
+    context->upsertScriptState = LD_SCRIPT_UNSUPPORTED;
+    LD_ASSERT(LDi_mtxunlock(&context->lock));
+}
+
+/* makes sure the script is cached on the server, returns
+LD_SCRIPT_RESULT_FALLBACK if scripting is unavailable */
+static enum ScriptResult
+loadUpsertScript(struct Context *const context,
+    struct Connection *const connection, char *const sha)
+{
+    redisReply *reply;
+    enum ScriptState state;
+
+    LD_ASSERT(context);
+    LD_ASSERT(connection);
+    LD_ASSERT(sha);
+
+    LD_ASSERT(LDi_mtxlock(&context->lock));
+    state = context->upsertScriptState;
+    if (state == LD_SCRIPT_LOADED) {
+        memcpy(sha, context->upsertScriptSHA, 41);
+    }
+    LD_ASSERT(LDi_mtxunlock(&context->lock));
+
+    if (state == LD_SCRIPT_LOADED) {
+        return LD_SCRIPT_RESULT_OK;
+    } else if (state == LD_SCRIPT_UNSUPPORTED) {
+        return LD_SCRIPT_RESULT_FALLBACK;
+    }
+
+    reply = redisCommand(connection->connection, "SCRIPT LOAD %s",
+        upsertScript);
+
+    if (!reply) {
+        return LD_SCRIPT_RESULT_ERROR;
+    }
+
+    if (scriptingRejected(reply)) {
+        markScriptingUnsupported(context);
+
+        resetReply(&reply);
+
+        return LD_SCRIPT_RESULT_FALLBACK;
+    }
+
+    if (reply->type != REDIS_REPLY_STRING || reply->len != 40) {
+        /* the state stays unknown, so a later upsert tries again */
+        if (reply->type == REDIS_REPLY_ERROR && reply->str) {
+            char msg[256];
+
+            if (snprintf(msg, sizeof(msg), "redis SCRIPT LOAD failed: %s",
+                reply->str) >= 0)
+            {
+                LD_LOG(LD_LOG_WARNING, msg);
+            }
+        } else {
+            LD_LOG(LD_LOG_WARNING, "redis SCRIPT LOAD unexpected reply");
+        }
+
+        resetReply(&reply);
+
+        return LD_SCRIPT_RESULT_ERROR;
+    }
+
+    memcpy(sha, reply->str, 40);
+    sha[40] = 0;
+
+    LD_ASSERT(LDi_mtxlock(&context->lock));
+    memcpy(context->upsertScriptSHA, sha, 41);
+    context->upsertScriptState = LD_SCRIPT_LOADED;
+    LD_ASSERT(LDi_mtxunlock(&context->lock));
+
+    resetReply(&reply);
+
+    return LD_SCRIPT_RESULT_OK;
+}
+
+/* forgets the cached digest, for example after SCRIPT FLUSH on the server */
+static void
+unloadUpsertScript(struct Context *const context)
+{
+    LD_ASSERT(context);
+
+    LD_ASSERT(LDi_mtxlock(&context->lock));
+    if (context->upsertScriptState == LD_SCRIPT_LOADED) {
+        context->upsertScriptState = LD_SCRIPT_UNKNOWN;
+    }
+    LD_ASSERT(LDi_mtxunlock(&context->lock));
+}
+
+static enum ScriptResult
+upsertScripted(struct Context *const context,
+    struct Connection *const connection, const char *const kind,
+    const struct LDStoreCollectionItem *const feature,
+    const char *const featureKey, const char *const serialized,
+    void (*const hook)())
+{
+    redisReply *reply;
+    char collectionKey[256], version[16], sha[41];
+    char channel[256], message[256];
+    const char *argv[9];
+    size_t argvlen[9];
+    unsigned int attempt;
+    int versionLength;
+    enum ScriptResult loaded;
+
+    LD_ASSERT(context);
+    LD_ASSERT(connection);
+    LD_ASSERT(kind);
+    LD_ASSERT(feature);
+    LD_ASSERT(featureKey);
+    LD_ASSERT(serialized);
+
+    reply = NULL;
+
+    if (snprintf(collectionKey, sizeof(collectionKey), "%s:%s",
+        LDRedisConfigGetPrefix(context->config), kind) < 0)
+    {
+        return LD_SCRIPT_RESULT_ERROR;
+    }
+
+    if ((versionLength = snprintf(version, sizeof(version), "%u",
+        feature->version)) < 0)
+    {
+        return LD_SCRIPT_RESULT_ERROR;
+    }
+
+    if (!invalidationChannel(context, channel, sizeof(channel))) {
+        return LD_SCRIPT_RESULT_ERROR;
+    }
+
+    if (snprintf(message, sizeof(message), "%s:%s", kind, featureKey) < 0) {
+        return LD_SCRIPT_RESULT_ERROR;
+    }
+
+    /* a second attempt covers the script cache being flushed */
+    for (attempt = 0; attempt < 2; attempt++) {
+        if ((loaded = loadUpsertScript(context, connection, sha)) !=
+            LD_SCRIPT_RESULT_OK)
+        {
+            return loaded;
+        }
+
+        if (hook && attempt == 0) {
+            hook();
+        }
+
+        argv[0] = "EVALSHA";          argvlen[0] = 7;
+        argv[1] = sha;                argvlen[1] = 40;
+        argv[2] = "1";                argvlen[2] = 1;
+        argv[3] = collectionKey;      argvlen[3] = strlen(collectionKey);
+        argv[4] = featureKey;         argvlen[4] = strlen(featureKey);
+        argv[5] = version;            argvlen[5] = versionLength;
+        argv[6] = serialized;         argvlen[6] = strlen(serialized);
+        argv[7] = channel;            argvlen[7] = strlen(channel);
+        argv[8] = message;            argvlen[8] = strlen(message);
+
+        reply = redisCommandArgv(connection->connection, 9, argv, argvlen);
+
+        if (!reply) {
+            return LD_SCRIPT_RESULT_ERROR;
+        }
+
+        if (reply->type == REDIS_REPLY_INTEGER) {
+            resetReply(&reply);
+
+            return LD_SCRIPT_RESULT_OK;
+        }
+
+        if (reply->type == REDIS_REPLY_ERROR &&
+            strncmp(reply->str, "NOSCRIPT", 8) == 0)
+        {
+            LD_LOG(LD_LOG_TRACE, "redis upsert script not cached reloading");
+
+            unloadUpsertScript(context);
+
+            resetReply(&reply);
+
+            continue;
+        }
+
+        /* EVALSHA may be disabled even though SCRIPT LOAD is not */
+        if (scriptingRejected(reply)) {
+            markScriptingUnsupported(context);
+
+            resetReply(&reply);
+
+            return LD_SCRIPT_RESULT_FALLBACK;
+        }
+
+        LD_LOG(LD_LOG_ERROR, "redis upsert script failed");
+
+        resetReply(&reply);
+
+        return LD_SCRIPT_RESULT_ERROR;
+    }
+
+    return LD_SCRIPT_RESULT_ERROR;
+}
+
+/* optimistic transaction used when scripting is unavailable */
+static bool
+upsertWatched(struct Context *const context,
+    struct Connection *const connection, const char *const kind,
+    const struct LDStoreCollectionItem *const feature,
+    const char *const featureKey, const char *const serialized,
+    void (*const hook)())
+{
+    redisReply *reply;
+    bool deleted;
+    unsigned int existingVersion;
+    char channel[256];
+
+    LD_ASSERT(context);
+    LD_ASSERT(connection);
+    LD_ASSERT(kind);
+    LD_ASSERT(feature);
+    LD_ASSERT(featureKey);
+    LD_ASSERT(serialized);
+
+    reply = NULL;
+
+    if (!invalidationChannel(context, channel, sizeof(channel))) {
+        return false;
+    }
+
+    while (true) {
+        reply = redisCommand(connection->connection, "WATCH %s:%s",
+            LDRedisConfigGetPrefix(context->config), kind);
+
+        if (!redisCheckStatus(reply, "OK")) {
+            goto error;
+        }
+
+        resetReply(&reply);
+
+        reply = redisCommand(connection->connection, "HGET %s:%s %s",
+            LDRedisConfigGetPrefix(context->config), kind, featureKey);
+
+        if (!reply) {
+            goto error;
+        } else if (reply->type == REDIS_REPLY_NIL) {
+            /* does not exist */
+        } else if (!redisCheckReply(reply, REDIS_REPLY_STRING)) {
+            goto error;
+        } else if (!LDi_scanFeatureVersion(reply->str, &existingVersion,
+            &deleted))
+        {
+            goto error;
+        } else if (existingVersion >= feature->version) {
+            /* deleted placeholders keep their version, as in memory */
+            resetReply(&reply);
+
+            reply = redisCommand(connection->connection, "UNWATCH");
+
+            resetReply(&reply);
+
+            return true;
+        }
+
+        resetReply(&reply);
+
+        if (hook) {
+            hook();
+        }
+
+        reply = redisCommand(connection->connection, "MULTI");
+
+        if (!redisCheckStatus(reply, "OK")) {
+            LD_LOG(LD_LOG_ERROR, "Redis MULTI failed");
+
+            goto error;
+        }
+
+        resetReply(&reply);
+
+        reply = redisCommand(connection->connection, "HSET %s:%s %s %s",
+            LDRedisConfigGetPrefix(context->config), kind, featureKey,
+            serialized);
+
+        if (!redisCheckStatus(reply, "QUEUED")) {
+            LD_LOG(LD_LOG_ERROR, "Redis expected OK");
+
+            goto error;
+        }
+
+        resetReply(&reply);
+
+        if (channel[0]) {
+            reply = redisCommand(connection->connection, "PUBLISH %s %s:%s",
+                channel, kind, featureKey);
+
+            if (!redisCheckStatus(reply, "QUEUED")) {
+                LD_LOG(LD_LOG_ERROR, "Redis expected QUEUED");
+
+                goto error;
+            }
+
+            resetReply(&reply);
+        }
+
+        reply = redisCommand(connection->connection, "EXEC");
+
+        if (reply) {
+            if (reply->type == REDIS_REPLY_ARRAY) {
+                break;
+            } else if (reply->type == REDIS_REPLY_NIL) {
+                LD_LOG(LD_LOG_WARNING, "Redis race detected retrying");
+
+                resetReply(&reply);
+            } else {
+                LD_LOG(LD_LOG_ERROR, "Redis EXEC incorrect type");
+
+                goto error;
+            }
+        } else {
+            LD_LOG(LD_LOG_ERROR, "Redis reply is NULL");
+
+            goto error;
+        }
+    }
+
+    resetReply(&reply);
+
+    return true;
+
+  error:
+    resetReply(&reply);
+
+    return false;
+}
+
+bool
+storeUpsertInternal(void *const contextRaw, const char *const kind,
+    const struct LDStoreCollectionItem *const feature,
+    const char *const featureKey,
+    void (*const hook)())
+{
+    struct Context *context;
+    struct Connection *connection;
+    const char *serialized;
+    char *placeholder;
+    bool success;
+
+    LD_LOG(LD_LOG_TRACE, "redis storeUpsertInternal");
+
+    LD_ASSERT(contextRaw);
+    LD_ASSERT(kind);
+    LD_ASSERT(feature);
+    LD_ASSERT(featureKey);
+
+    context     = (struct Context *)contextRaw;
+    placeholder = NULL;
+    connection  = NULL;
+    success     = false;
+
+    if (feature->buffer) {
+        serialized = (const char *)feature->buffer;
+    } else if ((placeholder = serializeDeleted(feature, featureKey))) {
+        serialized = placeholder;
+    } else {
+        goto cleanup;
+    }
+
+    if (!(connection = borrowConnection(context))) {
+        goto cleanup;
+    }
+
+    switch (upsertScripted(context, connection, kind, feature, featureKey,
+        serialized, hook))
+    {
+        case LD_SCRIPT_RESULT_OK:
+            success = true;
+            break;
+        case LD_SCRIPT_RESULT_FALLBACK:
+            success = upsertWatched(context, connection, kind, feature,
+                featureKey, serialized, hook);
+            break;
+        case LD_SCRIPT_RESULT_ERROR:
+            break;
+    }
+
+  cleanup:
+    LDFree(placeholder);
+
+    returnConnection(context, connection);
+
+    return success;
+}
+
+static bool
+storeUpsert(void *const contextRaw, const char *const kind,
+    const struct LDStoreCollectionItem *const feature,
+    const char *const featureKey)
+{
+    LD_ASSERT(contextRaw);
+    LD_ASSERT(kind);
+    LD_ASSERT(feature);
+    LD_ASSERT(featureKey);
+
+    return storeUpsertInternal(contextRaw, kind, feature, featureKey, NULL);
+}
+
+static bool
+storeInitialized(void *const contextRaw)
+{
+    struct Context *context;
+    redisReply *reply;
+    struct Connection *connection;
+    bool initialized;
+
+    LD_LOG(LD_LOG_TRACE, "redis storeInitialized");
+
+    LD_ASSERT(contextRaw);
+
+    context    = (struct Context *)contextRaw;
+    connection = NULL;
+    reply      = NULL;
+
+    if (!(connection = borrowConnection(context))) {
+        return false;
+    }
+
+    reply = redisCommand(connection->connection, "EXISTS %s:%s",
+        LDRedisConfigGetPrefix(context->config), initedKey);
+
+    initialized = !redisCheckReply(reply, REDIS_REPLY_INTEGER)
+        || reply->integer;
+
+    resetReply(&reply);
+
+    returnConnection(context, connection);
+
+    return initialized;
+}
+
+/* applies a "kind:key", "kind", or "*" message from the channel */
+static void
+applyChannelMessage(struct Subscriber *const subscriber,
+    const char *const message)
+{
+    const char *separator;
+    char kind[64];
+    size_t kindLength;
+
+    LD_ASSERT(subscriber);
+    LD_ASSERT(message);
+
+    if (message[0] == 0 || strcmp(message, "*") == 0) {
+        subscriber->invalidate(subscriber->store, NULL, NULL);
+    } else if (!(separator = strchr(message, ':'))) {
+        subscriber->invalidate(subscriber->store, message, NULL);
+    } else if ((kindLength = separator - message) < sizeof(kind)) {
+        memcpy(kind, message, kindLength);
+        kind[kindLength] = 0;
+
+        subscriber->invalidate(subscriber->store, kind, separator + 1);
+    } else {
+        /* not a kind this SDK uses, dropping everything is safe */
+        subscriber->invalidate(subscriber->store, NULL, NULL);
+    }
+}
+
+/* applies a notification for "__keyspace@<db>__:<prefix>:<kind>" */
+static void
+applyKeyspaceEvent(struct Context *const context, const char *const channel)
+{
+    const char *key, *prefix;
+    size_t prefixLength;
+
+    LD_ASSERT(context);
+    LD_ASSERT(channel);
+
+    if (!(key = strstr(channel, "__:"))) {
+        return;
+    }
+
+    key          = key + 3;
+    prefix       = LDRedisConfigGetPrefix(context->config);
+    prefixLength = strlen(prefix);
+
+    if (strncmp(key, prefix, prefixLength) != 0 || key[prefixLength] != ':') {
+        return;
+    }
+
+    key += prefixLength + 1;
+
+    /* version hashes change together with their kind, $inited never does
+    anything to cached items */
+    if (key[0] == '$' || strchr(key, ':')) {
+        return;
+    }
+
+    context->subscriber.invalidate(context->subscriber.store, key, NULL);
+}
+
+static void
+applyInvalidation(struct Context *const context,
+    const redisReply *const reply)
+{
+    LD_ASSERT(context);
+    LD_ASSERT(reply);
+
+    if (reply->type != REDIS_REPLY_ARRAY || reply->elements < 3 ||
+        reply->element[0]->type != REDIS_REPLY_STRING)
+    {
+        return;
+    }
+
+    if (reply->elements == 3 && strcmp(reply->element[0]->str, "message") == 0
+        && reply->element[2]->type == REDIS_REPLY_STRING)
+    {
+        applyChannelMessage(&context->subscriber, reply->element[2]->str);
+    } else if (reply->elements == 4 &&
+        strcmp(reply->element[0]->str, "pmessage") == 0 &&
+        reply->element[2]->type == REDIS_REPLY_STRING)
+    {
+        applyKeyspaceEvent(context, reply->element[2]->str);
+    }
+}
+
+static redisContext *
+openSubscription(struct Context *const context)
+{
+    redisContext *connection;
+    redisReply *reply;
+    char target[256];
+
+    LD_ASSERT(context);
+
+    /* no command timeout, reading blocks until the next message */
+    if (!(connection = openConnection(context->config, 0))) {
+        return NULL;
+    }
+
+    if (context->config->invalidation == LD_REDIS_INVALIDATION_KEYSPACE) {
+        if (snprintf(target, sizeof(target), "__keyspace@*__:%s:*",
+            LDRedisConfigGetPrefix(context->config)) < 0)
+        {
+            goto error;
+        }
+
+        reply = redisCommand(connection, "PSUBSCRIBE %s", target);
+    } else {
+        if (!invalidationChannel(context, target, sizeof(target))) {
+            goto error;
+        }
+
+        reply = redisCommand(connection, "SUBSCRIBE %s", target);
+    }
+
+    if (!redisCheckReply(reply, REDIS_REPLY_ARRAY)) {
+        LD_LOG(LD_LOG_ERROR, "redis invalidation subscribe failed");
+
+        resetReply(&reply);
+
+        goto error;
+    }
+
+    resetReply(&reply);
+
+    return connection;
+
+  error:
+    redisFree(connection);
+
+    return NULL;
+}
+
+static THREAD_RETURN
+subscriberThread(void *const contextRaw)
+{
+    struct Context *context;
+    struct Subscriber *subscriber;
+    unsigned int backoff;
+
+    LD_ASSERT(contextRaw);
+
+    context    = (struct Context *)contextRaw;
+    subscriber = &context->subscriber;
+    backoff    = LD_REDIS_SUBSCRIBE_MIN_BACKOFF;
+
+    while (true) {
+        redisContext *connection;
+        redisReply *reply;
+
+        LD_ASSERT(LDi_mtxlock(&subscriber->lock));
+        if (subscriber->stopping) {
+            LD_ASSERT(LDi_mtxunlock(&subscriber->lock));
+
+            break;
+        }
+        LD_ASSERT(LDi_mtxunlock(&subscriber->lock));
+
+        if ((connection = openSubscription(context))) {
+            LD_ASSERT(LDi_mtxlock(&subscriber->lock));
+            if (subscriber->stopping) {
+                LD_ASSERT(LDi_mtxunlock(&subscriber->lock));
+
+                redisFree(connection);
+
+                break;
+            }
+            subscriber->connection = connection;
+            LD_ASSERT(LDi_mtxunlock(&subscriber->lock));
+
+            /* anything published while unsubscribed was missed */
+            subscriber->invalidate(subscriber->store, NULL, NULL);
+
+            backoff = LD_REDIS_SUBSCRIBE_MIN_BACKOFF;
+            reply   = NULL;
+
+            while (redisGetReply(connection, (void **)&reply) == REDIS_OK) {
+                if (reply) {
+                    applyInvalidation(context, reply);
+                }
+
+                resetReply(&reply);
+            }
+
+            LD_ASSERT(LDi_mtxlock(&subscriber->lock));
+            subscriber->connection = NULL;
+            LD_ASSERT(LDi_mtxunlock(&subscriber->lock));
+
+            redisFree(connection);
+        }
+
+        LD_ASSERT(LDi_mtxlock(&subscriber->lock));
+        if (!subscriber->stopping) {
+            LD_LOG(LD_LOG_WARNING,
+                "redis invalidation subscription lost, retrying");
+
+            LDi_condwait(&subscriber->condition, &subscriber->lock, backoff);
+        }
+        LD_ASSERT(LDi_mtxunlock(&subscriber->lock));
+
+        backoff *= 2;
+
+        if (backoff > LD_REDIS_SUBSCRIBE_MAX_BACKOFF) {
+            backoff = LD_REDIS_SUBSCRIBE_MAX_BACKOFF;
+        }
+    }
+
+    return THREAD_RETURN_DEFAULT;
+}
+
+static void
+storeSubscribe(void *const contextRaw, LDStoreInvalidate invalidate,
+    void *const store)
+{
+    struct Context *context;
+
+    LD_LOG(LD_LOG_TRACE, "redis storeSubscribe");
+
+    LD_ASSERT(contextRaw);
+    LD_ASSERT(invalidate);
+
+    context = (struct Context *)contextRaw;
+
+    if (context->config->invalidation == LD_REDIS_INVALIDATION_NONE) {
+        return;
+    }
+
+    LD_ASSERT(!context->subscriber.started);
+
+    context->subscriber.invalidate = invalidate;
+    context->subscriber.store      = store;
+
+    if (!LDi_createthread(&context->subscriber.thread, subscriberThread,
+        context))
+    {
+        LD_LOG(LD_LOG_ERROR, "failed to start redis invalidation thread");
+
+        return;
+    }
+
+    context->subscriber.started = true;
+}
+
+/* wakes the subscriber from its blocking read and waits for it to exit */
+static void
+stopSubscriber(struct Subscriber *const subscriber)
+{
+    LD_ASSERT(subscriber);
+
+    if (!subscriber->started) {
+        return;
+    }
+
+    LD_ASSERT(LDi_mtxlock(&subscriber->lock));
+    subscriber->stopping = true;
+
+    if (subscriber->connection) {
+        shutdown(subscriber->connection->fd, LD_SHUT_RDWR);
+    }
+    LD_ASSERT(LDi_mtxunlock(&subscriber->lock));
+
+    LDi_condsignal(&subscriber->condition);
+
+    LD_ASSERT(LDi_jointhread(subscriber->thread));
+
+    subscriber->started = false;
+}
+
+/* **** Asynchronous connection **** */
+
+#ifndef _WIN32
+
+/* The event hooks are called by hiredis from functions invoked under the
+client lock. */
+static void
+asyncAddRead(void *const clientRaw)
+{
+    ((struct AsyncClient *)clientRaw)->reading = true;
+}
+
+static void
+asyncDelRead(void *const clientRaw)
+{
+    ((struct AsyncClient *)clientRaw)->reading = false;
+}
+
+static void
+asyncAddWrite(void *const clientRaw)
+{
+    struct AsyncClient *client;
+    char signal;
+
+    client = (struct AsyncClient *)clientRaw;
+    signal = 0;
+
+    client->writing = true;
+
+    /* a full pipe already guarantees a wake up */
+    if (write(client->wake[1], &signal, 1) < 0) {
+        LD_LOG(LD_LOG_TRACE, "redis async wake pipe full");
+    }
+}
+
+static void
+asyncDelWrite(void *const clientRaw)
+{
+    ((struct AsyncClient *)clientRaw)->writing = false;
+}
+
+/* called when hiredis frees the connection, after failing its callbacks */
+static void
+asyncCleanup(void *const clientRaw)
+{
+    struct AsyncClient *client;
+
+    client = (struct AsyncClient *)clientRaw;
+
+    client->connection  = NULL;
+    client->reading     = false;
+    client->writing     = false;
+    client->outstanding = 0;
+}
+
+/* expects client lock, connects on first use and after a failure */
+static redisAsyncContext *
+asyncConnection(struct Context *const context)
+{
+    struct AsyncClient *client;
+    redisAsyncContext *connection;
+
+    LD_ASSERT(context);
+
+    client = &context->async;
+
+    if (client->connection) {
+        return client->connection;
+    }
+
+    connection = redisAsyncConnect(LDRedisConfigGetHost(context->config),
+        context->config->port);
+
+    if (!connection) {
+        LD_LOG(LD_LOG_ERROR, "failed to create redis async connection");
+
+        return NULL;
+    }
+
+    if (connection->err) {
+        char msg[256];
+
+        LD_ASSERT(snprintf(msg, sizeof(msg),
+            "redis async connection had error: %s", connection->errstr) >= 0);
+
+        LD_LOG(LD_LOG_ERROR, msg);
+
+        redisAsyncFree(connection);
+
+        return NULL;
+    }
+
+    connection->data        = client;
+    connection->ev.data     = client;
+    connection->ev.addRead  = asyncAddRead;
+    connection->ev.delRead  = asyncDelRead;
+    connection->ev.addWrite = asyncAddWrite;
+    connection->ev.delWrite = asyncDelWrite;
+    connection->ev.cleanup  = asyncCleanup;
+
+    client->connection = connection;
+    /* the connect completes once the socket is writable */
+    client->reading    = true;
+    client->writing    = true;
+
+    return connection;
+}
+
+/* expects client lock */
+static void
+finishAsyncRequest(struct AsyncClient *const client,
+    struct AsyncRequest *const request)
+{
+    LD_ASSERT(client);
+    LD_ASSERT(request);
+
+    LL_APPEND(client->finished, request);
+
+    if (client->outstanding) {
+        client->outstanding--;
+    }
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&client->lastProgress));
+}
+
+/* Reply callbacks run under the client lock, from the event loop or while
+the connection is freed, in which case the reply is NULL. */
+static void
+onAsyncGet(redisAsyncContext *const connection, void *const reply,
+    void *const requestRaw)
+{
+    struct AsyncRequest *request;
+
+    LD_ASSERT(connection);
+    LD_ASSERT(requestRaw);
+
+    request = (struct AsyncRequest *)requestRaw;
+
+    request->success = readItem((redisReply *)reply, &request->item);
+
+    finishAsyncRequest((struct AsyncClient *)connection->data, request);
+}
+
+static void
+onAsyncAll(redisAsyncContext *const connection, void *const reply,
+    void *const requestRaw)
+{
+    struct AsyncRequest *request;
+
+    LD_ASSERT(connection);
+    LD_ASSERT(requestRaw);
+
+    request = (struct AsyncRequest *)requestRaw;
+
+    request->success = readCollection((redisReply *)reply, &request->items,
+        &request->itemCount);
+
+    finishAsyncRequest((struct AsyncClient *)connection->data, request);
+}
+
+static void
+onAsyncWrite(redisAsyncContext *const connection, void *const reply,
+    void *const requestRaw)
+{
+    struct AsyncRequest *request;
+
+    LD_ASSERT(connection);
+    LD_ASSERT(requestRaw);
+
+    request = (struct AsyncRequest *)requestRaw;
+
+    request->success = redisCheckReply((redisReply *)reply,
+        request->expectedReply);
+
+    if (!request->success) {
+        LD_LOG(LD_LOG_ERROR, "redis async write failed");
+    }
+
+    finishAsyncRequest((struct AsyncClient *)connection->data, request);
+}
+
+/* resends the script with EVAL when the server no longer has it cached, and
+leaves the request to WATCH / MULTI when the server rejects scripting */
+static void
+onAsyncUpsert(redisAsyncContext *const connection, void *const reply,
+    void *const requestRaw)
+{
+    struct AsyncRequest *request;
+    const redisReply *result;
+
+    LD_ASSERT(connection);
+    LD_ASSERT(requestRaw);
+
+    request = (struct AsyncRequest *)requestRaw;
+    result  = (const redisReply *)reply;
+
+    if (result && result->type == REDIS_REPLY_ERROR && result->str &&
+        strncmp(result->str, "NOSCRIPT", 8) == 0 && request->fallback)
+    {
+        struct AsyncClient *const client =
+            (struct AsyncClient *)connection->data;
+
+        LD_LOG(LD_LOG_TRACE, "redis upsert script not cached resending");
+
+        if (redisAsyncFormattedCommand(connection, onAsyncUpsert, request,
+            request->fallback, request->fallbackLength) == REDIS_OK)
+        {
+            /* hiredis copied the command, it is only resent once */
+            redisFreeCommand(request->fallback);
+            request->fallback = NULL;
+
+            /* still outstanding, but the server replied */
+            LD_ASSERT(LDi_getMonotonicMilliseconds(&client->lastProgress));
+
+            return;
+        }
+    }
+
+    /* the blocking upsert must not run on the event loop under the lock, a
+    NOSCRIPT that could not be resent is only a write failure */
+    if (result && scriptingRejected(result) &&
+        strncmp(result->str, "NOSCRIPT", 8) != 0)
+    {
+        request->watched = true;
+
+        finishAsyncRequest((struct AsyncClient *)connection->data, request);
+
+        return;
+    }
+
+    onAsyncWrite(connection, reply, requestRaw);
+}
+
+static void
+freeAsyncRequest(struct AsyncRequest *const request)
+{
+    LD_ASSERT(request);
+
+    if (request->fallback) {
+        redisFreeCommand(request->fallback);
+    }
+
+    LDFree(request->kind);
+    LDFree(request->featureKey);
+    /* the request owns the copy the cast is safe */
+    LDFree((void *)request->feature.buffer);
+
+    LDFree(request);
+}
+
+static void
+runCompletions(struct AsyncRequest *const requests)
+{
+    struct AsyncRequest *request, *tmp;
+
+    LL_FOREACH_SAFE(requests, request, tmp) {
+        if (request->getCompletion) {
+            request->getCompletion(request->completionData, request->success,
+                &request->item);
+        } else if (request->allCompletion) {
+            request->allCompletion(request->completionData, request->success,
+                request->items, request->itemCount);
+        } else {
+            LD_ASSERT(request->completion);
+
+            if (request->watched) {
+                markScriptingUnsupported(request->context);
+
+                request->success = storeUpsert(request->context,
+                    request->kind, &request->feature, request->featureKey);
+            }
+
+            request->completion(request->completionData, request->success);
+        }
+
+        freeAsyncRequest(request);
+    }
+}
+
+/* expects client lock, takes the requests ready to be completed */
+static struct AsyncRequest *
+takeFinished(struct AsyncClient *const client)
+{
+    struct AsyncRequest *finished;
+
+    LD_ASSERT(client);
+
+    finished         = client->finished;
+    client->finished = NULL;
+
+    return finished;
+}
+
+static THREAD_RETURN
+asyncThread(void *const contextRaw)
+{
+    struct Context *context;
+    struct AsyncClient *client;
+
+    LD_ASSERT(contextRaw);
+
+    context = (struct Context *)contextRaw;
+    client  = &context->async;
+
+    while (true) {
+        struct pollfd fds[2];
+        struct AsyncRequest *finished;
+        redisAsyncContext *polled;
+        unsigned long now;
+        nfds_t fdCount;
+        char drain[64];
+
+        LD_ASSERT(LDi_mtxlock(&client->lock));
+
+        if (client->stopping) {
+            LD_ASSERT(LDi_mtxunlock(&client->lock));
+
+            break;
+        }
+
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&now));
+
+        /* replies arrive in order so no progress means the oldest request
+        is overdue, dropping the connection fails every request on it */
+        if (client->connection && client->outstanding &&
+            context->config->commandTimeout &&
+            now - client->lastProgress > context->config->commandTimeout)
+        {
+            LD_LOG(LD_LOG_ERROR, "redis async command timed out");
+
+            redisAsyncFree(client->connection);
+        }
+
+        fds[0].fd      = client->wake[0];
+        fds[0].events  = POLLIN;
+        fds[0].revents = 0;
+        fdCount        = 1;
+
+        if ((polled = client->connection)) {
+            fds[1].fd      = polled->c.fd;
+            fds[1].events  = (client->reading ? POLLIN : 0) |
+                (client->writing ? POLLOUT : 0);
+            fds[1].revents = 0;
+            fdCount        = 2;
+        }
+
+        finished = takeFinished(client);
+
+        LD_ASSERT(LDi_mtxunlock(&client->lock));
+
+        runCompletions(finished);
+
+        /* the timeout bounds how late a command timeout is noticed */
+        if (poll(fds, fdCount, 100) < 0) {
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            while (read(client->wake[0], drain, sizeof(drain)) > 0) {}
+        }
+
+        if (fdCount < 2 || !fds[1].revents) {
+            continue;
+        }
+
+        LD_ASSERT(LDi_mtxlock(&client->lock));
+
+        /* the connection may have been replaced while polling */
+        if (client->connection == polled) {
+            if (fds[1].revents & (POLLIN | POLLERR | POLLHUP)) {
+                redisAsyncHandleRead(polled);
+            }
+
+            if (client->connection == polled &&
+                fds[1].revents & POLLOUT)
+            {
+                redisAsyncHandleWrite(polled);
+            }
+        }
+
+        LD_ASSERT(LDi_mtxunlock(&client->lock));
+    }
+
+    return THREAD_RETURN_DEFAULT;
+}
+
+static bool
+startAsyncClient(struct Context *const context)
+{
+    struct AsyncClient *client;
+    unsigned int i;
+
+    LD_ASSERT(context);
+
+    client = &context->async;
+
+    if (pipe(client->wake) != 0) {
+        LD_LOG(LD_LOG_ERROR, "failed to create redis async wake pipe");
+
+        return false;
+    }
+
+    for (i = 0; i < 2; i++) {
+        fcntl(client->wake[i], F_SETFL,
+            fcntl(client->wake[i], F_GETFL) | O_NONBLOCK);
+    }
+
+    LD_ASSERT(LDi_mtxinit(&client->lock));
+
+    if (!LDi_createthread(&client->thread, asyncThread, context)) {
+        LD_LOG(LD_LOG_ERROR, "failed to start redis async thread");
+
+        LD_ASSERT(LDi_mtxdestroy(&client->lock));
+
+        close(client->wake[0]);
+        close(client->wake[1]);
+
+        return false;
+    }
+
+    client->started = true;
+
+    return true;
+}
+
+/* fails requests still in flight and runs their completions */
+static void
+stopAsyncClient(struct AsyncClient *const client)
+{
+    struct AsyncRequest *finished;
+    char signal;
+
+    LD_ASSERT(client);
+
+    if (!client->started) {
+        return;
+    }
+
+    signal = 0;
+
+    LD_ASSERT(LDi_mtxlock(&client->lock));
+    client->stopping = true;
+
+    if (write(client->wake[1], &signal, 1) < 0) {
+        LD_LOG(LD_LOG_TRACE, "redis async wake pipe full");
+    }
+    LD_ASSERT(LDi_mtxunlock(&client->lock));
+
+    LD_ASSERT(LDi_jointhread(client->thread));
+
+    LD_ASSERT(LDi_mtxlock(&client->lock));
+    if (client->connection) {
+        redisAsyncFree(client->connection);
+    }
+
+    finished = takeFinished(client);
+    LD_ASSERT(LDi_mtxunlock(&client->lock));
+
+    runCompletions(finished);
+
+    LD_ASSERT(LDi_mtxdestroy(&client->lock));
+
+    close(client->wake[0]);
+    close(client->wake[1]);
+
+    client->started = false;
+}
+
+static struct AsyncRequest *
+newAsyncRequest(void *const completionData)
+{
+    struct AsyncRequest *request;
+
+    if (!(request = (struct AsyncRequest *)
+        LDAlloc(sizeof(struct AsyncRequest))))
+    {
         LD_LOG(LD_LOG_ERROR, "LDAlloc failed");
 
-        goto cleanup;
+        return NULL;
     }
 
-    memset(collection, 0, resultBytes);
+    memset(request, 0, sizeof(struct AsyncRequest));
 
-    collectionIter = collection;
+    request->completionData = completionData;
 
-    for (i = 0; i < reply->elements; i++) {
-        const char *raw;
-        /* skip name field */
-        i++;
+    return request;
+}
+
+/* expects client lock, counts a submitted request */
+static void
+trackAsyncRequest(struct AsyncClient *const client)
+{
+    LD_ASSERT(client);
+
+    if (client->outstanding++ == 0) {
+        LD_ASSERT(LDi_getMonotonicMilliseconds(&client->lastProgress));
+    }
+}
+
+/* Submits a single command. Takes the request, which is freed if it could
+not be submitted. */
+static bool
+submitAsync(struct Context *const context,
+    struct AsyncRequest *const request, redisCallbackFn *const callback,
+    const int argc, const char **const argv, const size_t *const argvlen)
+{
+    struct AsyncClient *client;
+    redisAsyncContext *connection;
+    bool submitted;
 
-        if (!redisCheckReply(reply->element[i], REDIS_REPLY_STRING)) {
-            LD_LOG(LD_LOG_ERROR, "not a string");
+    LD_ASSERT(context);
+    LD_ASSERT(request);
+    LD_ASSERT(callback);
 
-            goto cleanup;
-        }
+    client    = &context->async;
+    submitted = false;
 
-        LD_ASSERT(raw = reply->element[i]->str);
+    LD_ASSERT(LDi_mtxlock(&client->lock));
+    if (!client->stopping && (connection = asyncConnection(context))) {
+        if (redisAsyncCommandArgv(connection, callback, request, argc, argv,
+            argvlen) == REDIS_OK)
+        {
+            trackAsyncRequest(client);
 
-        if (!(feature = LDJSONDeserialize(raw))) {
-            goto cleanup;
+            submitted = true;
         }
+    }
+    LD_ASSERT(LDi_mtxunlock(&client->lock));
 
-        if (!(collectionIter->buffer = LDStrDup(raw))) {
-            goto cleanup;
-        }
+    if (!submitted) {
+        LD_LOG(LD_LOG_WARNING, "redis async submission failed");
 
-        collectionIter->bufferSize = strlen(raw);
-        collectionIter->version    = LDi_getFeatureVersion(feature);
+        freeAsyncRequest(request);
+    }
 
-        LDJSONFree(feature);
-        feature = NULL;
+    return submitted;
+}
 
-        collectionIter++;
-    }
+static bool
+storeGetAsync(void *const contextRaw, const char *const kind,
+    const char *const key, LDStoreGetCompletion completion,
+    void *const completionData)
+{
+    struct Context *context;
+    struct AsyncRequest *request;
+    char collectionKey[256];
+    const char *argv[3];
+    size_t argvlen[3];
 
-    *result = collection;
-    success = true;
+    LD_LOG(LD_LOG_TRACE, "redis storeGetAsync");
 
-  cleanup:
-    LDJSONFree(feature);
+    LD_ASSERT(contextRaw);
+    LD_ASSERT(kind);
+    LD_ASSERT(key);
+    LD_ASSERT(completion);
 
-    resetReply(&reply);
-    returnConnection(context, connection);
+    context = (struct Context *)contextRaw;
 
-    if (!success) {
-        for (i = 0; i < *resultCount; i++) {
-            LDFree(collection[i].buffer);
-        }
-        LDFree(collection);
+    if (snprintf(collectionKey, sizeof(collectionKey), "%s:%s",
+        LDRedisConfigGetPrefix(context->config), kind) < 0)
+    {
+        return false;
     }
 
-    return success;
+    if (!(request = newAsyncRequest(completionData))) {
+        return false;
+    }
+
+    request->getCompletion = completion;
+
+    argv[0] = "HGET";        argvlen[0] = 4;
+    argv[1] = collectionKey; argvlen[1] = strlen(collectionKey);
+    argv[2] = key;           argvlen[2] = strlen(key);
+
+    return submitAsync(context, request, onAsyncGet, 3, argv, argvlen);
 }
 
-bool
-storeUpsertInternal(void *const contextRaw, const char *const kind,
-    const struct LDStoreCollectionItem *const feature,
-    const char *const featureKey,
-    void (*const hook)())
+static bool
+storeAllAsync(void *const contextRaw, const char *const kind,
+    LDStoreAllCompletion completion, void *const completionData)
 {
     struct Context *context;
-    redisReply *reply;
-    struct LDJSON *existing;
-    struct Connection *connection;
-    char *serialized;
-    bool success;
+    struct AsyncRequest *request;
+    char collectionKey[256];
+    const char *argv[2];
+    size_t argvlen[2];
 
-    LD_LOG(LD_LOG_TRACE, "redis storeUpsertInternal");
+    LD_LOG(LD_LOG_TRACE, "redis storeAllAsync");
 
     LD_ASSERT(contextRaw);
     LD_ASSERT(kind);
-    LD_ASSERT(feature);
-    LD_ASSERT(featureKey);
+    LD_ASSERT(completion);
 
-    context    = (struct Context *)contextRaw;
-    reply      = NULL;
-    serialized = NULL;
-    existing   = NULL;
-    connection = NULL;
-    success    = false;
+    context = (struct Context *)contextRaw;
 
-    if (!(connection = borrowConnection(context))) {
-        goto cleanup;
+    if (snprintf(collectionKey, sizeof(collectionKey), "%s:%s",
+        LDRedisConfigGetPrefix(context->config), kind) < 0)
+    {
+        return false;
     }
 
-    while (true) {
-        reply = redisCommand(connection->connection, "WATCH %s:%s",
-            LDRedisConfigGetPrefix(context->config), kind);
+    if (!(request = newAsyncRequest(completionData))) {
+        return false;
+    }
 
-        if (!redisCheckStatus(reply, "OK")) {
-            goto cleanup;
-        }
+    request->allCompletion = completion;
 
-        resetReply(&reply);
+    argv[0] = "HGETALL";     argvlen[0] = 7;
+    argv[1] = collectionKey; argvlen[1] = strlen(collectionKey);
 
-        reply = redisCommand(connection->connection, "HGET %s:%s %s",
-            LDRedisConfigGetPrefix(context->config), kind, featureKey);
+    return submitAsync(context, request, onAsyncAll, 2, argv, argvlen);
+}
 
-        if (!reply) {
-            goto cleanup;
-        } else if (reply->type == REDIS_REPLY_NIL) {
-            /* does not exist */
-        } else if (!redisCheckReply(reply, REDIS_REPLY_STRING)) {
-            goto cleanup;
-        } else if ((existing = LDJSONDeserialize(reply->str))) {
-            if (LDi_isFeatureDeleted(existing)) {
-                LDJSONFree(existing);
+/* keeps what the WATCH / MULTI upsert needs once the caller has returned */
+static bool
+copyUpsert(struct AsyncRequest *const request, const char *const kind,
+    const struct LDStoreCollectionItem *const feature,
+    const char *const featureKey)
+{
+    char *buffer;
 
-                existing = NULL;
-            }
-        } else {
-            goto cleanup;
-        }
+    LD_ASSERT(request);
+    LD_ASSERT(kind);
+    LD_ASSERT(feature);
+    LD_ASSERT(featureKey);
 
-        resetReply(&reply);
+    if (!(request->kind = LDStrDup(kind))) {
+        return false;
+    }
 
-        if (existing && LDi_getFeatureVersion(existing) >=
-            feature->version)
-        {
-            success = true;
+    if (!(request->featureKey = LDStrDup(featureKey))) {
+        return false;
+    }
 
-            goto cleanup;
-        }
+    request->feature.version    = feature->version;
+    request->feature.bufferSize = feature->bufferSize;
 
-        LDJSONFree(existing);
-        existing = NULL;
+    if (feature->buffer) {
+        if (!(buffer = (char *)LDAlloc(feature->bufferSize + 1))) {
+            return false;
+        }
 
-        if (feature->buffer) {
-            serialized = feature->buffer;
-        } else {
-            struct LDJSON *placeholder;
+        memcpy(buffer, feature->buffer, feature->bufferSize);
+        buffer[feature->bufferSize] = 0;
 
-            if (!(placeholder =
-                LDi_makeDeleted(featureKey, feature->version)))
-            {
-                goto cleanup;
-            }
+        request->feature.buffer = buffer;
+    }
 
-            serialized = LDJSONSerialize(placeholder);
+    return true;
+}
 
-            LDJSONFree(placeholder);
+/* Sends the upsert script with EVALSHA, and with EVAL if the server does not
+have it cached. Without scripting the blocking WATCH / MULTI upsert runs
+before returning. A request the server rejects the script of runs it from
+the completion thread instead. */
+static bool
+storeUpsertAsync(void *const contextRaw, const char *const kind,
+    const struct LDStoreCollectionItem *const feature,
+    const char *const featureKey, LDStoreCompletion completion,
+    void *const completionData)
+{
+    struct Context *context;
+    struct AsyncRequest *request;
+    char collectionKey[256], version[16];
+    char channel[256], message[256];
+    const char *argv[9], *serialized;
+    size_t argvlen[9];
+    char *placeholder;
+    int versionLength;
+    long long fallbackLength;
+    bool scripted, submitted;
+
+    LD_LOG(LD_LOG_TRACE, "redis storeUpsertAsync");
 
-            if (!serialized) {
-                goto cleanup;
-            }
-        }
+    LD_ASSERT(contextRaw);
+    LD_ASSERT(kind);
+    LD_ASSERT(feature);
+    LD_ASSERT(featureKey);
+    LD_ASSERT(completion);
 
-        if (hook) {
-            hook();
-        }
+    context     = (struct Context *)contextRaw;
+    placeholder = NULL;
 
-        reply = redisCommand(connection->connection, "MULTI");
+    LD_ASSERT(LDi_mtxlock(&context->lock));
+    scripted = context->upsertScriptState != LD_SCRIPT_UNSUPPORTED;
+    LD_ASSERT(LDi_mtxunlock(&context->lock));
 
-        if (!redisCheckStatus(reply, "OK")) {
-            LD_LOG(LD_LOG_ERROR, "Redis MULTI failed");
+    if (!scripted) {
+        completion(completionData,
+            storeUpsert(contextRaw, kind, feature, featureKey));
 
-            goto cleanup;
-        }
+        return true;
+    }
 
-        resetReply(&reply);
+    if (snprintf(collectionKey, sizeof(collectionKey), "%s:%s",
+        LDRedisConfigGetPrefix(context->config), kind) < 0)
+    {
+        return false;
+    }
 
-        reply = redisCommand(connection->connection, "HSET %s:%s %s %s",
-            LDRedisConfigGetPrefix(context->config), kind, featureKey,
-            serialized);
+    if ((versionLength = snprintf(version, sizeof(version), "%u",
+        feature->version)) < 0)
+    {
+        return false;
+    }
 
-        if (!redisCheckStatus(reply, "QUEUED")) {
-            LD_LOG(LD_LOG_ERROR, "Redis expected OK");
+    if (!invalidationChannel(context, channel, sizeof(channel))) {
+        return false;
+    }
 
-            goto cleanup;
-        }
+    if (snprintf(message, sizeof(message), "%s:%s", kind, featureKey) < 0) {
+        return false;
+    }
 
-        resetReply(&reply);
+    if (feature->buffer) {
+        serialized = (const char *)feature->buffer;
+    } else if ((placeholder = serializeDeleted(feature, featureKey))) {
+        serialized = placeholder;
+    } else {
+        return false;
+    }
 
-        reply = redisCommand(connection->connection, "EXEC");
+    if (!(request = newAsyncRequest(completionData))) {
+        LDFree(placeholder);
 
-        if (reply) {
-            if (reply->type == REDIS_REPLY_ARRAY) {
-                break;
-            } else if (reply->type == REDIS_REPLY_NIL) {
-                LD_LOG(LD_LOG_WARNING, "Redis race detected retrying");
+        return false;
+    }
 
-                resetReply(&reply);
-            } else {
-                LD_LOG(LD_LOG_ERROR, "Redis EXEC incorrect type");
+    request->completion    = completion;
+    request->expectedReply = REDIS_REPLY_INTEGER;
+    request->context       = context;
 
-                goto cleanup;
-            }
-        } else {
-            LD_LOG(LD_LOG_ERROR, "Redis reply is NULL");
+    if (!copyUpsert(request, kind, feature, featureKey)) {
+        LDFree(placeholder);
+        freeAsyncRequest(request);
 
-            goto cleanup;
-        }
+        return false;
     }
 
-    success = true;
+    argv[0] = "EVAL";        argvlen[0] = 4;
+    argv[1] = upsertScript;  argvlen[1] = strlen(upsertScript);
+    argv[2] = "1";           argvlen[2] = 1;
+    argv[3] = collectionKey; argvlen[3] = strlen(collectionKey);
+    argv[4] = featureKey;    argvlen[4] = strlen(featureKey);
+    argv[5] = version;       argvlen[5] = versionLength;
+    argv[6] = serialized;    argvlen[6] = strlen(serialized);
+    argv[7] = channel;       argvlen[7] = strlen(channel);
+    argv[8] = message;       argvlen[8] = strlen(message);
+
+    if ((fallbackLength = redisFormatCommandArgv(&request->fallback, 9, argv,
+        argvlen)) < 0)
+    {
+        LDFree(placeholder);
+        freeAsyncRequest(request);
 
-  cleanup:
-    if ((feature && (serialized != feature->buffer)) || !feature) {
-        LDFree(serialized);
+        return false;
     }
 
-    LDJSONFree(existing);
-
-    resetReply(&reply);
+    request->fallbackLength = (size_t)fallbackLength;
 
-    returnConnection(context, connection);
+    argv[0] = "EVALSHA";                   argvlen[0] = 7;
+    argv[1] = context->upsertScriptDigest; argvlen[1] = 40;
 
-    return success;
-}
+    submitted = submitAsync(context, request, onAsyncUpsert, 9, argv,
+        argvlen);
 
-static bool
-storeUpsert(void *const contextRaw, const char *const kind,
-    const struct LDStoreCollectionItem *const feature,
-    const char *const featureKey)
-{
-    LD_ASSERT(contextRaw);
-    LD_ASSERT(kind);
-    LD_ASSERT(feature);
-    LD_ASSERT(featureKey);
+    LDFree(placeholder);
 
-    return storeUpsertInternal(contextRaw, kind, feature, featureKey, NULL);
+    return submitted;
 }
 
 static bool
-storeInitialized(void *const contextRaw)
+storeInitAsync(void *const contextRaw,
+    const struct LDStoreCollectionState *collections,
+    const unsigned int collectionCount, LDStoreCompletion completion,
+    void *const completionData)
 {
     struct Context *context;
-    redisReply *reply;
-    struct Connection *connection;
-    bool initialized;
+    struct AsyncClient *client;
+    struct AsyncRequest *request;
+    struct Pipeline pipeline;
+    bool submitted;
 
-    LD_LOG(LD_LOG_TRACE, "redis storeInitialized");
+    LD_LOG(LD_LOG_TRACE, "redis storeInitAsync");
 
     LD_ASSERT(contextRaw);
+    LD_ASSERT(collections || collectionCount == 0);
+    LD_ASSERT(completion);
 
-    context    = (struct Context *)contextRaw;
-    connection = NULL;
-    reply      = NULL;
+    context   = (struct Context *)contextRaw;
+    client    = &context->async;
+    submitted = false;
 
-    if (!(connection = borrowConnection(context))) {
+    if (!(request = newAsyncRequest(completionData))) {
         return false;
     }
 
-    reply = redisCommand(connection->connection, "EXISTS %s:%s",
-        LDRedisConfigGetPrefix(context->config), initedKey);
+    request->completion    = completion;
+    request->expectedReply = REDIS_REPLY_ARRAY;
 
-    initialized = !redisCheckReply(reply, REDIS_REPLY_INTEGER)
-        || reply->integer;
+    memset(&pipeline, 0, sizeof(struct Pipeline));
 
-    resetReply(&reply);
+    /* the transaction is appended under the lock so no other command can
+    land inside of it, only the reply to EXEC is checked */
+    LD_ASSERT(LDi_mtxlock(&client->lock));
+    if (!client->stopping &&
+        (pipeline.asyncConnection = asyncConnection(context)))
+    {
+        if (appendInit(context, &pipeline, collections, collectionCount) &&
+            redisAsyncCommand(pipeline.asyncConnection, onAsyncWrite, request,
+            "EXEC") == REDIS_OK)
+        {
+            trackAsyncRequest(client);
 
-    returnConnection(context, connection);
+            submitted = true;
+        } else if (pipeline.pending) {
+            /* a partial transaction must not reach the server */
+            redisAsyncFree(pipeline.asyncConnection);
+        }
+    }
+    LD_ASSERT(LDi_mtxunlock(&client->lock));
 
-    return initialized;
+    if (!submitted) {
+        LD_LOG(LD_LOG_WARNING, "redis async submission failed");
+
+        freeAsyncRequest(request);
+    }
+
+    return submitted;
 }
 
+#endif
+
 static void
 storeDestructor(void *const contextRaw)
 {
@@ -771,20 +2896,40 @@ storeDestructor(void *const contextRaw)
     context = (struct Context *)contextRaw;
 
     if (context) {
-        while (context->connections) {
-            struct Connection *tmp;
+        unsigned int i;
+
+        /* the subscriber may be using the config */
+        stopSubscriber(&context->subscriber);
+
+        #ifndef _WIN32
+            stopAsyncClient(&context->async);
+        #endif
+
+        LD_ASSERT(LDi_mtxdestroy(&context->subscriber.lock));
+        LDi_conddestroy(&context->subscriber.condition);
+
+        for (i = 0; i < context->shardCount; i++) {
+            struct PoolShard *const shard = &context->shards[i];
+
+            while (shard->connections) {
+                struct Connection *tmp;
 
-            LD_ASSERT(tmp = context->connections);
+                LD_ASSERT(tmp = shard->connections);
 
-            redisFree(tmp->connection);
+                redisFree(tmp->connection);
 
-            LL_DELETE(context->connections, tmp);
+                LL_DELETE(shard->connections, tmp);
 
-            LDFree(tmp);
+                LDFree(tmp);
+            }
+
+            LD_ASSERT(LDi_mtxdestroy(&shard->lock));
+            LDi_conddestroy(&shard->condition);
         }
 
+        LDFree(context->shards);
+
         LD_ASSERT(LDi_mtxdestroy(&context->lock));
-        LDi_conddestroy(&context->condition);
 
         LDRedisConfigFree(context->config);
 
@@ -792,6 +2937,35 @@ storeDestructor(void *const contextRaw)
     }
 }
 
+void
+LDStoreInterfaceRedisExtensions(struct LDStoreInterface *const store,
+    struct LDStoreInterfaceExtensions *const extensions)
+{
+    const struct Context *context;
+
+    LD_ASSERT(store);
+    LD_ASSERT(store->context);
+    LD_ASSERT(extensions);
+
+    context = (const struct Context *)store->context;
+
+    memset(extensions, 0, sizeof(struct LDStoreInterfaceExtensions));
+
+    extensions->size      = sizeof(struct LDStoreInterfaceExtensions);
+    extensions->subscribe = storeSubscribe;
+
+    /* the async client is only running if LDRedisConfigSetAsync was set and
+    it started */
+    if (context->async.started) {
+        #ifndef _WIN32
+            extensions->getAsync    = storeGetAsync;
+            extensions->allAsync    = storeAllAsync;
+            extensions->upsertAsync = storeUpsertAsync;
+            extensions->initAsync   = storeInitAsync;
+        #endif
+    }
+}
+
 struct LDStoreInterface *
 LDStoreInterfaceRedisNew(struct LDRedisConfig *const config)
 {
@@ -807,18 +2981,70 @@ LDStoreInterfaceRedisNew(struct LDRedisConfig *const config)
         goto error;
     }
 
+    memset(context, 0, sizeof(struct Context));
+
     if (!(handle =
         (struct LDStoreInterface *)LDAlloc(sizeof(struct LDStoreInterface))))
     {
         goto error;
     }
 
-    context->count       = 0;
-    context->connections = NULL;
-    context->config      = config;
+    context->config     = config;
+    context->shardCount = config->poolSize < LD_REDIS_POOL_SHARDS ?
+        config->poolSize : LD_REDIS_POOL_SHARDS;
+
+    if (context->shardCount == 0) {
+        context->shardCount = 1;
+    }
+
+    context->upsertScriptState  = LD_SCRIPT_UNKNOWN;
+    context->upsertScriptSHA[0] = 0;
+
+    {
+        static const char *const hex = "0123456789abcdef";
+        char digest[21];
+        unsigned int i;
+
+        /* the name Redis gives the script, to use EVALSHA before loading */
+        SHA1(digest, upsertScript, strlen(upsertScript));
+
+        for (i = 0; i < 20; i++) {
+            context->upsertScriptDigest[i * 2] =
+                hex[(unsigned char)digest[i] >> 4];
+            context->upsertScriptDigest[i * 2 + 1] =
+                hex[(unsigned char)digest[i] & 0x0F];
+        }
+
+        context->upsertScriptDigest[40] = 0;
+    }
+
+    if (!(context->shards = (struct PoolShard *)
+        LDAlloc(sizeof(struct PoolShard) * context->shardCount)))
+    {
+        goto error;
+    }
+
+    memset(context->shards, 0,
+        sizeof(struct PoolShard) * context->shardCount);
+
+    {
+        unsigned int i;
+
+        /* the pool size is split as evenly as possible between shards */
+        for (i = 0; i < context->shardCount; i++) {
+            struct PoolShard *const shard = &context->shards[i];
+
+            shard->capacity = config->poolSize / context->shardCount +
+                (i < config->poolSize % context->shardCount ? 1 : 0);
+
+            LD_ASSERT(LDi_mtxinit(&shard->lock));
+            LDi_condinit(&shard->condition);
+        }
+    }
 
     LD_ASSERT(LDi_mtxinit(&context->lock));
-    LDi_condinit(&context->condition);
+    LD_ASSERT(LDi_mtxinit(&context->subscriber.lock));
+    LDi_condinit(&context->subscriber.condition);
 
     handle->context     = context;
     handle->init        = storeInit;
@@ -828,10 +3054,21 @@ LDStoreInterfaceRedisNew(struct LDRedisConfig *const config)
     handle->initialized = storeInitialized;
     handle->destructor  = storeDestructor;
 
+    #ifndef _WIN32
+        if (config->async) {
+            startAsyncClient(context);
+        }
+    #endif
+
     return handle;
 
   error:
     LDFree(handle);
+
+    if (context) {
+        LDFree(context->shards);
+    }
+
     LDFree(context);
 
     return NULL;
@@ -102,6 +102,265 @@ testWriteConflict()
     LDConfigFree(config);
 }
 
+static struct LDStore *
+prepareInvalidatedStore()
+{
+    struct LDStore *store;
+    struct LDStoreInterface *interface;
+    struct LDStoreInterfaceExtensions extensions;
+    struct LDRedisConfig *redisConfig;
+    struct LDConfig *config;
+
+    LD_ASSERT(config = LDConfigNew(""));
+    LD_ASSERT(redisConfig = LDRedisConfigNew());
+    LD_ASSERT(LDRedisConfigSetInvalidation(redisConfig,
+        LD_REDIS_INVALIDATION_CHANNEL));
+    LD_ASSERT(interface = LDStoreInterfaceRedisNew(redisConfig));
+    LDStoreInterfaceRedisExtensions(interface, &extensions);
+    LDConfigSetFeatureStoreBackend(config, interface);
+    LDConfigSetFeatureStoreBackendExtensions(config, &extensions);
+    /* only an invalidation can refresh the reader */
+    LDConfigSetFeatureStoreBackendCacheTTL(config, 60 * 60 * 1000);
+    LD_ASSERT(store = LDStoreNew(config));
+    config->storeBackend = NULL;
+    LDConfigFree(config);
+
+    return store;
+}
+
+static void
+testChannelInvalidation()
+{
+    struct LDStore *reader, *writer;
+    struct LDJSONRC *lookup;
+    unsigned int version, attempts;
+
+    flushDB();
+
+    LD_ASSERT(reader = prepareInvalidatedStore());
+    LD_ASSERT(writer = prepareInvalidatedStore());
+
+    LD_ASSERT(LDStoreInitEmpty(writer));
+    LD_ASSERT(LDStoreUpsert(writer, LD_FLAG,
+        makeMinimalFlag("abc", 1, true, false)));
+
+    /* the subscription is asynchronous, wait for the first version */
+    for (attempts = 0; attempts < 100; attempts++) {
+        LD_ASSERT(LDStoreGet(reader, LD_FLAG, "abc", &lookup));
+
+        if (lookup) {
+            break;
+        }
+
+        LD_ASSERT(LDi_sleepMilliseconds(20));
+    }
+    LD_ASSERT(lookup);
+    LDJSONRCDecrement(lookup);
+
+    LD_ASSERT(LDStoreUpsert(writer, LD_FLAG,
+        makeMinimalFlag("abc", 2, true, false)));
+
+    for (attempts = 0; attempts < 100; attempts++) {
+        LD_ASSERT(LDStoreGet(reader, LD_FLAG, "abc", &lookup));
+        LD_ASSERT(lookup);
+        version = LDi_getFeatureVersion(LDJSONRCGet(lookup));
+        LDJSONRCDecrement(lookup);
+
+        if (version == 2) {
+            break;
+        }
+
+        LD_ASSERT(LDi_sleepMilliseconds(20));
+    }
+    LD_ASSERT(version == 2);
+
+    LDStoreDestroy(reader);
+    LDStoreDestroy(writer);
+}
+
+static struct LDStore *
+prepareAsyncStore()
+{
+    struct LDStore *store;
+    struct LDStoreInterface *interface;
+    struct LDStoreInterfaceExtensions extensions;
+    struct LDRedisConfig *redisConfig;
+    struct LDConfig *config;
+
+    LD_ASSERT(config = LDConfigNew(""));
+    LD_ASSERT(redisConfig = LDRedisConfigNew());
+    LD_ASSERT(LDRedisConfigSetAsync(redisConfig, true));
+    LD_ASSERT(interface = LDStoreInterfaceRedisNew(redisConfig));
+    LDStoreInterfaceRedisExtensions(interface, &extensions);
+    LD_ASSERT(extensions.upsertAsync);
+    LDConfigSetFeatureStoreBackend(config, interface);
+    LDConfigSetFeatureStoreBackendExtensions(config, &extensions);
+    LD_ASSERT(store = LDStoreNew(config));
+    config->storeBackend = NULL;
+    LDConfigFree(config);
+
+    return store;
+}
+
+static void
+testAsync()
+{
+    struct LDStore *store, *reader;
+    struct LDJSONRC *lookup;
+    unsigned int attempts;
+
+    flushDB();
+
+    LD_ASSERT(store = prepareAsyncStore());
+
+    /* init is awaited even though it is submitted asynchronously */
+    LD_ASSERT(LDStoreInitEmpty(store));
+    LD_ASSERT(LDStoreInitialized(store));
+
+    LD_ASSERT(LDStoreUpsert(store, LD_FLAG,
+        makeMinimalFlag("abc", 3, true, false)));
+
+    /* the cache is updated when the write completes */
+    for (attempts = 0; attempts < 100; attempts++) {
+        LD_ASSERT(LDStoreGet(store, LD_FLAG, "abc", &lookup));
+
+        if (lookup) {
+            break;
+        }
+
+        LD_ASSERT(LDi_sleepMilliseconds(20));
+    }
+    LD_ASSERT(lookup);
+    LD_ASSERT(LDi_getFeatureVersion(LDJSONRCGet(lookup)) == 3);
+    LDJSONRCDecrement(lookup);
+
+    /* destroying the store completes every outstanding write */
+    LD_ASSERT(LDStoreRemove(store, LD_FLAG, "abc", 4));
+    LDStoreDestroy(store);
+
+    /* read back through a synchronous store */
+    LD_ASSERT(reader = prepareInvalidatedStore());
+    LD_ASSERT(LDStoreGet(reader, LD_FLAG, "abc", &lookup));
+    LD_ASSERT(!lookup);
+    LDStoreDestroy(reader);
+}
+
+static void
+setScripting(const bool allowed)
+{
+    redisContext *connection;
+    redisReply *reply;
+
+    LD_ASSERT(connection = redisConnect("127.0.0.1", 6379));
+    LD_ASSERT(!connection->err);
+
+    LD_ASSERT(reply = redisCommand(connection, "ACL SETUSER default %s",
+        allowed ? "+@all" : "-@scripting"));
+    LD_ASSERT(reply->type == REDIS_REPLY_STATUS);
+    freeReplyObject(reply);
+    redisFree(connection);
+}
+
+static void
+testAsyncScriptingRejected()
+{
+    struct LDStore *store, *reader;
+    struct LDJSONRC *lookup;
+    unsigned int attempts;
+
+    flushDB();
+    setScripting(false);
+
+    LD_ASSERT(store = prepareAsyncStore());
+    LD_ASSERT(LDStoreInitEmpty(store));
+
+    /* the rejected script is replaced by an optimistic transaction */
+    LD_ASSERT(LDStoreUpsert(store, LD_FLAG,
+        makeMinimalFlag("abc", 3, true, false)));
+
+    for (attempts = 0; attempts < 100; attempts++) {
+        LD_ASSERT(LDStoreGet(store, LD_FLAG, "abc", &lookup));
+
+        if (lookup) {
+            break;
+        }
+
+        LD_ASSERT(LDi_sleepMilliseconds(20));
+    }
+    LD_ASSERT(lookup);
+    LD_ASSERT(LDi_getFeatureVersion(LDJSONRCGet(lookup)) == 3);
+    LDJSONRCDecrement(lookup);
+
+    /* later writes skip the script entirely */
+    LD_ASSERT(LDStoreUpsert(store, LD_FLAG,
+        makeMinimalFlag("abc", 4, true, false)));
+    LDStoreDestroy(store);
+
+    LD_ASSERT(reader = prepareInvalidatedStore());
+    LD_ASSERT(LDStoreGet(reader, LD_FLAG, "abc", &lookup));
+    LD_ASSERT(lookup);
+    LD_ASSERT(LDi_getFeatureVersion(LDJSONRCGet(lookup)) == 4);
+    LDJSONRCDecrement(lookup);
+    LDStoreDestroy(reader);
+
+    setScripting(true);
+}
+
+/* a feature that fails validation, but that the memory cache accepts */
+static struct LDJSON *
+makeInvalidFeature(const char *const key)
+{
+    struct LDJSON *feature;
+
+    LD_ASSERT(feature = makeMinimalFlag(key, 1, true, false));
+    LD_ASSERT(LDObjectSetKey(feature, "deleted", LDNewText("yes")));
+
+    return feature;
+}
+
+static void
+testInitSkipsInvalidFeatures()
+{
+    struct LDStore *store, *reader;
+    struct LDJSON *sets, *flags, *segments;
+    struct LDJSONRC *lookup;
+
+    LD_ASSERT(store = prepareEmptyStore());
+
+    LD_ASSERT(flags = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(flags, "abc",
+        makeMinimalFlag("abc", 3, true, false)));
+    LD_ASSERT(LDObjectSetKey(flags, "bad", makeInvalidFeature("bad")));
+
+    /* no valid items at all, so the collection gets no HMSET */
+    LD_ASSERT(segments = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(segments, "bad", makeInvalidFeature("bad")));
+
+    LD_ASSERT(sets = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(sets, "features", flags));
+    LD_ASSERT(LDObjectSetKey(sets, "segments", segments));
+
+    LD_ASSERT(LDStoreInit(store, sets));
+    LD_ASSERT(LDStoreInitialized(store));
+
+    /* read back without the cache of the writer */
+    LD_ASSERT(reader = prepareInvalidatedStore());
+    LD_ASSERT(LDStoreInitialized(reader));
+
+    LD_ASSERT(LDStoreGet(reader, LD_FLAG, "abc", &lookup));
+    LD_ASSERT(lookup);
+    LD_ASSERT(LDi_getFeatureVersion(LDJSONRCGet(lookup)) == 3);
+    LDJSONRCDecrement(lookup);
+
+    LD_ASSERT(LDStoreGet(reader, LD_FLAG, "bad", &lookup));
+    LD_ASSERT(!lookup);
+    LD_ASSERT(LDStoreGet(reader, LD_SEGMENT, "bad", &lookup));
+    LD_ASSERT(!lookup);
+
+    LDStoreDestroy(reader);
+    LDStoreDestroy(store);
+}
+
 int
 main()
 {
@@ -109,6 +368,10 @@ main()
 
     runSharedStoreTests(prepareEmptyStore);
     testWriteConflict();
+    testChannelInvalidation();
+    testAsync();
+    testAsyncScriptingRejected();
+    testInitSkipsInvalidFeatures();
 
     return 0;
 }
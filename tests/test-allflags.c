@@ -104,6 +104,130 @@ testAllFlagsReturnsNilIfUserKeyIsNil()
     LDClientClose(client);
 }
 
+static void
+testAllFlagsState()
+{
+    struct LDJSON *flag1, *flag2, *state, *meta;
+    struct LDClient *client;
+    struct LDUser *user;
+
+    LD_ASSERT(client = makeTestClient());
+    LD_ASSERT(user = LDUserNew("userkey"));
+
+    /* flag1, client side */
+    LD_ASSERT(flag1 = makeMinimalFlag("flag1", 3, true, true));
+    LD_ASSERT(LDObjectSetKey(flag1, "clientSide", LDNewBool(true)));
+    setFallthrough(flag1, 1);
+    addVariation(flag1, LDNewText("a"));
+    addVariation(flag1, LDNewText("b"));
+
+    /* flag2, off without an off variation */
+    LD_ASSERT(flag2 = makeMinimalFlag("flag2", 4, false, false));
+    addVariation(flag2, LDNewText("c"));
+
+    /* store */
+    LD_ASSERT(LDStoreInitEmpty(client->store));
+    LD_ASSERT(LDStoreUpsert(client->store, LD_FLAG, flag1));
+    LD_ASSERT(LDStoreUpsert(client->store, LD_FLAG, flag2));
+
+    /* every flag without reasons */
+    LD_ASSERT(state = LDAllFlagsState(client, user, 0));
+    LD_ASSERT(LDCollectionGetSize(state) == 4);
+    LD_ASSERT(strcmp(LDGetText(LDObjectLookup(state, "flag1")), "b") == 0);
+    LD_ASSERT(LDJSONGetType(LDObjectLookup(state, "flag2")) == LDNull);
+    LD_ASSERT(LDGetBool(LDObjectLookup(state, "$valid")));
+
+    LD_ASSERT(meta = LDObjectLookup(state, "$flagsState"));
+    LD_ASSERT(LDCollectionGetSize(meta) == 2);
+    LD_ASSERT(meta = LDObjectLookup(meta, "flag1"));
+    LD_ASSERT(LDGetNumber(LDObjectLookup(meta, "version")) == 3);
+    LD_ASSERT(LDGetNumber(LDObjectLookup(meta, "variation")) == 1);
+    LD_ASSERT(LDGetBool(LDObjectLookup(meta, "trackEvents")));
+    LD_ASSERT(!LDObjectLookup(meta, "reason"));
+    LD_ASSERT(meta = LDObjectLookup(LDObjectLookup(state, "$flagsState"),
+        "flag2"));
+    LD_ASSERT(!LDObjectLookup(meta, "variation"));
+    LD_ASSERT(!LDObjectLookup(meta, "trackEvents"));
+
+    LDJSONFree(state);
+
+    /* client side flags with reasons */
+    LD_ASSERT(state = LDAllFlagsState(client, user,
+        LD_ALL_FLAGS_CLIENT_SIDE_ONLY | LD_ALL_FLAGS_WITH_REASONS));
+    LD_ASSERT(LDCollectionGetSize(state) == 3);
+    LD_ASSERT(!LDObjectLookup(state, "flag2"));
+    LD_ASSERT(meta = LDObjectLookup(state, "$flagsState"));
+    LD_ASSERT(LDCollectionGetSize(meta) == 1);
+    LD_ASSERT(meta = LDObjectLookup(LDObjectLookup(meta, "flag1"), "reason"));
+    LD_ASSERT(strcmp(LDGetText(LDObjectLookup(meta, "kind")), "FALLTHROUGH")
+        == 0);
+
+    /* cleanup */
+    LDJSONFree(state);
+    LDUserFree(user);
+    LDClientClose(client);
+}
+
+static void
+testAllFlagsThreads()
+{
+    struct LDClient *clients[2];
+    struct LDConfig *config;
+    struct LDUser *user;
+    struct LDJSON *flag;
+    char *serialized[2], key[32];
+    unsigned int i, j;
+
+    LD_ASSERT(user = LDUserNew("userkey"));
+
+    LD_ASSERT(clients[0] = makeTestClient());
+    LD_ASSERT(config = LDConfigNew("key"));
+    LDConfigSetEvaluationThreads(config, 4);
+    LD_ASSERT(clients[1] = LDClientInit(config, 0));
+
+    for (i = 0; i < 2; i++) {
+        LD_ASSERT(LDStoreInitEmpty(clients[i]->store));
+
+        for (j = 0; j < 300; j++) {
+            LD_ASSERT(snprintf(key, sizeof(key), "flag%u", j) > 0);
+            LD_ASSERT(flag = makeMinimalFlag(key, j, j % 3 != 0, false));
+            LD_ASSERT(LDObjectSetKey(flag, "clientSide", LDNewBool(j % 2)));
+            LD_ASSERT(LDObjectSetKey(flag, "offVariation", LDNewNumber(0)));
+            setFallthrough(flag, 1);
+            addVariation(flag, LDNewNumber(j));
+            addVariation(flag, LDNewText(key));
+            LD_ASSERT(LDStoreUpsert(clients[i]->store, LD_FLAG, flag));
+        }
+    }
+
+    /* the same output in the same order on one thread and on four */
+    for (j = 0; j < 3; j++) {
+        for (i = 0; i < 2; i++) {
+            struct LDJSON *result;
+
+            if (j == 0) {
+                LD_ASSERT(result = LDAllFlags(clients[i], user));
+                LD_ASSERT(LDCollectionGetSize(result) == 300);
+            } else {
+                LD_ASSERT(result = LDAllFlagsState(clients[i], user,
+                    j == 2 ? LD_ALL_FLAGS_CLIENT_SIDE_ONLY : 0));
+            }
+
+            LD_ASSERT(serialized[i] = LDJSONSerialize(result));
+            LDJSONFree(result);
+        }
+
+        LD_ASSERT(strcmp(serialized[0], serialized[1]) == 0);
+
+        LDFree(serialized[0]);
+        LDFree(serialized[1]);
+    }
+
+    LDUserFree(user);
+    LDClientClose(clients[0]);
+    LDClientClose(clients[1]);
+}
+
 int
 main()
 {
@@ -112,6 +236,8 @@ main()
 
     testAllFlags();
     testAllFlagsReturnsNilIfUserKeyIsNil();
+    testAllFlagsState();
+    testAllFlagsThreads();
 
     return 0;
 }
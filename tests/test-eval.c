@@ -165,7 +165,7 @@ returnsOffVariationIfFlagIsOff()
 
     /* run */
     LD_ASSERT(LDi_evaluate(NULL, flag, user, (struct LDStore *)1, &details,
-        &events, &result, false) == EVAL_MISS);
+        &events, &result, false, NULL) == EVAL_MISS);
 
     /* validation */
     LD_ASSERT(strcmp("off", LDGetText(result)) == 0);
@@ -202,7 +202,7 @@ testFlagReturnsNilIfFlagIsOffAndOffVariationIsUnspecified()
 
     /* run */
     LD_ASSERT(LDi_evaluate(NULL, flag, user, (struct LDStore *)1, &details,
-        &events, &result, false) == EVAL_MISS);
+        &events, &result, false, NULL) == EVAL_MISS);
 
     /* validation */
     LD_ASSERT(!result);
@@ -243,7 +243,7 @@ testFlagReturnsFallthroughIfFlagIsOnAndThereAreNoRules()
 
     /* run */
     LD_ASSERT(LDi_evaluate(client, flag, user, (struct LDStore *)1, &details,
-        &events, &result, false) == EVAL_MATCH);
+        &events, &result, false, NULL) == EVAL_MATCH);
 
     /* validate */
     LD_ASSERT(strcmp(LDGetText(result), "fall") == 0);
@@ -300,7 +300,7 @@ testFlagReturnsOffVariationIfPrerequisiteIsOff()
 
     /* run */
     LD_ASSERT(LDi_evaluate(client, flag1, user, store, &details, &events,
-        &result, false));
+        &result, false, NULL));
 
     /* validate */
     LD_ASSERT(strcmp(LDGetText(result), "off") == 0);
@@ -372,7 +372,7 @@ testFlagReturnsOffVariationIfPrerequisiteIsNotMet()
 
     /* run */
     LD_ASSERT(LDi_evaluate(client, flag1, user, store, &details, &events,
-        &result, false));
+        &result, false, NULL));
 
     /* validate */
     LD_ASSERT(strcmp(LDGetText(result), "off") == 0);
@@ -443,7 +443,7 @@ testFlagReturnsFallthroughVariationIfPrerequisiteIsMetAndThereAreNoRules()
 
     /* run */
     LD_ASSERT(LDi_evaluate(client, flag1, user, store, &details, &events,
-        &result, false));
+        &result, false, NULL));
 
     /* validate */
     LD_ASSERT(strcmp(LDGetText(result), "fall") == 0);
@@ -525,7 +525,7 @@ testMultipleLevelsOfPrerequisiteProduceMultipleEvents()
 
     /* run */
     LD_ASSERT(LDi_evaluate(client, flag1, user, store, &details, &events,
-        &result, false));
+        &result, false, NULL));
 
     /* validate */
     LD_ASSERT(strcmp(LDGetText(result), "fall") == 0);
@@ -565,6 +565,152 @@ testMultipleLevelsOfPrerequisiteProduceMultipleEvents()
     LDClientClose(client);
 }
 
+static struct LDJSON *
+makePrerequisiteFlag(const char *const key, const unsigned int version,
+    const char *const prerequisite)
+{
+    struct LDJSON *flag;
+
+    LD_ASSERT(flag = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(flag, "key", LDNewText(key)));
+    LD_ASSERT(LDObjectSetKey(flag, "on", LDNewBool(true)));
+    LD_ASSERT(LDObjectSetKey(flag, "version", LDNewNumber(version)));
+    LD_ASSERT(LDObjectSetKey(flag, "offVariation", LDNewNumber(0)));
+    if (prerequisite) {
+        addPrerequisite(flag, prerequisite, 1);
+    }
+    setFallthrough(flag, 1);
+    addVariations2(flag);
+
+    return flag;
+}
+
+static void
+testSharedPrerequisiteIsMemoized()
+{
+    struct LDUser *user;
+    struct LDStore *store;
+    struct LDJSON *flag1, *flag2, *result, *events, *event;
+    struct LDDetails details;
+    struct LDClient *client;
+    struct LDConfig *config;
+    struct LDEvalMemo memo;
+    unsigned int i;
+
+    LDi_evalMemoInit(&memo);
+
+    LD_ASSERT(config = LDConfigNew("abc"));
+    LD_ASSERT(client = LDClientInit(config, 0));
+    LD_ASSERT(user = LDUserNew("userKeyA"));
+
+    /* two flags behind one kill switch, which has its own prerequisite */
+    flag1 = makePrerequisiteFlag("feature0", 1, "killSwitch");
+    flag2 = makePrerequisiteFlag("feature1", 1, "killSwitch");
+
+    LD_ASSERT(store = prepareEmptyStore());
+    LD_ASSERT(LDStoreUpsert(store, LD_FLAG,
+        makePrerequisiteFlag("killSwitch", 3, "feature2")));
+    LD_ASSERT(LDStoreUpsert(store, LD_FLAG,
+        makePrerequisiteFlag("feature2", 1, NULL)));
+
+    /* the second evaluation reuses the first, with its own prereqOf */
+    for (i = 0; i < 3; i++) {
+        events = NULL;
+        result = NULL;
+        LDDetailsInit(&details);
+
+        if (i == 2) {
+            /* a new version of the kill switch is evaluated again */
+            struct LDJSON *off;
+
+            off = makePrerequisiteFlag("killSwitch", 4, "feature2");
+            LD_ASSERT(LDObjectSetKey(off, "on", LDNewBool(false)));
+            LD_ASSERT(LDStoreUpsert(store, LD_FLAG, off));
+        }
+
+        LD_ASSERT(LDi_evaluate(client, i == 1 ? flag2 : flag1, user, store,
+            &details, &events, &result, false, &memo) ==
+            (i == 2 ? EVAL_MISS : EVAL_MATCH));
+        LD_ASSERT(memo.entries);
+
+        if (i == 2) {
+            LD_ASSERT(strcmp(LDGetText(result), "nogo") == 0);
+            LD_ASSERT(details.reason == LD_PREREQUISITE_FAILED);
+
+            LD_ASSERT(LDCollectionGetSize(events) == 1);
+            LD_ASSERT(event = LDArrayLookup(events, 0));
+            LD_ASSERT(LDGetNumber(LDObjectLookup(event, "version")) == 4);
+        } else {
+            LD_ASSERT(strcmp(LDGetText(result), "go") == 0);
+            LD_ASSERT(details.reason == LD_FALLTHROUGH);
+
+            LD_ASSERT(LDCollectionGetSize(events) == 2);
+            LD_ASSERT(event = LDArrayLookup(events, 0));
+            LD_ASSERT(strcmp("feature2",
+                LDGetText(LDObjectLookup(event, "key"))) == 0);
+            LD_ASSERT(strcmp("killSwitch",
+                LDGetText(LDObjectLookup(event, "prereqOf"))) == 0);
+            LD_ASSERT(event = LDArrayLookup(events, 1));
+            LD_ASSERT(strcmp("killSwitch",
+                LDGetText(LDObjectLookup(event, "key"))) == 0);
+            LD_ASSERT(strcmp(i ? "feature1" : "feature0",
+                LDGetText(LDObjectLookup(event, "prereqOf"))) == 0);
+        }
+
+        LDJSONFree(result);
+        LDJSONFree(events);
+        LDDetailsClear(&details);
+    }
+
+    LDi_evalMemoClear(&memo);
+    LD_ASSERT(!memo.entries);
+
+    LDJSONFree(flag1);
+    LDJSONFree(flag2);
+    LDStoreDestroy(store);
+    LDUserFree(user);
+    LDClientClose(client);
+}
+
+static void
+testPrerequisiteCycleIsSchemaError()
+{
+    struct LDUser *user;
+    struct LDStore *store;
+    struct LDJSON *flag, *result, *events;
+    struct LDDetails details;
+    struct LDClient *client;
+    struct LDConfig *config;
+
+    events = NULL;
+    result = NULL;
+
+    LDDetailsInit(&details);
+    LD_ASSERT(config = LDConfigNew("abc"));
+    LD_ASSERT(client = LDClientInit(config, 0));
+    LD_ASSERT(user = LDUserNew("userKeyA"));
+
+    flag = makePrerequisiteFlag("feature0", 1, "feature1");
+
+    LD_ASSERT(store = prepareEmptyStore());
+    LD_ASSERT(LDStoreUpsert(store, LD_FLAG,
+        makePrerequisiteFlag("feature1", 1, "feature2")));
+    LD_ASSERT(LDStoreUpsert(store, LD_FLAG,
+        makePrerequisiteFlag("feature2", 1, "feature0")));
+    LD_ASSERT(LDStoreUpsert(store, LD_FLAG, LDJSONDuplicate(flag)));
+
+    LD_ASSERT(LDi_evaluate(client, flag, user, store, &details, &events,
+        &result, false, NULL) == EVAL_SCHEMA);
+
+    LDJSONFree(flag);
+    LDJSONFree(events);
+    LDJSONFree(result);
+    LDStoreDestroy(store);
+    LDUserFree(user);
+    LDDetailsClear(&details);
+    LDClientClose(client);
+}
+
 static void
 testFlagMatchesUserFromTarget()
 {
@@ -606,7 +752,7 @@ testFlagMatchesUserFromTarget()
 
     /* run */
     LD_ASSERT(LDi_evaluate(NULL, flag, user, (struct LDStore *)1, &details,
-        &events, &result, false));
+        &events, &result, false, NULL));
 
     /* validate */
     LD_ASSERT(strcmp(LDGetText(result), "on") == 0);
@@ -642,7 +788,7 @@ testFlagMatchesUserFromRules()
 
     /* run */
     LD_ASSERT(LDi_evaluate(NULL, flag, user, (struct LDStore *)1, &details,
-        &events, &result, false));
+        &events, &result, false, NULL));
 
     /* validate */
     LD_ASSERT(strcmp(LDGetText(result), "on") == 0);
@@ -688,7 +834,7 @@ testClauseCanMatchBuiltInAttribute()
 
     /* run */
     LD_ASSERT(LDi_evaluate(NULL, flag, user, (struct LDStore *)1, &details,
-        &events, &result, false));
+        &events, &result, false, NULL));
 
     /* validate */
     LD_ASSERT(LDGetBool(result) == true);
@@ -730,7 +876,7 @@ testClauseCanMatchCustomAttribute()
 
     /* run */
     LD_ASSERT(LDi_evaluate(NULL, flag, user, (struct LDStore *)1, &details,
-        &events, &result, false));
+        &events, &result, false, NULL));
 
     /* validate */
     LD_ASSERT(LDGetBool(result) == true);
@@ -770,7 +916,7 @@ testClauseReturnsFalseForMissingAttribute()
 
     /* run */
     LD_ASSERT(LDi_evaluate(NULL, flag, user, (struct LDStore *)1, &details,
-        &events, &result, false));
+        &events, &result, false, NULL));
 
     /* validate */
     LD_ASSERT(LDGetBool(result) == false);
@@ -811,7 +957,7 @@ testClauseCanBeNegated()
 
     /* run */
     LD_ASSERT(LDi_evaluate(NULL, flag, user, (struct LDStore *)1, &details,
-        &events, &result, false));
+        &events, &result, false, NULL));
 
     /* validate */
     LD_ASSERT(LDGetBool(result) == false);
@@ -852,7 +998,7 @@ testClauseForMissingAttributeIsFalseEvenIfNegate()
 
     /* run */
     LD_ASSERT(LDi_evaluate(NULL, flag, user, (struct LDStore *)1, &details,
-        &events, &result, false));
+        &events, &result, false, NULL));
 
     /* validate */
     LD_ASSERT(LDGetBool(result) == false);
@@ -892,7 +1038,7 @@ testClauseWithUnknownOperatorDoesNotMatch()
 
     /* run */
     LD_ASSERT(LDi_evaluate(NULL, flag, user, (struct LDStore *)1, &details,
-        &events, &result, false) == EVAL_MATCH);
+        &events, &result, false, NULL) == EVAL_MATCH);
 
     /* validate */
     LD_ASSERT(LDGetBool(result) == false);
@@ -945,7 +1091,7 @@ testSegmentMatchClauseRetrievesSegmentFromStore()
 
     /* run */
     LD_ASSERT(LDi_evaluate(NULL, flag, user, store, &details, &events, &result,
-        false) == EVAL_MATCH);
+        false, NULL) == EVAL_MATCH);
 
     /* validate */
     LD_ASSERT(LDGetBool(result) == true);
@@ -958,6 +1104,83 @@ testSegmentMatchClauseRetrievesSegmentFromStore()
     LDDetailsClear(&details);
 }
 
+static void
+testSegmentMatchIsMemoizedByVersion()
+{
+    struct LDUser *user;
+    struct LDStore *store;
+    struct LDJSON *segment, *flag, *result, *members, *values, *clause,
+        *events;
+    struct LDDetails details;
+    struct LDEvalMemo memo;
+    unsigned int i;
+
+    LDi_evalMemoInit(&memo);
+
+    LD_ASSERT(user = LDUserNew("foo"));
+
+    /* segment */
+    LD_ASSERT(members = LDNewArray());
+    LD_ASSERT(LDArrayPush(members, LDNewText("foo")));
+
+    LD_ASSERT(segment = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(segment, "key", LDNewText("segkey")));
+    LD_ASSERT(LDObjectSetKey(segment, "included", members));
+    LD_ASSERT(LDObjectSetKey(segment, "version", LDNewNumber(3)));
+
+    /* flag */
+    LD_ASSERT(values = LDNewArray());
+    LD_ASSERT(LDArrayPush(values, LDNewText("segkey")));
+
+    LD_ASSERT(clause = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(clause, "attribute", LDNewText("")));
+    LD_ASSERT(LDObjectSetKey(clause, "op", LDNewText("segmentMatch")));
+    LD_ASSERT(LDObjectSetKey(clause, "values", values));
+
+    LD_ASSERT(flag = booleanFlagWithClause(clause));
+
+    /* store */
+    LD_ASSERT(store = prepareEmptyStore());
+    LD_ASSERT(LDStoreUpsert(store, LD_SEGMENT, segment));
+
+    /* the second evaluation is answered from the memo, the third sees a new
+    version of the segment that excludes the user */
+    for (i = 0; i < 3; i++) {
+        result = NULL;
+        events = NULL;
+        LDDetailsInit(&details);
+
+        if (i == 2) {
+            LD_ASSERT(members = LDNewArray());
+            LD_ASSERT(LDArrayPush(members, LDNewText("foo")));
+
+            LD_ASSERT(segment = LDNewObject());
+            LD_ASSERT(LDObjectSetKey(segment, "key", LDNewText("segkey")));
+            LD_ASSERT(LDObjectSetKey(segment, "excluded", members));
+            LD_ASSERT(LDObjectSetKey(segment, "version", LDNewNumber(4)));
+
+            LD_ASSERT(LDStoreUpsert(store, LD_SEGMENT, segment));
+        }
+
+        LD_ASSERT(LDi_evaluate(NULL, flag, user, store, &details, &events,
+            &result, false, &memo) == EVAL_MATCH);
+
+        LD_ASSERT(LDGetBool(result) == (i != 2));
+        LD_ASSERT(memo.segments);
+        LD_ASSERT(!events);
+
+        LDJSONFree(result);
+        LDDetailsClear(&details);
+    }
+
+    LDi_evalMemoClear(&memo);
+    LD_ASSERT(!memo.segments);
+
+    LDJSONFree(flag);
+    LDStoreDestroy(store);
+    LDUserFree(user);
+}
+
 static void
 testSegmentMatchClauseFallsThroughIfSegmentNotFound()
 {
@@ -988,7 +1211,7 @@ testSegmentMatchClauseFallsThroughIfSegmentNotFound()
 
     /* run */
     LD_ASSERT(LDi_evaluate(NULL, flag, user, store, &details, &events, &result,
-        false) == EVAL_MATCH);
+        false, NULL) == EVAL_MATCH);
 
     /* validate */
     LD_ASSERT(LDGetBool(result) == false);
@@ -1043,7 +1266,7 @@ testCanMatchJustOneSegmentFromList()
 
     /* run */
     LD_ASSERT(LDi_evaluate(NULL, flag, user, store, &details, &events, &result,
-        false) == EVAL_MATCH);
+        false, NULL) == EVAL_MATCH);
 
     /* validate */
     LD_ASSERT(LDGetBool(result) == true);
@@ -1097,6 +1320,8 @@ main()
     testFlagReturnsOffVariationIfPrerequisiteIsNotMet();
     testFlagReturnsFallthroughVariationIfPrerequisiteIsMetAndThereAreNoRules();
     testMultipleLevelsOfPrerequisiteProduceMultipleEvents();
+    testSharedPrerequisiteIsMemoized();
+    testPrerequisiteCycleIsSchemaError();
     testFlagMatchesUserFromTarget();
     testFlagMatchesUserFromRules();
     testClauseCanMatchBuiltInAttribute();
@@ -1106,6 +1331,7 @@ main()
     testClauseForMissingAttributeIsFalseEvenIfNegate();
     testClauseWithUnknownOperatorDoesNotMatch();
     testSegmentMatchClauseRetrievesSegmentFromStore();
+    testSegmentMatchIsMemoizedByVersion();
     testSegmentMatchClauseFallsThroughIfSegmentNotFound();
     testCanMatchJustOneSegmentFromList();
 
@@ -10,6 +10,9 @@
 #include "store.h"
 
 #include "util-flags.h"
+#ifndef _WIN32
+    #include "util-http.h"
+#endif
 
 static struct LDClient *
 makeOfflineClient()
@@ -397,6 +400,133 @@ testInlineUsersInEvents()
     LDClientClose(client);
 }
 
+static void
+testFlushWaitOffline()
+{
+    struct LDClient *client;
+
+    LD_ASSERT(client = makeOfflineClient());
+
+    LD_ASSERT(LDClientFlushWait(client, 1000) == LD_FLUSH_OFFLINE);
+
+    LDClientClose(client);
+}
+
+static void
+testFlushWaitNothingQueued()
+{
+    struct LDConfig *config;
+    struct LDClient *client;
+
+    /* daemon mode only runs the analytics interface */
+    LD_ASSERT(config = LDConfigNew("api_key"));
+    LDConfigSetUseLDD(config, true);
+    LD_ASSERT(client = LDClientInit(config, 0));
+
+    LD_ASSERT(LDClientFlushWait(client, 10 * 1000) == LD_FLUSH_SUCCESS);
+
+    LDClientClose(client);
+}
+
+static void
+testFlushWaitSharedReactor()
+{
+    struct LDReactor *reactor;
+    struct LDConfig *config1, *config2;
+    struct LDClient *client1, *client2;
+
+    LD_ASSERT(reactor = LDReactorNew());
+
+    LD_ASSERT(config1 = LDConfigNew("api_key1"));
+    LDConfigSetUseLDD(config1, true);
+    LDConfigSetReactor(config1, reactor);
+    LD_ASSERT(client1 = LDClientInit(config1, 0));
+
+    LD_ASSERT(config2 = LDConfigNew("api_key2"));
+    LDConfigSetUseLDD(config2, true);
+    LDConfigSetReactor(config2, reactor);
+    LD_ASSERT(client2 = LDClientInit(config2, 0));
+
+    /* both clients are serviced by the same thread */
+    LD_ASSERT(LDClientFlushWait(client1, 10 * 1000) == LD_FLUSH_SUCCESS);
+    LD_ASSERT(LDClientFlushWait(client2, 10 * 1000) == LD_FLUSH_SUCCESS);
+
+    /* closing one client leaves the other running */
+    LDClientClose(client1);
+    LD_ASSERT(LDClientFlushWait(client2, 10 * 1000) == LD_FLUSH_SUCCESS);
+    LDClientClose(client2);
+
+    LDReactorFree(reactor);
+}
+
+#ifndef _WIN32
+static struct LDClient *
+makeDeliveringClient(const struct TestHTTPServer *const server)
+{
+    struct LDConfig *config;
+    struct LDClient *client;
+
+    LD_ASSERT(config = LDConfigNew("api_key"));
+    LDConfigSetUseLDD(config, true);
+    LD_ASSERT(LDConfigSetEventsURI(config, server->url));
+    LD_ASSERT(client = LDClientInit(config, 0));
+
+    return client;
+}
+
+static void
+testFlushWaitInFlight()
+{
+    struct TestHTTPServer server;
+    struct LDClient *client;
+    struct LDUser *user;
+
+    const char *const responses[] = {
+        "HTTP/1.1 202 Accepted\r\nContent-Length: 0\r\n\r\n"
+    };
+
+    /* the delivery is held open well past the next reactor pass */
+    startServer(&server, responses, 1, 500);
+
+    LD_ASSERT(client = makeDeliveringClient(&server));
+    LD_ASSERT(user = LDUserNew("abc"));
+    LD_ASSERT(LDClientTrack(client, "event", user, NULL));
+
+    LD_ASSERT(LDClientFlushWait(client, 10 * 1000) == LD_FLUSH_SUCCESS);
+    LD_ASSERT(server.served == 1);
+    LD_ASSERT(strncmp(server.requests[0], "POST /bulk ", 11) == 0);
+
+    LDUserFree(user);
+    LDClientClose(client);
+    stopServer(&server);
+}
+
+static void
+testFlushWaitTimeout()
+{
+    struct TestHTTPServer server;
+    struct LDClient *client;
+    struct LDUser *user;
+    unsigned long start, now;
+
+    /* the delivery is accepted but never answered */
+    startServer(&server, NULL, 0, 0);
+
+    LD_ASSERT(client = makeDeliveringClient(&server));
+    LD_ASSERT(user = LDUserNew("abc"));
+    LD_ASSERT(LDClientTrack(client, "event", user, NULL));
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&start));
+    LD_ASSERT(LDClientFlushWait(client, 200) == LD_FLUSH_TIMEOUT);
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&now));
+    LD_ASSERT(now - start >= 200);
+
+    LDUserFree(user);
+    LDClientClose(client);
+    stopServer(&server);
+}
+#endif
+
 int
 main()
 {
@@ -412,6 +542,13 @@ main()
     testTrackMetricQueued();
     testIndexEventGeneration();
     testInlineUsersInEvents();
+    testFlushWaitOffline();
+    testFlushWaitNothingQueued();
+    testFlushWaitSharedReactor();
+#ifndef _WIN32
+    testFlushWaitInFlight();
+    testFlushWaitTimeout();
+#endif
 
     return 0;
 }
@@ -1,6 +1,11 @@
+#include <locale.h>
+
 #include <launchdarkly/api.h>
 
+#include "cJSON.h"
+
 #include "misc.h"
+#include "operators.h"
 
 static void
 testNull()
@@ -160,6 +165,595 @@ testAppend()
     LDJSONFree(right);
 }
 
+/* large enough to be indexed */
+static void
+testLargeObject()
+{
+    struct LDJSON *json, *copy, *iter, *tmp;
+    char key[32], *serialized;
+    unsigned int i;
+
+    LD_ASSERT(json = LDNewObject());
+
+    for (i = 0; i < 1000; i++) {
+        LD_ASSERT(snprintf(key, sizeof(key), "key%u", i) > 0);
+        LD_ASSERT(LDObjectSetKey(json, key, LDNewNumber(i)));
+    }
+
+    LD_ASSERT(LDCollectionGetSize(json) == 1000);
+    LD_ASSERT(!LDObjectLookup(json, "missing"));
+
+    /* replaced members move to the end */
+    LD_ASSERT(LDObjectSetKey(json, "key0", LDNewNumber(5000)));
+    LD_ASSERT(LDGetNumber(LDObjectLookup(json, "key0")) == 5000);
+    LD_ASSERT(LDCollectionGetSize(json) == 1000);
+    LD_ASSERT(strcmp(LDIterKey(LDGetIter(json)), "key1") == 0);
+
+    LDObjectDeleteKey(json, "key10");
+    LD_ASSERT(!LDObjectLookup(json, "key10"));
+
+    LD_ASSERT(tmp = LDObjectDetachKey(json, "key11"));
+    LD_ASSERT(LDGetNumber(tmp) == 11);
+    LDJSONFree(tmp);
+    LD_ASSERT(!LDObjectLookup(json, "key11"));
+
+    LD_ASSERT(iter = LDObjectLookup(json, "key12"));
+    LD_ASSERT(tmp = LDCollectionDetachIter(json, iter));
+    LDJSONFree(tmp);
+    LD_ASSERT(!LDObjectLookup(json, "key12"));
+
+    LD_ASSERT(LDCollectionGetSize(json) == 997);
+
+    for (i = 13; i < 1000; i++) {
+        LD_ASSERT(snprintf(key, sizeof(key), "key%u", i) > 0);
+        LD_ASSERT(LDGetNumber(LDObjectLookup(json, key)) == i);
+    }
+
+    /* parsed and copied objects are indexed as well */
+    LD_ASSERT(serialized = LDJSONSerialize(json));
+    LD_ASSERT(copy = LDJSONDeserialize(serialized));
+    LDFree(serialized);
+    LD_ASSERT(LDJSONCompare(json, copy));
+    LD_ASSERT(LDGetNumber(LDObjectLookup(copy, "key999")) == 999);
+    LDJSONFree(copy);
+
+    LD_ASSERT(copy = LDJSONDuplicate(json));
+    LD_ASSERT(LDGetNumber(LDObjectLookup(copy, "key0")) == 5000);
+    LDJSONFree(copy);
+
+    LDJSONFree(json);
+}
+
+static void
+testRepeatedKey()
+{
+    struct LDJSON *json;
+
+    LD_ASSERT(json = LDJSONDeserialize("{\"a\":1,\"b\":2,\"c\":3,\"d\":4,"
+        "\"e\":5,\"f\":6,\"g\":7,\"h\":8,\"i\":9,\"j\":10,\"k\":11,\"l\":12,"
+        "\"m\":13,\"n\":14,\"o\":15,\"p\":16,\"a\":17}"));
+
+    /* the first member wins */
+    LD_ASSERT(LDGetNumber(LDObjectLookup(json, "a")) == 1);
+
+    LDObjectDeleteKey(json, "a");
+    LD_ASSERT(LDGetNumber(LDObjectLookup(json, "a")) == 17);
+
+    LDObjectDeleteKey(json, "a");
+    LD_ASSERT(!LDObjectLookup(json, "a"));
+
+    LDJSONFree(json);
+}
+
+static void
+testArena()
+{
+    struct LDJSON *put, *data, *flags, *flag, *copy, *tmp;
+    unsigned int i;
+
+    LD_ASSERT(put = LDi_JSONDeserializeArena("{\"path\":\"/\",\"data\":"
+        "{\"flags\":{\"a\":{\"key\":\"a\",\"version\":1},"
+        "\"b\":{\"key\":\"b\",\"version\":2}},\"segments\":{}}}"));
+
+    /* reshaped the way streaming and polling do */
+    LD_ASSERT(data = LDObjectDetachKey(put, "data"));
+    LDJSONFree(put);
+    LD_ASSERT(flags = LDObjectDetachKey(data, "flags"));
+    LD_ASSERT(LDObjectSetKey(data, "features", flags));
+    LD_ASSERT(LDCollectionGetSize(LDObjectLookup(data, "features")) == 2);
+
+    LD_ASSERT(flags = LDObjectDetachKey(data, "features"));
+    LDJSONFree(data);
+    LD_ASSERT(flag = LDObjectDetachKey(flags, "b"));
+    LDJSONFree(flags);
+
+    /* heap items may be linked into the remaining flag */
+    LD_ASSERT(LDObjectSetKey(flag, "on", LDNewBool(true)));
+    LD_ASSERT(tmp = LDNewArray());
+    LD_ASSERT(LDArrayPush(tmp, LDNewText("x")));
+    LD_ASSERT(LDObjectSetKey(flag, "targets", tmp));
+    LD_ASSERT(LDGetBool(LDObjectLookup(flag, "on")));
+
+    /* copies leave the arena */
+    LD_ASSERT(copy = LDJSONDuplicate(flag));
+    LDJSONFree(flag);
+    LD_ASSERT(strcmp(LDGetText(LDObjectLookup(copy, "key")), "b") == 0);
+    LD_ASSERT(LDGetNumber(LDObjectLookup(copy, "version")) == 2);
+    LDJSONFree(copy);
+
+    /* a large object is indexed, and may grow past its index */
+    LD_ASSERT(LDJSONGetType(put = LDi_JSONDeserializeArena("{\"a\":1,\"b\":2,"
+        "\"c\":3,\"d\":4,\"e\":5,\"f\":6,\"g\":7,\"h\":8,\"i\":9,"
+        "\"j\":10,\"k\":11,\"l\":12,\"m\":13,\"n\":14,\"o\":15,"
+        "\"p\":16}")) == LDObject);
+
+    for (i = 0; i < 64; i++) {
+        char key[16];
+
+        LD_ASSERT(snprintf(key, sizeof(key), "key-%u", i) > 0);
+        LD_ASSERT(LDObjectSetKey(put, key, LDNewNumber(i)));
+    }
+
+    LD_ASSERT(LDCollectionGetSize(put) == 80);
+    LD_ASSERT(LDGetNumber(LDObjectLookup(put, "p")) == 16);
+    LD_ASSERT(LDGetNumber(LDObjectLookup(put, "key-63")) == 63);
+
+    /* arena items move between arenas and the heap */
+    LD_ASSERT(data = LDi_JSONDeserializeArena("{\"z\":[1,2]}"));
+    LD_ASSERT(tmp = LDObjectDetachKey(put, "a"));
+    LD_ASSERT(LDObjectSetKey(data, "a", tmp));
+    LD_ASSERT(tmp = LDObjectDetachKey(data, "z"));
+    LD_ASSERT(copy = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(copy, "z", tmp));
+    LDJSONFree(put);
+    LD_ASSERT(LDGetNumber(LDObjectLookup(data, "a")) == 1);
+    LDJSONFree(data);
+    LD_ASSERT(LDCollectionGetSize(LDObjectLookup(copy, "z")) == 2);
+    LDJSONFree(copy);
+
+    LD_ASSERT(!LDi_JSONDeserializeArena("{\"a\":"));
+}
+
+/* the trees have the same shape, order, and values down to the bit */
+static bool
+sameTree(const cJSON *a, const cJSON *b)
+{
+    for (; a && b; a = a->next, b = b->next) {
+        if (a->type != b->type || a->valueint != b->valueint ||
+            memcmp(&a->valuedouble, &b->valuedouble, sizeof(double)) != 0 ||
+            !a->valuestring != !b->valuestring || !a->string != !b->string ||
+            (a->valuestring && strcmp(a->valuestring, b->valuestring) != 0) ||
+            (a->string && strcmp(a->string, b->string) != 0) ||
+            !a->prev != !b->prev || !sameTree(a->child, b->child))
+        {
+            return false;
+        }
+    }
+
+    return !a && !b;
+}
+
+/* the indexed parser either rejects the text or agrees with cJSON, returns
+whether it accepted */
+static bool
+expectSameParse(const char *const text)
+{
+    cJSON *expected, *actual;
+    bool accepted;
+
+    expected = cJSON_Parse(text);
+    actual   = (cJSON *)LDi_JSONParseIndexed(text, strlen(text), false);
+
+    if ((accepted = actual != NULL)) {
+        LD_ASSERT(expected);
+        LD_ASSERT(sameTree(expected, actual));
+    }
+
+    cJSON_Delete(expected);
+    cJSON_Delete(actual);
+
+    return accepted;
+}
+
+static void
+testParseIndexed()
+{
+    static const char *const strict[] = { "0", "-0", "1", "-1", "0.5",
+        "1e3", "1E+3", "-2.5e-3", "123456789012345678901234567890",
+        "9007199254740993", "0.1", "1.7976931348623157e308", "1e400",
+        "-1e-400", "5e-324", "2147483648", "-2147483649", "4.35",
+        "true", "false", "null", "\"\"", "[]", "{}", " [ 1 , 2 ] ",
+        "\t\r\n{\"a\" : [true,false,null,{\"b\":{}}]}\n",
+        "\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"", "\"\\u00e9\\u2713\\uD83D\\uDE00\"",
+        "\"\\u0041\\u0000\\u0042\"", "\"\xe2\x9c\x93 raw\"",
+        "{\"a\":1,\"a\":2}", "[\"}\",\"]\",\",\",\":\",\"{\"]",
+        "[\"\\\\\",\"\\\\\\\\\",\"\\\\\\\"\"]" };
+    static const char *const rejected[] = { "", " ", "01", "-", "1.", ".5",
+        "1e", "1e+", "+1", "[1,]", "[,1]", "{\"a\" 1}", "{\"a\":1,}", "{1:2}",
+        "\"a\tb\"", "[1] x", "[1]]", "\"\\ud800\"", "\"\\udc00\"",
+        "\"\\ud800\\u0041\"", "\"\\x\"", "\"\\u12g4\"", "tru", "truex",
+        "nul", "\"abc", "[", "{", "[1", "{\"a\":", "\xef\xbb\xbf{}", "\f1",
+        "[1 2]", "\"a\"\"b\"", "[\"a\"1]", "[true1]", "1-2", "[--1]",
+        "{\"a\":1 \"b\":2}", "nan", "[Infinity]" };
+    char text[512], *large;
+    struct LDJSON *heap, *arena;
+    unsigned int i, j, depth;
+    size_t length;
+
+    for (i = 0; i < sizeof(strict) / sizeof(strict[0]); i++) {
+        LD_ASSERT(expectSameParse(strict[i]));
+    }
+
+    for (i = 0; i < sizeof(rejected) / sizeof(rejected[0]); i++) {
+        LD_ASSERT(!LDi_JSONParseIndexed(rejected[i], strlen(rejected[i]),
+            false));
+    }
+
+    /* strings and runs of backslashes across block boundaries */
+    for (i = 0; i < 140; i++) {
+        for (j = 0; j < 6; j++) {
+            char *out = text;
+
+            memset(out, ' ', i);
+            out += i;
+            *out++ = '[';
+            *out++ = '"';
+            memset(out, '\\', j * 2);
+            out += j * 2;
+            if (j % 2) {
+                *out++ = '\\';
+                *out++ = '"';
+            }
+            memcpy(out, "\",1,\"", 5);
+            out += 5;
+            memset(out, '\\', 64 + j * 2);
+            out += 64 + j * 2;
+            *out++ = '"';
+            *out++ = ']';
+            *out   = 0;
+
+            LD_ASSERT(expectSameParse(text));
+        }
+    }
+
+    /* at the nesting limit of cJSON and past it */
+    for (depth = CJSON_NESTING_LIMIT; depth <= CJSON_NESTING_LIMIT + 1;
+        depth++)
+    {
+        LD_ASSERT(large = LDAlloc(depth * 2 + 1));
+        memset(large, '[', depth);
+        memset(large + depth, ']', depth);
+        large[depth * 2] = 0;
+
+        LD_ASSERT(expectSameParse(large) == (depth == CJSON_NESTING_LIMIT));
+
+        LDFree(large);
+    }
+
+    /* random edits of valid text, each rejected or parsed as cJSON does */
+    for (i = 0; i < 20000; i++) {
+        static const char replacements[] = "\"\\{}[]:,0-+e.tnu \t\x01\xff";
+        static const char *const seed = "{\"key\":\"flag-1\",\"on\":true,"
+            "\"rules\":[{\"clauses\":[{\"values\":[\"a\\\"b\",\"\\u00e9\","
+            "-1.5e3,0,null]}],\"weight\":12.375}],\"salt\":\"x\\\\y\\n\"}";
+        unsigned int edits, position, random;
+
+        strcpy(text, seed);
+
+        for (edits = 0; edits < 1 + i % 3; edits++) {
+            LD_ASSERT(LDi_random(&position));
+            LD_ASSERT(LDi_random(&random));
+
+            length    = strlen(text);
+            position %= length;
+
+            switch (random % 3) {
+                case 0:
+                    text[position] = replacements[(random / 3) %
+                        (sizeof(replacements) - 1)];
+                    break;
+                case 1:
+                    memmove(text + position, text + position + 1,
+                        length - position);
+                    break;
+                default:
+                    memmove(text + position + 1, text + position,
+                        length - position + 1);
+                    text[position] = replacements[(random / 3) %
+                        (sizeof(replacements) - 1)];
+            }
+        }
+
+        expectSameParse(text);
+    }
+
+    /* through LDJSONDeserialize and into an arena once long enough */
+    LD_ASSERT(heap = LDNewArray());
+    for (i = 0; i < 2000; i++) {
+        LD_ASSERT(LDArrayPush(heap, LDNewNumber(i * 1.25)));
+        LD_ASSERT(LDArrayPush(heap, LDNewText("\"quoted\"\t\\")));
+    }
+    LD_ASSERT(large = LDJSONSerialize(heap));
+    LDJSONFree(heap);
+
+    LD_ASSERT(expectSameParse(large));
+    LD_ASSERT(heap = LDJSONDeserialize(large));
+    LD_ASSERT(arena = LDi_JSONDeserializeArena(large));
+    LD_ASSERT(LDJSONCompare(heap, arena));
+    LD_ASSERT(LDCollectionGetSize(arena) == 4000);
+
+    LDJSONFree(heap);
+    LDJSONFree(arena);
+    LDFree(large);
+}
+
+static void
+testArenaInterning()
+{
+    struct LDJSON *clauses, *clause, *values, *heap, *arena, *detached;
+    const struct LDJSON *first, *second;
+    unsigned int i;
+    char *text, key[32];
+
+    LD_ASSERT(clauses = LDNewArray());
+    for (i = 0; i < 500; i++) {
+        LD_ASSERT(snprintf(key, sizeof(key), "user-%u", i) > 0);
+        LD_ASSERT(values = LDNewArray());
+        LD_ASSERT(LDArrayPush(values, LDNewText("@example.com")));
+        LD_ASSERT(LDArrayPush(values, LDNewText(key)));
+        LD_ASSERT(LDArrayPush(values, LDNewText("escaped\\")));
+        LD_ASSERT(clause = LDNewObject());
+        LD_ASSERT(LDObjectSetKey(clause, "op", LDNewText("endsWith")));
+        LD_ASSERT(LDObjectSetKey(clause, "attribute", LDNewText("email")));
+        LD_ASSERT(LDObjectSetKey(clause, "values", values));
+        LD_ASSERT(LDArrayPush(clauses, clause));
+    }
+    LD_ASSERT(text = LDJSONSerialize(clauses));
+    LDJSONFree(clauses);
+
+    LD_ASSERT(heap = LDJSONDeserialize(text));
+    LD_ASSERT(arena = LDi_JSONDeserializeArena(text));
+    LD_ASSERT(LDJSONCompare(heap, arena));
+
+    first  = LDArrayLookup(arena, 0);
+    second = LDArrayLookup(arena, 499);
+
+    /* names point to the shared copy, compared by pointer */
+    LD_ASSERT(LDGetText(LDObjectLookup(first, "op")) ==
+        LDi_names[LD_NAME_ENDS_WITH]);
+    LD_ASSERT(LDGetText(LDObjectLookup(second, "attribute")) ==
+        LDi_names[LD_NAME_EMAIL]);
+    LD_ASSERT(LDi_lookupOperation(LDGetText(LDObjectLookup(first, "op"))));
+
+    /* repeated strings are stored once, escaped ones each time */
+    LD_ASSERT(LDGetText(LDArrayLookup(LDObjectLookup(first, "values"), 0)) ==
+        LDGetText(LDArrayLookup(LDObjectLookup(second, "values"), 0)));
+    LD_ASSERT(LDGetText(LDArrayLookup(LDObjectLookup(first, "values"), 1)) !=
+        LDGetText(LDArrayLookup(LDObjectLookup(second, "values"), 1)));
+    LD_ASSERT(LDGetText(LDArrayLookup(LDObjectLookup(first, "values"), 2)) !=
+        LDGetText(LDArrayLookup(LDObjectLookup(second, "values"), 2)));
+
+    /* shared strings outlive the rest of the tree with the arena */
+    LD_ASSERT(detached = LDObjectDetachKey(LDArrayLookup(arena, 499),
+        "values"));
+    LDJSONFree(arena);
+    LD_ASSERT(LDJSONCompare(detached,
+        LDObjectLookup(LDArrayLookup(heap, 499), "values")));
+    LDJSONFree(detached);
+
+    LDJSONFree(heap);
+    LDFree(text);
+}
+
+/* the serializer writes what cJSON does */
+static void
+expectSameText(const struct LDJSON *const json)
+{
+    char *expected, *actual;
+
+    LD_ASSERT(expected = cJSON_PrintUnformatted((const cJSON *)json));
+    LD_ASSERT(actual = LDJSONSerialize(json));
+    LD_ASSERT(strcmp(expected, actual) == 0);
+
+    LDFree(expected);
+    LDFree(actual);
+}
+
+static void
+testSerializeNumbers()
+{
+    static const double numbers[] = { 0, 1, -1, 7, 10, 100, 123456789,
+        999999999999999, 1e15, -1e15, 1e16, 1e300, 0.5, -0.25, 0.1, 0.2,
+        0.1 + 0.2, 1.0 / 3, 12.375, 0.0001, 0.00012, 0.00001, 1e-300,
+        4294967296.5, 3.14159265358979, 123456.123456, 0.12345678,
+        0.123456789, 5e-324, 1.7976931348623157e308, 2.5e-5 };
+    struct LDJSON *number;
+    unsigned int i;
+
+    for (i = 0; i < sizeof(numbers) / sizeof(numbers[0]); i++) {
+        LD_ASSERT(number = LDNewNumber(numbers[i]));
+        expectSameText(number);
+        LDJSONFree(number);
+
+        LD_ASSERT(number = LDNewNumber(-numbers[i]));
+        expectSameText(number);
+        LDJSONFree(number);
+    }
+
+    for (i = 0; i < 100000; i++) {
+        unsigned int a, b;
+        double value;
+
+        LD_ASSERT(LDi_random(&a));
+        LD_ASSERT(LDi_random(&b));
+
+        /* whole numbers, short decimals, and arbitrary fractions */
+        switch (i % 3) {
+            case 0:  value = (double)a - b;                  break;
+            case 1:  value = (double)(a % 100000) / 1000;    break;
+            default: value = (double)a / (b ? b : 1) * 1e-3; break;
+        }
+
+        LD_ASSERT(number = LDNewNumber(value));
+        expectSameText(number);
+        LDJSONFree(number);
+    }
+}
+
+static void
+testSerializeText()
+{
+    struct LDJSON *text;
+    char buffer[64];
+    unsigned int i, j;
+
+    for (i = 1; i < 256; i++) {
+        /* the escaped byte at each offset of a word */
+        for (j = 0; j < 20; j++) {
+            memset(buffer, 'a', sizeof(buffer));
+            buffer[j]  = (char)i;
+            buffer[40] = 0;
+
+            LD_ASSERT(text = LDNewText(buffer));
+            expectSameText(text);
+            LDJSONFree(text);
+        }
+    }
+
+    LD_ASSERT(text = LDNewText("\xe2\x9c\x93 tab\there \"quoted\" back\\slash"));
+    expectSameText(text);
+    LDJSONFree(text);
+}
+
+static void
+testSerializeBuffer()
+{
+    struct LDJSON *json, *array;
+    struct LDJSONBuffer buffer;
+    char storage[16];
+    unsigned int i;
+
+    LD_ASSERT(json = LDJSONDeserialize("{\"a\":[1,2.5,\"x\",true,false,"
+        "null,{}],\"b\":{\"c\":[]},\"\\n\":\"\"}"));
+    expectSameText(json);
+
+    LDi_JSONBufferInit(&buffer, storage, sizeof(storage));
+
+    /* fits the storage */
+    LD_ASSERT(LDi_JSONSerializeInto(LDObjectLookup(json, "b"), &buffer));
+    LD_ASSERT(strcmp(buffer.text, "{\"c\":[]}") == 0);
+    LD_ASSERT(buffer.text == storage);
+
+    /* moves to the heap */
+    LD_ASSERT(LDi_JSONSerializeInto(json, &buffer));
+    LD_ASSERT(strcmp(buffer.text, "{\"a\":[1,2.5,\"x\",true,false,null,{}],"
+        "\"b\":{\"c\":[]},\"\\n\":\"\"}") == 0);
+    LD_ASSERT(buffer.owned);
+
+    /* and is reused */
+    LD_ASSERT(array = LDNewArray());
+    for (i = 0; i < 1000; i++) {
+        LD_ASSERT(LDArrayPush(array, LDNewNumber(i)));
+    }
+    LD_ASSERT(LDi_JSONSerializeInto(array, &buffer));
+    LD_ASSERT(buffer.length == strlen(buffer.text));
+    LD_ASSERT(LDi_JSONSerializeInto(LDObjectLookup(json, "b"), &buffer));
+    LD_ASSERT(strcmp(buffer.text, "{\"c\":[]}") == 0);
+
+    expectSameText(array);
+
+    LDi_JSONBufferFree(&buffer);
+    LDJSONFree(array);
+    LDJSONFree(json);
+}
+
+/* false when no locale with a ',' decimal point is installed */
+static bool
+setCommaLocale()
+{
+    static const char *const names[] = { "de_DE.UTF-8", "de_DE.utf8",
+        "de_DE", "fr_FR.UTF-8", "fr_FR.utf8", "fr_FR" };
+    unsigned int i;
+
+    for (i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (setlocale(LC_NUMERIC, names[i]) && LDi_decimalPoint() == ',') {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void
+expectNumberText(const double number, const char *const expected)
+{
+    struct LDJSON *json;
+    char *actual;
+
+    LD_ASSERT(json = LDNewNumber(number));
+    LD_ASSERT(actual = LDJSONSerialize(json));
+    LD_ASSERT(strcmp(actual, expected) == 0);
+
+    LDFree(actual);
+    LDJSONFree(json);
+}
+
+static void
+testSerializeNumbersInLocale()
+{
+    if (!setCommaLocale()) {
+        return;
+    }
+
+    /* formatted directly, and by printf at 15 and 17 digits */
+    expectNumberText(2.5, "2.5");
+    expectNumberText(1.0 / 3, "0.33333333333333331");
+    expectNumberText(0.1 + 0.2, "0.30000000000000004");
+    expectNumberText(5e-324, "4.94065645841247e-324");
+
+    LD_ASSERT(setlocale(LC_NUMERIC, "C"));
+}
+
+static void
+expectParsedNumbers(const char *const text)
+{
+    struct LDJSON *json;
+
+    LD_ASSERT(json = LDJSONDeserialize(text));
+    LD_ASSERT(LDGetNumber(LDArrayLookup(json, 0)) == 0.1234567890123456789);
+    LD_ASSERT(LDGetNumber(LDArrayLookup(json, 1)) == 1.5e-300);
+    LD_ASSERT(LDGetNumber(LDArrayLookup(json, 2)) == 2.5);
+    LDJSONFree(json);
+}
+
+static void
+testParseNumbersInLocale()
+{
+    /* the first two are beyond the exact fast path, so read by strtod */
+    static const char *const numbers = "[0.1234567890123456789,1.5e-300,2.5,";
+    char *text;
+    size_t length;
+
+    if (!setCommaLocale()) {
+        return;
+    }
+
+    /* short documents are parsed by cJSON */
+    expectParsedNumbers("[0.1234567890123456789, 1.5e-300, 2.5]");
+
+    /* and long ones by the strict parser */
+    length = strlen(numbers);
+    LD_ASSERT(text = LDAlloc(length + 20003));
+    memcpy(text, numbers, length);
+    text[length] = '"';
+    memset(text + length + 1, 'a', 20000);
+    memcpy(text + length + 20001, "\"]", 3);
+    expectParsedNumbers(text);
+    LDFree(text);
+
+    LD_ASSERT(setlocale(LC_NUMERIC, "C"));
+}
+
 int
 main()
 {
@@ -174,6 +768,16 @@ main()
     testObject();
     testMerge();
     testAppend();
+    testLargeObject();
+    testRepeatedKey();
+    testArena();
+    testParseIndexed();
+    testArenaInterning();
+    testSerializeNumbers();
+    testSerializeText();
+    testSerializeBuffer();
+    testSerializeNumbersInLocale();
+    testParseNumbersInLocale();
 
     return 0;
 }
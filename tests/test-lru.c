@@ -64,6 +64,23 @@ testZeroCapacityAlwaysNew()
     LDLRUFree(lru);
 }
 
+void
+testInsertHashed()
+{
+    struct LDLRU *lru;
+
+    LD_ASSERT(lru = LDLRUInit(10));
+
+    LD_ASSERT(LDLRUSTATUS_NEW ==
+        LDLRUInsertHashed(lru, "abc", LDLRUHash("abc")));
+    LD_ASSERT(LDLRUSTATUS_EXISTED == LDLRUInsert(lru, "abc"));
+    LD_ASSERT(LDLRUSTATUS_NEW == LDLRUInsert(lru, "def"));
+    LD_ASSERT(LDLRUSTATUS_EXISTED ==
+        LDLRUInsertHashed(lru, "def", LDLRUHash("def")));
+
+    LDLRUFree(lru);
+}
+
 int
 main()
 {
@@ -74,6 +91,7 @@ main()
     testMaxCapacity();
     testAccessBumpsPosition();
     testZeroCapacityAlwaysNew();
+    testInsertHashed();
 
     return 0;
 }
@@ -137,6 +137,36 @@ testJSONVariationDefaultValueOffline()
     LDDetailsClear(&details);
 }
 
+static void
+testNetworkStatsEmptyOffline()
+{
+    struct LDClient *client;
+    struct LDNetworkStats stats;
+    /* prep */
+    LD_ASSERT(client = makeOfflineClient());
+    /* test */
+    LDClientGetNetworkStats(client, &stats);
+    /* validate */
+    LD_ASSERT(stats.requests == 0);
+    LD_ASSERT(stats.connections == 0);
+    LD_ASSERT(stats.handshakes == 0);
+    LD_ASSERT(stats.http2Requests == 0);
+    /* cleanup */
+    LDClientClose(client);
+}
+
+static void
+testAwaitInitializedOffline()
+{
+    struct LDClient *client;
+    /* prep */
+    LD_ASSERT(client = makeOfflineClient());
+    /* test */
+    LD_ASSERT(!LDClientAwaitInitialized(client, 10));
+    /* cleanup */
+    LDClientClose(client);
+}
+
 int
 main()
 {
@@ -148,6 +178,8 @@ main()
     testDoubleVariationDefaultValueOffline();
     testStringVariationDefaultValueOffline();
     testJSONVariationDefaultValueOffline();
+    testNetworkStatsEmptyOffline();
+    testAwaitInitializedOffline();
 
     return 0;
 }
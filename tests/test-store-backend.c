@@ -1,3 +1,5 @@
+#include <string.h>
+
 #include <launchdarkly/api.h>
 
 #include "misc.h"
@@ -89,7 +91,8 @@ makeMockFailInterface()
 }
 
 static struct LDStore *
-prepareStore(struct LDStoreInterface *const handle)
+prepareExtendedStore(struct LDStoreInterface *const handle,
+    const struct LDStoreInterfaceExtensions *const extensions)
 {
     struct LDStore *store;
     struct LDConfig *config;
@@ -98,6 +101,9 @@ prepareStore(struct LDStoreInterface *const handle)
     if (handle) {
         LDConfigSetFeatureStoreBackend(config, handle);
     }
+    if (extensions) {
+        LDConfigSetFeatureStoreBackendExtensions(config, extensions);
+    }
     LD_ASSERT(store = LDStoreNew(config));
     config->storeBackend = NULL;
 
@@ -106,6 +112,12 @@ prepareStore(struct LDStoreInterface *const handle)
     return store;
 }
 
+static struct LDStore *
+prepareStore(struct LDStoreInterface *const handle)
+{
+    return prepareExtendedStore(handle, NULL);
+}
+
 static void
 testFailInit()
 {
@@ -386,6 +398,78 @@ testInitializedCache()
     LDStoreDestroy(store);
 }
 
+static void
+testInitializedCheckTTLZero()
+{
+    struct LDStore *store;
+    struct LDStoreInterface *handle;
+    struct LDConfig *config;
+
+    LD_ASSERT(handle = makeMockFailInterface());
+    handle->initialized = mockStaticInitialized;
+
+    LD_ASSERT(config = LDConfigNew(""));
+    LDConfigSetFeatureStoreBackend(config, handle);
+    LDConfigSetFeatureStoreBackendInitCheckTTL(config, 0);
+    LD_ASSERT(store = LDStoreNew(config));
+    config->storeBackend = NULL;
+    LDConfigFree(config);
+
+    staticInitializedValue = false;
+    staticInitializedCount = 0;
+
+    /* negative answers are not remembered */
+    LD_ASSERT(!LDStoreInitialized(store));
+    LD_ASSERT(!LDStoreInitialized(store));
+    LD_ASSERT(staticInitializedCount == 2);
+    /* positive answers always are */
+    staticInitializedValue = true;
+    LD_ASSERT(LDStoreInitialized(store));
+    LD_ASSERT(LDStoreInitialized(store));
+    LD_ASSERT(staticInitializedCount == 3);
+
+    LDStoreDestroy(store);
+}
+
+static bool
+mockSucceedInit(void *const context,
+    const struct LDStoreCollectionState *collections,
+    const unsigned int collectionCount)
+{
+    (void)context;
+    LD_ASSERT(collections || collectionCount == 0);
+
+    staticInitializedValue = true;
+
+    return true;
+}
+
+static void
+testInitializedAfterInit()
+{
+    struct LDStore *store;
+    struct LDStoreInterface *handle;
+
+    LD_ASSERT(handle = makeMockFailInterface());
+    handle->init        = mockSucceedInit;
+    handle->initialized = mockStaticInitialized;
+    LD_ASSERT(store = prepareStore(handle));
+
+    staticInitializedValue = false;
+    staticInitializedCount = 0;
+
+    /* the negative answer is remembered */
+    LD_ASSERT(!LDStoreInitialized(store));
+    LD_ASSERT(staticInitializedCount == 1);
+
+    /* but a successful init replaces it */
+    LD_ASSERT(LDStoreInitEmpty(store));
+    LD_ASSERT(LDStoreInitialized(store));
+    LD_ASSERT(staticInitializedCount == 1);
+
+    LDStoreDestroy(store);
+}
+
 static unsigned int staticGetCount;
 static struct LDJSON *staticGetValue;
 static char *staticGetKey;
@@ -459,6 +543,327 @@ testGetCache()
 
     LDJSONRCDecrement(item1);
     LDJSONRCDecrement(item2);
+    LDJSONFree(staticGetValue);
+    staticGetValue = NULL;
+    LDStoreDestroy(store);
+}
+
+static LDStoreInvalidate staticInvalidate;
+static void *staticInvalidateStore;
+
+static void
+mockStaticSubscribe(void *const context, LDStoreInvalidate invalidate,
+    void *const store)
+{
+    (void)context;
+    LD_ASSERT(invalidate);
+    LD_ASSERT(store);
+
+    staticInvalidate      = invalidate;
+    staticInvalidateStore = store;
+}
+
+static void
+testInvalidate()
+{
+    struct LDStore *store;
+    struct LDStoreInterface *handle;
+    struct LDStoreInterfaceExtensions extensions;
+    struct LDJSONRC *item;
+
+    memset(&extensions, 0, sizeof(extensions));
+    extensions.size      = sizeof(extensions);
+    extensions.subscribe = mockStaticSubscribe;
+
+    LD_ASSERT(handle = makeMockFailInterface());
+    handle->get = mockStaticGet;
+    LD_ASSERT(store = prepareExtendedStore(handle, &extensions));
+    LD_ASSERT(staticInvalidateStore == store);
+
+    LD_ASSERT(staticGetValue = makeMinimalFlag("abc", 12, true, true));
+    staticGetKey   = "abc";
+    staticGetCount = 0;
+
+    LD_ASSERT(LDStoreGet(store, LD_FLAG, "abc", &item));
+    LD_ASSERT(item);
+    LDJSONRCDecrement(item);
+    LD_ASSERT(staticGetCount == 1);
+
+    /* other items and kinds keep their cache entries */
+    staticInvalidate(staticInvalidateStore, "features", "other");
+    staticInvalidate(staticInvalidateStore, "segments", NULL);
+    LD_ASSERT(LDStoreGet(store, LD_FLAG, "abc", &item));
+    LDJSONRCDecrement(item);
+    LD_ASSERT(staticGetCount == 1);
+
+    staticInvalidate(staticInvalidateStore, "features", "abc");
+    LD_ASSERT(LDStoreGet(store, LD_FLAG, "abc", &item));
+    LDJSONRCDecrement(item);
+    LD_ASSERT(staticGetCount == 2);
+
+    staticInvalidate(staticInvalidateStore, "features", NULL);
+    LD_ASSERT(LDStoreGet(store, LD_FLAG, "abc", &item));
+    LDJSONRCDecrement(item);
+    LD_ASSERT(staticGetCount == 3);
+
+    staticInvalidate(staticInvalidateStore, NULL, NULL);
+    LD_ASSERT(LDStoreGet(store, LD_FLAG, "abc", &item));
+    LDJSONRCDecrement(item);
+    LD_ASSERT(staticGetCount == 4);
+
+    LDJSONFree(staticGetValue);
+    staticGetValue = NULL;
+
+    LDStoreDestroy(store);
+}
+
+/* an implementation built against an older header knows fewer members */
+static void
+testExtensionsBeyondSizeUnused()
+{
+    struct LDStore *store;
+    struct LDStoreInterface *handle;
+    struct LDStoreInterfaceExtensions extensions;
+
+    memset(&extensions, 0, sizeof(extensions));
+    extensions.size      = sizeof(extensions.size);
+    extensions.subscribe = mockStaticSubscribe;
+
+    staticInvalidateStore = NULL;
+
+    LD_ASSERT(handle = makeMockFailInterface());
+    LD_ASSERT(store = prepareExtendedStore(handle, &extensions));
+    LD_ASSERT(!staticInvalidateStore);
+
+    LDStoreDestroy(store);
+}
+
+static void
+testRefreshAhead()
+{
+    struct LDStore *store;
+    struct LDStoreInterface *handle;
+    struct LDConfig *config;
+    struct LDJSONRC *item;
+    unsigned int attempts, version;
+
+    LD_ASSERT(handle = makeMockFailInterface());
+    handle->get = mockStaticGet;
+
+    LD_ASSERT(config = LDConfigNew(""));
+    LDConfigSetFeatureStoreBackend(config, handle);
+    LDConfigSetFeatureStoreBackendCacheTTL(config, 10);
+    LDConfigSetFeatureStoreBackendCacheHardTTL(config, 60 * 1000);
+    LD_ASSERT(store = LDStoreNew(config));
+    config->storeBackend = NULL;
+    LDConfigFree(config);
+
+    LD_ASSERT(staticGetValue = makeMinimalFlag("abc", 12, true, true));
+    staticGetKey   = "abc";
+    staticGetCount = 0;
+
+    LD_ASSERT(LDStoreGet(store, LD_FLAG, "abc", &item));
+    LD_ASSERT(LDi_getFeatureVersion(LDJSONRCGet(item)) == 12);
+    LDJSONRCDecrement(item);
+    LD_ASSERT(staticGetCount == 1);
+
+    /* changed before the refresh can start, it runs on another thread */
+    LDJSONFree(staticGetValue);
+    LD_ASSERT(staticGetValue = makeMinimalFlag("abc", 13, true, true));
+
+    LD_ASSERT(LDi_sleepMilliseconds(20));
+
+    /* the stale item is served until the refresh lands */
+    for (attempts = 0; attempts < 100; attempts++) {
+        LD_ASSERT(LDStoreGet(store, LD_FLAG, "abc", &item));
+        LD_ASSERT(item);
+        version = LDi_getFeatureVersion(LDJSONRCGet(item));
+        LDJSONRCDecrement(item);
+
+        if (version == 13) {
+            break;
+        }
+
+        LD_ASSERT(version == 12);
+        LD_ASSERT(LDi_sleepMilliseconds(5));
+    }
+    LD_ASSERT(version == 13);
+
+    LDStoreDestroy(store);
+
+    /* one synchronous fetch, then background refreshes only */
+    LD_ASSERT(staticGetCount >= 2);
+
+    LDJSONFree(staticGetValue);
+    staticGetValue = NULL;
+}
+
+static void
+getMissing(struct LDStore *const store, char *const key)
+{
+    struct LDJSONRC *item;
+
+    staticGetKey = key;
+
+    LD_ASSERT(LDStoreGet(store, LD_FLAG, key, &item));
+    LD_ASSERT(!item);
+}
+
+static void
+testNegativeCache()
+{
+    struct LDStore *store;
+    struct LDStoreInterface *handle;
+    struct LDConfig *config;
+
+    LD_ASSERT(handle = makeMockFailInterface());
+    handle->get = mockStaticGet;
+
+    LD_ASSERT(config = LDConfigNew(""));
+    LDConfigSetFeatureStoreBackend(config, handle);
+    /* present items are always read from the backend */
+    LDConfigSetFeatureStoreBackendCacheTTL(config, 0);
+    LDConfigSetFeatureStoreBackendNegativeCacheTTL(config, 60 * 1000);
+    LDConfigSetFeatureStoreBackendNegativeCacheCapacity(config, 2);
+    LD_ASSERT(store = LDStoreNew(config));
+    config->storeBackend = NULL;
+    LDConfigFree(config);
+
+    staticGetValue = NULL;
+    staticGetCount = 0;
+
+    getMissing(store, "a");
+    getMissing(store, "b");
+    LD_ASSERT(staticGetCount == 2);
+
+    getMissing(store, "a");
+    getMissing(store, "b");
+    LD_ASSERT(staticGetCount == 2);
+
+    /* evicts a, the oldest */
+    getMissing(store, "c");
+    LD_ASSERT(staticGetCount == 3);
+    getMissing(store, "b");
+    getMissing(store, "c");
+    LD_ASSERT(staticGetCount == 3);
+
+    getMissing(store, "a");
+    LD_ASSERT(staticGetCount == 4);
+
+    LDi_expireAll(store);
+    getMissing(store, "a");
+    LD_ASSERT(staticGetCount == 5);
+
+    LDStoreDestroy(store);
+}
+
+static void
+testNegativeCacheTTLZero()
+{
+    struct LDStore *store;
+    struct LDStoreInterface *handle;
+    struct LDConfig *config;
+    struct LDJSONRC *item;
+
+    LD_ASSERT(handle = makeMockFailInterface());
+    handle->get = mockStaticGet;
+
+    LD_ASSERT(config = LDConfigNew(""));
+    LDConfigSetFeatureStoreBackend(config, handle);
+    LDConfigSetFeatureStoreBackendCacheTTL(config, 0);
+    LD_ASSERT(store = LDStoreNew(config));
+    config->storeBackend = NULL;
+    LDConfigFree(config);
+
+    staticGetValue = NULL;
+    staticGetCount = 0;
+
+    getMissing(store, "a");
+    LD_ASSERT(staticGetCount == 1);
+
+    /* an item added to the backend is seen on the next read */
+    LD_ASSERT(staticGetValue = makeMinimalFlag("a", 1, true, true));
+
+    LD_ASSERT(LDStoreGet(store, LD_FLAG, "a", &item));
+    LD_ASSERT(item);
+    LD_ASSERT(staticGetCount == 2);
+
+    LDJSONRCDecrement(item);
+    LDJSONFree(staticGetValue);
+    staticGetValue = NULL;
+    LDStoreDestroy(store);
+}
+
+static ld_mutex_t slowGetLock;
+static unsigned int slowGetCount;
+
+static bool
+mockSlowGet(void *const context, const char *const kind,
+    const char *const featureKey,
+    struct LDStoreCollectionItem *const result)
+{
+    struct LDJSON *flag;
+
+    (void)context;
+    LD_ASSERT(kind);
+    LD_ASSERT(featureKey);
+    LD_ASSERT(result);
+
+    LD_ASSERT(LDi_sleepMilliseconds(20));
+
+    LD_ASSERT(LDi_mtxlock(&slowGetLock));
+    slowGetCount++;
+    LD_ASSERT(LDi_mtxunlock(&slowGetLock));
+
+    LD_ASSERT(flag = makeMinimalFlag(featureKey, 3, true, true));
+    LD_ASSERT(result->buffer = LDJSONSerialize(flag));
+    result->bufferSize = strlen(result->buffer);
+    result->version    = 3;
+    LDJSONFree(flag);
+
+    return true;
+}
+
+static THREAD_RETURN
+getConcurrently(void *const rawStore)
+{
+    struct LDJSONRC *item;
+
+    LD_ASSERT(LDStoreGet((struct LDStore *)rawStore, LD_FLAG, "abc", &item));
+    LD_ASSERT(item);
+    LD_ASSERT(LDi_getFeatureVersion(LDJSONRCGet(item)) == 3);
+    LDJSONRCDecrement(item);
+
+    return THREAD_RETURN_DEFAULT;
+}
+
+static void
+testCoalescedGet()
+{
+    struct LDStore *store;
+    struct LDStoreInterface *handle;
+    ld_thread_t threads[8];
+    unsigned int i;
+
+    LD_ASSERT(handle = makeMockFailInterface());
+    handle->get = mockSlowGet;
+    LD_ASSERT(store = prepareStore(handle));
+
+    LD_ASSERT(LDi_mtxinit(&slowGetLock));
+    slowGetCount = 0;
+
+    for (i = 0; i < 8; i++) {
+        LD_ASSERT(LDi_createthread(&threads[i], getConcurrently, store));
+    }
+
+    for (i = 0; i < 8; i++) {
+        LD_ASSERT(LDi_jointhread(threads[i]));
+    }
+
+    /* late threads find the cached item, early ones share the read */
+    LD_ASSERT(slowGetCount == 1);
+
+    LD_ASSERT(LDi_mtxdestroy(&slowGetLock));
     LDStoreDestroy(store);
 }
 
@@ -623,6 +1028,166 @@ testAllCache()
     LDStoreDestroy(store);
 }
 
+static bool staticInitAsync;
+static unsigned int staticGetAsyncCount;
+static LDStoreCompletion staticUpsertCompletion;
+static void *staticUpsertCompletionData;
+
+static bool
+mockImmediateInit(void *const context,
+    const struct LDStoreCollectionState *collections,
+    const unsigned int collectionCount, LDStoreCompletion completion,
+    void *const completionData)
+{
+    (void)context;
+    LD_ASSERT(collections || collectionCount == 0);
+    LD_ASSERT(completion);
+
+    staticInitAsync = true;
+
+    completion(completionData, true);
+
+    return true;
+}
+
+static bool
+mockImmediateGet(void *const context, const char *const kind,
+    const char *const featureKey, LDStoreGetCompletion completion,
+    void *const completionData)
+{
+    struct LDStoreCollectionItem item;
+
+    LD_ASSERT(completion);
+    LD_ASSERT(mockStaticGet(context, kind, featureKey, &item));
+
+    staticGetAsyncCount++;
+
+    completion(completionData, true, &item);
+
+    return true;
+}
+
+/* completed by the test */
+static bool
+mockDeferredUpsert(void *const context, const char *const kind,
+    const struct LDStoreCollectionItem *const feature,
+    const char *const featureKey, LDStoreCompletion completion,
+    void *const completionData)
+{
+    LD_ASSERT(mockStaticUpsert(context, kind, feature, featureKey));
+    LD_ASSERT(completion);
+    LD_ASSERT(!staticUpsertCompletion);
+
+    staticUpsertCompletion     = completion;
+    staticUpsertCompletionData = completionData;
+
+    return true;
+}
+
+static void
+completeUpsert(const bool success)
+{
+    LDStoreCompletion completion;
+
+    LD_ASSERT(completion = staticUpsertCompletion);
+
+    staticUpsertCompletion = NULL;
+
+    completion(staticUpsertCompletionData, success);
+}
+
+static void
+testAsync()
+{
+    struct LDStore *store;
+    struct LDStoreInterface *handle;
+    struct LDStoreInterfaceExtensions extensions;
+    struct LDConfig *config;
+    struct LDJSONRC *item;
+    unsigned int attempts, version;
+
+    LD_ASSERT(handle = makeMockFailInterface());
+    handle->get    = mockStaticGet;
+    handle->upsert = mockStaticUpsert;
+
+    memset(&extensions, 0, sizeof(extensions));
+    extensions.size        = sizeof(extensions);
+    extensions.initAsync   = mockImmediateInit;
+    extensions.getAsync    = mockImmediateGet;
+    extensions.upsertAsync = mockDeferredUpsert;
+
+    LD_ASSERT(config = LDConfigNew(""));
+    LDConfigSetFeatureStoreBackend(config, handle);
+    LDConfigSetFeatureStoreBackendExtensions(config, &extensions);
+    LDConfigSetFeatureStoreBackendCacheTTL(config, 10);
+    LDConfigSetFeatureStoreBackendCacheHardTTL(config, 60 * 1000);
+    LD_ASSERT(store = LDStoreNew(config));
+    config->storeBackend = NULL;
+    LDConfigFree(config);
+
+    staticInitAsync     = false;
+    staticGetAsyncCount = 0;
+    staticGetCount      = 0;
+    staticGetValue      = NULL;
+    staticGetKey        = "abc";
+    staticUpsertCount   = 0;
+    staticUpsertKey     = "abc";
+
+    LD_ASSERT(LDStoreInitEmpty(store));
+    LD_ASSERT(staticInitAsync);
+
+    /* the cache is only updated once the backend completes the write */
+    LD_ASSERT(LDStoreUpsert(store, LD_FLAG,
+        makeMinimalFlag("abc", 12, true, true)));
+    LD_ASSERT(staticUpsertCount == 1);
+
+    LD_ASSERT(LDStoreGet(store, LD_FLAG, "abc", &item));
+    LD_ASSERT(!item);
+    LD_ASSERT(staticGetCount == 1);
+
+    completeUpsert(true);
+
+    LD_ASSERT(LDStoreGet(store, LD_FLAG, "abc", &item));
+    LD_ASSERT(LDi_getFeatureVersion(LDJSONRCGet(item)) == 12);
+    LDJSONRCDecrement(item);
+    LD_ASSERT(staticGetCount == 1);
+
+    /* a failed write leaves the cache alone */
+    LD_ASSERT(LDStoreRemove(store, LD_FLAG, "abc", 13));
+    completeUpsert(false);
+
+    LD_ASSERT(LDStoreGet(store, LD_FLAG, "abc", &item));
+    LD_ASSERT(LDi_getFeatureVersion(LDJSONRCGet(item)) == 12);
+    LDJSONRCDecrement(item);
+
+    /* refreshes go through the asynchronous interface */
+    LD_ASSERT(staticGetValue = makeMinimalFlag("abc", 14, true, true));
+
+    LD_ASSERT(LDi_sleepMilliseconds(20));
+
+    for (attempts = 0; attempts < 100; attempts++) {
+        LD_ASSERT(LDStoreGet(store, LD_FLAG, "abc", &item));
+        LD_ASSERT(item);
+        version = LDi_getFeatureVersion(LDJSONRCGet(item));
+        LDJSONRCDecrement(item);
+
+        if (version == 14) {
+            break;
+        }
+
+        LD_ASSERT(LDi_sleepMilliseconds(5));
+    }
+    LD_ASSERT(version == 14);
+
+    LDStoreDestroy(store);
+
+    LD_ASSERT(staticGetAsyncCount >= 1);
+    LD_ASSERT(staticGetCount == staticGetAsyncCount + 1);
+
+    LDJSONFree(staticGetValue);
+    staticGetValue = NULL;
+}
+
 int
 main()
 {
@@ -640,9 +1205,18 @@ main()
     testFailGetInvalidFlag();
     testFailAllInvalidFlag();
     testInitializedCache();
+    testInitializedCheckTTLZero();
+    testInitializedAfterInit();
     testGetCache();
     testUpsertCache();
+    testInvalidate();
+    testExtensionsBeyondSizeUnused();
+    testRefreshAhead();
+    testCoalescedGet();
+    testNegativeCache();
+    testNegativeCacheTTLZero();
     testAllCache();
+    testAsync();
 
     return 0;
 }
@@ -19,6 +19,32 @@ prepareEmptyStore()
     return store;
 }
 
+static void
+testScanFeatureVersion()
+{
+    unsigned int version;
+    bool deleted;
+
+    LD_ASSERT(LDi_scanFeatureVersion(
+        "{\"key\": \"a\", \"version\": 12}", &version, &deleted));
+    LD_ASSERT(version == 12);
+    LD_ASSERT(!deleted);
+
+    /* nested versions and escaped quotes are not mistaken for the top level */
+    LD_ASSERT(LDi_scanFeatureVersion(
+        "{\"variations\": [{\"version\": 3}, \"a\\\"version\\\":7\"],"
+        " \"deleted\" : true, \"version\":4}", &version, &deleted));
+    LD_ASSERT(version == 4);
+    LD_ASSERT(deleted);
+
+    LD_ASSERT(LDi_scanFeatureVersion("{\"key\": \"a\"}", &version, &deleted));
+    LD_ASSERT(version == 0);
+
+    LD_ASSERT(!LDi_scanFeatureVersion(
+        "{\"key\": \"a\", \"version\": 1", &version, &deleted));
+    LD_ASSERT(!LDi_scanFeatureVersion("{\"key\": \"a}", &version, &deleted));
+}
+
 int
 main()
 {
@@ -26,6 +52,7 @@ main()
     LDGlobalInit();
 
     runSharedStoreTests(prepareEmptyStore);
+    testScanFeatureVersion();
 
     return 0;
 }
@@ -5,6 +5,11 @@
 #include "evaluate.h"
 #include "streaming.h"
 #include "misc.h"
+#include "network.h"
+
+#ifndef _WIN32
+    #include "util-http.h"
+#endif
 
 static void
 testParsePathFlags()
@@ -54,8 +59,12 @@ testInitialPut(struct StreamContext *const context)
 
     LD_ASSERT(context);
 
+    LD_ASSERT(!LDClientAwaitInitialized(context->client, 0));
+
     LD_ASSERT(LDi_streamWriteCallback(event, strlen(event), 1, context));
 
+    LD_ASSERT(LDClientAwaitInitialized(context->client, 0));
+
     LD_ASSERT(LDStoreGet(
         context->client->store, LD_FLAG, "my-flag", &flag));
     LD_ASSERT(flag);
@@ -403,6 +412,318 @@ testSSENoEventType(struct StreamContext *const context)
     LD_ASSERT(LDi_streamWriteCallback(event, strlen(event), 1, context));
 }
 
+static void
+testDataSourceStreaming(struct StreamContext *const context)
+{
+    struct LDDataSourceStatus status;
+
+    const char *const event =
+        "event: put\n"
+        "data: {\"path\": \"/\", \"data\": {\"flags\": {},"
+        "\"segments\": {}}}\n\n";
+
+    LD_ASSERT(context);
+
+    LDClientGetDataSourceStatus(context->client, &status);
+    LD_ASSERT(status.state == LD_DATA_SOURCE_INITIALIZING);
+    LD_ASSERT(status.transitions == 0);
+
+    LD_ASSERT(LDi_streamWriteCallback(event, strlen(event), 1, context));
+
+    LDClientGetDataSourceStatus(context->client, &status);
+    LD_ASSERT(status.state == LD_DATA_SOURCE_STREAMING);
+    LD_ASSERT(status.transitions == 1);
+
+    /* a second put is not a transition */
+    LD_ASSERT(LDi_streamWriteCallback(event, strlen(event), 1, context));
+
+    LDClientGetDataSourceStatus(context->client, &status);
+    LD_ASSERT(status.transitions == 1);
+}
+
+static void
+onInitialized(struct LDClient *const client, void *const userData)
+{
+    LD_ASSERT(client);
+    LD_ASSERT(userData);
+
+    (*(unsigned int *)userData)++;
+}
+
+static void
+testInitializedCallback()
+{
+    struct LDConfig *config;
+    struct LDClient *client;
+    struct StreamContext *context;
+    unsigned int calls;
+
+    const char *const event =
+        "event: put\n"
+        "data: {\"path\": \"/\", \"data\": {\"flags\": {},"
+        "\"segments\": {}}}\n\n";
+
+    calls = 0;
+
+    LD_ASSERT(config = LDConfigNew("key"));
+    LDConfigSetUseLDD(config, true);
+    LDConfigSetSendEvents(config, false);
+    LDConfigSetInitializedCallback(config, onInitialized, &calls);
+    LD_ASSERT(client = LDClientInit(config, 0));
+    LD_ASSERT(context = (struct StreamContext *)
+        malloc(sizeof(struct StreamContext)));
+    memset(context, 0, sizeof(struct StreamContext));
+    context->client = client;
+
+    LD_ASSERT(calls == 0);
+    LD_ASSERT(LDi_streamWriteCallback(event, strlen(event), 1, context));
+    LD_ASSERT(calls == 1);
+    /* callback only fires on the first transition */
+    LD_ASSERT(LDi_streamWriteCallback(event, strlen(event), 1, context));
+    LD_ASSERT(calls == 1);
+
+    LDFree(context->dataBuffer);
+    LDFree(context->memory);
+    LDFree(context);
+    LDClientClose(client);
+}
+
+#ifndef _WIN32
+#define POLL_RESPONSE_HEADERS "HTTP/1.1 200 OK\r\nConnection: close\r\n"
+#define POLL_PAYLOAD(version) \
+    "{\"flags\": {\"my-flag\": {\"key\": \"my-flag\", \"version\": " \
+    #version "}}, \"segments\": {}}"
+
+static struct LDClient *
+makePollingClient(const struct TestHTTPServer *const server,
+    const unsigned int pollInterval)
+{
+    struct LDConfig *config;
+    struct LDClient *client;
+
+    LD_ASSERT(config = LDConfigNew("key"));
+    LDConfigSetUseLDD(config, true);
+    LDConfigSetSendEvents(config, false);
+    LDConfigSetPollInterval(config, pollInterval);
+    LD_ASSERT(LDConfigSetBaseURI(config, server->url));
+    LD_ASSERT(client = LDClientInit(config, 0));
+
+    return client;
+}
+
+/* as if the stream dropped longer ago than the polling grace period */
+static void
+interruptStream(struct LDClient *const client)
+{
+    unsigned long now;
+
+    LD_ASSERT(LDi_getMonotonicMilliseconds(&now));
+    LD_ASSERT(now >= 5 * 1000);
+
+    LD_ASSERT(LDi_wrlock(&client->lock));
+    client->streamDown      = true;
+    client->streamDownSince = now - 5 * 1000;
+    LD_ASSERT(LDi_wrunlock(&client->lock));
+}
+
+/* as the stream does when it delivers a put */
+static void
+recoverStream(struct LDClient *const client)
+{
+    LD_ASSERT(LDi_wrlock(&client->lock));
+    client->streamDown = false;
+    LDi_setDataSourceState(client, LD_DATA_SOURCE_STREAMING);
+    LD_ASSERT(LDi_wrunlock(&client->lock));
+}
+
+/* waits out the current poll interval */
+static CURL *
+awaitPoll(struct LDClient *const client,
+    struct NetworkInterface *const polling)
+{
+    CURL *curl;
+    unsigned int attempts;
+
+    for (attempts = 0; !(curl = polling->poll(client, polling->context));
+        attempts++)
+    {
+        LD_ASSERT(attempts < 1000);
+        LD_ASSERT(LDi_sleepMilliseconds(1));
+    }
+
+    return curl;
+}
+
+/* performs the request and completes it as the network thread does */
+static void
+completePoll(struct LDClient *const client,
+    struct NetworkInterface *const polling, CURL *const curl)
+{
+    long responsecode;
+    bool success;
+
+    success = curl_easy_perform(curl) == CURLE_OK;
+
+    LD_ASSERT(curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responsecode)
+        == CURLE_OK);
+    LD_ASSERT(success && (responsecode == 200 || responsecode == 304));
+
+    polling->done(client, polling->context, success);
+
+    curl_easy_cleanup(curl);
+}
+
+static unsigned int
+flagVersion(struct LDClient *const client)
+{
+    struct LDJSONRC *flag;
+    unsigned int version;
+
+    LD_ASSERT(LDStoreGet(client->store, LD_FLAG, "my-flag", &flag));
+    LD_ASSERT(flag);
+    version = LDGetNumber(LDObjectLookup(LDJSONRCGet(flag), "version"));
+    LDJSONRCDecrement(flag);
+
+    return version;
+}
+
+static unsigned int
+currentPollInterval(struct LDClient *const client)
+{
+    struct LDDataSourceStatus status;
+
+    LDClientGetDataSourceStatus(client, &status);
+
+    return status.pollInterval;
+}
+
+static void
+testPollingFallback()
+{
+    struct TestHTTPServer server;
+    struct LDClient *client;
+    struct NetworkInterface *polling;
+    struct LDDataSourceStatus status;
+
+    const char *const responses[] = {
+        POLL_RESPONSE_HEADERS "\r\n" POLL_PAYLOAD(1),
+        POLL_RESPONSE_HEADERS "\r\n" POLL_PAYLOAD(2)
+    };
+
+    startServer(&server, responses, 2, 0);
+    LD_ASSERT(client = makePollingClient(&server, 10));
+    LD_ASSERT(polling = LDi_constructPolling(client));
+
+    /* the stream has not had a chance to connect yet */
+    LD_ASSERT(!polling->poll(client, polling->context));
+
+    interruptStream(client);
+    completePoll(client, polling, awaitPoll(client, polling));
+
+    LDClientGetDataSourceStatus(client, &status);
+    LD_ASSERT(status.state == LD_DATA_SOURCE_FALLBACK);
+    LD_ASSERT(LDClientIsInitialized(client));
+    LD_ASSERT(flagVersion(client) == 1);
+
+    /* polling stops once the stream delivers data */
+    recoverStream(client);
+    LD_ASSERT(LDi_sleepMilliseconds(20));
+    LD_ASSERT(!polling->poll(client, polling->context));
+
+    /* a poll that completes after the stream recovered is discarded */
+    interruptStream(client);
+    {
+        CURL *const curl = awaitPoll(client, polling);
+
+        recoverStream(client);
+        completePoll(client, polling, curl);
+    }
+
+    LDClientGetDataSourceStatus(client, &status);
+    LD_ASSERT(status.state == LD_DATA_SOURCE_STREAMING);
+    LD_ASSERT(flagVersion(client) == 1);
+
+    polling->destroy(polling->context);
+    LDFree(polling);
+    LDClientClose(client);
+    stopServer(&server);
+}
+
+static void
+testPollingNotModified()
+{
+    struct TestHTTPServer server;
+    struct LDClient *client;
+    struct NetworkInterface *polling;
+
+    const char *const responses[] = {
+        POLL_RESPONSE_HEADERS "ETag: \"abc\"\r\n\r\n" POLL_PAYLOAD(1),
+        "HTTP/1.1 304 Not Modified\r\nConnection: close\r\n\r\n"
+    };
+
+    startServer(&server, responses, 2, 0);
+    LD_ASSERT(client = makePollingClient(&server, 10));
+    LD_ASSERT(polling = LDi_constructPolling(client));
+
+    interruptStream(client);
+    completePoll(client, polling, awaitPoll(client, polling));
+    completePoll(client, polling, awaitPoll(client, polling));
+
+    LD_ASSERT(!strstr(server.requests[0], "If-None-Match"));
+    LD_ASSERT(strstr(server.requests[1], "If-None-Match: \"abc\"\r\n"));
+
+    /* not modified keeps the data and counts as unchanged */
+    LD_ASSERT(flagVersion(client) == 1);
+    LD_ASSERT(currentPollInterval(client) == 20);
+
+    polling->destroy(polling->context);
+    LDFree(polling);
+    LDClientClose(client);
+    stopServer(&server);
+}
+
+static void
+testPollingIntervalAdapts()
+{
+    struct TestHTTPServer server;
+    struct LDClient *client;
+    struct NetworkInterface *polling;
+    unsigned int i;
+
+    /* without an ETag unchanged payloads are detected by content */
+    const char *const responses[] = {
+        POLL_RESPONSE_HEADERS "\r\n" POLL_PAYLOAD(1),
+        POLL_RESPONSE_HEADERS "\r\n" POLL_PAYLOAD(1),
+        POLL_RESPONSE_HEADERS "\r\n" POLL_PAYLOAD(1),
+        POLL_RESPONSE_HEADERS "\r\n" POLL_PAYLOAD(1),
+        POLL_RESPONSE_HEADERS "\r\n" POLL_PAYLOAD(1),
+        POLL_RESPONSE_HEADERS "\r\n" POLL_PAYLOAD(2)
+    };
+
+    /* doubles while unchanged up to 8x, resets on change */
+    const unsigned int intervals[] = { 10, 20, 40, 80, 80, 10 };
+
+    startServer(&server, responses, 6, 0);
+    LD_ASSERT(client = makePollingClient(&server, 10));
+    LD_ASSERT(polling = LDi_constructPolling(client));
+
+    interruptStream(client);
+
+    for (i = 0; i < 6; i++) {
+        completePoll(client, polling, awaitPoll(client, polling));
+
+        LD_ASSERT(currentPollInterval(client) == intervals[i]);
+    }
+
+    LD_ASSERT(flagVersion(client) == 2);
+
+    polling->destroy(polling->context);
+    LDFree(polling);
+    LDClientClose(client);
+    stopServer(&server);
+}
+#endif
+
 int
 main()
 {
@@ -431,6 +752,13 @@ main()
     testStreamContext(testSSEUnknownEventType);
     testStreamContext(testSSENoData);
     testStreamContext(testSSENoEventType);
+    testInitializedCallback();
+    testStreamContext(testDataSourceStreaming);
+#ifndef _WIN32
+    testPollingFallback();
+    testPollingNotModified();
+    testPollingIntervalAdapts();
+#endif
 
     return 0;
 }
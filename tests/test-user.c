@@ -4,6 +4,7 @@
 
 #include "user.h"
 #include "misc.h"
+#include "lru.h"
 
 static struct LDUser *
 constructBasic()
@@ -117,6 +118,86 @@ serializeAll()
     LDJSONFree(json);
 }
 
+static char *
+serializeFor(struct LDClient *const client, const struct LDUser *const user)
+{
+    struct LDJSON *json;
+    char *serialized;
+
+    LD_ASSERT(json = LDUserToJSON(client, user, true));
+    LD_ASSERT(serialized = LDJSONSerialize(json));
+
+    LDJSONFree(json);
+
+    return serialized;
+}
+
+static void
+prepareKeepsValuesAndJSON()
+{
+    struct LDConfig *config;
+    struct LDClient *client;
+    struct LDUser *user;
+    struct LDJSON *value;
+    char *expected, *actual;
+    const char *const attributes[] = { "key", "ip", "email", "anonymous",
+        "name", "plan" };
+    unsigned int i;
+
+    LD_ASSERT(config = LDConfigNew("key"));
+    LD_ASSERT(LDConfigAddPrivateAttribute(config, "email"));
+    LD_ASSERT(client = LDClientInit(config, 0));
+
+    LD_ASSERT(user = constructBasic());
+    LD_ASSERT(LDObjectSetKey(user->custom, "plan", LDNewText("gold")));
+
+    LD_ASSERT(expected = serializeFor(client, user));
+
+    LD_ASSERT(LDUserPrepare(client, user));
+    LD_ASSERT(user->prepared);
+    LD_ASSERT(user->prepared->keyHash == LDLRUHash("abc"));
+
+    /* the same values and the same redacted JSON as before */
+    LD_ASSERT(actual = serializeFor(client, user));
+    LD_ASSERT(strcmp(expected, actual) == 0);
+    LDFree(actual);
+
+    for (i = 0; i < sizeof(attributes) / sizeof(attributes[0]); i++) {
+        struct LDJSON *temporary;
+
+        LD_ASSERT(value = LDi_valueOfAttribute(user, attributes[i]));
+        LD_ASSERT(LDJSONCompare(value,
+            LDi_lookupAttribute(user, attributes[i], &temporary)));
+        LD_ASSERT(!temporary);
+        LDJSONFree(value);
+    }
+
+    LD_ASSERT(!LDi_valueOfAttribute(user, "country"));
+    LD_ASSERT(!LDi_valueOfAttribute(user, "missing"));
+
+    /* without the client, only the user's private attributes are redacted */
+    LD_ASSERT(actual = serializeFor(NULL, user));
+    LD_ASSERT(strstr(actual, "janedoe@launchdarkly.com"));
+    LDFree(actual);
+
+    /* a change discards what was prepared */
+    LD_ASSERT(LDUserSetEmail(user, "jane@example.com"));
+    LD_ASSERT(!user->prepared);
+
+    LD_ASSERT(value = LDi_valueOfAttribute(user, "email"));
+    LD_ASSERT(strcmp(LDGetText(value), "jane@example.com") == 0);
+    LDJSONFree(value);
+
+    LD_ASSERT(LDUserPrepare(client, user));
+    LD_ASSERT(actual = serializeFor(client, user));
+    LD_ASSERT(strcmp(expected, actual) == 0);
+    LDFree(actual);
+
+    LDFree(expected);
+    LDUserFree(user);
+    LDClientClose(client);
+}
+
 int
 main()
 {
@@ -130,6 +211,7 @@ main()
     serializeEmpty();
     serializeRedacted();
     serializeAll();
+    prepareKeepsValuesAndJSON();
 
     return 0;
 }
@@ -225,6 +225,189 @@ testJSONVariation()
     LDDetailsClear(&details);
 }
 
+static void
+testVariations()
+{
+    struct LDClient *client;
+    struct LDUser *user;
+    struct LDJSON *flag, *def, *event, *counters;
+    struct LDVariationRequest requests[40];
+    struct LDVariationResult results[40];
+    unsigned int i;
+    /* setup */
+    LD_ASSERT(client = makeTestClient());
+    LD_ASSERT(user = LDUserNew("userkey"));
+    LD_ASSERT(def = LDNewObject());
+    LD_ASSERT(LDObjectSetKey(def, "default", LDNewText("default")));
+    LD_ASSERT(LDStoreInitEmpty(client->store));
+    /* flags */
+    LD_ASSERT(flag = makeMinimalFlag("boolFlag", 1, true, true));
+    setFallthrough(flag, 1);
+    addVariation(flag, LDNewBool(false));
+    addVariation(flag, LDNewBool(true));
+    LD_ASSERT(LDStoreUpsert(client->store, LD_FLAG, flag));
+    LD_ASSERT(flag = makeMinimalFlag("numberFlag", 2, true, false));
+    setFallthrough(flag, 0);
+    addVariation(flag, LDNewNumber(12.5));
+    LD_ASSERT(LDStoreUpsert(client->store, LD_FLAG, flag));
+    LD_ASSERT(flag = makeMinimalFlag("textFlag", 3, true, false));
+    setFallthrough(flag, 0);
+    addVariation(flag, LDNewText("b"));
+    LD_ASSERT(LDStoreUpsert(client->store, LD_FLAG, flag));
+    /* requests, past what the stack holds */
+    for (i = 0; i < 40; i++) {
+        switch (i % 8) {
+            case 0:
+                requests[i].key              = "boolFlag";
+                requests[i].type             = LD_VARIATION_BOOL;
+                requests[i].fallback.boolean = false;
+                break;
+            case 1:
+                requests[i].key              = "numberFlag";
+                requests[i].type             = LD_VARIATION_INT;
+                requests[i].fallback.integer = 3;
+                break;
+            case 2:
+                requests[i].key             = "numberFlag";
+                requests[i].type            = LD_VARIATION_DOUBLE;
+                requests[i].fallback.number = 0.5;
+                break;
+            case 3:
+                requests[i].key           = "textFlag";
+                requests[i].type          = LD_VARIATION_STRING;
+                requests[i].fallback.text = "a";
+                break;
+            case 4:
+                requests[i].key           = "missingFlag";
+                requests[i].type          = LD_VARIATION_JSON;
+                requests[i].fallback.json = def;
+                break;
+            case 5:
+                requests[i].key              = "textFlag";
+                requests[i].type             = LD_VARIATION_BOOL;
+                requests[i].fallback.boolean = true;
+                break;
+            case 6:
+                requests[i].key           = NULL;
+                requests[i].type          = LD_VARIATION_STRING;
+                requests[i].fallback.text = NULL;
+                break;
+            default:
+                requests[i].key           = "missingFlag";
+                requests[i].type          = LD_VARIATION_STRING;
+                requests[i].fallback.text = "c";
+                break;
+        }
+    }
+    /* run */
+    LDVariations(client, user, requests, results, 40, true);
+    /* validate */
+    for (i = 0; i < 40; i++) {
+        LD_ASSERT(results[i].type == requests[i].type);
+
+        switch (i % 8) {
+            case 0:
+                LD_ASSERT(results[i].value.boolean == true);
+                LD_ASSERT(results[i].details.reason == LD_FALLTHROUGH);
+                LD_ASSERT(results[i].details.hasVariation);
+                LD_ASSERT(results[i].details.variationIndex == 1);
+                break;
+            case 1:
+                LD_ASSERT(results[i].value.integer == 12);
+                LD_ASSERT(results[i].details.reason == LD_FALLTHROUGH);
+                break;
+            case 2:
+                LD_ASSERT(results[i].value.number == 12.5);
+                LD_ASSERT(results[i].details.reason == LD_FALLTHROUGH);
+                break;
+            case 3:
+                LD_ASSERT(strcmp(results[i].value.text, "b") == 0);
+                LD_ASSERT(results[i].details.reason == LD_FALLTHROUGH);
+                break;
+            case 4:
+                LD_ASSERT(LDJSONCompare(results[i].value.json, def));
+                LD_ASSERT(results[i].value.json != def);
+                LD_ASSERT(results[i].details.reason == LD_ERROR);
+                LD_ASSERT(results[i].details.extra.errorKind ==
+                    LD_FLAG_NOT_FOUND);
+                break;
+            case 5:
+                LD_ASSERT(results[i].value.boolean == true);
+                LD_ASSERT(results[i].details.reason == LD_ERROR);
+                LD_ASSERT(results[i].details.extra.errorKind ==
+                    LD_WRONG_TYPE);
+                break;
+            case 6:
+                LD_ASSERT(results[i].value.text == NULL);
+                LD_ASSERT(results[i].details.reason == LD_ERROR);
+                LD_ASSERT(results[i].details.extra.errorKind == LD_NULL_KEY);
+                break;
+            default:
+                LD_ASSERT(strcmp(results[i].value.text, "c") == 0);
+                LD_ASSERT(results[i].details.reason == LD_ERROR);
+                LD_ASSERT(results[i].details.extra.errorKind ==
+                    LD_FLAG_NOT_FOUND);
+                break;
+        }
+    }
+    /* one index event, then the tracked evaluations in order */
+    LD_ASSERT(LDi_wrlock(&client->lock));
+    LD_ASSERT(LDCollectionGetSize(client->events) == 6);
+    LD_ASSERT(event = LDArrayLookup(client->events, 0));
+    LD_ASSERT(strcmp(LDGetText(LDObjectLookup(event, "kind")), "index") == 0);
+
+    for (i = 1; i < 6; i++) {
+        LD_ASSERT(event = LDArrayLookup(client->events, i));
+        LD_ASSERT(strcmp(LDGetText(LDObjectLookup(event, "key")), "boolFlag")
+            == 0);
+        LD_ASSERT(LDObjectLookup(event, "reason"));
+    }
+    /* every evaluation with a key is counted */
+    LD_ASSERT(counters = LDObjectLookup(client->summaryCounters, "boolFlag"));
+    LD_ASSERT(counters = LDGetIter(LDObjectLookup(counters, "counters")));
+    LD_ASSERT(LDGetNumber(LDObjectLookup(counters, "count")) == 5);
+    LD_ASSERT(counters = LDObjectLookup(client->summaryCounters, "textFlag"));
+    LD_ASSERT(counters = LDGetIter(LDObjectLookup(counters, "counters")));
+    LD_ASSERT(LDGetNumber(LDObjectLookup(counters, "count")) == 10);
+    LD_ASSERT(counters = LDObjectLookup(client->summaryCounters,
+        "missingFlag"));
+    LD_ASSERT(counters = LDGetIter(LDObjectLookup(counters, "counters")));
+    LD_ASSERT(LDGetNumber(LDObjectLookup(counters, "count")) == 10);
+    LD_ASSERT(LDObjectLookup(counters, "unknown"));
+    LD_ASSERT(LDi_wrunlock(&client->lock));
+    /* cleanup */
+    LDVariationResultsClear(results, 40);
+    LDJSONFree(def);
+    LDUserFree(user);
+    LDClientClose(client);
+}
+
+static void
+testVariationsNotReady()
+{
+    struct LDClient *client;
+    struct LDUser *user;
+    struct LDVariationRequest request;
+    struct LDVariationResult result;
+    /* setup */
+    LD_ASSERT(client = makeTestClient());
+    LD_ASSERT(user = LDUserNew("userkey"));
+
+    request.key           = "textFlag";
+    request.type          = LD_VARIATION_STRING;
+    request.fallback.text = "a";
+    /* run */
+    LDVariations(client, user, &request, &result, 1, false);
+    /* validate */
+    LD_ASSERT(strcmp(result.value.text, "a") == 0);
+    LD_ASSERT(result.details.reason == LD_ERROR);
+    LD_ASSERT(result.details.extra.errorKind == LD_CLIENT_NOT_READY);
+    /* cleanup */
+    LDVariationResultsClear(&result, 1);
+    LDUserFree(user);
+    LDClientClose(client);
+}
+
 int
 main()
 {
@@ -237,6 +420,8 @@ main()
     testDoubleVariationAsInt();
     testStringVariation();
     testJSONVariation();
+    testVariations();
+    testVariationsNotReady();
 
     return 0;
 }
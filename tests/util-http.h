@@ -0,0 +1,170 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <launchdarkly/api.h>
+
+#include "misc.h"
+
+/* A local HTTP server for driving the network interfaces in tests. Each
+connection is answered with the next scripted response and then closed. */
+
+#define LD_TEST_HTTP_MAX_REQUESTS 8
+#define LD_TEST_HTTP_REQUEST_SIZE 4096
+
+struct TestHTTPServer {
+    int listener;
+    unsigned short port;
+    /* responses served in order, one per connection */
+    const char *const *responses;
+    unsigned int responseCount;
+    /* how long to hold each request before answering */
+    unsigned long delay;
+    ld_thread_t thread;
+    bool started;
+    /* headers of each request served */
+    char requests[LD_TEST_HTTP_MAX_REQUESTS][LD_TEST_HTTP_REQUEST_SIZE];
+    unsigned int served;
+    char url[64];
+};
+
+static void
+readRequest(const int connection, char *const request)
+{
+    size_t length, headerLength, expected;
+    ssize_t count;
+    const char *end, *contentLength;
+
+    length       = 0;
+    headerLength = 0;
+    expected     = 0;
+
+    while (length < LD_TEST_HTTP_REQUEST_SIZE - 1) {
+        LD_ASSERT((count = recv(connection, request + length,
+            LD_TEST_HTTP_REQUEST_SIZE - 1 - length, 0)) >= 0);
+
+        if (count == 0) {
+            break;
+        }
+
+        length += count;
+        request[length] = 0;
+
+        if (!headerLength && (end = strstr(request, "\r\n\r\n"))) {
+            headerLength = end - request + 4;
+
+            if ((contentLength = strstr(request, "Content-Length: "))) {
+                expected = strtoul(contentLength + 16, NULL, 10);
+            }
+
+            if (strstr(request, "Expect: 100-continue")) {
+                const char *const proceed = "HTTP/1.1 100 Continue\r\n\r\n";
+
+                LD_ASSERT(send(connection, proceed, strlen(proceed), 0) ==
+                    (ssize_t)strlen(proceed));
+            }
+        }
+
+        if (headerLength && length >= headerLength + expected) {
+            break;
+        }
+    }
+
+    /* only the headers are kept */
+    request[headerLength] = 0;
+}
+
+static THREAD_RETURN
+serveRequests(void *const rawserver)
+{
+    struct TestHTTPServer *server;
+
+    server = (struct TestHTTPServer *)rawserver;
+
+    while (server->served < server->responseCount) {
+        const char *response;
+        char *request;
+        int connection;
+
+        if ((connection = accept(server->listener, NULL, NULL)) < 0) {
+            break;
+        }
+
+        response = server->responses[server->served];
+        request  = server->requests[server->served];
+
+        readRequest(connection, request);
+
+        LD_ASSERT(LDi_sleepMilliseconds(server->delay));
+
+        /* counted first so a client that saw the response sees the count */
+        server->served++;
+
+        LD_ASSERT(send(connection, response, strlen(response), 0) ==
+            (ssize_t)strlen(response));
+
+        LD_ASSERT(close(connection) == 0);
+    }
+
+    return THREAD_RETURN_DEFAULT;
+}
+
+/* with no responses connections are left waiting in the backlog forever */
+static void
+startServer(struct TestHTTPServer *const server,
+    const char *const *const responses, const unsigned int responseCount,
+    const unsigned long delay)
+{
+    struct sockaddr_in address;
+    socklen_t addressLength;
+
+    LD_ASSERT(server);
+    LD_ASSERT(responseCount <= LD_TEST_HTTP_MAX_REQUESTS);
+
+    memset(server, 0, sizeof(struct TestHTTPServer));
+    memset(&address, 0, sizeof(struct sockaddr_in));
+
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port        = 0;
+    addressLength           = sizeof(struct sockaddr_in);
+
+    LD_ASSERT((server->listener = socket(AF_INET, SOCK_STREAM, 0)) >= 0);
+    LD_ASSERT(bind(server->listener, (struct sockaddr *)&address,
+        addressLength) == 0);
+    LD_ASSERT(listen(server->listener, LD_TEST_HTTP_MAX_REQUESTS) == 0);
+    LD_ASSERT(getsockname(server->listener, (struct sockaddr *)&address,
+        &addressLength) == 0);
+
+    server->port          = ntohs(address.sin_port);
+    server->responses     = responses;
+    server->responseCount = responseCount;
+    server->delay         = delay;
+
+    LD_ASSERT(snprintf(server->url, sizeof(server->url),
+        "http://127.0.0.1:%u", server->port) > 0);
+
+    if (responseCount) {
+        LD_ASSERT(LDi_createthread(&server->thread, serveRequests, server));
+
+        server->started = true;
+    }
+}
+
+/* waits for every scripted response to be served */
+static void
+stopServer(struct TestHTTPServer *const server)
+{
+    LD_ASSERT(server);
+
+    if (server->started) {
+        LD_ASSERT(LDi_jointhread(server->thread));
+    }
+
+    LD_ASSERT(close(server->listener) == 0);
+}
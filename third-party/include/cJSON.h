@@ -99,6 +99,14 @@ then using the CJSON_API_VISIBILITY flag to "export" the same symbols the way CJ
 #define cJSON_IsReference 256
 #define cJSON_StringIsConst 512
 
+/* LaunchDarkly: items parsed into an arena by src/json.c. cJSON_Delete hands
+ * them to the arena release hook instead of freeing them, cJSON_Duplicate
+ * copies them onto the heap. */
+#define cJSON_InArena 1024
+#define cJSON_ArenaRoot 2048
+#define cJSON_ArenaIndexed 4096
+#define cJSON_ArenaBits (cJSON_InArena | cJSON_ArenaRoot | cJSON_ArenaIndexed)
+
 /* The cJSON structure: */
 typedef struct cJSON
 {
@@ -120,6 +128,9 @@ typedef struct cJSON
 
     /* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
     char *string;
+
+    /* LaunchDarkly: hash index over the members of large objects, maintained by src/json.c. Freed with the item, never copied. Arena items use it to find their arena instead. */
+    void *index;
 } cJSON;
 
 typedef struct cJSON_Hooks
@@ -143,6 +154,9 @@ CJSON_PUBLIC(const char*) cJSON_Version(void);
 /* Supply malloc, realloc and free functions to cJSON */
 CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks);
 
+/* LaunchDarkly: called by cJSON_Delete for each cJSON_InArena item in place of freeing it */
+CJSON_PUBLIC(void) cJSON_InitArenaHook(void (*release)(cJSON *item));
+
 /* Memory Management: the caller is always responsible to free the results from all variants of cJSON_Parse (with cJSON_Delete) and cJSON_Print (with stdlib free, cJSON_Hooks.free_fn, or cJSON_free as appropriate). The exception is cJSON_PrintPreallocated, where the caller has full responsibility of the buffer. */
 /* Supply a block of JSON, and this returns a cJSON object you can interrogate. */
 CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value);
@@ -208,6 +208,13 @@ CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks)
     }
 }
 
+static void (*arena_release)(cJSON *item) = NULL;
+
+CJSON_PUBLIC(void) cJSON_InitArenaHook(void (*release)(cJSON *item))
+{
+    arena_release = release;
+}
+
 /* Internal constructor. */
 static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
 {
@@ -227,6 +234,12 @@ CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
     while (item != NULL)
     {
         next = item->next;
+        if (item->type & cJSON_InArena)
+        {
+            arena_release(item);
+            item = next;
+            continue;
+        }
         if (!(item->type & cJSON_IsReference) && (item->child != NULL))
         {
             cJSON_Delete(item->child);
@@ -239,6 +252,10 @@ CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
         {
             global_hooks.deallocate(item->string);
         }
+        if (!(item->type & cJSON_IsReference) && (item->index != NULL))
+        {
+            global_hooks.deallocate(item->index);
+        }
         global_hooks.deallocate(item);
         item = next;
     }
@@ -2580,7 +2597,7 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
         goto fail;
     }
     /* Copy over all vars */
-    newitem->type = item->type & (~cJSON_IsReference);
+    newitem->type = item->type & (~(cJSON_IsReference | cJSON_ArenaBits));
     newitem->valueint = item->valueint;
     newitem->valuedouble = item->valuedouble;
     if (item->valuestring)
@@ -2593,7 +2610,16 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
     }
     if (item->string)
     {
-        newitem->string = (item->type&cJSON_StringIsConst) ? item->string : (char*)cJSON_strdup((unsigned char*)item->string, &global_hooks);
+        /* arena keys are marked constant but do not outlive the arena */
+        if ((item->type & cJSON_StringIsConst) && !(item->type & cJSON_InArena))
+        {
+            newitem->string = item->string;
+        }
+        else
+        {
+            newitem->type &= ~cJSON_StringIsConst;
+            newitem->string = (char*)cJSON_strdup((unsigned char*)item->string, &global_hooks);
+        }
         if (!newitem->string)
         {
             goto fail;
@@ -2888,7 +2914,8 @@ CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * cons
             {
                 return false;
             }
-            if (strcmp(a->valuestring, b->valuestring) == 0)
+            /* strings interned while parsing into an arena are shared */
+            if ((a->valuestring == b->valuestring) || (strcmp(a->valuestring, b->valuestring) == 0))
             {
                 return true;
             }